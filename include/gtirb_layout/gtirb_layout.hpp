@@ -50,9 +50,37 @@ void GTIRB_LAYOUT_EXPORT_API fixIntegralSymbols(gtirb::Context& Ctx,
                                                 gtirb::Module& M);
 
 /// Assigns addresses to byte intervals in the module to make it printable.
+///
+/// Byte intervals joined by fallthrough edges are laid out next to each other.
+/// Fallthrough edges that cannot be kept (for instance, edges from a block
+/// that is not the last of its interval, or from another section) are
+/// reported and ignored.
+///
+/// \param Ctx  Context to create new blocks in.
+/// \param M    Module to lay out.
+///
+/// \return false if malformed fallthrough edges were ignored; the module is
+/// laid out either way.
 bool GTIRB_LAYOUT_EXPORT_API layoutModule(gtirb::Context& Ctx,
                                           gtirb::Module& M);
 
+/// Assigns addresses to the byte intervals in the module that need them to
+/// make it printable, keeping the others at their current addresses.
+///
+/// Byte intervals without addresses, and byte intervals that overlap others,
+/// are moved into gaps of their section, or after it, together with the byte
+/// intervals they are joined to by fallthrough edges. If moving them is not
+/// enough, for instance because sections interleave, the module is laid out
+/// again as by \ref layoutModule.
+///
+/// \param Ctx  Context to create new blocks in.
+/// \param M    Module to lay out.
+///
+/// \return false if malformed fallthrough edges were ignored; the module is
+/// laid out either way.
+bool GTIRB_LAYOUT_EXPORT_API layoutModuleIncremental(gtirb::Context& Ctx,
+                                                     gtirb::Module& M);
+
 /// Removes addresses from the byte intervals in a module. Automatically calls
 /// \ref fixIntegralSymbols to ensure symbols remain linked to the byte
 /// intervals after their addresses change.
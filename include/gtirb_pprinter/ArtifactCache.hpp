@@ -0,0 +1,99 @@
+//===- ArtifactCache.hpp ------------------------------------------*- C++ ---//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_ARTIFACT_CACHE_H
+#define GTIRB_PP_ARTIFACT_CACHE_H
+
+#include "Export.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace gtirb_bprint {
+
+/// Accumulates the inputs that determine an artifact into a cache key.
+///
+/// Each field is length-prefixed before being hashed, so that a sequence of
+/// fields cannot collide with a different split of the same bytes.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API CacheKey {
+public:
+  CacheKey();
+  ~CacheKey();
+  CacheKey(const CacheKey&) = delete;
+  CacheKey& operator=(const CacheKey&) = delete;
+
+  CacheKey& add(std::string_view Field);
+  CacheKey& add(uint64_t Field);
+
+  /// Add \p Bytes to a field whose length is not known until all of it has
+  /// been read. The field is ended by adding its total length.
+  CacheKey& addChunk(std::string_view Bytes);
+
+  /// Add the contents of the file \p Path, or a marker if it cannot be read.
+  CacheKey& addFile(const std::string& Path);
+
+  /// Return the key as a hexadecimal digest.
+  std::string str() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> State;
+};
+
+/// A content-addressed store of files on disk.
+///
+/// Artifacts are stored under the hex digest of a CacheKey. Publishing is
+/// atomic (the file is staged in the cache directory and then renamed), so
+/// several processes may share one cache directory.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API ArtifactCache {
+public:
+  /// Use (and create, if needed) the cache directory \p Dir.
+  explicit ArtifactCache(std::string Dir);
+
+  const std::string& directory() const { return Dir; }
+
+  /// Copy the artifact stored under \p Key to \p Dest.
+  ///
+  /// Returns false if there is no such artifact or it cannot be copied.
+  bool fetch(const std::string& Key, const std::string& Dest) const;
+
+  /// Store a copy of the file \p Src under \p Key.
+  bool publish(const std::string& Key, const std::string& Src) const;
+
+  /// Return the contents of the artifact stored under \p Key, if any.
+  std::optional<std::string> load(const std::string& Key) const;
+
+  /// Store \p Contents under \p Key.
+  bool store(const std::string& Key, std::string_view Contents) const;
+
+  /// Remove the least recently used artifacts until the cache holds at most
+  /// \p MaxBytes. Fetching or loading an artifact marks it as used.
+  void prune(uint64_t MaxBytes) const;
+
+  /// Describe the tool \p Tool for inclusion in a cache key.
+  ///
+  /// The tool is located on the PATH (unless it is a path) and identified by
+  /// its resolved path, size, and modification time, so that upgrading a
+  /// toolchain invalidates the artifacts it built. Results are memoized.
+  static std::string toolIdentity(const std::string& Tool);
+
+private:
+  std::string Dir;
+};
+
+} // namespace gtirb_bprint
+
+#endif // GTIRB_PP_ARTIFACT_CACHE_H
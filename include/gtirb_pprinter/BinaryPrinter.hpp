@@ -16,12 +16,15 @@
 #define GTIRB_PP_BINARY_PRINTER_H
 
 #include "PrettyPrinter.hpp"
+#include <algorithm>
 #include <gtirb/gtirb.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 
 /// \brief Binary-print GTIRB representations.
 namespace gtirb_bprint {
+class ArtifactCache;
 class TempFile;
 
 class DEBLOAT_PRETTYPRINTER_EXPORT_API BinaryPrinter {
@@ -29,6 +32,15 @@ protected:
   std::vector<std::string> ExtraCompileArgs;
   std::vector<std::string> LibraryPaths;
   const gtirb_pprint::PrettyPrinter& Printer;
+  // Maximum number of tool invocations to run concurrently (0: one per
+  // hardware thread).
+  unsigned Jobs = 0;
+  // Cache of previously built link stubs (dummy .so files, import .lib files).
+  std::shared_ptr<ArtifactCache> StubCache;
+  // Write x86-64 ELF objects directly instead of assembling the listing.
+  bool NativeObject = false;
+  // Maximum number of compilation units to split a binary's listing into.
+  unsigned SplitUnits = 1;
 
   bool prepareSource(gtirb::Context& ctx, gtirb::Module& mod,
                      TempFile& tempFile) const;
@@ -36,6 +48,10 @@ protected:
   bool prepareSources(gtirb::Context& ctx, gtirb::IR& ir,
                       std::vector<TempFile>& tempFiles) const;
 
+  // Print the module as up to SplitUnits compilation units, one per file.
+  bool prepareUnitSources(gtirb::Context& ctx, gtirb::Module& mod,
+                          std::vector<TempFile>& tempFiles) const;
+
 public:
   BinaryPrinter(const gtirb_pprint::PrettyPrinter& prettyPrinter,
                 const std::vector<std::string>& extraCompileArgs,
@@ -44,6 +60,31 @@ public:
         Printer(prettyPrinter) {}
 
   virtual ~BinaryPrinter() = default;
+
+  /// Limit the number of tool invocations run concurrently. Zero selects the
+  /// number of hardware threads.
+  void setJobs(unsigned N) { Jobs = N; }
+  unsigned getJobs() const { return Jobs; }
+
+  /// Reuse link stubs from, and store newly built stubs in, \p Cache.
+  void setStubCache(std::shared_ptr<ArtifactCache> Cache) {
+    StubCache = std::move(Cache);
+  }
+
+  /// Write objects directly from the IR when the module allows it, falling
+  /// back to the assembler otherwise. Only x86-64 ELF modules are supported.
+  void setNativeObject(bool Value) { NativeObject = Value; }
+
+  /// Split the listing of a binary into up to \p N compilation units that are
+  /// assembled concurrently. Only x86 and x86-64 ELF listings are split.
+  void setSplitUnits(unsigned N) { SplitUnits = std::max(N, 1u); }
+
+  /// Add everything a binary built from \p Module depends on besides the
+  /// module itself and the printing options to \p Key: the options of this
+  /// printer, the identity of the tools it runs, and the libraries it links
+  /// against.
+  virtual void addBuildToKey(CacheKey& Key, const gtirb::Module& Module) const;
+
   virtual int assemble(const std::string& outputFilename,
                        gtirb::Context& context, gtirb::Module& mod) const = 0;
   virtual int link(const std::string& outputFilename, gtirb::Context& context,
@@ -35,6 +35,8 @@ private:
   std::string compiler;
   bool debug = false;
   bool useDummySO = false;
+  // The libraries in the library paths, listed once for this link.
+  mutable LibraryIndex Libraries;
   bool isInfixLibraryName(const std::string& library) const;
   std::optional<std::string>
   findLibrary(const std::string& library,
@@ -46,26 +48,31 @@ private:
   Symbols in a group together will be generated refer to the same location in
   the library.
 
-  Creates a library with the filename lib in the directory libDir. Appends
-  compiler arguments to libArgs required for linking with the generated
-  library.
+  Queues the creation of a library with the filename lib in the directory
+  libDir on pool. Where possible the library is written directly (see
+  writeElfStub); otherwise its assembly source is written to libDir and the
+  compiler is run to build it. The result is delivered through a future
+  appended to jobs.
 
   Returns true on success, or false if:
   - libDir does not exist
   - elfSymbolInfo auxdata cannot be found for a symbol in syms
   - Symbols in the same SymbolGroup have inconsistent sizes
-  - The compiler returned an error when building the dummy .so
   */
   bool generateDummySO(const gtirb::Module& module, const std::string& libDir,
                        const std::string& lib,
-                       const std::vector<SymbolGroup>& syms) const;
+                       const std::vector<SymbolGroup>& syms, ProcessPool& pool,
+                       std::vector<std::future<int>>& jobs) const;
 
   /**
   Generate dummy stand-in libraries for .so files, so that original libraries
   are not needed to re-link the binary.
 
   Libraries are generated in the libDir directory. Appends compiler arguments
-  to libArgs required for linking with the generated libraries.
+  to libArgs required for linking with the generated libraries. The libraries
+  are built concurrently on pool; the caller must wait for the futures
+  appended to jobs (which return non-zero if the compiler failed) before
+  linking against them.
 
   Returns true on success, or false if:
   - generateDummySO fails (see its docstring for failure reasons)
@@ -77,15 +84,38 @@ private:
   bool prepareDummySOLibs(const gtirb::Context& Context,
                           const gtirb::Module& module,
                           const std::string& libDir,
-                          std::vector<std::string>& libArgs) const;
+                          std::vector<std::string>& libArgs, ProcessPool& pool,
+                          std::vector<std::future<int>>& jobs) const;
+  /**
+  Write module directly to the object file object, bypassing the assembler.
+
+  Returns false if native objects are disabled or the module cannot be
+  written directly; the module must then be printed and assembled instead.
+  */
+  bool writeNativeObject(gtirb::Context& context, gtirb::Module& module,
+                         TempFile& object) const;
   void addOrigLibraryArgs(const gtirb::Module& module,
                           std::vector<std::string>& args,
                           const std::string& location) const;
+
+  /// What one invocation of the compiler does with its inputs.
+  enum class CompilerStep {
+    Build,    ///< Assemble the sources, if any, and link the inputs.
+    Assemble, ///< Assemble one source into an object.
+  };
+
+  /**
+  Build the compiler arguments for one step of building the module. The
+  arguments given by the user and by the printing policy are passed to every
+  source once, whether the sources are assembled and linked together or
+  assembled separately.
+  */
   std::vector<std::string>
   buildCompilerArgs(std::string outputFilename,
-                    const std::vector<TempFile>& asmPath,
+                    const std::vector<std::string>& inputs,
                     gtirb::Context& context, gtirb::Module& module,
-                    const std::vector<std::string>& libArgs) const;
+                    const std::vector<std::string>& libArgs,
+                    CompilerStep step = CompilerStep::Build) const;
 
 public:
   /// Construct a ElfBinaryPrinter with the default configuration.
@@ -99,6 +129,8 @@ public:
         debug(debugFlag), useDummySO(dummySOFlag) {}
   virtual ~ElfBinaryPrinter() = default;
 
+  void addBuildToKey(CacheKey& Key,
+                     const gtirb::Module& Module) const override;
   int assemble(const std::string& outputFilename, gtirb::Context& context,
                gtirb::Module& mod) const override;
   int link(const std::string& outputFilename, gtirb::Context& context,
@@ -0,0 +1,151 @@
+//===- ElfObjectPrinter.hpp ---------------------------------------*- C++ ---//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_ELF_OBJECT_PRINTER_H
+#define GTIRB_PP_ELF_OBJECT_PRINTER_H
+
+#include "AttPrettyPrinter.hpp"
+#include "ElfObjectWriter.hpp"
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace gtirb_pprint {
+
+/// \brief Writes an x86-64 ELF module as a relocatable object, without going
+/// through the assembler.
+///
+/// The printer walks the module exactly as the AT&T printer does, so the same
+/// sections, blocks, and symbols are emitted, but instead of printing
+/// instructions and data for the assembler to re-encode, it copies their
+/// bytes from the byte intervals and turns symbolic expressions into
+/// relocations. CFI directives are encoded into .eh_frame.
+///
+/// Modules using features that have no direct equivalent here (TLS or GOT
+/// relocations other than GOTPCREL, uleb128 data, CFI personality routines,
+/// ...) are rejected, and should be printed and assembled instead.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API ElfObjectPrinter
+    : public AttPrettyPrinter {
+public:
+  ElfObjectPrinter(gtirb::Context& context, const gtirb::Module& module,
+                   const PrintingPolicy& policy);
+
+  /// Write the module to \p Path.
+  ///
+  /// Returns false, after logging why, if the module cannot be written
+  /// directly or the file cannot be written.
+  bool write(const std::string& Path);
+
+protected:
+  void printSectionHeader(std::ostream& os,
+                          const gtirb::Section& section) override;
+  void printSectionFooter(std::ostream& os,
+                          const gtirb::Section& section) override;
+  void printAlignment(std::ostream& OS, uint64_t Alignment) override;
+  void printBlockContents(std::ostream& os, const gtirb::CodeBlock& block,
+                          uint64_t offset) override;
+  void printBlockContents(std::ostream& os, const gtirb::DataBlock& block,
+                          uint64_t offset) override;
+  void printFunctionEnd(std::ostream& OS,
+                        const gtirb::Symbol& FunctionSymbol) override;
+  void printSymbolDefinition(std::ostream& os,
+                             const gtirb::Symbol& symbol) override;
+  void printSymbolDefinitionRelativeToPC(std::ostream& os,
+                                         const gtirb::Symbol& symbol,
+                                         gtirb::Addr pc) override;
+  void printIntegralSymbol(std::ostream& os,
+                           const gtirb::Symbol& symbol) override;
+  void printUndefinedSymbol(std::ostream& os,
+                            const gtirb::Symbol& symbol) override;
+
+private:
+  // A field of a section holding `(Sym1 - Sym2) / Scale + Addend` or, when
+  // there is no Sym2, `Sym1 + Addend` (minus the address of the field if
+  // PCRelative). Fixups are resolved once every symbol is defined.
+  struct Fixup {
+    size_t Section;
+    uint64_t Offset;
+    uint64_t Size;
+    const gtirb::Symbol* Sym1;
+    const gtirb::Symbol* Sym2;
+    int64_t Scale;
+    int64_t Addend;
+    bool PCRelative;
+    gtirb_bprint::ElfRelocationType Type;
+  };
+
+  // A frame description entry being built from CFI directives.
+  struct Frame {
+    size_t Section;
+    uint64_t Begin;
+    uint64_t End;
+    std::vector<uint8_t> Instructions;
+  };
+
+  gtirb_bprint::ElfObject Object;
+  std::map<std::string, size_t> SectionIndices;
+  std::optional<size_t> CurrentSection;
+
+  // Entries of Object.Symbols for the module's symbols and by name, the
+  // versioned aliases of the entries, and the section symbols.
+  std::map<const gtirb::Symbol*, size_t> SymbolIndices;
+  std::map<std::string, size_t> SymbolNames;
+  std::map<size_t, size_t> VersionAliases;
+  std::map<size_t, size_t> SectionSymbols;
+  std::vector<Fixup> Fixups;
+
+  std::vector<Frame> Frames;
+  std::optional<Frame> OpenFrame;
+  uint64_t FrameLocation = 0;
+  int64_t CfaOffset = 0;
+  std::vector<int64_t> CfaOffsetStack;
+
+  // The first reason found that the module cannot be written directly.
+  std::optional<std::string> Unsupported;
+
+  void unsupported(const std::string& Reason);
+  gtirb_bprint::ElfObjectSection& currentSection();
+  uint64_t sectionOffset();
+
+  size_t addSymbol(const gtirb::Symbol& Symbol,
+                   gtirb_bprint::ElfObjectSymbol Entry);
+  void defineSymbol(const gtirb::Symbol& Symbol,
+                    gtirb_bprint::ElfObjectSymbolKind Kind, uint64_t Value);
+  size_t symbolIndex(const gtirb::Symbol& Symbol);
+  size_t sectionSymbol(size_t Section);
+  const gtirb::Symbol* referenceTarget(const gtirb::Symbol* Symbol) const;
+  const gtirb_bprint::ElfObjectSymbol*
+  definition(const gtirb::Symbol* Symbol) const;
+
+  void addInstructionFixups(const gtirb::CodeBlock& Block, const cs_insn& Insn,
+                            uint64_t InsnOffset);
+  void addDataFixup(const gtirb::SymbolicExpression& Expr, uint64_t Offset,
+                    uint64_t Size);
+  void addFixup(const Fixup& F);
+  void addRelocation(size_t Section, uint64_t Offset,
+                     const gtirb::Symbol& Target,
+                     gtirb_bprint::ElfRelocationType Type, int64_t Addend);
+  bool patch(const Fixup& F, int64_t Value);
+  void resolveFixups();
+
+  void addCFIDirectives(const gtirb::Offset& Offset, uint64_t SectionOffset);
+  void addCFIDirective(const aux_data::CFIDirective& Directive,
+                       uint64_t SectionOffset);
+  void buildEhFrame();
+};
+
+} // namespace gtirb_pprint
+
+#endif // GTIRB_PP_ELF_OBJECT_PRINTER_H
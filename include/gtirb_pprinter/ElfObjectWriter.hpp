@@ -0,0 +1,98 @@
+//===- ElfObjectWriter.hpp ----------------------------------------*- C++ ---//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_ELF_OBJECT_WRITER_H
+#define GTIRB_PP_ELF_OBJECT_WRITER_H
+
+#include "Export.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gtirb_bprint {
+
+/// x86-64 relocation types (their R_X86_64_* values).
+enum class ElfRelocationType : uint32_t {
+  X86_64_64 = 1,
+  X86_64_PC32 = 2,
+  X86_64_PLT32 = 4,
+  X86_64_GOTPCREL = 9,
+  X86_64_32 = 10,
+  X86_64_32S = 11,
+  X86_64_16 = 12,
+  X86_64_8 = 14,
+  X86_64_PC64 = 24
+};
+
+/// Where a symbol of a relocatable object is defined.
+enum class ElfObjectSymbolKind { Undefined, Defined, Absolute, Common };
+
+/// A symbol of a relocatable object.
+struct ElfObjectSymbol {
+  std::string Name;
+  ElfObjectSymbolKind Kind = ElfObjectSymbolKind::Undefined;
+  // Index in ElfObject::Sections of the section defining the symbol (only for
+  // defined symbols).
+  size_t Section = 0;
+  // Offset in the section, absolute value, or alignment of a common symbol.
+  uint64_t Value = 0;
+  uint64_t Size = 0;
+  // The STT_*, STB_*, and STV_* values of the symbol.
+  uint8_t Type = 0;
+  uint8_t Binding = 0;
+  uint8_t Visibility = 0;
+};
+
+/// A relocation applied to a field of a section.
+struct ElfObjectRelocation {
+  uint64_t Offset = 0;
+  // Index in ElfObject::Symbols.
+  size_t Symbol = 0;
+  ElfRelocationType Type = ElfRelocationType::X86_64_64;
+  int64_t Addend = 0;
+};
+
+/// A section of a relocatable object.
+struct ElfObjectSection {
+  std::string Name;
+  // The SHT_* and SHF_* values of the section.
+  uint32_t Type = 0;
+  uint64_t Flags = 0;
+  uint64_t Alignment = 1;
+  // Contents of the section; empty for SHT_NOBITS sections, whose size is
+  // given by NoBitsSize instead.
+  std::vector<uint8_t> Contents;
+  uint64_t NoBitsSize = 0;
+  std::vector<ElfObjectRelocation> Relocations;
+};
+
+/// The contents of an x86-64 ELF relocatable object.
+struct ElfObject {
+  std::vector<ElfObjectSection> Sections;
+  std::vector<ElfObjectSymbol> Symbols;
+};
+
+/// Write \p Object to \p Path as an x86-64 ELF relocatable object.
+///
+/// Local symbols are placed before the others in .symtab, as the format
+/// requires; relocations are written to a .rela section for each section
+/// that has them.
+///
+/// Returns false if the file cannot be written.
+DEBLOAT_PRETTYPRINTER_EXPORT_API bool writeElfObject(const std::string& Path,
+                                                     const ElfObject& Object);
+
+} // namespace gtirb_bprint
+
+#endif // GTIRB_PP_ELF_OBJECT_WRITER_H
@@ -149,6 +149,12 @@ protected:
       const gtirb::ByteInterval::ConstSymbolicExpressionElement& SEE,
       uint64_t Size, std::optional<std::string> Type) override;
 
+  bool canSplitUnits() const override;
+  bool isLocalSymbol(const gtirb::Symbol& symbol) const override;
+  bool canCacheFunctions() const override;
+  void addSymbolToKey(gtirb_bprint::CacheKey& Key,
+                      const gtirb::Symbol& Symbol) const override;
+
   virtual void printHeader(std::ostream& /*os*/) override{};
 
   virtual void printSymbolHeader(std::ostream& os, const gtirb::Symbol& symbol);
@@ -0,0 +1,73 @@
+//===- ElfStubWriter.hpp ------------------------------------------*- C++ ---//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_ELF_STUB_WRITER_H
+#define GTIRB_PP_ELF_STUB_WRITER_H
+
+#include "Export.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gtirb_bprint {
+
+/// Machines for which stub shared objects can be written.
+enum class ElfStubMachine : uint16_t { X86 = 3, X86_64 = 62, AArch64 = 183 };
+
+/// Types of symbols in a stub shared object (their STT_* values).
+enum class ElfStubSymbolType : uint8_t {
+  NoType = 0,
+  Object = 1,
+  Func = 2,
+  GnuIFunc = 10
+};
+
+/// A symbol defined by a stub shared object.
+struct ElfStubSymbol {
+  std::string Name;
+  // Version the symbol is defined with, or empty if it is unversioned.
+  std::string Version;
+  // Whether the version is hidden (`sym@VER`) rather than the default
+  // (`sym@@VER`).
+  bool HiddenVersion = false;
+  ElfStubSymbolType Type = ElfStubSymbolType::NoType;
+  bool Weak = false;
+  // Value of st_size.
+  uint64_t Size = 0;
+};
+
+/// Symbols that share an address in a stub shared object.
+struct ElfStubGroup {
+  // Whether the symbols are placed in .text rather than .data.
+  bool Code = false;
+  // Number of bytes reserved for the group.
+  uint64_t Size = 0;
+  std::vector<ElfStubSymbol> Symbols;
+};
+
+/// Write a shared object named \p SoName to \p Path that defines the symbols
+/// of \p Groups.
+///
+/// The file only contains what a linker needs to link against the library:
+/// .dynsym, .dynstr, .hash, .gnu.version, .gnu.version_d, .dynamic (with
+/// DT_SONAME), and zero-filled .text and .data sections holding the symbols.
+///
+/// Returns false if the file cannot be written.
+DEBLOAT_PRETTYPRINTER_EXPORT_API bool
+writeElfStub(const std::string& Path, const std::string& SoName,
+             ElfStubMachine Machine, const std::vector<ElfStubGroup>& Groups);
+
+} // namespace gtirb_bprint
+
+#endif // GTIRB_PP_ELF_STUB_WRITER_H
@@ -15,9 +15,21 @@
 #ifndef GTIRB_FileUtils_H
 #define GTIRB_FileUtils_H
 
+#include "Export.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace gtirb_bprint {
@@ -56,6 +68,46 @@ public:
   const std::string& dirName() const { return Name; }
 };
 
+/// Destination of the buffers filled by an AsyncOutputStream. Both methods
+/// are only called from the stream's writer thread.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API OutputSink {
+public:
+  virtual ~OutputSink() = default;
+
+  /// Write a batch of buffers, in order. Returns false on error.
+  virtual bool write(const std::vector<std::string_view>& Buffers) = 0;
+
+  /// Flush and close the destination. Returns false on error.
+  virtual bool close() = 0;
+};
+
+/// An output stream that hands filled fixed-size buffers to a dedicated writer
+/// thread, so that formatting and I/O overlap. The number of buffers waiting
+/// to be written is bounded; the formatting thread blocks when the writer
+/// falls behind.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API AsyncOutputStream : public std::ostream {
+public:
+  explicit AsyncOutputStream(std::unique_ptr<OutputSink> Sink);
+  ~AsyncOutputStream();
+
+  bool isOpen() const;
+
+  /// Write all buffered output, close the sink and stop the writer thread.
+  /// Returns true if everything was written successfully.
+  bool close();
+
+private:
+  class Buffer;
+  std::unique_ptr<Buffer> Buf;
+};
+
+/// Open a file for writing through an AsyncOutputStream. If \p EstimatedSize
+/// is non-zero, space for the file is preallocated where the platform
+/// supports it; the file is truncated to its final size when it is closed.
+/// Returns nullptr if the file cannot be opened.
+DEBLOAT_PRETTYPRINTER_EXPORT_API std::unique_ptr<OutputSink>
+openFileSink(const std::string& Path, uint64_t EstimatedSize = 0);
+
 std::string replaceExtension(const std::string path, const std::string new_ext);
 
 // Helper functions to resolve symlinks and get a real path to a file.
@@ -63,13 +115,77 @@ std::optional<std::string> resolveRegularFilePath(const std::string& path);
 std::optional<std::string> resolveRegularFilePath(const std::string& path,
                                                   const std::string& fileName);
 
+/// An index of the files in library directories, so that finding the
+/// libraries of a module lists each directory once instead of probing it for
+/// every library.
+///
+/// Every name in a directory is indexed, including the symbolic links giving
+/// the soname and development names of a versioned library. A name is
+/// resolved to a regular file, as resolveRegularFilePath does, the first time
+/// it is found. Directories are listed when they are first searched and are
+/// not listed again, so an index should only be kept while the directories
+/// are not expected to change, e.g. for one link. It may be used
+/// concurrently.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API LibraryIndex {
+public:
+  /// Return the path of the file named \p Name in the first of \p Dirs
+  /// where it is, or links to, a regular file. Names with a directory, and
+  /// names in an empty directory path (the current directory), are looked up
+  /// directly instead of in the index.
+  std::optional<std::string> find(const std::vector<std::string>& Dirs,
+                                  const std::string& Name);
+
+private:
+  struct Entry {
+    bool Resolved = false;
+    std::optional<std::string> Path;
+  };
+  using Directory = std::unordered_map<std::string, Entry>;
+
+  Directory& scan(const std::string& Dir);
+
+  std::mutex Mutex;
+  std::unordered_map<std::string, Directory> Directories;
+};
+
 // Helper function to execute a process with arguments; will search for the
-// given tool on PATH automatically. If the tool cannot be found, the function
-// returns nullopt. Otherwise, the function returns the return code from
-// executing the tool.
+// given tool on PATH automatically (see ToolchainProbe::find). If the tool
+// cannot be found, the function returns nullopt. Otherwise, the function
+// returns the return code from executing the tool.
 std::optional<int> execute(const std::string& tool,
                            const std::vector<std::string>& args);
 
+/// A bounded pool of threads for running independent tool invocations
+/// concurrently, so that at most a fixed number of child processes run at the
+/// same time.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API ProcessPool {
+public:
+  /// Create a pool running at most \p Jobs tasks at a time. If \p Jobs is
+  /// zero, the number of hardware threads is used.
+  explicit ProcessPool(unsigned Jobs = 0);
+
+  /// Wait for all queued tasks to finish.
+  ~ProcessPool();
+
+  ProcessPool(const ProcessPool&) = delete;
+  ProcessPool& operator=(const ProcessPool&) = delete;
+
+  /// Queue a task, typically one or more calls to execute(), returning an
+  /// exit code.
+  std::future<int> submit(std::function<int()> Task);
+
+private:
+  void run();
+
+  unsigned MaxThreads;
+  std::vector<std::thread> Threads;
+  std::deque<std::packaged_task<int()>> Tasks;
+  std::mutex Mutex;
+  std::condition_variable Available;
+  unsigned Idle = 0;
+  bool Stopping = false;
+};
+
 // Helper function to copy files, creating parent directories as needed
 void copyFile(const std::string& src, const std::string& dest);
 
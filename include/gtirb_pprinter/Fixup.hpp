@@ -22,6 +22,7 @@ class Module;
 } // namespace gtirb
 
 namespace gtirb_pprint {
+class FixupOverlay;
 class PrettyPrinter;
 
 /// Transforms a GTIRB module to make it acceptable to
@@ -34,17 +35,20 @@ class PrettyPrinter;
 /// \param Ctx
 /// \param Mod
 /// \param Printer
-void DEBLOAT_PRETTYPRINTER_EXPORT_API applyFixups(gtirb::Context& Ctx,
-                                                  gtirb::Module& Mod,
-                                                  const PrettyPrinter& Printer);
+/// \param Overlay  If not null, records the changes so they can be discarded.
+void DEBLOAT_PRETTYPRINTER_EXPORT_API
+applyFixups(gtirb::Context& Ctx, gtirb::Module& Mod,
+            const PrettyPrinter& Printer, FixupOverlay* Overlay = nullptr);
 
 /// Turn any direct references to global symbols, which
 /// are illegal relocations in shared objects, into
 /// indirect references
-void fixupSharedObject(gtirb::Context& Ctx, gtirb::Module& Mod);
+void fixupSharedObject(gtirb::Context& Ctx, gtirb::Module& Mod,
+                       FixupOverlay* Overlay = nullptr);
 
 /// Ensure that PE entry symbols are correctly named
-void fixupPESymbols(gtirb::Context& Ctx, gtirb::Module& Mod);
+void fixupPESymbols(gtirb::Context& Ctx, gtirb::Module& Mod,
+                    FixupOverlay* Overlay = nullptr);
 
 /// Fixup ELF symbol bindings.
 ///
@@ -55,7 +59,8 @@ void fixupPESymbols(gtirb::Context& Ctx, gtirb::Module& Mod);
 ///
 /// - main (only necessary for --policy=dynamic, but we fixup unconditionally)
 /// - DT_INIT and DT_FINI functions
-void fixupELFSymbols(gtirb::Context& Ctx, gtirb::Module& Mod);
+void fixupELFSymbols(gtirb::Context& Ctx, gtirb::Module& Mod,
+                     FixupOverlay* Overlay = nullptr);
 
 } // namespace gtirb_pprint
 
@@ -0,0 +1,74 @@
+//===- FixupOverlay.hpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_PPRINTER_FIXUP_OVERLAY_H
+#define GT_PPRINTER_FIXUP_OVERLAY_H
+#include "Export.hpp"
+
+#include <gtirb/gtirb.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace gtirb_pprint {
+
+/// Records the changes that the fixups and the layout make to a module, so
+/// that they can be discarded and the module printed again under other
+/// options without reloading the IR.
+///
+/// The fixups report each change to the overlay before making it; the layout
+/// library does not know about overlays, so the state that it changes is
+/// saved with saveLayout() before it runs.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API FixupOverlay {
+public:
+  explicit FixupOverlay(gtirb::Module& M) : Module(M) {}
+
+  FixupOverlay(const FixupOverlay&) = delete;
+  FixupOverlay& operator=(const FixupOverlay&) = delete;
+
+  /// Save the addresses of the byte intervals and of the integral symbols of
+  /// the module, before \c fixIntegralSymbols or a layout changes them.
+  void saveLayout();
+
+  /// Record that \p Symbol was added to the module.
+  void addedSymbol(gtirb::Symbol& Symbol);
+
+  /// Record that \p Block was added to the module.
+  void addedProxyBlock(gtirb::ProxyBlock& Block);
+
+  /// Save the name and referent or address of \p Symbol before they change.
+  void changingSymbol(gtirb::Symbol& Symbol);
+
+  /// Save the ELF symbol information of \p Symbol before it changes.
+  void changingElfSymbolInfo(gtirb::Symbol& Symbol);
+
+  /// Save the symbolic expression at \p Offset of \p Interval before it is
+  /// replaced.
+  void changingSymbolicExpression(gtirb::ByteInterval& Interval,
+                                  uint64_t Offset);
+
+  /// Undo the recorded changes, the most recent first, and forget them.
+  void discard();
+
+  /// Whether no changes are recorded.
+  bool empty() const { return Undo.empty(); }
+
+private:
+  gtirb::Module& Module;
+  std::vector<std::function<void()>> Undo;
+};
+
+} // namespace gtirb_pprint
+
+#endif /* GT_PPRINTER_FIXUP_OVERLAY_H */
@@ -0,0 +1,121 @@
+//===- ListingSink.hpp ------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_LISTING_SINK_H
+#define GTIRB_PP_LISTING_SINK_H
+
+#include "Export.hpp"
+
+#include <gtirb/gtirb.hpp>
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gtirb_pprint {
+
+/// A symbolic expression in the bytes of an instruction or of data, with the
+/// names of its symbols as the printer would print them.
+struct SymbolicReference {
+  /// The offset of the expression from the start of the instruction or data.
+  uint64_t Offset = 0;
+  /// The symbol referenced.
+  std::string Symbol;
+  /// For a difference of symbols, the symbol subtracted from Symbol.
+  std::optional<std::string> Minus;
+  /// The scale of a difference of symbols; 1 otherwise.
+  int64_t Scale = 1;
+  int64_t Addend = 0;
+};
+
+/// An instruction of the listing.
+struct InstructionEvent {
+  gtirb::Addr Address;
+  /// The encoding of the instruction.
+  std::string_view Bytes;
+  std::string Mnemonic;
+  /// The operands, as they would be printed in the listing.
+  std::vector<std::string> Operands;
+  std::vector<SymbolicReference> References;
+};
+
+/// The contents of a data block, from an offset to its end.
+struct DataEvent {
+  gtirb::Addr Address;
+  uint64_t Size = 0;
+  /// The initialized bytes; the remaining Size - Bytes.size() bytes are zero.
+  std::string_view Bytes;
+  /// The encoding of the data from the `encodings` AuxData, if any, e.g.
+  /// "string" or "ascii".
+  std::optional<std::string> Type;
+  std::vector<SymbolicReference> References;
+};
+
+/// Receives the contents of a listing as structured events instead of text.
+///
+/// The events are produced in the order of the text listing: each section,
+/// then the symbols and contents of its printed blocks. Headers, footers,
+/// directives, and comments of the text listing have no events.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API ListingSink {
+public:
+  virtual ~ListingSink() = default;
+
+  virtual void onSection(const gtirb::Section& /* Section */) {}
+  /// A label for \p Symbol, printed as \p Name, at \p Address.
+  virtual void onSymbol(const gtirb::Symbol& /* Symbol */,
+                        std::string_view /* Name */,
+                        gtirb::Addr /* Address */) {}
+  virtual void onInstruction(const InstructionEvent& /* Instruction */) {}
+  virtual void onData(const DataEvent& /* Data */) {}
+};
+
+/// Writes each event as a compact JSON object on its own line:
+///
+///     {"type":"section","name":".text","address":4096,"size":16}
+///     {"type":"symbol","name":"main","address":4096}
+///     {"type":"instruction","address":4096,"bytes":"e8f7ffffff",
+///      "mnemonic":"call","operands":["foo"],
+///      "refs":[{"offset":1,"symbol":"foo","addend":0}]}
+///     {"type":"data","address":8192,"size":8,
+///      "refs":[{"offset":0,"symbol":"main","addend":0}]}
+///
+/// Bytes are written in hexadecimal. Data whose bytes are all zero only has a
+/// size, without "bytes".
+class DEBLOAT_PRETTYPRINTER_EXPORT_API JsonLinesSink : public ListingSink {
+public:
+  explicit JsonLinesSink(std::ostream& Stream) : Out(Stream) {}
+
+  void onSection(const gtirb::Section& Section) override;
+  void onSymbol(const gtirb::Symbol& Symbol, std::string_view Name,
+                gtirb::Addr Address) override;
+  void onInstruction(const InstructionEvent& Instruction) override;
+  void onData(const DataEvent& Data) override;
+
+private:
+  std::ostream& Out;
+
+  void writeReferences(const std::vector<SymbolicReference>& References);
+};
+
+/// Quote \p Text as a JSON string. Bytes that are not printable ASCII are
+/// escaped as the code points U+0000 to U+00FF, so that they can be
+/// recovered exactly.
+DEBLOAT_PRETTYPRINTER_EXPORT_API std::string jsonQuote(std::string_view Text);
+
+} // namespace gtirb_pprint
+
+#endif /* GTIRB_PP_LISTING_SINK_H */
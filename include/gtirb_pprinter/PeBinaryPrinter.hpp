@@ -33,6 +33,9 @@ public:
                   const std::vector<std::string>& ExtraCompileArgs,
                   const std::vector<std::string>& LibraryPaths);
 
+  void addBuildToKey(CacheKey& Key,
+                     const gtirb::Module& Module) const override;
+
   // Assemble a module but do not link the object.
   int assemble(const std::string& OutputFile, gtirb::Context& Context,
                gtirb::Module& Module) const override;
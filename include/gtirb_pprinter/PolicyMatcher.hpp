@@ -0,0 +1,119 @@
+//===- PolicyMatcher.hpp ----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_PPRINTER_POLICY_MATCHER_H
+#define GT_PPRINTER_POLICY_MATCHER_H
+#include "Export.hpp"
+
+#include <gtirb/gtirb.hpp>
+
+#include <bitset>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace gtirb_pprint {
+
+struct PrintingPolicy;
+
+/// Matches names against a set of names, some of which may be glob
+/// patterns, compiled once.
+///
+/// A name matches if it is one of the names, or if it matches one of the
+/// glob patterns, given as names starting with `glob:`. In the rest of a
+/// pattern, `*` matches any sequence of characters, `?` any character, and
+/// `[...]` any character of a set such as `[a-z_]`, or any character not in
+/// it if the set starts with `!` or `^`. Other names are matched exactly, so
+/// e.g. MSVC-decorated names starting with `?` are never patterns. Names
+/// matching one of the exceptions, in the same way, never match.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API NameMatcher {
+public:
+  NameMatcher() = default;
+  explicit NameMatcher(const std::unordered_set<std::string>& Names,
+                       const std::unordered_set<std::string>& Exceptions = {});
+
+  bool matches(const std::string& Name) const;
+
+  /// The prefix of the names matched as glob patterns.
+  static constexpr const char* PatternPrefix = "glob:";
+
+  /// Whether \p Name is matched as a glob pattern.
+  static bool isPattern(const std::string& Name);
+
+private:
+  // A glob compiled to the characters accepted at each position. Names not
+  // starting with its literal prefix are rejected without running it.
+  struct Glob {
+    struct Position {
+      bool Star = false;
+      std::bitset<256> Accepted;
+    };
+    std::string Prefix;
+    std::vector<Position> Positions;
+
+    explicit Glob(const std::string& Pattern);
+    bool matches(const std::string& Name) const;
+  };
+
+  struct NameSet {
+    std::unordered_set<std::string> Exact;
+    std::vector<Glob> Patterns;
+
+    explicit NameSet(const std::unordered_set<std::string>& Names = {});
+    bool contains(const std::string& Name) const;
+  };
+
+  NameSet Included, Excluded;
+};
+
+/// The decisions of a printing policy for the symbols and sections of a
+/// module, matched once when the printer needs them instead of each time a
+/// block or symbol is printed.
+///
+/// A compiled policy is immutable, and is shared by the printers created for
+/// the same module and policy.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API CompiledPolicy {
+public:
+  CompiledPolicy(const PrintingPolicy& Policy, const gtirb::Module& Module);
+
+  /// Whether the name of \p Symbol is one of the functions to skip.
+  bool isSkippedFunction(const gtirb::Symbol& Symbol) const;
+
+  /// Whether the name of \p Symbol is one of the symbols to skip.
+  bool isSkippedSymbol(const gtirb::Symbol& Symbol) const;
+
+  /// Whether \p Name, e.g. the name of a forwarded symbol, is one of the
+  /// symbols to skip.
+  bool isSkippedSymbolName(const std::string& Name) const {
+    return SymbolNames.matches(Name);
+  }
+
+  /// Whether the name of \p Section is one of the sections to skip.
+  bool isSkippedSection(const gtirb::Section& Section) const;
+
+private:
+  bool isSkippedFunctionName(const std::string& Name) const;
+
+  const gtirb::Module* Module;
+  NameMatcher FunctionNames, SymbolNames, SectionNames;
+  // The functions skipped by exact name, unless they are kept.
+  std::unordered_set<std::string> PrunedFunctionNames;
+  NameMatcher KeptFunctionNames;
+  std::unordered_set<const gtirb::Symbol*> SkippedFunctions, SkippedSymbols;
+  std::unordered_set<const gtirb::Section*> SkippedSections;
+};
+
+} // namespace gtirb_pprint
+
+#endif /* GT_PPRINTER_POLICY_MATCHER_H */
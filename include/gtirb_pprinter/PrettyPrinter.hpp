@@ -15,8 +15,11 @@
 #ifndef GTIRB_PP_PRETTY_PRINTER_H
 #define GTIRB_PP_PRETTY_PRINTER_H
 
+#include "ArtifactCache.hpp"
 #include "AuxDataUtils.hpp"
 #include "Export.hpp"
+#include "ListingSink.hpp"
+#include "PolicyMatcher.hpp"
 #include "Syntax.hpp"
 
 #include <gtirb/gtirb.hpp>
@@ -24,6 +27,7 @@
 #include <boost/range/any_range.hpp>
 #include <capstone/capstone.h>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <iosfwd>
 #include <list>
@@ -104,6 +108,11 @@ getModuleFileFormat(const gtirb::Module& module);
 DEBLOAT_PRETTYPRINTER_EXPORT_API std::string
 getModuleISA(const gtirb::Module& module);
 
+/// Return a rough estimate of the size in bytes of the assembly listing of a
+/// GTIRB module, suitable for preallocating output files.
+DEBLOAT_PRETTYPRINTER_EXPORT_API uint64_t
+estimateListingSize(const gtirb::Module& module);
+
 /// Set the default syntax for the given file formats, isas, and listing modes.
 DEBLOAT_PRETTYPRINTER_EXPORT_API bool
 setDefaultSyntax(std::initializer_list<std::string> formats,
@@ -121,7 +130,9 @@ getDefaultSyntax(const std::string& format, const std::string& isa,
 
 /// A set of options to give to PrettyPrinterBase's policy in one category.
 /// Essentially, contains whether or not a set of strings to skip is cleared,
-/// and what strings are added/removed from the set to skip.
+/// and what strings are added/removed from the set to skip. Strings starting
+/// with `glob:` are glob patterns, e.g. `glob:asan_*`; all others are exact
+/// names, even if they contain `*`, `?` or `[`. See NameMatcher.
 class DEBLOAT_PRETTYPRINTER_EXPORT_API PolicyOptions {
 public:
   void skip(const std::string& s) { Skip.insert(s); }
@@ -140,6 +151,14 @@ public:
     }
   }
 
+  /// Also add the strings to keep to \p k, so that they are kept even if
+  /// they match a pattern to skip.
+  void apply(std::unordered_set<std::string>& c,
+             std::unordered_set<std::string>& k) const {
+    apply(c);
+    k.insert(Keep.begin(), Keep.end());
+  }
+
 private:
   std::unordered_set<std::string> Skip, Keep;
   bool UseDefaults = true;
@@ -149,12 +168,23 @@ struct DEBLOAT_PRETTYPRINTER_EXPORT_API PrintingPolicy {
   /// Functions to avoid printing the contents and labels of.
   std::unordered_set<std::string> skipFunctions;
 
+  /// Functions to skip as well, by their exact names, e.g. those found
+  /// unreachable by --prune-unreachable. Unlike skipFunctions, these are
+  /// never matched as patterns.
+  std::unordered_set<std::string> prunedFunctions;
+
   /// Symbols to avoid printing the labels of.
   std::unordered_set<std::string> skipSymbols;
 
   /// Sections to avoid printing.
   std::unordered_set<std::string> skipSections;
 
+  /// Functions, symbols, and sections printed even if their names match a
+  /// pattern in the sets to skip above.
+  std::unordered_set<std::string> keepFunctions;
+  std::unordered_set<std::string> keepSymbols;
+  std::unordered_set<std::string> keepSections;
+
   /// These sections have a couple of special cases for data objects. They
   /// usually contain entries that need to be ignored (the compiler will add
   /// them again) and require special alignment of 8
@@ -217,6 +247,20 @@ public:
 
   /// Indicates whether symbol versions should be ignored (only for ELF).
   bool getIgnoreSymbolVersions() const { return IgnoreSymbolVersions; }
+
+  /// Set whether the functions that cannot be reached from the entry points
+  /// of a module are skipped, in addition to the functions skipped by the
+  /// policy; see findUnreachableFunctions.
+  void setPruneUnreachable(bool Value) { PruneUnreachable = Value; }
+
+  /// Indicates whether unreachable functions are skipped.
+  bool getPruneUnreachable() const { return PruneUnreachable; }
+
+  /// Reuse the text printed for unchanged functions from \p Cache, and store
+  /// the text of the others in it; see PrettyPrinterBase::setFunctionCache.
+  void setFunctionCache(std::shared_ptr<gtirb_bprint::ArtifactCache> Cache) {
+    FunctionCache = std::move(Cache);
+  }
   /// fixes up any direct references to global symbols, which
   /// are illegal relocations in shared objects.
   void fixupSharedObject(gtirb::Context& Ctx, gtirb::Module& Mod,
@@ -236,6 +280,81 @@ public:
   int print(std::ostream& Stream, gtirb::Context& Context,
             const gtirb::Module& Module) const;
 
+  /// Write the IR module directly to an x86-64 ELF relocatable object,
+  /// without going through the assembler.
+  ///
+  /// \param Path    the object file to write
+  /// \param Context context to use for allocating AuxData objects if needed
+  /// \param Module  the module to write
+  ///
+  /// \return 0 on success, or -1 if the module is not an x86-64 ELF module,
+  /// is not printed in assembler mode, or uses features that require the
+  /// assembler.
+  int writeObject(const std::string& Path, gtirb::Context& Context,
+                  const gtirb::Module& Module) const;
+
+  /// Create printers for the IR module split into separately assembled
+  /// compilation units; see PrettyPrinterBase::splitUnits.
+  ///
+  /// \param Context context to use for allocating AuxData objects if needed
+  /// \param Module  the module to pretty-print
+  /// \param Count   the maximum number of units
+  ///
+  /// \return a printer for each unit, in link order, or no printers if the
+  /// module cannot be printed. Modules that cannot be split get a single
+  /// printer for the whole listing.
+  std::vector<std::unique_ptr<PrettyPrinterBase>>
+  createUnitPrinters(gtirb::Context& Context, const gtirb::Module& Module,
+                     size_t Count) const;
+
+  /// Create a printer for the IR module, which may be kept to print parts of
+  /// the module repeatedly; see PrettyPrinterBase::printBlocks.
+  ///
+  /// \param Context context to use for allocating AuxData objects if needed
+  /// \param Module  the module to pretty-print
+  ///
+  /// \return the printer, or nullptr if the module cannot be printed.
+  std::unique_ptr<PrettyPrinterBase>
+  createPrinter(gtirb::Context& Context, const gtirb::Module& Module) const;
+
+  /// Pretty-print only the blocks of one function of the IR module, with
+  /// their symbols and alignment and the headers of their sections.
+  ///
+  /// The printer created for the module is kept, so that later calls for the
+  /// same module reuse what it computed about the module (e.g. the functions
+  /// and ambiguous symbols) as long as the configuration does not change.
+  /// Copies of this PrettyPrinter do not share kept printers.
+  ///
+  /// \param Stream   the stream to print to
+  /// \param Context  context to use for allocating AuxData objects if needed
+  /// \param Module   the module containing the function
+  /// \param Function the UUID of the function in the `functionBlocks` AuxData
+  ///
+  /// \return 0 on success, or -1 if the module cannot be printed or has no
+  /// such function.
+  int printFunction(std::ostream& Stream, gtirb::Context& Context,
+                    const gtirb::Module& Module,
+                    const gtirb::UUID& Function) const;
+
+  /// Pretty-print only the blocks of the IR module overlapping the addresses
+  /// from \p Begin up to \p End; see printFunction.
+  ///
+  /// \return 0 on success, or -1 if the module cannot be printed.
+  int printAddressRange(std::ostream& Stream, gtirb::Context& Context,
+                        const gtirb::Module& Module, gtirb::Addr Begin,
+                        gtirb::Addr End) const;
+
+  /// Send the listing of the IR module to \p Sink as structured events
+  /// (sections, labels, instructions, and data) instead of printing it.
+  ///
+  /// \param Sink    the sink receiving the events
+  /// \param Context context to use for allocating AuxData objects if needed
+  /// \param Module  the module to list
+  ///
+  /// \return 0 on success, or -1 if the module cannot be listed.
+  int printEvents(ListingSink& Sink, gtirb::Context& Context,
+                  const gtirb::Module& Module) const;
+
   PolicyOptions& functionPolicy() { return FunctionPolicy; }
   const PolicyOptions& functionPolicy() const { return FunctionPolicy; }
 
@@ -255,6 +374,11 @@ public:
   bool namedPolicyExists(const std::string& Name) const;
   const PrintingPolicy& getPolicy(const gtirb::Module& Module) const;
 
+  /// Return the names of the sections of \p Module skipped by the policy,
+  /// with the section options applied.
+  std::unordered_set<std::string>
+  skippedSections(const gtirb::Module& Module) const;
+
   /// Update BinaryType aux_data for the given module
   void updateDynMode(gtirb::Module& Module, const std::string& SharedOption);
   /// Lookup BinaryType aux_data for the given module
@@ -268,8 +392,39 @@ private:
   PolicyOptions FunctionPolicy, SymbolPolicy, SectionPolicy, ArraySectionPolicy;
   std::string PolicyName = "default";
   bool IgnoreSymbolVersions = false;
+  bool PruneUnreachable = false;
+  std::shared_ptr<gtirb_bprint::ArtifactCache> FunctionCache;
+
+  // A printer kept by printFunction and printAddressRange, with the
+  // configuration it was created with.
+  struct KeptPrinter {
+    TargetTy Target;
+    PrintingPolicy Policy;
+    std::shared_ptr<gtirb_bprint::ArtifactCache> Cache;
+    std::unique_ptr<PrettyPrinterBase> Printer;
+  };
+  // The kept printers of each module, and the unreachable functions found
+  // for PruneUnreachable; copies start without any.
+  struct ModuleCaches {
+    ModuleCaches() = default;
+    ModuleCaches(const ModuleCaches&) {}
+    ModuleCaches& operator=(const ModuleCaches&) {
+      Printers.clear();
+      UnreachableFunctions.clear();
+      return *this;
+    }
+    std::map<const gtirb::Module*, KeptPrinter> Printers;
+    std::map<const gtirb::Module*, std::unordered_set<std::string>>
+        UnreachableFunctions;
+  };
+  mutable ModuleCaches Caches;
 
   PrettyPrinterFactory& getFactory(const gtirb::Module& Module) const;
+  PrintingPolicy configurePolicy(const gtirb::Module& Module) const;
+  const std::unordered_set<std::string>&
+  unreachableFunctions(const gtirb::Module& Module) const;
+  PrettyPrinterBase* keptPrinter(gtirb::Context& Context,
+                                 const gtirb::Module& Module) const;
 };
 
 /// Abstract factory - encloses default printing configuration and a method for
@@ -309,6 +464,25 @@ private:
   NamedPolicyMap NamedPolicies;
 };
 
+/// A split of a module's listing into compilation units that are assembled
+/// separately and linked in order.
+///
+/// Each unit is a contiguous range of the printed blocks, so every section
+/// keeps its order once the units are linked. Units begin at section or
+/// function boundaries; symbols defined in one unit and referenced from
+/// another are printed as hidden globals, under unique names.
+struct DEBLOAT_PRETTYPRINTER_EXPORT_API CompilationUnits {
+  /// Where each unit after the first begins: the index of a section in
+  /// Module::sections() and of a block in Section::blocks().
+  std::vector<std::pair<size_t, size_t>> Starts;
+
+  /// Local symbols referenced across units, and the names they are printed
+  /// with.
+  std::map<const gtirb::Symbol*, std::string> Promoted;
+
+  size_t size() const { return Starts.size() + 1; }
+};
+
 /// The pretty-printer interface. There is only one exposed function, \link
 /// print().
 class DEBLOAT_PRETTYPRINTER_EXPORT_API PrettyPrinterBase {
@@ -319,6 +493,62 @@ public:
 
   virtual std::ostream& print(std::ostream& out);
 
+  /// Selects blocks to print with printBlocks().
+  using BlockFilter = std::function<bool(const gtirb::Node& Block)>;
+
+  /// Print only the blocks accepted by \p Filter, with their symbols and
+  /// alignment and the headers of the sections containing them, but without
+  /// the header and footer of the listing.
+  ///
+  /// Unlike print(), this may be called any number of times, reusing the
+  /// module-level information the printer computed when it was created.
+  std::ostream& printBlocks(std::ostream& out, const BlockFilter& Filter);
+
+  /// Print the blocks of the function \p Function as printBlocks() does.
+  ///
+  /// Returns false if the module has no such function.
+  bool printFunction(std::ostream& out, const gtirb::UUID& Function);
+
+  /// Print the blocks overlapping the addresses from \p Begin up to \p End
+  /// as printBlocks() does.
+  void printAddressRange(std::ostream& out, gtirb::Addr Begin,
+                         gtirb::Addr End);
+
+  /// Send the contents of the listing to \p Sink instead of printing them;
+  /// see ListingSink. Like printBlocks(), this may be called any number of
+  /// times.
+  void printEvents(ListingSink& Sink);
+
+  /// Split the listing into at most \p Count compilation units of about the
+  /// same size. Units are only split where the assembler does not need to
+  /// see both sides together: never inside a function or a CFI frame, nor
+  /// between a label difference and the labels it needs.
+  ///
+  /// Returns a single unit if the printer cannot split its listing.
+  std::shared_ptr<const CompilationUnits> splitUnits(size_t Count) const;
+
+  /// Print only unit \p Unit of \p Units, computed by splitUnits on a
+  /// printer for the same module and policy.
+  void setCompilationUnit(std::shared_ptr<const CompilationUnits> Units,
+                          size_t Unit);
+
+  /// Cache the text printed for each function in \p Cache.
+  ///
+  /// Functions are looked up by a hash of everything their text depends on
+  /// (their blocks' bytes, symbolic expressions, symbols, CFI directives and
+  /// alignment, and the printer and policy), so the text of functions that
+  /// did not change since a previous run is copied instead of printed again.
+  /// Only assembler listings of printers supporting it are cached.
+  void setFunctionCache(std::shared_ptr<gtirb_bprint::ArtifactCache> Cache);
+
+  /// The decisions of the printer's policy for the symbols and sections of
+  /// the module, compiled when first needed.
+  const std::shared_ptr<const CompiledPolicy>& compiledPolicy() const;
+
+  /// Use \p Compiled, returned by compiledPolicy on a printer for the same
+  /// module and policy, instead of compiling the policy again.
+  void setCompiledPolicy(std::shared_ptr<const CompiledPolicy> Compiled);
+
 protected:
   const Syntax& syntax;
   PrintingPolicy policy;
@@ -374,6 +604,11 @@ protected:
   // x86-specific fixups helper.
   void x86FixupInstruction(cs_insn& inst);
 
+  /// Print an instruction of a block with printInstruction(), or send it to
+  /// the sink of printEvents() if there is one.
+  void emitInstruction(std::ostream& os, const gtirb::CodeBlock& block,
+                       const cs_insn& inst, const gtirb::Offset& offset);
+
   /// Print a single instruction to the stream. This implementation prints the
   /// mnemonic provided by Capstone, then calls printOperandList(). Thus, it is
   /// probably sufficient for most subclasses to configure Capstone to produce
@@ -433,6 +668,16 @@ protected:
 
   virtual void printOperand(std::ostream& os, const gtirb::CodeBlock& block,
                             const cs_insn& inst, uint64_t index);
+
+  /// Print an operand of an operand list with printOperand(). While
+  /// emitInstruction() sends the instruction to a sink, the text of each
+  /// operand printed this way becomes an operand of the event; it must be
+  /// used by the operand loops of printOperandList() overrides.
+  void printListedOperand(std::ostream& os, const gtirb::CodeBlock& block,
+                          const cs_insn& inst, uint64_t index);
+  /// Print an operand that printOperandList() formats itself, such as a
+  /// condition code, and list it like printListedOperand() does.
+  void printListedOperand(std::ostream& os, const std::string& Text);
   virtual void printOpRegdirect(std::ostream& os, const cs_insn& inst,
                                 uint64_t index) = 0;
   virtual void printOpImmediate(std::ostream& os,
@@ -487,20 +732,53 @@ protected:
 
   std::optional<uint64_t> getAlignment(gtirb::Addr Addr) const;
 
-  bool shouldSkip(const PrintingPolicy& Policy,
-                  const gtirb::Section& section) const;
-  bool shouldSkip(const PrintingPolicy& Policy,
-                  const gtirb::Symbol& symbol) const;
-  bool shouldSkip(const PrintingPolicy& Policy,
-                  const gtirb::CodeBlock& block) const;
-  bool shouldSkip(const PrintingPolicy& Policy,
-                  const gtirb::DataBlock& block) const;
+  /// The compiled decisions of the printer's policy.
+  const CompiledPolicy& decisions() const;
+
+  bool shouldSkip(const gtirb::Section& section) const;
+  bool shouldSkip(const gtirb::Symbol& symbol) const;
+  bool shouldSkip(const gtirb::CodeBlock& block) const;
+  bool shouldSkip(const gtirb::DataBlock& block) const;
+
+  /// Whether the listing may be split into compilation units.
+  virtual bool canSplitUnits() const { return false; }
+
+  /// Whether a symbol is only visible in the unit defining it.
+  virtual bool isLocalSymbol(const gtirb::Symbol& /* symbol */) const {
+    return true;
+  }
+
+  /// The compilation unit being printed, if the listing is split.
+  std::shared_ptr<const CompilationUnits> Units;
+  size_t UnitIndex = 0;
+
+  /// Whether the text printed for functions may be cached. Printers keeping
+  /// state across functions, other than the program counter and the open CFI
+  /// frame, must not allow it.
+  virtual bool canCacheFunctions() const { return false; }
+
+  /// Add everything the printed references to and definitions of \p Symbol
+  /// depend on to a function's cache key.
+  virtual void addSymbolToKey(gtirb_bprint::CacheKey& Key,
+                              const gtirb::Symbol& Symbol) const;
 
 private:
   gtirb::Addr programCounter;
 
   std::optional<gtirb::Addr> CFIStartProc;
 
+  // The blocks being printed by printBlocks(), if any.
+  const BlockFilter* SelectedBlocks = nullptr;
+
+  // The sink receiving the listing in printEvents(), if any.
+  ListingSink* Sink = nullptr;
+
+  // The operands of the instruction being sent to the sink, if any.
+  std::vector<std::string>* ListedOperands = nullptr;
+
+  // The compiled policy, shared by the printers of the units of a module.
+  mutable std::shared_ptr<const CompiledPolicy> Compiled;
+
   // When emitting end-of-line comments, what is the preferred (minimum) column
   // position to use?
   const size_t PreferredEOLCommentPos;
@@ -512,6 +790,24 @@ private:
   template <typename BlockType>
   std::optional<uint64_t> getAlignmentImpl(const BlockType& Block);
 
+  std::shared_ptr<gtirb_bprint::ArtifactCache> FunctionCache;
+  // What the text of every function depends on besides its own contents.
+  std::string FunctionCacheSalt;
+  size_t CachedFunctions = 0;
+  size_t PrintedFunctions = 0;
+
+  void printNode(std::ostream& OS, const gtirb::Node& Node);
+  void printLabel(std::ostream& OS, const gtirb::Symbol& Symbol);
+  void emitData(const gtirb::DataBlock& Block, uint64_t Offset);
+  std::vector<SymbolicReference>
+  symbolicReferences(const gtirb::ByteInterval& BI, uint64_t Start,
+                     uint64_t Size) const;
+  void printFunctionBlocks(std::ostream& OS,
+                           const std::vector<const gtirb::Node*>& Blocks);
+  std::string functionKey(const std::vector<const gtirb::Node*>& Blocks);
+  template <typename BlockType>
+  void addBlockToKey(gtirb_bprint::CacheKey& Key, const BlockType& Block);
+
   static bool x86InstHasMoffsetEncoding(const cs_insn& inst);
 
   /** Populate Function-related fields.*/
@@ -527,8 +823,7 @@ private:
 
   // A function is skipped if its name or any of its aliases are
   // in the function skip policy.
-  bool isFunctionSkipped(const PrintingPolicy& Policy,
-                         const gtirb::Symbol& FunctionSymbol) const;
+  bool isFunctionSkipped(const gtirb::Symbol& FunctionSymbol) const;
 
   /** Mapping from function UUIDs to the symbols that define the function
    * name.*/
@@ -554,6 +849,8 @@ protected:
       FunctionAliases;
 
   std::map<const gtirb::Symbol*, std::string> AmbiguousSymbols;
+  /** Range of block indices of each section printed in this unit.*/
+  std::map<const gtirb::Section*, std::pair<size_t, size_t>> UnitBlocks;
   std::string m_accum_comment;
   static std::string s_symaddr_0_warning(uint64_t symAddr);
 };
@@ -0,0 +1,34 @@
+//===- PrintError.hpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_PPRINTER_PRINT_ERROR_H
+#define GT_PPRINTER_PRINT_ERROR_H
+#include "Export.hpp"
+
+#include <stdexcept>
+
+namespace gtirb_pprint {
+
+/// Thrown when a module cannot be printed, e.g. because an instruction does
+/// not decode or has an operand that cannot be printed. Only the module being
+/// printed is abandoned, so a caller printing several IRs in one process can
+/// go on with the others.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API PrintError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+} // namespace gtirb_pprint
+
+#endif /* GT_PPRINTER_PRINT_ERROR_H */
@@ -0,0 +1,45 @@
+//===- Reachability.hpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_PPRINTER_REACHABILITY_H
+#define GT_PPRINTER_REACHABILITY_H
+#include "Export.hpp"
+
+#include <gtirb/gtirb.hpp>
+
+#include <string>
+#include <unordered_set>
+
+namespace gtirb_pprint {
+
+/// Find the functions of an ELF or PE module that cannot be reached from its
+/// entry points.
+///
+/// The entry points are the entry block of the module, `_start`, `_init`,
+/// and `_fini`, the exported symbols, the PE exception handlers, the symbols
+/// of CFI directives, and every symbol referenced from data, which includes
+/// `.init_array` and `.fini_array` and the address-taken blocks stored in
+/// data. A function is reached if one of its blocks is the target of a CFG
+/// edge from a reached block, or is referenced by a symbolic expression of a
+/// reached block. Code blocks outside of functions are reached.
+///
+/// \return the names of the unreachable functions that are not also the name
+/// of a reachable function, or no names if the module has no functions or is
+/// neither ELF nor PE.
+DEBLOAT_PRETTYPRINTER_EXPORT_API std::unordered_set<std::string>
+findUnreachableFunctions(const gtirb::Module& Module);
+
+} // namespace gtirb_pprint
+
+#endif /* GT_PPRINTER_REACHABILITY_H */
@@ -0,0 +1,71 @@
+//===- ToolchainProbe.hpp -----------------------------------------*- C++ ---//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_TOOLCHAIN_PROBE_H
+#define GTIRB_PP_TOOLCHAIN_PROBE_H
+
+#include "Export.hpp"
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace gtirb_bprint {
+
+/// Locates the tools run by the binary printers, and queries them, once per
+/// process.
+///
+/// Results are memoized for the value of PATH they were found with. They may
+/// also be saved to a file and loaded by later runs; loaded results are only
+/// used while the tools, and the directories on PATH searched before them,
+/// are unchanged.
+class DEBLOAT_PRETTYPRINTER_EXPORT_API ToolchainProbe {
+public:
+  /// The probe shared by all binary printers.
+  static ToolchainProbe& instance();
+
+  /// Return the path to \p Tool: \p Tool itself if it names a file, or
+  /// else the first program of that name on PATH.
+  std::optional<std::string> find(const std::string& Tool);
+
+  /// Return the first line printed by running \p Tool with \p Args (e.g.
+  /// `--version`), or nothing if the tool cannot be found or fails.
+  std::optional<std::string> query(const std::string& Tool,
+                                   const std::vector<std::string>& Args);
+
+  /// Load the results saved to \p Path by a previous run.
+  bool load(const std::string& Path);
+
+  /// Save the results of this and previous runs to \p Path.
+  bool save(const std::string& Path) const;
+
+private:
+  struct Entry {
+    std::optional<std::string> Result;
+    // Identifies the files the result was derived from.
+    std::string Stamp;
+    // Whether the stamp was checked in this process.
+    bool Checked = false;
+  };
+
+  mutable std::mutex Mutex;
+  std::map<std::string, Entry> Entries;
+
+  std::optional<std::string> findLocked(const std::string& Tool);
+};
+
+} // namespace gtirb_bprint
+
+#endif // GTIRB_PP_TOOLCHAIN_PROBE_H
@@ -1,8 +1,9 @@
 import importlib.resources as native_importlib_resources
+import os
 import pathlib
 import platform
 from contextlib import contextmanager
-from typing import Iterator
+from typing import Iterator, Optional, Union
 
 from .version import __version__
 
@@ -12,7 +13,7 @@ else:
     import importlib_resources  # type: ignore
 
 
-__all__ = ["pprinter_path", "__version__"]
+__all__ = ["pprinter_path", "print_assembly", "__version__"]
 
 
 @contextmanager
@@ -29,3 +30,43 @@ def pprinter_path() -> Iterator[pathlib.Path]:
     template_path = importlib_resources.files(__package__) / executable_name
     with importlib_resources.as_file(template_path) as actual_path:
         yield actual_path
+
+
+def print_assembly(
+    ir: Union[bytes, bytearray, memoryview, str, os.PathLike],
+    output: Optional[Union[str, os.PathLike]] = None,
+    *,
+    module: Optional[str] = None,
+    syntax: Optional[str] = None,
+    listing_mode: Optional[str] = None,
+) -> Optional[bytes]:
+    """
+    Prints the assembly for a module of an IR in this process, without
+    running the gtirb-pprinter executable. The GIL is released while
+    loading and printing the IR.
+
+    This requires the native extension, which is only built when
+    gtirb-pprinter is configured with GTIRB_PPRINTER_PYTHON_EXTENSION=ON.
+
+    :param ir: The serialized IR, or the path to a GTIRB file. Either may be
+        gzip or zstd compressed.
+    :param output: The path of the assembly file to write. If omitted, the
+        assembly is returned instead.
+    :param module: The name of the module to print. Defaults to the first
+        module of the IR.
+    :param syntax: The syntax to print, as for `--syntax`.
+    :param listing_mode: The listing mode, as for `--listing-mode`.
+    :returns: The assembly, or None if it was written to `output`.
+    :raises ImportError: If the native extension was not built.
+    """
+    from . import _native  # type: ignore
+
+    options = dict(
+        output=os.fspath(output) if output is not None else "",
+        module=module or "",
+        syntax=syntax or "",
+        listing_mode=listing_mode or "",
+    )
+    if isinstance(ir, (bytes, bytearray, memoryview)):
+        return _native.print_bytes(ir, **options)
+    return _native.print_file(os.fspath(ir), **options)
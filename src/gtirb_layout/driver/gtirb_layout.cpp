@@ -23,6 +23,9 @@ int main(int argc, char** argv) {
   desc.add_options()("out,o", po::value<std::string>()->required(),
                      "Output GTIRB file.");
   desc.add_options()("remove,r", "Remove layout instead of adding it.");
+  desc.add_options()("incremental",
+                     "Only move the byte intervals that have no address or "
+                     "overlap others, keeping the others in place.");
 
   po::positional_options_description pd;
   pd.add("in", 1);
@@ -44,6 +47,11 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (vm.count("incremental") != 0 && vm.count("remove") != 0) {
+    LOG_ERROR << "--incremental cannot be used with --remove." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   gtirb::Context ctx;
   gtirb::IR* ir = nullptr;
 
@@ -71,7 +79,10 @@ int main(int argc, char** argv) {
   if (vm.count("remove") == 0) {
     for (auto& M : ir->modules()) {
       LOG_INFO << "Laying out module " << M.getUUID() << "..." << std::endl;
-      if (!gtirb_layout::layoutModule(ctx, M)) {
+      bool laidOut = vm.count("incremental") != 0
+                         ? gtirb_layout::layoutModuleIncremental(ctx, M)
+                         : gtirb_layout::layoutModule(ctx, M);
+      if (!laidOut) {
         LOG_ERROR << "Laying out module failed!" << std::endl;
         return EXIT_FAILURE;
       }
@@ -14,8 +14,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "gtirb_layout.hpp"
+#include "driver/Logger.h"
+#include <boost/uuid/uuid_io.hpp>
 #include <gtirb/gtirb.hpp>
-#include <set>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace gtirb;
 using namespace gtirb_layout;
@@ -25,62 +32,113 @@ void ::gtirb_layout::registerAuxDataTypes() {
   gtirb::AuxDataContainer::registerAuxDataType<Alignment>();
 }
 
-/// Return the CFG containing the given block.
+/// The ByteIntervals of the sections of a module, with the fallthrough
+/// predecessor of each.
 ///
-/// \param CB  CodeBlock to get the CFG for.
+/// Intervals are identified by their ordinal: their index in the sections and
+/// intervals of the module, in the order they were indexed in. The index
+/// holds pointers to the intervals, so it stays valid when their addresses
+/// change.
+struct FallthroughIndex {
+  static constexpr size_t None = std::numeric_limits<size_t>::max();
+
+  /// The intervals of section I are Intervals[SectionBegin[I]] up to
+  /// Intervals[SectionBegin[I + 1]].
+  std::vector<ByteInterval*> Intervals;
+  std::vector<size_t> SectionBegin;
+  /// The ordinal of the interval that falls through to each interval, or
+  /// None.
+  std::vector<size_t> Predecessor;
+  /// Whether malformed fallthrough edges were found (and ignored).
+  bool Malformed = false;
+};
+
+/// Index the fallthrough predecessors of the ByteIntervals in a module, in one
+/// pass over the edges of the CFG.
 ///
-/// \return the CFG containing the given block or \c nullptr if the CFG does
-/// not exist.
-static CFG* getCFG(CodeBlock* CB) {
-  if (auto* BI = CB->getByteInterval())
-    if (auto* S = BI->getSection())
-      if (auto* M = S->getModule())
-        if (auto* Ir = M->getIR())
-          return &Ir->getCFG();
-  return nullptr;
-}
-
-/// Find the ByteInterval, if any, that falls through to the given interval.
-///
-/// Assumes that at most one fallthrough edge from another byte interval to
-/// the given interval exists, that the source of that edge is the last block
-/// in its byte interval, and that the target of that edge is the first block
-/// in the given byte interval. Also assumes that both byte intervals are in
-/// the same section. Some of these assumptions are checked by assertion.
+/// An interval's predecessor is the interval containing the source of a
+/// fallthrough edge to its first code block. The source must be the last code
+/// block of an interval in the same section, and each interval may have a
+/// single predecessor; other fallthrough edges to a first code block cannot be
+/// kept by the layout, so they are reported and ignored.
 ///
-/// \param TargetBI  ByteInterval to find the predecessor for.
+/// \param M  Module containing the ByteIntervals to index.
 ///
-/// \return a ByteInterval that contains the source of a fallthrough edge that
-/// targets the given ByteInterval, or \c nullptr if no such source could be
-/// found.
-static ByteInterval* getPredecessorByteInterval(ByteInterval& TargetBI) {
-  if (!TargetBI.code_blocks().empty()) {
-    CodeBlock& Target = TargetBI.code_blocks().front();
-    if (CFG* Cfg = getCFG(&Target)) {
-      auto U = *getVertex(&Target, *Cfg);
-      for (auto E : boost::make_iterator_range(in_edges(U, *Cfg))) {
-        if (EdgeLabel Label = (*Cfg)[E];
-            Label && std::get<EdgeType>(*Label) == EdgeType::Fallthrough) {
-          CodeBlock* Source = dyn_cast<CodeBlock>((*Cfg)[source(E, *Cfg)]);
-
-          // FIXME: These are not really safe assumptions; user-provided IR may
-          // violate them. We should report an error to the caller rather than
-          // failing an assertion if they're violated.
-
-          assert(Source && "Code block has fallthrough edge from proxy block!");
-
-          ByteInterval* SourceBI = Source->getByteInterval();
-          assert(SourceBI && SourceBI->getSection() == TargetBI.getSection() &&
-                 "Block has fallthrough edge from a block in another section!");
-          assert(Source == &SourceBI->code_blocks().back() &&
-                 "fallthrough edge exists, but source is not at end of "
-                 "interval!");
-          return SourceBI;
-        }
-      }
+/// \return the index of the intervals of the module.
+static FallthroughIndex indexFallthroughs(Module& M) {
+  FallthroughIndex Index;
+  std::unordered_map<const ByteInterval*, size_t> Ordinals;
+  for (Section& S : M.sections()) {
+    Index.SectionBegin.push_back(Index.Intervals.size());
+    for (ByteInterval& BI : S.byte_intervals()) {
+      Ordinals.emplace(&BI, Index.Intervals.size());
+      Index.Intervals.push_back(&BI);
     }
   }
-  return nullptr;
+  Index.SectionBegin.push_back(Index.Intervals.size());
+  Index.Predecessor.assign(Index.Intervals.size(), FallthroughIndex::None);
+
+  const IR* Ir = M.getIR();
+  if (!Ir) {
+    return Index;
+  }
+
+  auto reportMalformed = [&Index](const ByteInterval& Target,
+                                  const char* Problem) {
+    LOG_ERROR << "Ignoring a fallthrough edge into the byte interval "
+              << Target.getUUID() << " of section "
+              << Target.getSection()->getName() << ": " << Problem << "\n";
+    Index.Malformed = true;
+  };
+
+  const CFG& Cfg = Ir->getCFG();
+  for (auto E : boost::make_iterator_range(edges(Cfg))) {
+    if (EdgeLabel Label = Cfg[E];
+        !Label || std::get<EdgeType>(*Label) != EdgeType::Fallthrough) {
+      continue;
+    }
+    const auto* Target = dyn_cast<CodeBlock>(Cfg[target(E, Cfg)]);
+    if (!Target) {
+      continue;
+    }
+    const ByteInterval* TargetBI = Target->getByteInterval();
+    auto TargetIt = Ordinals.find(TargetBI);
+    if (TargetIt == Ordinals.end()) {
+      // The edge is in another module.
+      continue;
+    }
+    if (Target != &TargetBI->code_blocks().front()) {
+      // Only fallthroughs into an interval constrain the layout.
+      continue;
+    }
+    const auto* Source = dyn_cast<CodeBlock>(Cfg[source(E, Cfg)]);
+    if (!Source) {
+      reportMalformed(*TargetBI, "its source is a proxy block");
+      continue;
+    }
+    const ByteInterval* SourceBI = Source->getByteInterval();
+    if (SourceBI == TargetBI) {
+      continue;
+    }
+    auto SourceIt = Ordinals.find(SourceBI);
+    if (SourceIt == Ordinals.end() ||
+        SourceBI->getSection() != TargetBI->getSection()) {
+      reportMalformed(*TargetBI, "its source is in another section");
+      continue;
+    }
+    if (Source != &SourceBI->code_blocks().back()) {
+      reportMalformed(*TargetBI, "its source is not the last code block");
+      continue;
+    }
+    size_t& Predecessor = Index.Predecessor[TargetIt->second];
+    if (Predecessor != FallthroughIndex::None &&
+        Predecessor != SourceIt->second) {
+      reportMalformed(*TargetBI, "another interval already falls through");
+      continue;
+    }
+    Predecessor = SourceIt->second;
+  }
+  return Index;
 }
 
 bool ::gtirb_layout::layoutRequired(
@@ -139,6 +197,30 @@ bool ::gtirb_layout::layoutRequired(IR& Ir) {
 #pragma warning(disable : 4702) // unreachable code
 #endif
 
+/// The offset and size of a block in its ByteInterval.
+static std::pair<uint64_t, uint64_t> blockExtent(const Node& Block) {
+  if (const auto* CB = dyn_cast<CodeBlock>(&Block)) {
+    return {CB->getOffset(), CB->getSize()};
+  }
+  if (const auto* DB = dyn_cast<DataBlock>(&Block)) {
+    return {DB->getOffset(), DB->getSize()};
+  }
+  assert(!"found non-block in block iterator!");
+  return {0, 0};
+}
+
+/// Where an integral symbol will refer to: an existing block, or a new
+/// 0-length block at an offset of an interval.
+struct IntegralReferent {
+  Symbol* Sym;
+  /// The position of the interval in the address-sorted intervals.
+  size_t Interval;
+  uint64_t Offset;
+  Node* Block = nullptr;
+  /// Whether a new block is a CodeBlock rather than a DataBlock.
+  bool Code = false;
+};
+
 void ::gtirb_layout::fixIntegralSymbols(gtirb::Context& Ctx, gtirb::Module& M) {
   // In general, we want as many integral symbols to not be integral as
   // possible. If they point to blocks, even 0-length ones, instead of raw
@@ -146,83 +228,157 @@ void ::gtirb_layout::fixIntegralSymbols(gtirb::Context& Ctx, gtirb::Module& M) {
   // addresses later in the layout process. This also removes the need
   // for the pretty-printer to check if it needs to print a symbol every time
   // the program counter increments.
+  //
+  // The symbols are resolved in one sweep over the symbols and the intervals,
+  // both sorted by address, instead of looking up each symbol's address.
   std::vector<Symbol*> IntSyms;
   for (auto& Sym : M.symbols()) {
     if (!Sym.hasReferent() && Sym.getAddress()) {
       IntSyms.push_back(&Sym);
     }
   }
+  if (IntSyms.empty()) {
+    return;
+  }
+  auto symbolAddr = [](const Symbol* Sym) { return *Sym->getAddress(); };
+  std::stable_sort(IntSyms.begin(), IntSyms.end(),
+                   [&](const Symbol* L, const Symbol* R) {
+                     return symbolAddr(L) < symbolAddr(R);
+                   });
+
+  std::vector<ByteInterval*> Intervals;
+  for (auto& BI : M.byte_intervals()) {
+    if (BI.getAddress()) {
+      Intervals.push_back(&BI);
+    }
+  }
+  auto intervalBegin = [](const ByteInterval* BI) { return *BI->getAddress(); };
+  auto intervalEnd = [](const ByteInterval* BI) {
+    return *BI->getAddress() + BI->getSize();
+  };
+  std::stable_sort(Intervals.begin(), Intervals.end(),
+                   [&](const ByteInterval* L, const ByteInterval* R) {
+                     return intervalBegin(L) < intervalBegin(R);
+                   });
+
+  // Pick the interval of each symbol: the first interval that encompasses its
+  // address or, failing that, that ends at its address.
+  std::vector<IntegralReferent> Referents;
+  std::vector<const Symbol*> Unrelocated;
+  std::vector<size_t> Active;
+  size_t NextInterval = 0;
+  for (Symbol* Sym : IntSyms) {
+    Addr A = symbolAddr(Sym);
+    for (; NextInterval < Intervals.size() &&
+           intervalBegin(Intervals[NextInterval]) <= A;
+         ++NextInterval) {
+      Active.push_back(NextInterval);
+    }
+    // Intervals ending before this address also end before later symbols.
+    Active.erase(std::remove_if(Active.begin(), Active.end(),
+                                [&](size_t I) {
+                                  return intervalEnd(Intervals[I]) < A;
+                                }),
+                 Active.end());
+    auto Found = std::find_if(Active.begin(), Active.end(), [&](size_t I) {
+      return A < intervalEnd(Intervals[I]);
+    });
+    if (Found == Active.end()) {
+      Found = std::find_if(Active.begin(), Active.end(), [&](size_t I) {
+        return Intervals[I]->getSize() != 0 && intervalEnd(Intervals[I]) == A;
+      });
+    }
+    if (Found == Active.end()) {
+      Unrelocated.push_back(Sym);
+      continue;
+    }
+    uint64_t Offset = A - intervalBegin(Intervals[*Found]);
+    Referents.push_back({Sym, *Found, Offset});
+  }
 
-  for (auto* Sym : IntSyms) {
-    auto Addr = *Sym->getAddress();
-    bool FoundReferent = false;
-
-    // If a byte interval encompasses this address, then we can redirect
-    // the symbol to point to it.
-    for (auto& BI : M.findByteIntervalsOn(Addr)) {
-      FoundReferent = true;
-
-      // do we have a block at this exact address?
-      Node* ExactMatch = nullptr;
-      for (auto& Block : BI.findBlocksAt(Addr)) {
-        ExactMatch = &Block;
-        break;
+  // Pick the block of each symbol, sweeping the blocks of each interval.
+  std::stable_sort(Referents.begin(), Referents.end(),
+                   [](const IntegralReferent& L, const IntegralReferent& R) {
+                     return L.Interval < R.Interval;
+                   });
+  for (auto Run = Referents.begin(); Run != Referents.end();) {
+    ByteInterval* BI = Intervals[Run->Interval];
+    auto RunEnd = std::find_if(Run, Referents.end(), [&](const auto& R) {
+      return R.Interval != Run->Interval;
+    });
+    auto Blocks = BI->blocks();
+    auto NextBlock = Blocks.begin();
+    std::vector<Node*> ActiveBlocks;
+    for (; Run != RunEnd; ++Run) {
+      uint64_t Offset = Run->Offset;
+      for (; NextBlock != Blocks.end() &&
+             blockExtent(*NextBlock).first <= Offset;
+           ++NextBlock) {
+        ActiveBlocks.push_back(&*NextBlock);
       }
-      if (ExactMatch) {
-        // If so, set the referent to it.
-        if (isa<CodeBlock>(ExactMatch)) {
-          Sym->setReferent(cast<CodeBlock>(ExactMatch));
-        } else if (isa<DataBlock>(ExactMatch)) {
-          Sym->setReferent(cast<DataBlock>(ExactMatch));
-        } else {
-          assert(!"found non-block in block iterator!");
-        }
-        break;
+      ActiveBlocks.erase(
+          std::remove_if(ActiveBlocks.begin(), ActiveBlocks.end(),
+                         [&](const Node* Block) {
+                           auto [BlockOffset, Size] = blockExtent(*Block);
+                           return BlockOffset != Offset &&
+                                  BlockOffset + Size <= Offset;
+                         }),
+          ActiveBlocks.end());
+
+      // Do we have a block at this exact address?
+      auto Exact = std::find_if(ActiveBlocks.begin(), ActiveBlocks.end(),
+                                [&](const Node* Block) {
+                                  return blockExtent(*Block).first == Offset;
+                                });
+      if (Exact != ActiveBlocks.end()) {
+        Run->Block = *Exact;
+        continue;
       }
+      // If a block encompasses the address, make a new 0-length block of the
+      // same type; if all else fails, make it a new 0-length data block.
+      Run->Code = !ActiveBlocks.empty() && isa<CodeBlock>(ActiveBlocks.front());
+    }
+  }
 
-      // Do we have a block encompassing this exact address?
-      Node* ApproxMatch = nullptr;
-      for (auto& Block : BI.findBlocksOn(Addr)) {
-        ApproxMatch = &Block;
-        break;
-      }
-      if (ApproxMatch) {
-        // If so, make a new 0-length block of the same type.
-        if (isa<CodeBlock>(ApproxMatch)) {
-          CodeBlock* NewRef =
-              BI.addBlock<CodeBlock>(Ctx, Addr - *BI.getAddress(), 0);
-          Sym->setReferent(NewRef);
-        } else if (isa<DataBlock>(ApproxMatch)) {
-          DataBlock* NewRef =
-              BI.addBlock<DataBlock>(Ctx, Addr - *BI.getAddress(), 0);
-          Sym->setReferent(NewRef);
+  // Create the new blocks, after the sweep so that it does not see them.
+  // Symbols at the same address share the block created for the first.
+  const IntegralReferent* Created = nullptr;
+  for (IntegralReferent& R : Referents) {
+    if (!R.Block) {
+      if (Created && Created->Interval == R.Interval &&
+          Created->Offset == R.Offset && Created->Code == R.Code) {
+        R.Block = Created->Block;
+      } else {
+        ByteInterval* BI = Intervals[R.Interval];
+        if (R.Code) {
+          R.Block = BI->addBlock<CodeBlock>(Ctx, R.Offset, 0);
         } else {
-          assert(!"found non-block in block iterator!");
+          R.Block = BI->addBlock<DataBlock>(Ctx, R.Offset, 0);
         }
-        break;
+        Created = &R;
       }
-
-      // if all else fails, make it a new 0-length data block.
-      DataBlock* NewRef =
-          BI.addBlock<DataBlock>(Ctx, Addr - *BI.getAddress(), 0);
-      Sym->setReferent(NewRef);
-      break;
     }
-
-    if (FoundReferent)
-      continue;
-    // This symbol may refer to the end of a byte interval.
-    // If so, make a new 0-length data block pointing at the end of the BI.
-    for (auto& BI : M.findByteIntervalsOn(Addr - 1)) {
-      FoundReferent = true;
-      DataBlock* NewRef =
-          BI.addBlock<DataBlock>(Ctx, Addr - *BI.getAddress(), 0);
-      Sym->setReferent(NewRef);
-      break;
+    if (auto* CB = dyn_cast<CodeBlock>(R.Block)) {
+      R.Sym->setReferent(CB);
+    } else if (auto* DB = dyn_cast<DataBlock>(R.Block)) {
+      R.Sym->setReferent(DB);
     }
+  }
 
-    // TODO: if !FoundReferent, then emit a warning that an integral symbol
-    // was not relocated.
+  if (!Unrelocated.empty()) {
+    // Only a few names are listed: images with absolute symbol tables may
+    // have many symbols outside of their intervals.
+    constexpr size_t Listed = 5;
+    std::string Names;
+    for (size_t I = 0; I < Unrelocated.size() && I < Listed; ++I) {
+      Names += (I ? ", " : "") + Unrelocated[I]->getName();
+    }
+    if (Unrelocated.size() > Listed) {
+      Names += ", ...";
+    }
+    LOG_WARNING << Unrelocated.size() << " integral symbol(s) of module "
+                << M.getName() << " not relocated, because no byte interval "
+                << "encompasses their addresses: " << Names << "\n";
   }
 }
 
@@ -253,54 +409,76 @@ static std::optional<uint64_t> defaultAlignment(std::optional<Addr> A) {
   return std::nullopt;
 }
 
-/// Collect the required alignments for blocks in a module.
+/// The alignment that the layout maintains for a ByteInterval: that of the
+/// first of its blocks with a required alignment.
+struct IntervalAlignment {
+  /// The offset of the aligned block in the interval.
+  uint64_t Offset = 0;
+  /// The required alignment of the block, or 1 if there is none.
+  uint64_t Alignment = 1;
+};
+
+/// Collect the required alignments for the ByteIntervals of a module.
 ///
 /// Uses the module's "alignment" AuxData, if present. For any ByteIntervals
 /// with addresses that do not contain blocks with user-defined alignment, the
 /// blocks in that ByteInterval will be assumed to be aligned to the largest
 /// power of two that is consistent with their current alignment.
 ///
-/// \param Ctx  used to look up the UUIDs in the "alignment" AuxData.
-/// \param M    module to gather alignments for.
+/// \param Ctx    used to look up the UUIDs in the "alignment" AuxData.
+/// \param M      module to gather alignments for.
+/// \param Index  the ByteIntervals of the module.
 ///
-/// \return An alignment table for blocks in the module.
-static gtirb::schema::Alignment::Type getAlignments(const Context& Ctx,
-                                                    const Module& M) {
+/// \return the alignment of each interval of the index, by ordinal.
+static std::vector<IntervalAlignment>
+getAlignments(const Context& Ctx, const Module& M,
+              const FallthroughIndex& Index) {
   using namespace gtirb::schema;
 
-  Alignment::Type Alignments;
-
   // Start with the user-specified alignment, if possible.
 
-  std::set<UUID> UserAligned;
-  if (const auto* AuxData = M.getAuxData<Alignment>()) {
-    for (const auto& Pair : *AuxData) {
+  const auto* UserAlignments = M.getAuxData<Alignment>();
+  std::unordered_set<const ByteInterval*> UserAligned;
+  if (UserAlignments) {
+    for (const auto& Pair : *UserAlignments) {
       if (const auto* N = Node::getByUUID(Ctx, std::get<const UUID>(Pair))) {
         if (const auto* CB = dyn_cast<CodeBlock>(N)) {
-          UserAligned.insert(CB->getByteInterval()->getUUID());
+          UserAligned.insert(CB->getByteInterval());
         } else if (const auto* DB = dyn_cast<DataBlock>(N)) {
-          UserAligned.insert(DB->getByteInterval()->getUUID());
+          UserAligned.insert(DB->getByteInterval());
         }
         // Aligning other node types (e.g., Section) is not currently supported.
       }
     }
-    Alignments.insert(AuxData->begin(), AuxData->end());
   }
 
   // Compute default alignment for blocks in byte intervals that were not
   // aligned by the user.
 
-  for (const ByteInterval& BI : M.byte_intervals()) {
-    if (BI.getAddress() && !UserAligned.count(BI.getUUID())) {
-      for (const CodeBlock& Block : BI.code_blocks()) {
-        if (auto Align = defaultAlignment(Block.getAddress())) {
-          Alignments.emplace(Block.getUUID(), *Align);
+  std::vector<IntervalAlignment> Alignments(Index.Intervals.size());
+  for (size_t I = 0; I < Index.Intervals.size(); ++I) {
+    const ByteInterval& BI = *Index.Intervals[I];
+    bool DefaultAligned = BI.getAddress() && !UserAligned.count(&BI);
+    for (const auto& Block : BI.blocks()) {
+      std::optional<uint64_t> Align;
+      if (UserAlignments) {
+        if (auto It = UserAlignments->find(Block.getUUID());
+            It != UserAlignments->end()) {
+          Align = It->second;
         }
       }
-      for (const DataBlock& Block : BI.data_blocks()) {
-        if (auto Align = defaultAlignment(Block.getAddress())) {
-          Alignments.emplace(Block.getUUID(), *Align);
+      if (!Align && DefaultAligned) {
+        Align = defaultAlignment(Block.getAddress());
+      }
+      if (Align) {
+        if (const auto* CB = dyn_cast<CodeBlock>(&Block)) {
+          Alignments[I] = {CB->getOffset(), *Align};
+        } else if (const auto* DB = dyn_cast<DataBlock>(&Block)) {
+          Alignments[I] = {DB->getOffset(), *Align};
+        } else {
+          assert(!"Unexpected block type: neither CodeBlock nor DataBlock");
         }
+        break;
       }
     }
   }
@@ -316,68 +494,323 @@ static gtirb::schema::Alignment::Type getAlignments(const Context& Ctx,
 /// edges) the sources and targets will be adjacent in the returned list. This
 /// implementation does not confirm that the CFG is well-behaved.
 ///
-/// \param S  Section containing the ByteIntervals to sort
+/// \param Index    the fallthrough index of the module's sections.
+/// \param Section  the position of the Section to sort in the index.
+/// \param Visited  the intervals already sorted, by ordinal.
 ///
-/// \return a vector containing the sorted pointers to the byte intervals.
-static std::vector<ByteInterval*> toposort(Section& S) {
-  std::vector<ByteInterval*> Sorted;
-  std::set<ByteInterval*> Visited;
-  for (ByteInterval& BI : S.byte_intervals()) {
-    std::vector<ByteInterval*> Pending;
-    ByteInterval* Pred = &BI;
-    while (Pred && !Visited.count(Pred)) {
-      Visited.insert(Pred);
+/// \return a vector containing the sorted ordinals of the byte intervals.
+static std::vector<size_t> toposort(const FallthroughIndex& Index,
+                                    size_t Section,
+                                    std::vector<bool>& Visited) {
+  std::vector<size_t> Sorted;
+  std::vector<size_t> Pending;
+  for (size_t I = Index.SectionBegin[Section];
+       I < Index.SectionBegin[Section + 1]; ++I) {
+    Pending.clear();
+    for (size_t Pred = I; Pred != FallthroughIndex::None && !Visited[Pred];
+         Pred = Index.Predecessor[Pred]) {
+      Visited[Pred] = true;
       Pending.push_back(Pred);
-      Pred = getPredecessorByteInterval(*Pred);
     }
     Sorted.insert(Sorted.end(), Pending.rbegin(), Pending.rend());
   }
   return Sorted;
 }
 
-bool ::gtirb_layout::layoutModule(gtirb::Context& Ctx, Module& M) {
-  using namespace gtirb::schema;
+/// Compute the address of a ByteInterval placed at or after an address.
+///
+/// \param A      the first address the interval may be placed at.
+/// \param Align  the alignment of the interval.
+///
+/// \return the first address at or after \p A that maintains the alignment of
+/// the interval's aligned block.
+static uint64_t alignInterval(uint64_t A, const IntervalAlignment& Align) {
+  uint64_t Mask = Align.Alignment - 1;
+  uint64_t OffsetAddr = A + Align.Offset;
+  if (OffsetAddr & Mask) {
+    A += Mask - (OffsetAddr & Mask) + 1;
+  }
+  return A;
+}
 
+/// Set the addresses of the ByteIntervals of a module, laying out the
+/// sections one after the other from address 0.
+///
+/// \param Index       the ByteIntervals of the module.
+/// \param Alignments  the alignment of each interval, by ordinal.
+static void assignAddresses(const FallthroughIndex& Index,
+                            const std::vector<IntervalAlignment>& Alignments) {
+  // Compute the address of every interval before setting any of them, so that
+  // the module's address indices are not consulted while they change.
+  std::vector<uint64_t> Addresses(Index.Intervals.size());
+  std::vector<bool> Visited(Index.Intervals.size());
+  uint64_t A = 0;
+  for (size_t SectionIndex = 0; SectionIndex + 1 < Index.SectionBegin.size();
+       ++SectionIndex) {
+    for (size_t I : toposort(Index, SectionIndex, Visited)) {
+      // If this interval contains any blocks with requested alignment, update
+      // the address to maintain the alignment of the first of them.
+      A = alignInterval(A, Alignments[I]);
+      Addresses[I] = A;
+      A += Index.Intervals[I]->getSize();
+    }
+  }
+
+  // Commit the addresses, in one pass over all the intervals.
+  for (size_t I = 0; I < Addresses.size(); ++I) {
+    Index.Intervals[I]->setAddress(Addr(Addresses[I]));
+  }
+}
+
+bool ::gtirb_layout::layoutModule(gtirb::Context& Ctx, Module& M) {
   // Fix symbols with integral referents that point to known objects.
   fixIntegralSymbols(Ctx, M);
 
+  FallthroughIndex Fallthroughs = indexFallthroughs(M);
+
   // Get the desired ByteInterval alignments.
 
-  Alignment::Type Alignments = getAlignments(Ctx, M);
+  std::vector<IntervalAlignment> Alignments =
+      getAlignments(Ctx, M, Fallthroughs);
 
-  // Store a list of sections and then iterate over them, because
-  // setting the address of a BI invalidates parent iterators.
-  uint64_t A = 0;
-  std::vector<std::reference_wrapper<Section>> Sections(M.sections_begin(),
-                                                        M.sections_end());
-  for (auto& S : Sections) {
-    for (ByteInterval* BI : toposort(S)) {
-      // If this interval contains any blocks with requested alignment, update
-      // the address to maintain the alignment of the first of them.
-      for (auto& Block : BI->blocks()) {
-        if (auto It = Alignments.find(Block.getUUID());
-            It != Alignments.end()) {
-          uint64_t Mask = It->second - 1;
-          uint64_t OffsetAddr = 0;
-          if (auto* CB = dyn_cast<CodeBlock>(&Block)) {
-            OffsetAddr = A + CB->getOffset();
-          } else if (auto* DB = dyn_cast<DataBlock>(&Block)) {
-            OffsetAddr = A + DB->getOffset();
-          } else {
-            assert(!"Unexpected block type: neither CodeBlock nor DataBlock");
+  assignAddresses(Fallthroughs, Alignments);
+
+  return !Fallthroughs.Malformed;
+}
+
+/// A sequence of ByteIntervals of a section, each falling through to the
+/// next, that the incremental layout keeps or moves as a whole.
+struct FallthroughChain {
+  /// The ordinals of the intervals, in layout order.
+  std::vector<size_t> Intervals;
+  /// The number of leading intervals that keep their addresses; the others
+  /// are given new addresses.
+  size_t Kept = 0;
+};
+
+/// Split the ByteIntervals of a Section into fallthrough chains.
+///
+/// \param Index    the fallthrough index of the module's sections.
+/// \param Section  the position of the Section in the index.
+/// \param Chains   vector to append the chains of the section to.
+static void fallthroughChains(const FallthroughIndex& Index, size_t Section,
+                              std::vector<FallthroughChain>& Chains) {
+  size_t Begin = Index.SectionBegin[Section];
+  size_t End = Index.SectionBegin[Section + 1];
+  // Predecessors are always in the same section, so the successors of the
+  // section's intervals are indexed from its first interval.
+  std::vector<size_t> Successor(End - Begin, FallthroughIndex::None);
+  for (size_t I = Begin; I < End; ++I) {
+    size_t P = Index.Predecessor[I];
+    if (P != FallthroughIndex::None &&
+        Successor[P - Begin] == FallthroughIndex::None) {
+      Successor[P - Begin] = I;
+    }
+  }
+  auto isHead = [&](size_t I) {
+    size_t P = Index.Predecessor[I];
+    return P == FallthroughIndex::None || Successor[P - Begin] != I;
+  };
+
+  std::vector<bool> Visited(End - Begin);
+  auto addChain = [&](size_t Head) {
+    FallthroughChain& Chain = Chains.emplace_back();
+    for (size_t I = Head; I != FallthroughIndex::None && !Visited[I - Begin];
+         I = Successor[I - Begin]) {
+      Visited[I - Begin] = true;
+      Chain.Intervals.push_back(I);
+    }
+  };
+  for (size_t I = Begin; I < End; ++I) {
+    if (isHead(I)) {
+      addChain(I);
+    }
+  }
+  // The remaining intervals are in cycles of fallthrough edges.
+  for (size_t I = Begin; I < End; ++I) {
+    if (!Visited[I - Begin]) {
+      addChain(I);
+    }
+  }
+}
+
+bool ::gtirb_layout::layoutModuleIncremental(gtirb::Context& Ctx,
+                                             Module& M) {
+  fixIntegralSymbols(Ctx, M);
+
+  FallthroughIndex Fallthroughs = indexFallthroughs(M);
+  std::vector<IntervalAlignment> Alignments =
+      getAlignments(Ctx, M, Fallthroughs);
+  const std::vector<ByteInterval*>& Intervals = Fallthroughs.Intervals;
+
+  size_t SectionCount = Fallthroughs.SectionBegin.size() - 1;
+  std::vector<FallthroughChain> Chains;
+  std::vector<size_t> SectionChains;
+  for (size_t SectionIndex = 0; SectionIndex < SectionCount; ++SectionIndex) {
+    SectionChains.push_back(Chains.size());
+    fallthroughChains(Fallthroughs, SectionIndex, Chains);
+  }
+  SectionChains.push_back(Chains.size());
+
+  // The intervals of a chain keep their addresses while they have addresses
+  // and are placed as the layout would place them after the chain's first
+  // interval.
+  for (FallthroughChain& Chain : Chains) {
+    std::optional<uint64_t> Next;
+    for (size_t I : Chain.Intervals) {
+      std::optional<Addr> A = Intervals[I]->getAddress();
+      uint64_t Expected = alignInterval(Next.value_or(A ? uint64_t{*A} : 0),
+                                        Alignments[I]);
+      if (!A || uint64_t{*A} != Expected) {
+        break;
+      }
+      Next = Expected + Intervals[I]->getSize();
+      ++Chain.Kept;
+    }
+  }
+
+  // Intervals that overlap an interval at a lower address do not keep their
+  // addresses either, nor do the intervals after them in their chain.
+  struct Extent {
+    uint64_t Begin;
+    uint64_t End;
+    size_t Chain;
+    size_t Position;
+  };
+  std::vector<Extent> Extents;
+  for (size_t C = 0; C < Chains.size(); ++C) {
+    for (size_t P = 0; P < Chains[C].Kept; ++P) {
+      const ByteInterval* BI = Intervals[Chains[C].Intervals[P]];
+      uint64_t Begin{*BI->getAddress()};
+      Extents.push_back({Begin, Begin + BI->getSize(), C, P});
+    }
+  }
+  std::sort(Extents.begin(), Extents.end(),
+            [](const Extent& L, const Extent& R) {
+              return std::tie(L.Begin, L.Chain) < std::tie(R.Begin, R.Chain);
+            });
+  uint64_t CoveredEnd = 0;
+  for (const Extent& E : Extents) {
+    if (E.Begin < CoveredEnd) {
+      Chains[E.Chain].Kept = std::min(Chains[E.Chain].Kept, E.Position);
+    } else {
+      CoveredEnd = std::max(CoveredEnd, E.End);
+    }
+  }
+
+  // The address ranges occupied by the kept intervals, and the range of the
+  // kept intervals of each section.
+  std::map<uint64_t, uint64_t> Occupied;
+  std::vector<std::optional<std::pair<uint64_t, uint64_t>>> Hulls(
+      SectionCount);
+  uint64_t ModuleEnd = 0;
+  auto occupy = [&](size_t SectionIndex, uint64_t Begin, uint64_t End) {
+    if (Begin != End) {
+      Occupied.emplace(Begin, End);
+    }
+    auto& Hull = Hulls[SectionIndex];
+    Hull = Hull ? std::make_pair(std::min(Hull->first, Begin),
+                                 std::max(Hull->second, End))
+                : std::make_pair(Begin, End);
+    ModuleEnd = std::max(ModuleEnd, End);
+  };
+  for (size_t SectionIndex = 0; SectionIndex < SectionCount; ++SectionIndex) {
+    for (size_t C = SectionChains[SectionIndex];
+         C < SectionChains[SectionIndex + 1]; ++C) {
+      for (size_t P = 0; P < Chains[C].Kept; ++P) {
+        const ByteInterval* BI = Intervals[Chains[C].Intervals[P]];
+        uint64_t Begin{*BI->getAddress()};
+        occupy(SectionIndex, Begin, Begin + BI->getSize());
+      }
+    }
+  }
+  auto isFree = [&](uint64_t Begin, uint64_t End) {
+    auto After = Occupied.upper_bound(Begin);
+    if (After != Occupied.begin() && std::prev(After)->second > Begin) {
+      return false;
+    }
+    return After == Occupied.end() || After->first >= End;
+  };
+
+  // Place the moved intervals of each chain after its kept intervals, if
+  // there is room. Otherwise, move the whole chain into the first gap of its
+  // section that fits it, after its section if that is free, or else after
+  // the module.
+  std::vector<std::pair<size_t, uint64_t>> Moves;
+  for (size_t SectionIndex = 0; SectionIndex < SectionCount; ++SectionIndex) {
+    for (size_t C = SectionChains[SectionIndex];
+         C < SectionChains[SectionIndex + 1]; ++C) {
+      FallthroughChain& Chain = Chains[C];
+      if (Chain.Kept == Chain.Intervals.size()) {
+        continue;
+      }
+      // The address of the first moved interval and the end of the chain, if
+      // the moved intervals are placed at Start.
+      auto extent = [&](uint64_t Start) {
+        uint64_t First =
+            alignInterval(Start, Alignments[Chain.Intervals[Chain.Kept]]);
+        uint64_t A = First;
+        for (size_t P = Chain.Kept; P < Chain.Intervals.size(); ++P) {
+          size_t I = Chain.Intervals[P];
+          A = alignInterval(A, Alignments[I]) + Intervals[I]->getSize();
+        }
+        return std::make_pair(First, A);
+      };
+      auto fits = [&](uint64_t Start) {
+        auto [Begin, End] = extent(Start);
+        return isFree(Begin, End);
+      };
+
+      std::optional<uint64_t> Start;
+      if (Chain.Kept > 0) {
+        const ByteInterval* Last = Intervals[Chain.Intervals[Chain.Kept - 1]];
+        uint64_t LastEnd = uint64_t{*Last->getAddress()} + Last->getSize();
+        if (fits(LastEnd)) {
+          Start = LastEnd;
+        } else {
+          for (size_t P = 0; P < Chain.Kept; ++P) {
+            const ByteInterval* BI = Intervals[Chain.Intervals[P]];
+            if (BI->getSize() != 0) {
+              Occupied.erase(uint64_t{*BI->getAddress()});
+            }
           }
-          if (OffsetAddr & Mask) {
-            A += Mask - (OffsetAddr & Mask) + 1;
+          Chain.Kept = 0;
+        }
+      }
+      if (const auto& Hull = Hulls[SectionIndex]; !Start && Hull) {
+        for (auto It = Occupied.lower_bound(Hull->first);
+             !Start && It != Occupied.end() && It->second < Hull->second;
+             ++It) {
+          if (fits(It->second)) {
+            Start = It->second;
           }
-          break;
+        }
+        if (!Start && fits(Hull->second)) {
+          Start = Hull->second;
         }
       }
-      BI->setAddress(Addr(A));
-      A += BI->getSize();
+      uint64_t A = Start.value_or(ModuleEnd);
+      for (size_t P = Chain.Kept; P < Chain.Intervals.size(); ++P) {
+        size_t I = Chain.Intervals[P];
+        A = alignInterval(A, Alignments[I]);
+        Moves.emplace_back(I, A);
+        occupy(SectionIndex, A, A + Intervals[I]->getSize());
+        A += Intervals[I]->getSize();
+      }
     }
   }
 
-  return true;
+  for (const auto& [I, A] : Moves) {
+    Intervals[I]->setAddress(Addr(A));
+  }
+
+  // Moving intervals cannot separate sections that interleave, or sections
+  // whose moved intervals were placed after the module; lay those out again.
+  if (layoutRequired(M)) {
+    assignAddresses(Fallthroughs, Alignments);
+  }
+
+  return !Fallthroughs.Malformed;
 }
 
 #if defined(_MSC_VER)
@@ -69,6 +69,36 @@ TEST(Unit_Layout, fixIntegralSymbols) {
   EXPECT_TRUE(S110->getReferent<DataBlock>());
 }
 
+TEST(Unit_Layout, fixIntegralSymbolsSweep) {
+  Context C;
+  Module* M = Module::Create(C, "test");
+  Section* S = M->addSection(C, ".test");
+  ByteInterval* BI1 = S->addByteInterval(C, Addr(0x200), 8);
+  ByteInterval* BI2 = S->addByteInterval(C, Addr(0x100), 8);
+  CodeBlock* CB = BI2->addBlock<CodeBlock>(C, 0, 8);
+  Symbol* S204 = M->addSymbol(C, Addr(0x204), "s204");
+  Symbol* S104A = M->addSymbol(C, Addr(0x104), "s104a");
+  Symbol* S300 = M->addSymbol(C, Addr(0x300), "s300");
+  Symbol* S104B = M->addSymbol(C, Addr(0x104), "s104b");
+  Symbol* S208 = M->addSymbol(C, Addr(0x208), "s208");
+  Symbol* S100 = M->addSymbol(C, Addr(0x100), "s100");
+
+  fixIntegralSymbols(C, *M);
+
+  EXPECT_EQ(CB, S100->getReferent<CodeBlock>());
+  ASSERT_TRUE(S104A->getReferent<CodeBlock>());
+  EXPECT_EQ(S104A->getReferent<CodeBlock>(), S104B->getReferent<CodeBlock>());
+  EXPECT_EQ(Addr(0x104), S104A->getAddress());
+  ASSERT_TRUE(S204->getReferent<DataBlock>());
+  EXPECT_EQ(BI1, S204->getReferent<DataBlock>()->getByteInterval());
+  ASSERT_TRUE(S208->getReferent<DataBlock>());
+  EXPECT_EQ(Addr(0x208), S208->getAddress());
+
+  // No interval encompasses 0x300, so the symbol stays integral.
+  EXPECT_FALSE(S300->hasReferent());
+  EXPECT_EQ(Addr(0x300), S300->getAddress());
+}
+
 TEST(Unit_Layout, removeModuleLayout) {
   Context C;
   IR* Ir = IR::Create(C);
@@ -175,6 +205,63 @@ TEST(Unit_Layout, layoutModuleWithCFG) {
   EXPECT_FALSE(layoutRequired(*Ir));
 }
 
+TEST(Unit_Layout, layoutModuleMalformedFallthrough) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Module* M = Ir->addModule(C, "test");
+  Section* S1 = M->addSection(C, ".test1");
+  Section* S2 = M->addSection(C, ".test2");
+  ByteInterval* BI1 = S1->addByteInterval(C, 16);
+  ByteInterval* BI2 = S1->addByteInterval(C, 16);
+  ByteInterval* BI3 = S2->addByteInterval(C, 16);
+  auto* CB1 = BI1->addBlock<CodeBlock>(C, 0, 8);
+  BI1->addBlock<CodeBlock>(C, 8, 8);
+  auto* CB2 = BI2->addBlock<CodeBlock>(C, 0, 16);
+  auto* CB3 = BI3->addBlock<CodeBlock>(C, 0, 16);
+
+  // Neither edge can be kept: CB1 is not at the end of its interval, and CB2
+  // is in another section than CB3.
+  addFallthrough(CB1, CB2, Ir->getCFG());
+  addFallthrough(CB2, CB3, Ir->getCFG());
+
+  EXPECT_FALSE(layoutModule(C, *M));
+  EXPECT_TRUE(BI1->getAddress());
+  EXPECT_TRUE(BI2->getAddress());
+  EXPECT_TRUE(BI3->getAddress());
+  EXPECT_FALSE(layoutRequired(*Ir));
+}
+
+TEST(Unit_Layout, layoutModuleIncremental) {
+  Context C;
+  IR* Ir = IR::Create(C);
+  Module* M = Ir->addModule(C, "test");
+  Section* S = M->addSection(C, ".test");
+  ByteInterval* BI1 = S->addByteInterval(C, Addr(0x100), 16);
+  ByteInterval* BI2 = S->addByteInterval(C, Addr(0x108), 16);
+  ByteInterval* BI3 = S->addByteInterval(C, 8);
+  ByteInterval* BI4 = S->addByteInterval(C, Addr(0x200), 16);
+  ByteInterval* BI5 = S->addByteInterval(C, 4);
+  auto* CB4 = BI4->addBlock<CodeBlock>(C, 0, 16);
+  auto* CB5 = BI5->addBlock<CodeBlock>(C, 0, 4);
+
+  // BI5 must stay after BI4, which keeps its address.
+  addFallthrough(CB4, CB5, Ir->getCFG());
+  EXPECT_TRUE(layoutRequired(*Ir));
+
+  EXPECT_TRUE(layoutModuleIncremental(C, *M));
+  EXPECT_EQ(Addr(0x100), BI1->getAddress());
+  EXPECT_EQ(Addr(0x200), BI4->getAddress());
+  EXPECT_EQ(Addr(0x210), BI5->getAddress());
+  // The overlapping and unaddressed intervals fit in the gap.
+  ASSERT_TRUE(BI2->getAddress());
+  ASSERT_TRUE(BI3->getAddress());
+  EXPECT_LE(Addr(0x110), *BI2->getAddress());
+  EXPECT_LE(Addr(0x110), *BI3->getAddress());
+  EXPECT_GT(Addr(0x200), *BI2->getAddress());
+  EXPECT_GT(Addr(0x200), *BI3->getAddress());
+  EXPECT_FALSE(layoutRequired(*Ir));
+}
+
 int main(int argc, char** argv) {
   registerAuxDataTypes();
 
@@ -18,6 +18,7 @@
 #include "Arm64PrettyPrinter.hpp"
 #include "AuxDataSchema.hpp"
 #include "AuxDataUtils.hpp"
+#include "PrintError.hpp"
 #include "StringUtils.hpp"
 
 #include <capstone/capstone.h>
@@ -197,7 +198,7 @@ void Arm64PrettyPrinter::printOperandList(std::ostream& os,
       IsPrintingGroupedOperands = true;
     }
 
-    printOperand(os, block, inst, i);
+    printListedOperand(os, block, inst, i);
 
     if (IsPrintingGroupedOperands) {
       uint8_t offset = 0;
@@ -285,7 +286,8 @@ void Arm64PrettyPrinter::printOperandList(std::ostream& os,
   if (inst.detail->arm64.cc != ARM64_CC_INVALID &&
       isCondInstr(static_cast<arm64_insn>(inst.id))) {
     std::string cc = arm64Cc2String(inst.detail->arm64.cc);
-    os << ',' << cc;
+    os << ',';
+    printListedOperand(os, cc);
   }
 }
 
@@ -334,8 +336,7 @@ void Arm64PrettyPrinter::printOperand(std::ostream& os,
     return;
   case ARM64_OP_INVALID:
   default:
-    std::cerr << "invalid operand\n";
-    exit(1);
+    throw PrintError("invalid operand");
   }
 }
 
@@ -626,8 +627,7 @@ void Arm64PrettyPrinter::printOpBarrier(std::ostream& os,
     return;
   case ARM64_BARRIER_INVALID:
   default:
-    std::cerr << "invalid operand\n";
-    exit(1);
+    throw PrintError("invalid barrier operand");
   }
 }
 
@@ -690,8 +690,7 @@ void Arm64PrettyPrinter::printOpPrefetch(std::ostream& os,
     return;
   case ARM64_PRFM_INVALID:
   default:
-    std::cerr << "invalid operand\n";
-    exit(1);
+    throw PrintError("invalid prefetch operand");
   }
 }
 
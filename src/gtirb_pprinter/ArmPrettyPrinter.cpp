@@ -16,6 +16,7 @@
 #include "ArmPrettyPrinter.hpp"
 #include "AuxDataSchema.hpp"
 #include "AuxDataUtils.hpp"
+#include "PrintError.hpp"
 #include "StringUtils.hpp"
 #include "driver/Logger.h"
 #include <iostream>
@@ -153,15 +154,16 @@ void ArmPrettyPrinter::printBlockContents(std::ostream& Os,
   }
 
   if (!Success) {
-    LOG_ERROR << "Failed to decode block at " << std::hex
-              << static_cast<uint64_t>(Addr) + Offset << std::dec;
-    std::exit(EXIT_FAILURE);
+    std::stringstream Message;
+    Message << "Failed to decode block at " << std::hex
+            << static_cast<uint64_t>(Addr) + Offset;
+    throw PrintError(Message.str());
   }
 
   gtirb::Offset BlockOffset(X.getUUID(), Offset);
   for (size_t I = 0; I < InsnCount; I++) {
     fixupInstruction((&(*InsnPtr))[I]);
-    printInstruction(Os, X, (&(*InsnPtr))[I], BlockOffset);
+    emitInstruction(Os, X, (&(*InsnPtr))[I], BlockOffset);
     BlockOffset.Displacement += (&(*InsnPtr))[I].size;
   }
 
@@ -240,9 +242,8 @@ static void rewriteMnemonic(cs_insn& inst, const char* str) {
   std::string newMnemonic = SS.str();
   size_t newMnemonicLen = newMnemonic.size() + 1;
   if (newMnemonicLen > CS_MNEMONIC_SIZE) {
-    LOG_ERROR << "Fixed up mnemonic \"" << newMnemonic << "\" does not fit in "
-              << CS_MNEMONIC_SIZE << "\n";
-    std::exit(EXIT_FAILURE);
+    throw PrintError("Fixed up mnemonic \"" + newMnemonic +
+                     "\" does not fit in " + std::to_string(CS_MNEMONIC_SIZE));
   }
   memcpy(inst.mnemonic, newMnemonic.c_str(), newMnemonicLen);
 }
@@ -370,23 +371,26 @@ void ArmPrettyPrinter::printOperandList(std::ostream& os,
       const cs_arm_op& op = detail.operands[i];
       // Print out closing parenthesis once a memory operand is encountered.
       if (op.type == ARM_OP_MEM) {
-        os << " }, [";
+        os << " }, ";
+        std::ostringstream Mem;
+        Mem << "[";
         if (op.mem.base != ARM_REG_INVALID) {
-          os << getRegisterName(op.mem.base);
+          Mem << getRegisterName(op.mem.base);
         }
         // The disp is for alignment for VLDn and VSTn instructions.
         if (op.mem.disp != 0) {
-          os << " :" << op.mem.disp;
+          Mem << " :" << op.mem.disp;
         }
-        os << "]";
+        Mem << "]";
         if (detail.writeback) {
-          os << "!";
+          Mem << "!";
         }
+        printListedOperand(os, Mem.str());
       } else {
         if (i != 0) {
           os << ", ";
         }
-        printOperand(os, block, inst, i);
+        printListedOperand(os, block, inst, i);
       }
     }
     return;
@@ -405,10 +409,14 @@ void ArmPrettyPrinter::printOperandList(std::ostream& os,
     }
     if (i == RegBitVectorIndex)
       os << "{ ";
-    printOperand(os, block, inst, i);
     if (LdmStm.find(static_cast<arm_insn>(inst.id)) != LdmStm.end() && i == 0 &&
         detail.writeback) {
-      os << "!";
+      std::ostringstream Base;
+      printOperand(Base, block, inst, i);
+      Base << "!";
+      printListedOperand(os, Base.str());
+    } else {
+      printListedOperand(os, block, inst, i);
     }
   }
   if (RegBitVectorIndex != -1)
@@ -457,14 +465,12 @@ void ArmPrettyPrinter::printOperand(std::ostream& os,
       os << "LE";
       break;
     default:
-      std::cerr << "invalid SETEND operand\n";
-      exit(1);
+      throw PrintError("invalid SETEND operand");
     }
     return;
   }
   default:
-    std::cerr << "invalid operand\n";
-    exit(1);
+    throw PrintError("invalid operand");
   }
 }
 
@@ -767,8 +773,7 @@ void ArmPrettyPrinter::printOpIndirect(
       os << "RRX";
       break;
     case ARM_SFT_INVALID:
-      std::cerr << "Invalid ARM shift operation.\n";
-      exit(1);
+      throw PrintError("Invalid ARM shift operation");
     }
     os << " " << op.shift.value;
   }
@@ -0,0 +1,257 @@
+//===- ArtifactCache.cpp ---------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ArtifactCache.hpp"
+#include "ToolchainProbe.hpp"
+#include "driver/Logger.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wunknown-warning-option"
+#pragma GCC diagnostic ignored "-Wshadow"
+#pragma GCC diagnostic ignored "-Wc++11-compat"
+#pragma GCC diagnostic ignored "-Wpessimizing-move"
+#pragma GCC diagnostic ignored "-Wdeprecated-copy"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4456) // variable shadowing warning
+#endif                          // __GNUC__
+#include <boost/filesystem.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif // __GNUC__
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace gtirb_bprint {
+
+class CacheKey::Impl {
+public:
+  boost::uuids::detail::sha1 Hash;
+};
+
+CacheKey::CacheKey() : State(std::make_unique<Impl>()) {}
+
+CacheKey::~CacheKey() = default;
+
+CacheKey& CacheKey::add(std::string_view Field) {
+  add(static_cast<uint64_t>(Field.size()));
+  State->Hash.process_bytes(Field.data(), Field.size());
+  return *this;
+}
+
+CacheKey& CacheKey::add(uint64_t Field) {
+  unsigned char Bytes[sizeof(Field)];
+  for (size_t I = 0; I < sizeof(Field); ++I) {
+    Bytes[I] = static_cast<unsigned char>(Field >> (8 * I));
+  }
+  State->Hash.process_bytes(Bytes, sizeof(Bytes));
+  return *this;
+}
+
+CacheKey& CacheKey::addChunk(std::string_view Bytes) {
+  State->Hash.process_bytes(Bytes.data(), Bytes.size());
+  return *this;
+}
+
+CacheKey& CacheKey::addFile(const std::string& Path) {
+  boost::system::error_code EC;
+  uint64_t Size = fs::file_size(Path, EC);
+  std::ifstream In(Path, std::ios::binary);
+  if (EC || !In) {
+    return add(std::numeric_limits<uint64_t>::max());
+  }
+  add(Size);
+  char Buffer[1 << 16];
+  while (In.read(Buffer, sizeof(Buffer)) || In.gcount() > 0) {
+    State->Hash.process_bytes(Buffer, static_cast<size_t>(In.gcount()));
+  }
+  return *this;
+}
+
+std::string CacheKey::str() const {
+  // Finalizing the digest modifies the hash state; work on a copy so that
+  // more fields can still be added.
+  boost::uuids::detail::sha1 Hash = State->Hash;
+  boost::uuids::detail::sha1::digest_type Digest;
+  Hash.get_digest(Digest);
+
+  std::ostringstream Out;
+  Out << std::hex << std::setfill('0');
+  for (auto Word : Digest) {
+    Out << std::setw(2 * sizeof(Word)) << static_cast<uint64_t>(Word);
+  }
+  return Out.str();
+}
+
+ArtifactCache::ArtifactCache(std::string D) : Dir(std::move(D)) {
+  boost::system::error_code EC;
+  fs::create_directories(Dir, EC);
+  if (EC) {
+    LOG_WARNING << "Could not create cache directory '" << Dir
+                << "': " << EC.message() << "\n";
+  }
+}
+
+namespace {
+
+// Record that a cache entry was used, for prune().
+void touch(const fs::path& Entry) {
+  boost::system::error_code EC;
+  fs::last_write_time(Entry, std::time(nullptr), EC);
+}
+
+} // namespace
+
+bool ArtifactCache::fetch(const std::string& Key,
+                          const std::string& Dest) const {
+  fs::path Entry = fs::path(Dir) / Key;
+  boost::system::error_code EC;
+  if (!fs::is_regular_file(Entry, EC)) {
+    return false;
+  }
+  fs::copy_file(Entry, Dest, fs::copy_options::overwrite_existing, EC);
+  if (EC) {
+    return false;
+  }
+  touch(Entry);
+  return true;
+}
+
+bool ArtifactCache::publish(const std::string& Key,
+                            const std::string& Src) const {
+  fs::path Entry = fs::path(Dir) / Key;
+  // Stage the copy next to its final location, so that the rename is atomic
+  // and readers never observe a partially written artifact.
+  fs::path Staged = fs::path(Dir) / fs::unique_path(Key + ".%%%%-%%%%.tmp");
+  boost::system::error_code EC;
+  fs::copy_file(Src, Staged, EC);
+  if (!EC) {
+    fs::rename(Staged, Entry, EC);
+  }
+  if (EC) {
+    LOG_WARNING << "Could not store '" << Src << "' in the cache: "
+                << EC.message() << "\n";
+    fs::remove(Staged, EC);
+    return false;
+  }
+  return true;
+}
+
+std::optional<std::string> ArtifactCache::load(const std::string& Key) const {
+  fs::path Entry = fs::path(Dir) / Key;
+  std::ifstream In(Entry.string(), std::ios::binary);
+  if (!In) {
+    return std::nullopt;
+  }
+  std::ostringstream Contents;
+  Contents << In.rdbuf();
+  if (In.bad()) {
+    return std::nullopt;
+  }
+  touch(Entry);
+  return Contents.str();
+}
+
+bool ArtifactCache::store(const std::string& Key,
+                          std::string_view Contents) const {
+  fs::path Entry = fs::path(Dir) / Key;
+  fs::path Staged = fs::path(Dir) / fs::unique_path(Key + ".%%%%-%%%%.tmp");
+  std::ofstream Out(Staged.string(), std::ios::binary);
+  Out.write(Contents.data(), Contents.size());
+  Out.close();
+  boost::system::error_code EC;
+  if (Out) {
+    fs::rename(Staged, Entry, EC);
+  }
+  if (!Out || EC) {
+    LOG_WARNING << "Could not store '" << Key << "' in the cache.\n";
+    fs::remove(Staged, EC);
+    return false;
+  }
+  return true;
+}
+
+void ArtifactCache::prune(uint64_t MaxBytes) const {
+  struct Entry {
+    std::time_t Used;
+    uint64_t Size;
+    fs::path Path;
+  };
+  std::vector<Entry> Entries;
+  uint64_t Total = 0;
+  boost::system::error_code EC;
+  for (fs::directory_iterator It(Dir, EC), End; !EC && It != End;
+       It.increment(EC)) {
+    const fs::path& Path = It->path();
+    // Skip artifacts still being staged by other processes.
+    if (Path.extension() == ".tmp" || !fs::is_regular_file(Path, EC)) {
+      continue;
+    }
+    uint64_t Size = fs::file_size(Path, EC);
+    std::time_t Used = fs::last_write_time(Path, EC);
+    if (!EC) {
+      Entries.push_back({Used, Size, Path});
+      Total += Size;
+    }
+  }
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry& A, const Entry& B) { return A.Used < B.Used; });
+  for (const Entry& E : Entries) {
+    if (Total <= MaxBytes) {
+      break;
+    }
+    if (fs::remove(E.Path, EC)) {
+      Total -= E.Size;
+    }
+  }
+}
+
+std::string ArtifactCache::toolIdentity(const std::string& Tool) {
+  static std::mutex Mutex;
+  static std::map<std::string, std::string> Identities;
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (auto It = Identities.find(Tool); It != Identities.end()) {
+    return It->second;
+  }
+
+  fs::path Path(ToolchainProbe::instance().find(Tool).value_or(""));
+  boost::system::error_code EC;
+  std::ostringstream Identity;
+  fs::path Resolved = fs::canonical(Path, EC);
+  if (EC || Path.empty()) {
+    // Unknown tools still get a stable identity; the build itself will
+    // report that the tool is missing.
+    Identity << Tool;
+  } else {
+    Identity << Resolved.string() << ';' << fs::file_size(Resolved, EC) << ';'
+             << fs::last_write_time(Resolved, EC);
+  }
+  return Identities[Tool] = Identity.str();
+}
+
+} // namespace gtirb_bprint
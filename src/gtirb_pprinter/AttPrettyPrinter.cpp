@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include "AttPrettyPrinter.hpp"
+#include "PrintError.hpp"
 #include "StringUtils.hpp"
 #include "driver/Logger.h"
 #include "version.h"
@@ -135,8 +136,7 @@ void AttPrettyPrinter::printOpImmediate(
 
   const cs_x86_op& Op = Insn.detail->x86.operands[Index];
   if (Op.type != X86_OP_IMM) {
-    LOG_ERROR << "printOpImmediate called without an immediate operand";
-    std::exit(EXIT_FAILURE);
+    throw PrintError("printOpImmediate called without an immediate operand");
   }
 
   bool ReferencesCode =
@@ -1,4 +1,5 @@
 #include "AuxDataUtils.hpp"
+#include "PrintError.hpp"
 #include <iostream>
 
 using namespace gtirb;
@@ -371,8 +372,7 @@ std::ostream& TypePrinter::printType(const gtirb::UUID& TypeId,
   case Index::Alias:
     return printAlias(getVariant<Index::Alias>(Entry), Stream);
   default:
-    assert(0 && "Unknown variant in type table entry");
-    exit(1);
+    throw gtirb_pprint::PrintError("Unknown variant in type table entry");
   }
 };
 
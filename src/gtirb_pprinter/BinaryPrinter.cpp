@@ -13,15 +13,22 @@
 //
 //===----------------------------------------------------------------------===//
 #include "BinaryPrinter.hpp"
+#include "ArtifactCache.hpp"
 #include "FileUtils.hpp"
 
 namespace gtirb_bprint {
 bool BinaryPrinter::prepareSource(gtirb::Context& ctx, gtirb::Module& mod,
                                   TempFile& tempFile) const {
   if (tempFile.isOpen()) {
-    Printer.print(tempFile, ctx, mod);
+    // Write the file through an asynchronous stream so that formatting and
+    // I/O overlap.
     tempFile.close();
-    return true;
+    AsyncOutputStream Stream(openFileSink(
+        tempFile.fileName(), gtirb_pprint::estimateListingSize(mod)));
+    if (!Stream.isOpen())
+      return false;
+    Printer.print(Stream, ctx, mod);
+    return Stream.close();
   }
   return false;
 }
@@ -38,4 +45,41 @@ bool BinaryPrinter::prepareSources(gtirb::Context& ctx, gtirb::IR& ir,
   }
   return true;
 }
+
+bool BinaryPrinter::prepareUnitSources(gtirb::Context& ctx, gtirb::Module& mod,
+                                       std::vector<TempFile>& tempFiles) const {
+  if (SplitUnits < 2) {
+    tempFiles = std::vector<TempFile>(1);
+    return prepareSource(ctx, mod, tempFiles.front());
+  }
+  auto Printers = Printer.createUnitPrinters(ctx, mod, SplitUnits);
+  if (Printers.empty())
+    return false;
+  tempFiles = std::vector<TempFile>(Printers.size());
+  const uint64_t Size =
+      gtirb_pprint::estimateListingSize(mod) / Printers.size();
+  for (size_t I = 0; I < Printers.size(); ++I) {
+    tempFiles[I].close();
+    AsyncOutputStream Stream(openFileSink(tempFiles[I].fileName(), Size));
+    if (!Stream.isOpen())
+      return false;
+    Printers[I]->print(Stream);
+    if (!Stream.close())
+      return false;
+  }
+  return true;
+}
+
+void BinaryPrinter::addBuildToKey(CacheKey& Key,
+                                  const gtirb::Module& /* mod */) const {
+  Key.add(ExtraCompileArgs.size());
+  for (const std::string& Arg : ExtraCompileArgs) {
+    Key.add(Arg);
+  }
+  Key.add(LibraryPaths.size());
+  for (const std::string& Path : LibraryPaths) {
+    Key.add(Path);
+  }
+  Key.add(NativeObject).add(SplitUnits);
+}
 } // namespace gtirb_bprint
@@ -16,9 +16,11 @@
 
 #include "Arm64PrettyPrinter.hpp"
 #include "ArmPrettyPrinter.hpp"
+#include "ArtifactCache.hpp"
 #include "AuxDataSchema.hpp"
 #include "AuxDataUtils.hpp"
 #include "ElfPrettyPrinter.hpp"
+#include "ElfStubWriter.hpp"
 #include "ElfVersionScriptPrinter.hpp"
 #include "FileUtils.hpp"
 #include "Mips32PrettyPrinter.hpp"
@@ -26,26 +28,25 @@
 #include <boost/filesystem.hpp>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace gtirb_bprint {
 
 bool ElfBinaryPrinter::isInfixLibraryName(const std::string& library) const {
-  std::regex libsoRegex("^lib(.*)\\.so.*");
-  std::smatch m;
-  return std::regex_match(library, m, libsoRegex);
+  static const std::regex libsoRegex("^lib(.*)\\.so.*");
+  return std::regex_match(library, libsoRegex);
 }
 
 std::optional<std::string>
 ElfBinaryPrinter::findLibrary(const std::string& library,
                               const std::vector<std::string>& paths) const {
-  for (const auto& path : paths) {
-    if (std::optional<std::string> fp = resolveRegularFilePath(path, library))
-      return fp;
-  }
-  return std::nullopt;
+  return Libraries.find(paths, library);
 }
 
 bool isBlackListedLib(std::string Library) {
@@ -57,20 +58,15 @@ bool isBlackListedLib(std::string Library) {
 // symbols but don't appear to need external linkage when rebuilding
 // the binary. Some, for example __rela_iplt_start, are introduced
 // by ddisasm.
-bool isBlackListed(std::string sym) {
-  static std::vector<std::string> blackList = {"",
-                                               "__rela_iplt_start",
-                                               "__rela_iplt_end",
-                                               "__gmon_start__",
-                                               "_ITM_registerTMCloneTable",
-                                               "_ITM_deregisterTMCloneTable"};
-
-  for (auto& name : blackList) {
-    if (sym == name) {
-      return true;
-    }
-  }
-  return false;
+bool isBlackListed(const std::string& sym) {
+  static const std::unordered_set<std::string> blackList = {
+      "",
+      "__rela_iplt_start",
+      "__rela_iplt_end",
+      "__gmon_start__",
+      "_ITM_registerTMCloneTable",
+      "_ITM_deregisterTMCloneTable"};
+  return blackList.count(sym) != 0;
 }
 
 /**
@@ -92,130 +88,286 @@ getISASyntax(const gtirb::ISA ISA) {
   }
 }
 
-bool ElfBinaryPrinter::generateDummySO(
-    const gtirb::Module& Module, const std::string& LibDir,
-    const std::string& Lib, const std::vector<SymbolGroup>& SymGroups) const {
-
-  // Assume that lib is a filename w/ no path prefix
-  assert(!boost::filesystem::path(Lib).has_parent_path());
-  std::string AsmFileName = Lib + ".s";
-  auto AsmFilePath = boost::filesystem::path(LibDir) / AsmFileName;
-  auto LibPath = boost::filesystem::path(LibDir) / Lib;
-  bool EmittedSymvers = false;
+namespace {
+// A symbol to define in a dummy .so.
+struct DummySOSymbol {
+  std::string Name;
+  // Version suffix, e.g. "@@VER_1" or "@VER_1".
+  std::optional<std::string> Version;
+  std::string Type;
+  bool Weak;
+  uint64_t Size;
+};
+
+// Symbols that refer to the same location in a dummy .so.
+struct DummySOGroup {
+  std::vector<DummySOSymbol> Symbols;
+  uint64_t Space;
+};
+} // namespace
 
-  {
-    std::ofstream AsmFile(AsmFilePath.string());
-    AsmFile << "# Generated dummy file for .so undefined symbols\n";
-
-    std::unique_ptr<gtirb_pprint::ElfSyntax> Syntax =
-        getISASyntax(Module.getISA());
-
-    std::map<std::string, int> VersionedSymNameCounts;
-    for (auto& SymGroup : SymGroups) {
-      std::optional<uint64_t> SymSize;
-
-      for (auto Sym : SymGroup) {
-        std::string Name = Sym->getName();
-
-        auto SymInfo = aux_data::getElfSymbolInfo(*Sym);
-        if (!SymInfo) {
-          // See if we have a symbol for "foo_copy", if so use its info
-          // TODO: We should not rely on symbol names semanitcally here.
-          // When ddisasm makes the ElfSymbolInfo available on both the copy
-          // and original symbol, this check should not be necessary.
-          std::string CopyName = Sym->getName() + "_copy";
-          if (auto CopySymRange = Sym->getModule()->findSymbols(CopyName)) {
-            SymInfo = aux_data::getElfSymbolInfo(*(CopySymRange.begin()));
-          } else {
-            LOG_ERROR << "Symbol not in symbol table [" << Sym->getName()
-                      << "] while generating dummy SO\n";
-            return false;
-          }
-        }
+/**
+Print the assembly source of a dummy .so defining the given symbol groups.
 
-        if (!SymSize) {
-          SymSize = SymInfo->Size;
-        } else if (*SymSize != SymInfo->Size) {
-          LOG_ERROR << "Symbol group has mismatched sizes; " << Name << " is "
-                    << SymInfo->Size << " bytes, but had " << *SymSize
-                    << " bytes\n";
-          return false;
-        }
+Sets EmittedSymvers if any symbol is versioned.
+*/
+static std::string printDummySOAssembly(const gtirb_pprint::ElfSyntax& Syntax,
+                                        const std::vector<DummySOGroup>& Groups,
+                                        bool& EmittedSymvers) {
+  static const std::unordered_map<std::string, std::string>
+      TypeNameConversion = {
+          {"FUNC", "function"},  {"OBJECT", "object"},
+          {"NOTYPE", "notype"},  {"NONE", "notype"},
+          {"TLS", "tls_object"}, {"GNU_IFUNC", "gnu_indirect_function"},
+      };
+
+  std::ostringstream AsmFile;
+  AsmFile << "# Generated dummy file for .so undefined symbols\n";
+
+  std::map<std::string, int> VersionedSymNameCounts;
+  for (const DummySOGroup& Group : Groups) {
+    for (const DummySOSymbol& Sym : Group.Symbols) {
+      std::string Name = Sym.Name;
+      const std::string& SymType = Sym.Type;
+      if (SymType == "FUNC" || SymType == "GNU_IFUNC") {
+        AsmFile << Syntax.text() << "\n";
+      } else if (SymType == "TLS") {
+        AsmFile << ".section .tdata, \"waT\"\n";
+      } else {
+        AsmFile << Syntax.data() << "\n";
+      }
 
-        std::string SymType = SymInfo->Type;
-        if (SymType == "FUNC" || SymType == "GNU_IFUNC") {
-          AsmFile << Syntax->text() << "\n";
-        } else if (SymType == "TLS") {
-          AsmFile << ".section .tdata, \"waT\"\n";
+      if (Sym.Version) {
+        // There may be multiple versioned symbols of the same name.
+        // Generate unique names for them to prevent linking errors.
+        auto It = VersionedSymNameCounts.find(Name);
+        if (It == VersionedSymNameCounts.end()) {
+          VersionedSymNameCounts[Name] = 1;
         } else {
-          AsmFile << Syntax->data() << "\n";
+          std::stringstream UniqueNameBuilder;
+          UniqueNameBuilder << Name << "_disambig_" << ++It->second;
+          Name = UniqueNameBuilder.str();
         }
 
-        if (!Printer.getIgnoreSymbolVersions()) {
-          auto Version = aux_data::getSymbolVersionString(*Sym);
-          if (Version) {
-            // There may be multiple versioned symbols of the same name.
-            // Generate unique names for them to prevent linking errors.
-            std::string OriginalName = Name;
-            auto It = VersionedSymNameCounts.find(Name);
-            if (It == VersionedSymNameCounts.end()) {
-              VersionedSymNameCounts[Name] = 1;
-            } else {
-              std::stringstream UniqueNameBuilder;
-              UniqueNameBuilder << Name << "_disambig_" << ++It->second;
-              Name = UniqueNameBuilder.str();
-            }
+        AsmFile << Syntax.symVer() << " " << Name << "," << Sym.Name
+                << *Sym.Version << '\n';
+        EmittedSymvers = true;
+      }
 
-            AsmFile << Syntax->symVer() << " " << Name << "," << OriginalName
-                    << *Version << '\n';
-            EmittedSymvers = true;
-          }
-        }
+      AsmFile << (Sym.Weak ? Syntax.weak() : Syntax.global()) << " " << Name
+              << "\n";
 
-        std::string Binding;
-        if (SymInfo->Binding == "WEAK") {
-          Binding = Syntax->weak();
-        } else {
-          Binding = Syntax->global();
-        }
+      if ((SymType == "OBJECT" || SymType == "TLS") && Sym.Size != 0) {
+        AsmFile << Syntax.symSize() << " " << Name << ", " << Sym.Size << "\n";
+      }
 
-        AsmFile << Binding << " " << Name << "\n";
+      AsmFile << Syntax.type() << ' ' << Name << ", "
+              << Syntax.attributePrefix() << TypeNameConversion.at(SymType)
+              << "\n";
 
-        if ((SymType == "OBJECT" || SymType == "TLS") && SymInfo->Size != 0) {
-          AsmFile << Syntax->symSize() << " " << Name << ", " << SymInfo->Size
-                  << "\n";
+      AsmFile << Name << ":\n";
+    }
+
+    // only emit one .skip directive for each symbol group, as symbol groups
+    // represent symbols that refer to the same data.
+    AsmFile << ".skip " << Group.Space << "\n";
+  }
+  return AsmFile.str();
+}
+
+/**
+Convert symbol groups for writing a dummy .so directly with writeElfStub.
+
+Returns std::nullopt if the groups need features the writer lacks (TLS
+symbols, or code and data symbols sharing a location), in which case the
+library has to be assembled instead.
+*/
+static std::optional<std::vector<ElfStubGroup>>
+getElfStubGroups(const std::vector<DummySOGroup>& Groups) {
+  static const std::unordered_map<std::string, ElfStubSymbolType> Types = {
+      {"FUNC", ElfStubSymbolType::Func},
+      {"GNU_IFUNC", ElfStubSymbolType::GnuIFunc},
+      {"OBJECT", ElfStubSymbolType::Object},
+      {"NOTYPE", ElfStubSymbolType::NoType},
+      {"NONE", ElfStubSymbolType::NoType},
+  };
+
+  std::vector<ElfStubGroup> Result;
+  for (const DummySOGroup& Group : Groups) {
+    ElfStubGroup& StubGroup = Result.emplace_back();
+    StubGroup.Size = Group.Space;
+    for (const DummySOSymbol& Sym : Group.Symbols) {
+      auto It = Types.find(Sym.Type);
+      if (It == Types.end()) {
+        return std::nullopt;
+      }
+      bool Code = It->second == ElfStubSymbolType::Func ||
+                  It->second == ElfStubSymbolType::GnuIFunc;
+      if (&Sym == &Group.Symbols.front()) {
+        StubGroup.Code = Code;
+      } else if (StubGroup.Code != Code) {
+        return std::nullopt;
+      }
+
+      ElfStubSymbol& StubSym = StubGroup.Symbols.emplace_back();
+      StubSym.Name = Sym.Name;
+      StubSym.Type = It->second;
+      StubSym.Weak = Sym.Weak;
+      // Like the assembled libraries, only data symbols have a size.
+      StubSym.Size = It->second == ElfStubSymbolType::Object ? Sym.Size : 0;
+      if (Sym.Version) {
+        // "@@VER" is the default version of the symbol, "@VER" a hidden one.
+        size_t Ats = Sym.Version->find_first_not_of('@');
+        if (Ats == std::string::npos) {
+          return std::nullopt;
         }
+        StubSym.Version = Sym.Version->substr(Ats);
+        StubSym.HiddenVersion = Ats == 1;
+      }
+    }
+  }
+  return Result;
+}
 
-        static const std::unordered_map<std::string, std::string>
-            TypeNameConversion = {
-                {"FUNC", "function"},  {"OBJECT", "object"},
-                {"NOTYPE", "notype"},  {"NONE", "notype"},
-                {"TLS", "tls_object"}, {"GNU_IFUNC", "gnu_indirect_function"},
-            };
-        auto TypeNameIt = TypeNameConversion.find(SymType);
-        if (TypeNameIt == TypeNameConversion.end()) {
-          LOG_ERROR << "Unknown type: " << SymType
-                    << " for symbol: " << Sym->getName() << "\n";
-          return false;
+/**
+Get the machine for writing dummy .so files directly, if it is supported.
+*/
+static std::optional<ElfStubMachine>
+getElfStubMachine(const gtirb::Module& Module) {
+  if (Module.getByteOrder() != gtirb::ByteOrder::Little) {
+    return std::nullopt;
+  }
+  switch (Module.getISA()) {
+  case gtirb::ISA::X64:
+    return ElfStubMachine::X86_64;
+  case gtirb::ISA::IA32:
+    return ElfStubMachine::X86;
+  case gtirb::ISA::ARM64:
+    return ElfStubMachine::AArch64;
+  default:
+    return std::nullopt;
+  }
+}
+
+bool ElfBinaryPrinter::generateDummySO(
+    const gtirb::Module& Module, const std::string& LibDir,
+    const std::string& Lib, const std::vector<SymbolGroup>& SymGroups,
+    ProcessPool& Pool, std::vector<std::future<int>>& Builds) const {
+
+  // Assume that lib is a filename w/ no path prefix
+  assert(!boost::filesystem::path(Lib).has_parent_path());
+  std::string AsmFileName = Lib + ".s";
+  auto AsmFilePath = boost::filesystem::path(LibDir) / AsmFileName;
+  auto LibPath = boost::filesystem::path(LibDir) / Lib;
+
+  // Collect what has to be known about the symbols from the IR.
+  std::vector<DummySOGroup> Groups;
+  for (auto& SymGroup : SymGroups) {
+    DummySOGroup& Group = Groups.emplace_back();
+    std::optional<uint64_t> SymSize;
+
+    for (auto Sym : SymGroup) {
+      std::string Name = Sym->getName();
+
+      auto SymInfo = aux_data::getElfSymbolInfo(*Sym);
+      if (!SymInfo) {
+        // See if we have a symbol for "foo_copy", if so use its info
+        // TODO: We should not rely on symbol names semanitcally here.
+        // When ddisasm makes the ElfSymbolInfo available on both the copy
+        // and original symbol, this check should not be necessary.
+        std::string CopyName = Sym->getName() + "_copy";
+        if (auto CopySymRange = Sym->getModule()->findSymbols(CopyName)) {
+          SymInfo = aux_data::getElfSymbolInfo(*(CopySymRange.begin()));
         } else {
-          const auto& TypeName = TypeNameIt->second;
-          AsmFile << Syntax->type() << ' ' << Name << ", "
-                  << Syntax->attributePrefix() << TypeName << "\n";
+          LOG_ERROR << "Symbol not in symbol table [" << Sym->getName()
+                    << "] while generating dummy SO\n";
+          return false;
         }
+      }
 
-        AsmFile << Name << ":\n";
+      if (!SymSize) {
+        SymSize = SymInfo->Size;
+      } else if (*SymSize != SymInfo->Size) {
+        LOG_ERROR << "Symbol group has mismatched sizes; " << Name << " is "
+                  << SymInfo->Size << " bytes, but had " << *SymSize
+                  << " bytes\n";
+        return false;
       }
 
-      // only emit one .skip directive for each symbol group, as symbol groups
-      // represent symbols that refer to the same data.
-      uint64_t Space = *SymSize;
-      if (Space == 0) {
-        Space = 4;
+      static const std::unordered_set<std::string> KnownTypes = {
+          "FUNC", "OBJECT", "NOTYPE", "NONE", "TLS", "GNU_IFUNC"};
+      if (KnownTypes.count(SymInfo->Type) == 0) {
+        LOG_ERROR << "Unknown type: " << SymInfo->Type
+                  << " for symbol: " << Sym->getName() << "\n";
+        return false;
       }
-      AsmFile << ".skip " << Space << "\n";
+
+      std::optional<std::string> Version;
+      if (!Printer.getIgnoreSymbolVersions()) {
+        Version = aux_data::getSymbolVersionString(*Sym);
+      }
+
+      Group.Symbols.push_back({Name, Version, SymInfo->Type,
+                               SymInfo->Binding == "WEAK", SymInfo->Size});
+    }
+
+    // Reserve space once for each symbol group, as symbol groups represent
+    // symbols that refer to the same data.
+    Group.Space = *SymSize;
+    if (Group.Space == 0) {
+      Group.Space = 4;
     }
   }
 
+  // The assembly source also serves as a description of the library's
+  // symbols in the cache key.
+  bool EmittedSymvers = false;
+  std::unique_ptr<gtirb_pprint::ElfSyntax> Syntax =
+      getISASyntax(Module.getISA());
+  std::string AsmText = printDummySOAssembly(*Syntax, Groups, EmittedSymvers);
+
+  // Write the library directly when possible; this is much cheaper than
+  // running the compiler and linker.
+  std::optional<ElfStubMachine> Machine = getElfStubMachine(Module);
+  std::optional<std::vector<ElfStubGroup>> StubGroups;
+  if (Machine) {
+    StubGroups = getElfStubGroups(Groups);
+  }
+  if (StubGroups) {
+    std::string Key;
+    if (StubCache) {
+      Key = CacheKey()
+                .add("elf-dummy-so-native")
+                .add(Lib)
+                .add(static_cast<uint64_t>(*Machine))
+                .add(AsmText)
+                .str();
+      if (StubCache->fetch(Key, LibPath.string())) {
+        LOG_INFO << "Reusing cached dummy .so for " << Lib << "\n";
+        return true;
+      }
+    }
+    Builds.push_back(Pool.submit([Path = LibPath.string(), Lib,
+                                  StubMachine = *Machine,
+                                  Stubs = std::move(*StubGroups),
+                                  Cache = StubCache, Key]() {
+      if (!writeElfStub(Path, Lib, StubMachine, Stubs)) {
+        LOG_ERROR << "Failed to write dummy .so: " << Lib << "\n";
+        return -1;
+      }
+      if (Cache) {
+        Cache->publish(Key, Path);
+      }
+      return 0;
+    }));
+    return true;
+  }
+
+  {
+    std::ofstream AsmOut(AsmFilePath.string());
+    AsmOut << AsmText;
+  }
+
   std::vector<std::string> Args;
   Args.push_back("-o");
   Args.push_back(LibPath.string());
@@ -225,29 +377,58 @@ bool ElfBinaryPrinter::generateDummySO(
   Args.push_back("-nodefaultlibs");
   Args.push_back(AsmFilePath.string());
 
-  TempFile VersionScript(".map");
+  std::string VersionScriptText;
   if (EmittedSymvers) {
     if (!Printer.getIgnoreSymbolVersions()) {
-      // A version script is only needed if we define versioned symbols.
+      // A version script is only needed if we define versioned symbols. It
+      // is kept next to the source, as it has to outlive this function.
+      auto VersionScriptPath = boost::filesystem::path(LibDir) / (Lib + ".map");
+      std::ofstream VersionScript(VersionScriptPath.string());
       if (gtirb_pprint::printVersionScript(Module, VersionScript)) {
-        Args.push_back("-Wl,--version-script=" + VersionScript.fileName());
+        Args.push_back("-Wl,--version-script=" + VersionScriptPath.string());
       }
+      VersionScript.close();
+      std::ifstream VersionScriptIn(VersionScriptPath.string());
+      VersionScriptText.assign(std::istreambuf_iterator<char>(VersionScriptIn),
+                               std::istreambuf_iterator<char>());
     }
   }
-  VersionScript.close();
 
-  if (std::optional<int> Ret = execute(compiler, Args)) {
-    if (*Ret) {
-      std::cerr << "ERROR: Compiler returned " << *Ret
-                << " for dummy .so: " << Lib << "\n";
-      return false;
+  // The stub is fully determined by its source, its version script, and the
+  // compiler building it.
+  std::string Key;
+  if (StubCache) {
+    Key = CacheKey()
+              .add("elf-dummy-so")
+              .add(Lib)
+              .add(static_cast<uint64_t>(Module.getISA()))
+              .add(AsmText)
+              .add(VersionScriptText)
+              .add(ArtifactCache::toolIdentity(compiler))
+              .str();
+    if (StubCache->fetch(Key, LibPath.string())) {
+      LOG_INFO << "Reusing cached dummy .so for " << Lib << "\n";
+      return true;
     }
-
-    return true;
   }
 
-  std::cerr << "ERROR: Failed to run compiler for dummy .so: " << Lib << "\n";
-  return false;
+  // The source is complete; building it does not touch the IR, so it can run
+  // in the background.
+  Builds.push_back(Pool.submit([Compiler = compiler, Args, Lib, LibPath,
+                                Cache = StubCache, Key]() {
+    if (std::optional<int> Ret = execute(Compiler, Args)) {
+      if (*Ret) {
+        LOG_ERROR << "Compiler returned " << *Ret << " for dummy .so: " << Lib
+                  << "\n";
+      } else if (Cache) {
+        Cache->publish(Key, LibPath.string());
+      }
+      return *Ret;
+    }
+    LOG_ERROR << "Failed to run compiler for dummy .so: " << Lib << "\n";
+    return -1;
+  }));
+  return true;
 }
 
 /**
@@ -350,7 +531,8 @@ buildDummySOSymbolGroups(const gtirb::Context& Context,
 // we can link against those.
 bool ElfBinaryPrinter::prepareDummySOLibs(
     const gtirb::Context& Context, const gtirb::Module& Module,
-    const std::string& LibDir, std::vector<std::string>& LibArgs) const {
+    const std::string& LibDir, std::vector<std::string>& LibArgs,
+    ProcessPool& Pool, std::vector<std::future<int>>& Builds) const {
   // Collect all libs we need to handle
   std::vector<std::string> Libs;
   for (const auto& Library : aux_data::getLibraries(Module)) {
@@ -458,7 +640,8 @@ bool ElfBinaryPrinter::prepareDummySOLibs(
 
   // Generate the .so files
   for (const auto& Lib : Libs) {
-    if (!generateDummySO(Module, LibDir, Lib, AllocatedSymbols[Lib])) {
+    if (!generateDummySO(Module, LibDir, Lib, AllocatedSymbols[Lib], Pool,
+                         Builds)) {
       LOG_ERROR << "Failed generating dummy .so for " << Lib << "\n";
       return false;
     }
@@ -505,7 +688,7 @@ void ElfBinaryPrinter::addOrigLibraryArgs(const gtirb::Module& module,
   }
   std::string L = (Location == "" ? "." : Location);
   // add binary library paths (add them to rpath as well)
-  std::regex OriginRegex{R"((\$ORIGIN\b)|($\{ORIGIN\}))"};
+  static const std::regex OriginRegex{R"((\$ORIGIN\b)|($\{ORIGIN\}))"};
   for (const auto& LibraryPath : aux_data::getLibraryPaths(module)) {
     std::string LinkPath = std::regex_replace(LibraryPath, OriginRegex, L);
     args.push_back("-L" + LinkPath);
@@ -513,6 +696,31 @@ void ElfBinaryPrinter::addOrigLibraryArgs(const gtirb::Module& module,
   }
 }
 
+void ElfBinaryPrinter::addBuildToKey(CacheKey& Key,
+                                     const gtirb::Module& Module) const {
+  BinaryPrinter::addBuildToKey(Key, Module);
+  Key.add(ArtifactCache::toolIdentity(compiler));
+  Key.add(debug).add(useDummySO);
+  if (useDummySO) {
+    return;
+  }
+
+  // Libraries found on the library paths are identified by their contents;
+  // the others are left to the compiler to find, and identified by name.
+  std::vector<std::string> Paths = LibraryPaths;
+  auto BinaryLibraryPaths = aux_data::getLibraryPaths(Module);
+  Paths.insert(Paths.end(), BinaryLibraryPaths.begin(),
+               BinaryLibraryPaths.end());
+  for (const auto& Library : aux_data::getLibraries(Module)) {
+    Key.add(Library);
+    if (std::optional<std::string> Location = findLibrary(Library, Paths)) {
+      Key.addFile(*Location);
+    } else {
+      Key.add("");
+    }
+  }
+}
+
 static bool allGlobalVisibleSymsExported(gtirb::Context& Ctx,
                                          gtirb::Module& Module) {
   auto SymbolTabIdxInfo = aux_data::getElfSymbolTabIdxInfo(Module);
@@ -548,42 +756,53 @@ static bool allGlobalVisibleSymsExported(gtirb::Context& Ctx,
 }
 
 std::vector<std::string> ElfBinaryPrinter::buildCompilerArgs(
-    std::string outputFilename, const std::vector<TempFile>& asmPaths,
+    std::string outputFilename, const std::vector<std::string>& inputs,
     gtirb::Context& context, gtirb::Module& module,
-    const std::vector<std::string>& libArgs) const {
+    const std::vector<std::string>& libArgs, CompilerStep step) const {
   std::vector<std::string> args;
   // Start constructing the compile arguments, of the form
   // -o <output_filename> fileAXADA.s
   args.emplace_back("-o");
   args.emplace_back(outputFilename);
-  std::transform(asmPaths.begin(), asmPaths.end(), std::back_inserter(args),
-                 [](const TempFile& TF) { return TF.fileName(); });
-  args.emplace_back("-Wl,--no-as-needed");
-  args.insert(args.end(), ExtraCompileArgs.begin(), ExtraCompileArgs.end());
-  args.insert(args.end(), libArgs.begin(), libArgs.end());
-
-  // add pie, no pie, or shared, depending on the binary type
-  gtirb_pprint::DynMode DM = Printer.getDynMode(module);
-  switch (DM) {
-  case gtirb_pprint::DYN_MODE_SHARED:
-    args.push_back("-shared");
-    break;
-  case gtirb_pprint::DYN_MODE_PIE:
-    args.push_back("-pie");
-    break;
-  case gtirb_pprint::DYN_MODE_NONE:
-    args.push_back("-no-pie");
-    break;
-  default:
-    assert(!"Unknown binary type!");
+  if (step == CompilerStep::Assemble) {
+    args.emplace_back("-c");
+  }
+  args.insert(args.end(), inputs.begin(), inputs.end());
+  bool Links = step != CompilerStep::Assemble;
+  if (Links) {
+    args.emplace_back("-Wl,--no-as-needed");
   }
+  // The user's arguments are passed to every step, as they may hold both
+  // assembler and linker flags; the compiler ignores those of other steps.
+  args.insert(args.end(), ExtraCompileArgs.begin(), ExtraCompileArgs.end());
+
+  if (Links) {
+    args.insert(args.end(), libArgs.begin(), libArgs.end());
+
+    // add pie, no pie, or shared, depending on the binary type
+    gtirb_pprint::DynMode DM = Printer.getDynMode(module);
+    switch (DM) {
+    case gtirb_pprint::DYN_MODE_SHARED:
+      args.push_back("-shared");
+      break;
+    case gtirb_pprint::DYN_MODE_PIE:
+      args.push_back("-pie");
+      break;
+    case gtirb_pprint::DYN_MODE_NONE:
+      args.push_back("-no-pie");
+      break;
+    default:
+      assert(!"Unknown binary type!");
+    }
 
-  if (DM != gtirb_pprint::DYN_MODE_SHARED) {
-    // append -Wl,--export-dynamic if needed; can occur for both DYN and EXEC.
-    // TODO: if some symbols are exported, but not all, build a dynamic list
-    // file and pass with `--dynamic-list`.
-    if (allGlobalVisibleSymsExported(context, module)) {
-      args.push_back("-Wl,--export-dynamic");
+    if (DM != gtirb_pprint::DYN_MODE_SHARED) {
+      // append -Wl,--export-dynamic if needed; can occur for both DYN and
+      // EXEC.
+      // TODO: if some symbols are exported, but not all, build a dynamic list
+      // file and pass with `--dynamic-list`.
+      if (allGlobalVisibleSymsExported(context, module)) {
+        args.push_back("-Wl,--export-dynamic");
+      }
     }
   }
 
@@ -593,11 +812,13 @@ std::vector<std::string> ElfBinaryPrinter::buildCompilerArgs(
   }
 
   // Add stack properties linker flags
-  if (auto StackSize = module.getAuxData<gtirb::schema::ElfStackSize>()) {
+  if (auto StackSize = module.getAuxData<gtirb::schema::ElfStackSize>();
+      StackSize && Links) {
     args.push_back("-Wl,-z,stack-size=" + std::to_string(*StackSize));
   }
 
-  if (auto StackExec = module.getAuxData<gtirb::schema::ElfStackExec>()) {
+  if (auto StackExec = module.getAuxData<gtirb::schema::ElfStackExec>();
+      StackExec && Links) {
     args.push_back(*StackExec ? "-Wl,-z,execstack" : "-Wl,-z,noexecstack");
   }
 
@@ -615,17 +836,36 @@ std::vector<std::string> ElfBinaryPrinter::buildCompilerArgs(
   return args;
 }
 
+bool ElfBinaryPrinter::writeNativeObject(gtirb::Context& context,
+                                         gtirb::Module& module,
+                                         TempFile& object) const {
+  if (!NativeObject) {
+    return false;
+  }
+  if (!ExtraCompileArgs.empty()) {
+    LOG_WARNING << "Compiler arguments are not applied to objects written "
+                   "directly.\n";
+  }
+  object.close();
+  return Printer.writeObject(object.fileName(), context, module) == 0;
+}
+
 int ElfBinaryPrinter::assemble(const std::string& outputFilename,
                                gtirb::Context& ctx, gtirb::Module& mod) const {
+  if (TempFile Object(".o"); writeNativeObject(ctx, mod, Object)) {
+    copyFile(Object.fileName(), outputFilename);
+    return 0;
+  }
+
   TempFile tempFile;
   if (!prepareSource(ctx, mod, tempFile)) {
     std::cerr << "ERROR: Could not write assembly into a temporary file.\n";
     return -1;
   }
   TempFile tempOutput;
-  std::vector<std::string> args{{"-o", tempOutput.fileName(), "-c"}};
-  args.insert(args.end(), ExtraCompileArgs.begin(), ExtraCompileArgs.end());
-  args.push_back(tempFile.fileName());
+  std::vector<std::string> args =
+      buildCompilerArgs(tempOutput.fileName(), {tempFile.fileName()}, ctx, mod,
+                        {}, CompilerStep::Assemble);
 
   if (std::optional<int> ret = execute(compiler, args)) {
     if (*ret) {
@@ -679,11 +919,6 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
                            gtirb::Context& ctx, gtirb::Module& module) const {
   if (debug)
     std::cout << "Generating binary file" << std::endl;
-  TempFile tempFile;
-  if (!prepareSource(ctx, module, tempFile)) {
-    LOG_ERROR << "Could not write assembly into a temporary file.\n";
-    return -1;
-  }
 
   // Prep stuff for dynamic library dependences
   // Note that this temporary directory has to survive
@@ -692,6 +927,10 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
   std::vector<std::string> libArgs;
   boost::filesystem::path outputPath(outputFilename);
 
+  // Dummy libraries are built in the background while the module is printed
+  // and assembled.
+  ProcessPool Pool(Jobs);
+  std::vector<std::future<int>> DummySOJobs;
   if (useDummySO) {
     // Create the temporary directory for storing the synthetic libraries.
     dummySoDir.emplace();
@@ -701,7 +940,8 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
       return -1;
     }
 
-    if (!prepareDummySOLibs(ctx, module, dummySoDir->dirName(), libArgs)) {
+    if (!prepareDummySOLibs(ctx, module, dummySoDir->dirName(), libArgs, Pool,
+                            DummySOJobs)) {
       LOG_ERROR << "Could not create dummy so files for linking.\n";
       return -1;
     }
@@ -720,6 +960,71 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
                        outputPath.parent_path().generic_string());
   }
 
+  std::vector<TempFile> Files;
+  TempFile DirectObject(".o");
+  std::vector<TempFile> Sources;
+  if (writeNativeObject(ctx, module, DirectObject)) {
+    bool DummySOFailed = false;
+    for (auto& Job : DummySOJobs) {
+      if (Job.get()) {
+        DummySOFailed = true;
+      }
+    }
+    if (DummySOFailed) {
+      LOG_ERROR << "Could not create dummy so files for linking.\n";
+      return -1;
+    }
+    Files.emplace_back(std::move(DirectObject));
+  } else if (!prepareUnitSources(ctx, module, Sources)) {
+    LOG_ERROR << "Could not write assembly into a temporary file.\n";
+    return -1;
+  } else if (Sources.size() == 1 && DummySOJobs.empty()) {
+    Files = std::move(Sources);
+  } else {
+    // Assemble the compilation units on the pool, so that they are assembled
+    // concurrently with each other and with the compilers building the dummy
+    // libraries.
+    std::vector<std::future<int>> AsmJobs;
+    for (const TempFile& Source : Sources) {
+      TempFile Object(".o");
+      Object.close();
+      std::vector<std::string> AsmArgs =
+          buildCompilerArgs(Object.fileName(), {Source.fileName()}, ctx,
+                            module, {}, CompilerStep::Assemble);
+      AsmJobs.push_back(Pool.submit([Compiler = compiler, AsmArgs]() {
+        if (std::optional<int> Ret = execute(Compiler, AsmArgs)) {
+          if (*Ret) {
+            LOG_ERROR << "assembler returned: " << *Ret << "\n";
+          }
+          return *Ret;
+        }
+        LOG_ERROR << "could not find the assembler '" << Compiler
+                  << "' on the PATH.\n";
+        return -1;
+      }));
+      Files.emplace_back(std::move(Object));
+    }
+    bool DummySOFailed = false;
+    for (auto& Job : DummySOJobs) {
+      if (Job.get()) {
+        DummySOFailed = true;
+      }
+    }
+    int AsmRet = 0;
+    for (auto& Job : AsmJobs) {
+      if (int Ret = Job.get(); Ret && !AsmRet) {
+        AsmRet = Ret;
+      }
+    }
+    if (AsmRet) {
+      return AsmRet;
+    }
+    if (DummySOFailed) {
+      LOG_ERROR << "Could not create dummy so files for linking.\n";
+      return -1;
+    }
+  }
+
   TempFile VersionScript(".map");
   if (aux_data::hasVersionedSymDefs(module) &&
       !Printer.getIgnoreSymbolVersions()) {
@@ -729,8 +1034,6 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
     }
   }
   VersionScript.close();
-  std::vector<TempFile> Files;
-  Files.emplace_back(std::move(tempFile));
 
   // Add -Wl,-init= and -Wl,-fini= arguments if necessary.
   // This recreates DT_INIT and DT_FINI dynamic entries.
@@ -746,10 +1049,13 @@ int ElfBinaryPrinter::link(const std::string& outputFilename,
           "fini")) {
     libArgs.push_back(*Arg);
   }
+  std::vector<std::string> Inputs;
+  std::transform(Files.begin(), Files.end(), std::back_inserter(Inputs),
+                 [](const TempFile& TF) { return TF.fileName(); });
   TempFile tempOutput(std::string(""));
   if (std::optional<int> ret =
-          execute(compiler, buildCompilerArgs(tempOutput.fileName(), Files, ctx,
-                                              module, libArgs))) {
+          execute(compiler, buildCompilerArgs(tempOutput.fileName(), Inputs,
+                                              ctx, module, libArgs))) {
     if (*ret) {
       LOG_ERROR << "assembler returned: " << *ret << "\n";
     } else {
@@ -0,0 +1,1186 @@
+//===- ElfObjectPrinter.cpp -------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ElfObjectPrinter.hpp"
+#include "ElfWriter.hpp"
+#include "driver/Logger.h"
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+
+using gtirb_bprint::ElfObjectSection;
+using gtirb_bprint::ElfObjectSymbol;
+using gtirb_bprint::ElfObjectSymbolKind;
+using gtirb_bprint::ElfRelocationType;
+
+namespace gtirb_pprint {
+
+namespace {
+
+constexpr uint32_t ShtProgbits = 1;
+constexpr uint32_t ShtNote = 7;
+constexpr uint32_t ShtNobits = 8;
+constexpr uint32_t ShtInitArray = 14;
+constexpr uint32_t ShtFiniArray = 15;
+constexpr uint32_t ShtPreinitArray = 16;
+constexpr uint32_t ShtX86_64Unwind = 0x70000001;
+
+constexpr uint64_t ShfWrite = 0x1;
+constexpr uint64_t ShfAlloc = 0x2;
+constexpr uint64_t ShfExecInstr = 0x4;
+constexpr uint64_t ShfTls = 0x400;
+
+constexpr uint64_t ShnCommon = 0xfff2;
+
+constexpr uint8_t SttNotype = 0;
+constexpr uint8_t SttObject = 1;
+constexpr uint8_t SttFunc = 2;
+constexpr uint8_t SttSection = 3;
+constexpr uint8_t SttTls = 6;
+constexpr uint8_t SttGnuIFunc = 10;
+
+constexpr uint8_t StbLocal = 0;
+constexpr uint8_t StbGlobal = 1;
+constexpr uint8_t StbWeak = 2;
+constexpr uint8_t StbGnuUnique = 10;
+
+constexpr uint8_t StvDefault = 0;
+constexpr uint8_t StvInternal = 1;
+constexpr uint8_t StvHidden = 2;
+constexpr uint8_t StvProtected = 3;
+
+// DWARF call frame instructions.
+constexpr uint8_t DwCfaAdvanceLoc = 0x40;
+constexpr uint8_t DwCfaOffset = 0x80;
+constexpr uint8_t DwCfaRestore = 0xc0;
+constexpr uint8_t DwCfaAdvanceLoc1 = 0x02;
+constexpr uint8_t DwCfaAdvanceLoc2 = 0x03;
+constexpr uint8_t DwCfaAdvanceLoc4 = 0x04;
+constexpr uint8_t DwCfaOffsetExtended = 0x05;
+constexpr uint8_t DwCfaRestoreExtended = 0x06;
+constexpr uint8_t DwCfaUndefined = 0x07;
+constexpr uint8_t DwCfaSameValue = 0x08;
+constexpr uint8_t DwCfaRegister = 0x09;
+constexpr uint8_t DwCfaRememberState = 0x0a;
+constexpr uint8_t DwCfaRestoreState = 0x0b;
+constexpr uint8_t DwCfaDefCfa = 0x0c;
+constexpr uint8_t DwCfaDefCfaRegister = 0x0d;
+constexpr uint8_t DwCfaDefCfaOffset = 0x0e;
+constexpr uint8_t DwCfaOffsetExtendedSf = 0x11;
+
+// The x86-64 CIE emitted by the assembler: code alignment 1, data alignment
+// -8, return address in r16 (rip), and CFA = rsp + 8 on entry.
+constexpr int64_t DataAlignment = -8;
+constexpr int64_t InitialCfaOffset = 8;
+
+std::string hex(uint64_t Value) {
+  std::stringstream Stream;
+  Stream << "0x" << std::hex << Value;
+  return Stream.str();
+}
+
+void appendLE(std::vector<uint8_t>& Data, uint64_t Value, uint64_t Size) {
+  for (uint64_t I = 0; I < Size; ++I) {
+    Data.push_back(static_cast<uint8_t>(Value >> (8 * I)));
+  }
+}
+
+void appendUleb(std::vector<uint8_t>& Data, uint64_t Value) {
+  do {
+    uint8_t Byte = Value & 0x7f;
+    Value >>= 7;
+    Data.push_back(Value ? Byte | 0x80 : Byte);
+  } while (Value);
+}
+
+void appendSleb(std::vector<uint8_t>& Data, int64_t Value) {
+  bool More = true;
+  while (More) {
+    uint8_t Byte = Value & 0x7f;
+    Value >>= 7;
+    More = !((Value == 0 && !(Byte & 0x40)) || (Value == -1 && (Byte & 0x40)));
+    Data.push_back(More ? Byte | 0x80 : Byte);
+  }
+}
+
+// Set the STT_*, STB_*, and STV_* values and the size of Entry from the ELF
+// symbol information of a symbol, as the directives printed by
+// ElfPrettyPrinter::printSymbolHeader would. Returns false if the
+// information is not recognized.
+bool setSymbolAttributes(ElfObjectSymbol& Entry,
+                         const aux_data::ElfSymbolInfo& Info) {
+  static const std::unordered_map<std::string, uint8_t> Types = {
+      {"NOTYPE", SttNotype}, {"NONE", SttNotype},
+      {"OBJECT", SttObject}, {"FUNC", SttFunc},
+      {"TLS", SttTls},       {"GNU_IFUNC", SttGnuIFunc}};
+  static const std::unordered_map<std::string, uint8_t> Bindings = {
+      {"LOCAL", StbLocal},
+      {"GLOBAL", StbGlobal},
+      {"WEAK", StbWeak},
+      {"UNIQUE", StbGnuUnique},
+      {"GNU_UNIQUE", StbGnuUnique}};
+  static const std::unordered_map<std::string, uint8_t> Visibilities = {
+      {"DEFAULT", StvDefault},
+      {"INTERNAL", StvInternal},
+      {"HIDDEN", StvHidden},
+      {"PROTECTED", StvProtected}};
+
+  auto Type = Types.find(Info.Type);
+  auto Binding = Bindings.find(Info.Binding);
+  auto Visibility = Visibilities.find(Info.Visibility);
+  if (Type == Types.end() || Binding == Bindings.end() ||
+      Visibility == Visibilities.end()) {
+    return false;
+  }
+  Entry.Type = Type->second;
+  Entry.Binding = Binding->second;
+  Entry.Visibility = Visibility->second;
+  // `.type sym, @gnu_unique_object` makes an object symbol.
+  if (Entry.Binding == StbGnuUnique) {
+    Entry.Type = SttObject;
+  }
+  if (Info.Type == "OBJECT" || Info.Type == "TLS") {
+    Entry.Size = Info.Size;
+  }
+  return true;
+}
+
+// Symbols the assembler does not keep in the symbol table; relocations
+// against them are made against their section instead.
+bool isLocalLabel(const ElfObjectSymbol& Entry) {
+  return Entry.Kind == ElfObjectSymbolKind::Defined &&
+         Entry.Binding == StbLocal && Entry.Name.rfind(".L", 0) == 0;
+}
+
+bool fitsIn(int64_t Value, uint64_t Size) {
+  if (Size >= 8) {
+    return true;
+  }
+  int64_t Bits = static_cast<int64_t>(8 * Size);
+  return Value >= -(int64_t{1} << (Bits - 1)) && Value < (int64_t{1} << Bits);
+}
+
+const ElfSyntax& objectSyntax() {
+  static const ElfSyntax Syntax{};
+  return Syntax;
+}
+
+} // namespace
+
+ElfObjectPrinter::ElfObjectPrinter(gtirb::Context& context_,
+                                   const gtirb::Module& module_,
+                                   const PrintingPolicy& policy_)
+    : AttPrettyPrinter(context_, module_, objectSyntax(), policy_) {}
+
+bool ElfObjectPrinter::write(const std::string& Path) {
+  // Walk the module as the printer would; the overrides below build the
+  // object instead of printing it.
+  std::ostream Discard(nullptr);
+  print(Discard);
+
+  if (OpenFrame) {
+    unsupported("unterminated .cfi_startproc");
+  }
+  buildEhFrame();
+  resolveFixups();
+
+  if (Unsupported) {
+    LOG_INFO << "Cannot write the object file directly (" << *Unsupported
+             << "); using the assembler instead.\n";
+    return false;
+  }
+
+  // Drop the local labels, which are only referenced through their sections.
+  std::vector<size_t> NewIndices(Object.Symbols.size());
+  std::vector<ElfObjectSymbol> Kept;
+  for (size_t I = 0; I < Object.Symbols.size(); ++I) {
+    if (!isLocalLabel(Object.Symbols[I])) {
+      NewIndices[I] = Kept.size();
+      Kept.push_back(std::move(Object.Symbols[I]));
+    }
+  }
+  Object.Symbols = std::move(Kept);
+  for (ElfObjectSection& Section : Object.Sections) {
+    for (auto& Relocation : Section.Relocations) {
+      Relocation.Symbol = NewIndices[Relocation.Symbol];
+    }
+  }
+
+  if (!gtirb_bprint::writeElfObject(Path, Object)) {
+    LOG_ERROR << "Unable to write object file " << Path << "\n";
+    return false;
+  }
+  return true;
+}
+
+void ElfObjectPrinter::unsupported(const std::string& Reason) {
+  if (!Unsupported) {
+    Unsupported = Reason;
+  }
+}
+
+ElfObjectSection& ElfObjectPrinter::currentSection() {
+  return Object.Sections[*CurrentSection];
+}
+
+uint64_t ElfObjectPrinter::sectionOffset() {
+  ElfObjectSection& Section = currentSection();
+  return Section.Type == ShtNobits ? Section.NoBitsSize
+                                   : Section.Contents.size();
+}
+
+void ElfObjectPrinter::printSectionHeader(std::ostream& /* os */,
+                                          const gtirb::Section& section) {
+  const std::string& Name = section.getName();
+  if (auto It = SectionIndices.find(Name); It != SectionIndices.end()) {
+    CurrentSection = It->second;
+    return;
+  }
+
+  ElfObjectSection Section;
+  Section.Name = Name;
+  if (auto Properties = aux_data::getSectionProperties(section)) {
+    auto [Type, Flags] = *Properties;
+    switch (Type) {
+    case ShtProgbits:
+    case ShtNobits:
+    case ShtNote:
+    case ShtInitArray:
+    case ShtFiniArray:
+    case ShtPreinitArray:
+      Section.Type = static_cast<uint32_t>(Type);
+      break;
+    default:
+      Section.Type = ShtProgbits;
+      break;
+    }
+    Section.Flags = Flags & (ShfWrite | ShfAlloc | ShfExecInstr | ShfTls);
+  } else {
+    Section.Type = section.isFlagSet(gtirb::SectionFlag::Initialized)
+                       ? ShtProgbits
+                       : ShtNobits;
+    if (section.isFlagSet(gtirb::SectionFlag::Loaded)) {
+      Section.Flags |= ShfAlloc;
+    }
+    if (section.isFlagSet(gtirb::SectionFlag::Writable)) {
+      Section.Flags |= ShfWrite;
+    }
+    if (section.isFlagSet(gtirb::SectionFlag::Executable)) {
+      Section.Flags |= ShfExecInstr;
+    }
+  }
+
+  CurrentSection = Object.Sections.size();
+  SectionIndices[Name] = *CurrentSection;
+  Object.Sections.push_back(std::move(Section));
+}
+
+void ElfObjectPrinter::printSectionFooter(std::ostream& /* os */,
+                                          const gtirb::Section& /* section */) {
+}
+
+void ElfObjectPrinter::printAlignment(std::ostream& /* OS */,
+                                      uint64_t Alignment) {
+  if (!CurrentSection || Alignment <= 1) {
+    return;
+  }
+  ElfObjectSection& Section = currentSection();
+  Section.Alignment = std::max(Section.Alignment, Alignment);
+  uint64_t Aligned =
+      gtirb_bprint::elf_writer::alignTo(sectionOffset(), Alignment);
+  if (Section.Type == ShtNobits) {
+    Section.NoBitsSize = Aligned;
+  } else {
+    // Pad code with nops, as the assembler does.
+    uint8_t Fill = (Section.Flags & ShfExecInstr) ? 0x90 : 0;
+    Section.Contents.resize(Aligned, Fill);
+  }
+}
+
+void ElfObjectPrinter::printBlockContents(std::ostream& /* os */,
+                                          const gtirb::CodeBlock& block,
+                                          uint64_t offset) {
+  if (offset > block.getSize()) {
+    return;
+  }
+  if (!CurrentSection || currentSection().Type == ShtNobits) {
+    unsupported("code outside of a section with contents");
+    return;
+  }
+
+  gtirb::Addr Addr = *block.getAddress();
+  const uint8_t* Bytes = block.rawBytes<uint8_t>() + offset;
+  uint64_t Size = block.getSize() - offset;
+  std::vector<uint8_t>& Contents = currentSection().Contents;
+  uint64_t Start = Contents.size();
+  Contents.insert(Contents.end(), Bytes, Bytes + Size);
+
+  // The bytes are copied as they are; the instructions are decoded only to
+  // find their symbolic operands.
+  cs_insn* Insn;
+  cs_option(this->csHandle, CS_OPT_DETAIL, CS_OPT_ON);
+  size_t Count = cs_disasm(this->csHandle, Bytes, Size,
+                           static_cast<uint64_t>(Addr) + offset, 0, &Insn);
+
+  // Exception-safe cleanup of instructions
+  std::unique_ptr<cs_insn, std::function<void(cs_insn*)>> FreeInsn(
+      Insn, [Count](cs_insn* I) { cs_free(I, Count); });
+
+  gtirb::Offset BlockOffset(block.getUUID(), offset);
+  uint64_t Decoded = 0;
+  for (size_t I = 0; I < Count; I++) {
+    addCFIDirectives(BlockOffset, Start + Decoded);
+    addInstructionFixups(block, Insn[I], Start + Decoded);
+    Decoded += Insn[I].size;
+    BlockOffset.Displacement += Insn[I].size;
+  }
+  if (Decoded != Size) {
+    unsupported("undecodable code at " + hex(uint64_t{Addr} + offset));
+  }
+  // CFI directives located at the end of the block, e.g. '.cfi_endproc'.
+  addCFIDirectives(BlockOffset, Start + Decoded);
+}
+
+void ElfObjectPrinter::printBlockContents(std::ostream& /* os */,
+                                          const gtirb::DataBlock& block,
+                                          uint64_t offset) {
+  if (offset > block.getSize()) {
+    return;
+  }
+  if (!CurrentSection) {
+    unsupported("data outside of a section");
+    return;
+  }
+
+  const gtirb::ByteInterval* BI = block.getByteInterval();
+  uint64_t Size = block.getSize() - offset;
+  uint64_t BlockStart = block.getOffset() + offset;
+
+  // Bytes past the initialized part of the byte interval are zero.
+  std::vector<uint8_t> Bytes(Size, 0);
+  uint64_t Initialized = BI->getInitializedSize();
+  if (Initialized > BlockStart) {
+    std::copy_n(BI->rawBytes<uint8_t>() + BlockStart,
+                std::min(Size, Initialized - BlockStart), Bytes.begin());
+  }
+
+  // Mirror PrettyPrinterBase::printBlockContents: zero-filled blocks are
+  // printed with `.zero`, and the others byte by byte.
+  bool Zero = std::all_of(Bytes.begin(), Bytes.end(),
+                          [](uint8_t B) { return B == 0; }) &&
+              !BI->getSymbolicExpression(BlockStart);
+  ElfObjectSection& Section = currentSection();
+  if (Section.Type == ShtNobits) {
+    if (!Zero) {
+      unsupported("initialized data in section " + Section.Name);
+      return;
+    }
+    Section.NoBitsSize += Size;
+    return;
+  }
+  uint64_t Start = Section.Contents.size();
+  if (Zero) {
+    Section.Contents.resize(Start + Size, 0);
+    return;
+  }
+
+  std::optional<std::string> Type = aux_data::getEncodingType(block);
+  if (Type == "string" || Type == "ascii") {
+    // ElfPrettyPrinter::printString only prints the non-null bytes.
+    std::copy_if(Bytes.begin(), Bytes.end(),
+                 std::back_inserter(Section.Contents),
+                 [](uint8_t B) { return B != 0; });
+    if (Type == "string") {
+      Section.Contents.push_back(0);
+    }
+    return;
+  }
+
+  Section.Contents.insert(Section.Contents.end(), Bytes.begin(), Bytes.end());
+  uint64_t Next = BlockStart;
+  for (const auto& SEE :
+       BI->findSymbolicExpressionsAtOffset(BlockStart, BlockStart + Size)) {
+    if (SEE.getOffset() < Next) {
+      // Overlaps the previous expression; the printer skips it too.
+      continue;
+    }
+    if (Type == "uleb128" || Type == "sleb128") {
+      unsupported(*Type + " data at " +
+                  hex(uint64_t{*block.getAddress()} + offset));
+      return;
+    }
+    uint64_t ExprSize = getSymbolicExpressionSize(SEE);
+    if (ExprSize == 0 || SEE.getOffset() + ExprSize > BlockStart + Size) {
+      unsupported("symbolic expression of unknown size at " +
+                  hex(uint64_t{*BI->getAddress()} + SEE.getOffset()));
+      return;
+    }
+    addDataFixup(SEE.getSymbolicExpression(),
+                 Start + (SEE.getOffset() - BlockStart), ExprSize);
+    Next = SEE.getOffset() + ExprSize;
+  }
+}
+
+void ElfObjectPrinter::printFunctionEnd(std::ostream& /* OS */,
+                                        const gtirb::Symbol& FunctionSymbol) {
+  auto It = SymbolIndices.find(&FunctionSymbol);
+  if (It == SymbolIndices.end() || !CurrentSection) {
+    return;
+  }
+  ElfObjectSymbol& Entry = Object.Symbols[It->second];
+  if (Entry.Kind != ElfObjectSymbolKind::Defined ||
+      Entry.Section != *CurrentSection) {
+    return;
+  }
+  Entry.Size = sectionOffset() - Entry.Value;
+  // The versioned alias is a copy of the symbol.
+  if (auto Alias = VersionAliases.find(It->second);
+      Alias != VersionAliases.end()) {
+    Object.Symbols[Alias->second].Size = Entry.Size;
+  }
+}
+
+void ElfObjectPrinter::printSymbolDefinition(std::ostream& /* os */,
+                                             const gtirb::Symbol& symbol) {
+  if (!CurrentSection) {
+    unsupported("symbol " + getSymbolName(symbol) + " outside of a section");
+    return;
+  }
+  defineSymbol(symbol, ElfObjectSymbolKind::Defined, sectionOffset());
+}
+
+void ElfObjectPrinter::printSymbolDefinitionRelativeToPC(
+    std::ostream& /* os */, const gtirb::Symbol& symbol, gtirb::Addr pc) {
+  if (!CurrentSection) {
+    unsupported("symbol " + getSymbolName(symbol) + " outside of a section");
+    return;
+  }
+  int64_t Delta = *symbol.getAddress() - pc;
+  defineSymbol(symbol, ElfObjectSymbolKind::Defined,
+               static_cast<uint64_t>(static_cast<int64_t>(sectionOffset()) +
+                                     Delta));
+}
+
+void ElfObjectPrinter::printIntegralSymbol(std::ostream& /* os */,
+                                           const gtirb::Symbol& symbol) {
+  defineSymbol(symbol, ElfObjectSymbolKind::Absolute,
+               static_cast<uint64_t>(*symbol.getAddress()));
+}
+
+void ElfObjectPrinter::printUndefinedSymbol(std::ostream& /* os */,
+                                            const gtirb::Symbol& symbol) {
+  auto Info = aux_data::getElfSymbolInfo(symbol);
+  if (!Info || Info->Type == "FILE") {
+    return;
+  }
+  if (SymbolIndices.count(&symbol)) {
+    return;
+  }
+
+  ElfObjectSymbol Entry;
+  Entry.Name = getSymbolName(symbol);
+  if (Info->SectionIndex == ShnCommon) {
+    // `.comm name, size[, alignment]`: without an explicit alignment, the
+    // assembler uses the largest power of two not larger than the size, up
+    // to 16.
+    Entry.Kind = ElfObjectSymbolKind::Common;
+    Entry.Type = SttObject;
+    Entry.Binding = StbGlobal;
+    Entry.Size = Info->Size;
+    Entry.Value = 1;
+    if (auto Alignment = aux_data::getAlignment(symbol.getUUID(), module)) {
+      Entry.Value = *Alignment;
+    } else {
+      while (Entry.Value < 16 && Entry.Value * 2 <= Entry.Size) {
+        Entry.Value *= 2;
+      }
+    }
+    addSymbol(symbol, std::move(Entry));
+    return;
+  }
+
+  auto Version = aux_data::getSymbolVersionString(symbol);
+  if (Info->Binding == "LOCAL" && Info->Visibility == "DEFAULT" &&
+      (Info->Type == "NOTYPE" || Info->Type == "NONE") && !Version) {
+    // Nothing is printed for these; a reference makes a global symbol.
+    return;
+  }
+  if (!setSymbolAttributes(Entry, *Info)) {
+    unsupported("unknown ELF symbol information for " + Entry.Name);
+    return;
+  }
+  // The assembler makes undefined symbols global.
+  if (Entry.Binding == StbLocal) {
+    Entry.Binding = StbGlobal;
+  }
+  Entry.Size = 0;
+  if (Version && !policy.IgnoreSymbolVersions) {
+    // `.symver Name, Symbol@VERSION`: references to the symbol use the
+    // versioned name.
+    Entry.Name = symbol.getName() + *Version;
+  }
+  if (auto It = SymbolNames.find(Entry.Name); It != SymbolNames.end()) {
+    SymbolIndices[&symbol] = It->second;
+    return;
+  }
+  addSymbol(symbol, std::move(Entry));
+}
+
+size_t ElfObjectPrinter::addSymbol(const gtirb::Symbol& Symbol,
+                                   ElfObjectSymbol Entry) {
+  size_t Index = Object.Symbols.size();
+  if (!SymbolNames.emplace(Entry.Name, Index).second) {
+    unsupported("symbol " + Entry.Name + " is defined more than once");
+  }
+  Object.Symbols.push_back(std::move(Entry));
+  SymbolIndices[&Symbol] = Index;
+  return Index;
+}
+
+void ElfObjectPrinter::defineSymbol(const gtirb::Symbol& Symbol,
+                                    ElfObjectSymbolKind Kind, uint64_t Value) {
+  std::string Name = getSymbolName(Symbol);
+  if (SymbolIndices.count(&Symbol)) {
+    unsupported("symbol " + Name + " is defined more than once");
+    return;
+  }
+
+  ElfObjectSymbol Entry;
+  Entry.Name = Name;
+  Entry.Kind = Kind;
+  Entry.Section = Kind == ElfObjectSymbolKind::Defined ? *CurrentSection : 0;
+  Entry.Value = Value;
+
+  std::optional<std::string> Version;
+  // FILE symbols are never printed as such, only as labels.
+  if (auto Info = aux_data::getElfSymbolInfo(Symbol);
+      Info && Info->Type != "FILE") {
+    if (!setSymbolAttributes(Entry, *Info)) {
+      unsupported("unknown ELF symbol information for " + Name);
+      return;
+    }
+    Version = aux_data::getSymbolVersionString(Symbol);
+  }
+
+  if (Version && policy.IgnoreSymbolVersions) {
+    LOG_WARNING << "Ignored symbol version for " << Name << *Version << "\n";
+    Version = std::nullopt;
+  }
+  if (Version && Name == Symbol.getName() && Version->substr(0, 2) == "@@") {
+    // `.symver Name, Name@@@VERSION` renames the symbol.
+    Entry.Name = Name + *Version;
+    Version = std::nullopt;
+  }
+
+  ElfObjectSymbol Alias = Entry;
+  size_t Index = addSymbol(Symbol, std::move(Entry));
+  if (Version) {
+    // `.symver Name, Symbol@VERSION` defines a versioned alias.
+    Alias.Name = Symbol.getName() + *Version;
+    size_t AliasIndex = Object.Symbols.size();
+    if (!SymbolNames.emplace(Alias.Name, AliasIndex).second) {
+      unsupported("symbol " + Alias.Name + " is defined more than once");
+    }
+    Object.Symbols.push_back(std::move(Alias));
+    VersionAliases[Index] = AliasIndex;
+  }
+}
+
+size_t ElfObjectPrinter::symbolIndex(const gtirb::Symbol& Symbol) {
+  if (auto It = SymbolIndices.find(&Symbol); It != SymbolIndices.end()) {
+    return It->second;
+  }
+  // Symbols that were referenced but not printed are undefined.
+  std::string Name = getSymbolName(Symbol);
+  if (auto It = SymbolNames.find(Name); It != SymbolNames.end()) {
+    return It->second;
+  }
+  ElfObjectSymbol Entry;
+  Entry.Name = Name;
+  Entry.Binding = StbGlobal;
+  return addSymbol(Symbol, std::move(Entry));
+}
+
+size_t ElfObjectPrinter::sectionSymbol(size_t Section) {
+  if (auto It = SectionSymbols.find(Section); It != SectionSymbols.end()) {
+    return It->second;
+  }
+  ElfObjectSymbol Entry;
+  Entry.Kind = ElfObjectSymbolKind::Defined;
+  Entry.Section = Section;
+  Entry.Type = SttSection;
+  Entry.Binding = StbLocal;
+  size_t Index = Object.Symbols.size();
+  Object.Symbols.push_back(std::move(Entry));
+  SectionSymbols[Section] = Index;
+  return Index;
+}
+
+const gtirb::Symbol*
+ElfObjectPrinter::referenceTarget(const gtirb::Symbol* Symbol) const {
+  // Mirror PrettyPrinterBase::printSymbolReference, which prints 0 for
+  // skipped symbols.
+  if (!Symbol) {
+    return nullptr;
+  }
+  if (const gtirb::Symbol* Forwarded = getForwardedSymbol(Symbol)) {
+    if (decisions().isSkippedSymbolName(getSymbolName(*Forwarded))) {
+      return nullptr;
+    }
+    return Forwarded;
+  }
+  if (shouldSkip(*Symbol)) {
+    return nullptr;
+  }
+  return Symbol;
+}
+
+const ElfObjectSymbol*
+ElfObjectPrinter::definition(const gtirb::Symbol* Symbol) const {
+  if (auto It = SymbolIndices.find(Symbol); It != SymbolIndices.end()) {
+    const ElfObjectSymbol& Entry = Object.Symbols[It->second];
+    if (Entry.Kind == ElfObjectSymbolKind::Defined) {
+      return &Entry;
+    }
+  }
+  return nullptr;
+}
+
+void ElfObjectPrinter::addInstructionFixups(const gtirb::CodeBlock& Block,
+                                            const cs_insn& Insn,
+                                            uint64_t InsnOffset) {
+  const cs_x86& Detail = Insn.detail->x86;
+  const gtirb::ByteInterval* BI = Block.getByteInterval();
+  gtirb::Addr EA(Insn.address);
+  std::string Location = hex(Insn.address);
+
+  bool ReferencesCode =
+      cs_insn_group(this->csHandle, &Insn, CS_GRP_JUMP) ||
+      cs_insn_group(this->csHandle, &Insn, CS_GRP_CALL) ||
+      cs_insn_group(this->csHandle, &Insn, CS_GRP_BRANCH_RELATIVE);
+
+  std::set<uint8_t> Fields;
+  for (int I = 0; I < Detail.op_count; I++) {
+    const cs_x86_op& Op = Detail.operands[I];
+    uint8_t FieldOffset;
+    uint64_t FieldSize;
+    if (Op.type == X86_OP_IMM) {
+      FieldOffset = Detail.encoding.imm_offset;
+      FieldSize = ReferencesCode ? Insn.size - FieldOffset
+                                 : Detail.encoding.imm_size;
+    } else if (Op.type == X86_OP_MEM) {
+      FieldOffset = Detail.encoding.disp_offset;
+      FieldSize = Detail.encoding.disp_size;
+    } else {
+      continue;
+    }
+
+    const gtirb::SymbolicExpression* Symbolic = nullptr;
+    if (FieldOffset > 0) {
+      Symbolic =
+          BI->getSymbolicExpression(EA + FieldOffset - *BI->getAddress());
+    } else if (BI->getSymbolicExpression(EA - *BI->getAddress())) {
+      // Expressions at the start of the instruction come from tools that
+      // did not know where the field was.
+      unsupported("symbolic operand without a field offset at " + Location);
+      return;
+    }
+    if (!Symbolic) {
+      if (Op.type == X86_OP_IMM && ReferencesCode) {
+        // The printer prints the target address, not the displacement.
+        unsupported("branch without a symbolic target at " + Location);
+      }
+      continue;
+    }
+    if (!Fields.insert(FieldOffset).second) {
+      continue;
+    }
+    if (FieldOffset + FieldSize > Insn.size) {
+      unsupported("symbolic operand outside of the instruction at " +
+                  Location);
+      return;
+    }
+
+    Fixup F{*CurrentSection,
+            InsnOffset + FieldOffset,
+            FieldSize,
+            nullptr,
+            nullptr,
+            1,
+            0,
+            false,
+            ElfRelocationType::X86_64_64};
+
+    if (const auto* SAA = std::get_if<gtirb::SymAddrAddr>(Symbolic)) {
+      bool RipRelative = Op.type == X86_OP_MEM && Op.mem.base == X86_REG_RIP;
+      if (!SAA->Attributes.empty() || RipRelative ||
+          (Op.type == X86_OP_IMM && ReferencesCode)) {
+        unsupported("unsupported symbolic operand at " + Location);
+        return;
+      }
+      F.Sym1 = referenceTarget(SAA->Sym1);
+      F.Sym2 = referenceTarget(SAA->Sym2);
+      F.Scale = SAA->Scale;
+      F.Addend = SAA->Offset;
+      if (!F.Sym1 || !F.Sym2) {
+        unsupported("reference to a skipped symbol at " + Location);
+        return;
+      }
+      addFixup(F);
+      continue;
+    }
+
+    const auto& SAC = std::get<gtirb::SymAddrConst>(*Symbolic);
+    const auto& Attributes = SAC.Attributes;
+    bool Plt = Attributes.count(gtirb::SymAttribute::PLT) > 0;
+    bool GotPcRel = Attributes.count(gtirb::SymAttribute::GOT) > 0 &&
+                    Attributes.count(gtirb::SymAttribute::PCREL) > 0;
+    F.Sym1 = referenceTarget(SAC.Sym);
+    F.Addend = SAC.Offset;
+    if (!F.Sym1) {
+      unsupported("reference to a skipped symbol at " + Location);
+      return;
+    }
+
+    if (Op.type == X86_OP_IMM && ReferencesCode) {
+      // As recent assemblers do, use PLT32 for all 32-bit branches.
+      if (Attributes.size() > (Plt ? 1u : 0u)) {
+        unsupported("unsupported branch target at " + Location);
+        return;
+      }
+      F.PCRelative = true;
+      F.Addend -= static_cast<int64_t>(FieldSize);
+      F.Type = ElfRelocationType::X86_64_PLT32;
+    } else if (Op.type == X86_OP_MEM && Op.mem.base == X86_REG_RIP) {
+      if (FieldSize != 4 ||
+          Attributes.size() > (GotPcRel ? 2u : (Plt ? 1u : 0u))) {
+        unsupported("unsupported RIP-relative operand at " + Location);
+        return;
+      }
+      F.PCRelative = true;
+      F.Addend -= Insn.size - FieldOffset;
+      F.Type = GotPcRel ? ElfRelocationType::X86_64_GOTPCREL
+                        : ElfRelocationType::X86_64_PC32;
+    } else {
+      if (Attributes.size() > (Plt ? 1u : 0u)) {
+        unsupported("unsupported symbolic operand at " + Location);
+        return;
+      }
+      switch (FieldSize) {
+      case 8:
+        F.Type = ElfRelocationType::X86_64_64;
+        break;
+      case 4:
+        // Sign-extended unless the operand is 32 bits wide.
+        F.Type = (Op.type == X86_OP_MEM || Op.size == 8)
+                     ? ElfRelocationType::X86_64_32S
+                     : ElfRelocationType::X86_64_32;
+        break;
+      case 2:
+        F.Type = ElfRelocationType::X86_64_16;
+        break;
+      case 1:
+        F.Type = ElfRelocationType::X86_64_8;
+        break;
+      default:
+        unsupported("unsupported operand size at " + Location);
+        return;
+      }
+    }
+    addFixup(F);
+  }
+}
+
+void ElfObjectPrinter::addDataFixup(const gtirb::SymbolicExpression& Expr,
+                                    uint64_t Offset, uint64_t Size) {
+  Fixup F{*CurrentSection, Offset, Size, nullptr, nullptr, 1, 0, false,
+          ElfRelocationType::X86_64_64};
+  std::string Location = hex(Offset) + " in " + currentSection().Name;
+
+  if (const auto* SAA = std::get_if<gtirb::SymAddrAddr>(&Expr)) {
+    if (!SAA->Attributes.empty()) {
+      unsupported("unsupported symbolic data at " + Location);
+      return;
+    }
+    F.Sym1 = referenceTarget(SAA->Sym1);
+    F.Sym2 = referenceTarget(SAA->Sym2);
+    F.Scale = SAA->Scale;
+    F.Addend = SAA->Offset;
+    if (!F.Sym1 || !F.Sym2) {
+      unsupported("reference to a skipped symbol at " + Location);
+      return;
+    }
+    addFixup(F);
+    return;
+  }
+
+  const auto& SAC = std::get<gtirb::SymAddrConst>(Expr);
+  // `@PLT` is not printed in data.
+  for (auto Attribute : SAC.Attributes) {
+    if (Attribute != gtirb::SymAttribute::PLT) {
+      unsupported("unsupported symbolic data at " + Location);
+      return;
+    }
+  }
+  switch (Size) {
+  case 8:
+    F.Type = ElfRelocationType::X86_64_64;
+    break;
+  case 4:
+    F.Type = ElfRelocationType::X86_64_32;
+    break;
+  case 2:
+    F.Type = ElfRelocationType::X86_64_16;
+    break;
+  case 1:
+    F.Type = ElfRelocationType::X86_64_8;
+    break;
+  default:
+    unsupported("unsupported symbolic data size at " + Location);
+    return;
+  }
+  // References to skipped symbols are printed as 0.
+  F.Sym1 = referenceTarget(SAC.Sym);
+  F.Addend = SAC.Offset;
+  addFixup(F);
+}
+
+void ElfObjectPrinter::addFixup(const Fixup& F) {
+  // As with the assembler, fields with relocations hold zero.
+  auto& Contents = Object.Sections[F.Section].Contents;
+  std::fill_n(Contents.begin() + F.Offset, F.Size, 0);
+  if (F.Sym1) {
+    Fixups.push_back(F);
+  }
+}
+
+void ElfObjectPrinter::addRelocation(size_t Section, uint64_t Offset,
+                                     const gtirb::Symbol& Target,
+                                     ElfRelocationType Type, int64_t Addend) {
+  size_t Index = symbolIndex(Target);
+  const ElfObjectSymbol& Entry = Object.Symbols[Index];
+  if (isLocalLabel(Entry)) {
+    Addend += static_cast<int64_t>(Entry.Value);
+    Index = sectionSymbol(Entry.Section);
+  }
+  Object.Sections[Section].Relocations.push_back({Offset, Index, Type, Addend});
+}
+
+bool ElfObjectPrinter::patch(const Fixup& F, int64_t Value) {
+  if (!fitsIn(Value, F.Size)) {
+    return false;
+  }
+  auto& Contents = Object.Sections[F.Section].Contents;
+  for (uint64_t I = 0; I < F.Size; ++I) {
+    Contents[F.Offset + I] = static_cast<uint8_t>(Value >> (8 * I));
+  }
+  return true;
+}
+
+void ElfObjectPrinter::resolveFixups() {
+  for (const Fixup& F : Fixups) {
+    std::string Location =
+        hex(F.Offset) + " in " + Object.Sections[F.Section].Name;
+    const ElfObjectSymbol* Def1 = definition(F.Sym1);
+
+    if (F.Sym2) {
+      // (Sym1 - Sym2) / Scale + Addend
+      const ElfObjectSymbol* Def2 = definition(F.Sym2);
+      if (Def1 && Def2 && Def1->Section == Def2->Section && F.Scale != 0) {
+        int64_t Difference = static_cast<int64_t>(Def1->Value - Def2->Value);
+        if (!patch(F, Difference / F.Scale + F.Addend)) {
+          unsupported("value out of range at " + Location);
+        }
+      } else if (Def2 && Def2->Section == F.Section && F.Scale == 1 &&
+                 (F.Size == 4 || F.Size == 8)) {
+        // A PC-relative relocation: S + A - P.
+        addRelocation(F.Section, F.Offset, *F.Sym1,
+                      F.Size == 4 ? ElfRelocationType::X86_64_PC32
+                                  : ElfRelocationType::X86_64_PC64,
+                      F.Addend + static_cast<int64_t>(F.Offset - Def2->Value));
+      } else {
+        unsupported("unsupported symbol difference at " + Location);
+      }
+      continue;
+    }
+
+    if (F.PCRelative && Def1 && Def1->Section == F.Section &&
+        Def1->Type != SttGnuIFunc &&
+        (Def1->Binding == StbLocal || F.Size < 4)) {
+      // As the assembler does, resolve references to local symbols of the
+      // same section here.
+      if (!patch(F, static_cast<int64_t>(Def1->Value - F.Offset) + F.Addend)) {
+        unsupported("PC-relative value out of range at " + Location);
+      }
+      continue;
+    }
+    if (F.PCRelative && F.Size < 4) {
+      unsupported("short branch to another section at " + Location);
+      continue;
+    }
+    addRelocation(F.Section, F.Offset, *F.Sym1, F.Type, F.Addend);
+  }
+}
+
+void ElfObjectPrinter::addCFIDirectives(const gtirb::Offset& Offset,
+                                        uint64_t SectionOffset) {
+  if (auto Directives = aux_data::getCFIDirectives(Offset, module)) {
+    for (const auto& Directive : *Directives) {
+      addCFIDirective(Directive, SectionOffset);
+    }
+  }
+}
+
+void ElfObjectPrinter::addCFIDirective(const aux_data::CFIDirective& Directive,
+                                       uint64_t SectionOffset) {
+  const std::string& Name = Directive.Directive;
+  const std::vector<int64_t>& Operands = Directive.Operands;
+
+  if (Name == ".cfi_startproc") {
+    if (OpenFrame || !Operands.empty()) {
+      unsupported("unsupported .cfi_startproc");
+      return;
+    }
+    OpenFrame = Frame{*CurrentSection, SectionOffset, SectionOffset, {}};
+    FrameLocation = SectionOffset;
+    CfaOffset = InitialCfaOffset;
+    CfaOffsetStack.clear();
+    return;
+  }
+  if (!OpenFrame) {
+    // The printer omits these as well.
+    return;
+  }
+  if (OpenFrame->Section != *CurrentSection ||
+      nodeFromUUID<gtirb::Symbol>(context, Directive.Uuid)) {
+    unsupported("unsupported " + Name + " directive");
+    return;
+  }
+  if (Name == ".cfi_endproc") {
+    OpenFrame->End = SectionOffset;
+    Frames.push_back(std::move(*OpenFrame));
+    OpenFrame.reset();
+    return;
+  }
+
+  auto operandsAre = [&](size_t N) {
+    if (Operands.size() != N) {
+      unsupported("malformed " + Name + " directive");
+      return false;
+    }
+    return true;
+  };
+  auto reg = [](int64_t R) { return static_cast<uint64_t>(R); };
+
+  std::vector<uint8_t> Instructions;
+  auto saveAt = [&](uint64_t Reg, int64_t Offset) {
+    if (Offset % DataAlignment != 0) {
+      unsupported("unaligned " + Name + " directive");
+      return;
+    }
+    int64_t Factored = Offset / DataAlignment;
+    if (Factored < 0) {
+      Instructions.push_back(DwCfaOffsetExtendedSf);
+      appendUleb(Instructions, Reg);
+      appendSleb(Instructions, Factored);
+    } else if (Reg < 64) {
+      Instructions.push_back(DwCfaOffset | static_cast<uint8_t>(Reg));
+      appendUleb(Instructions, static_cast<uint64_t>(Factored));
+    } else {
+      Instructions.push_back(DwCfaOffsetExtended);
+      appendUleb(Instructions, Reg);
+      appendUleb(Instructions, static_cast<uint64_t>(Factored));
+    }
+  };
+  auto defCfaOffset = [&](int64_t Offset) {
+    if (Offset < 0) {
+      unsupported("negative CFA offset");
+      return;
+    }
+    CfaOffset = Offset;
+    Instructions.push_back(DwCfaDefCfaOffset);
+    appendUleb(Instructions, static_cast<uint64_t>(Offset));
+  };
+
+  if (Name == ".cfi_def_cfa") {
+    if (!operandsAre(2)) {
+      return;
+    }
+    if (Operands[1] < 0) {
+      unsupported("negative CFA offset");
+      return;
+    }
+    CfaOffset = Operands[1];
+    Instructions.push_back(DwCfaDefCfa);
+    appendUleb(Instructions, reg(Operands[0]));
+    appendUleb(Instructions, static_cast<uint64_t>(Operands[1]));
+  } else if (Name == ".cfi_def_cfa_offset") {
+    if (!operandsAre(1)) {
+      return;
+    }
+    defCfaOffset(Operands[0]);
+  } else if (Name == ".cfi_adjust_cfa_offset") {
+    if (!operandsAre(1)) {
+      return;
+    }
+    defCfaOffset(CfaOffset + Operands[0]);
+  } else if (Name == ".cfi_def_cfa_register") {
+    if (!operandsAre(1)) {
+      return;
+    }
+    Instructions.push_back(DwCfaDefCfaRegister);
+    appendUleb(Instructions, reg(Operands[0]));
+  } else if (Name == ".cfi_offset") {
+    if (!operandsAre(2)) {
+      return;
+    }
+    saveAt(reg(Operands[0]), Operands[1]);
+  } else if (Name == ".cfi_rel_offset") {
+    if (!operandsAre(2)) {
+      return;
+    }
+    saveAt(reg(Operands[0]), Operands[1] - CfaOffset);
+  } else if (Name == ".cfi_restore") {
+    if (!operandsAre(1)) {
+      return;
+    }
+    if (reg(Operands[0]) < 64) {
+      Instructions.push_back(DwCfaRestore |
+                             static_cast<uint8_t>(Operands[0]));
+    } else {
+      Instructions.push_back(DwCfaRestoreExtended);
+      appendUleb(Instructions, reg(Operands[0]));
+    }
+  } else if (Name == ".cfi_undefined" || Name == ".cfi_same_value") {
+    if (!operandsAre(1)) {
+      return;
+    }
+    Instructions.push_back(Name == ".cfi_undefined" ? DwCfaUndefined
+                                                    : DwCfaSameValue);
+    appendUleb(Instructions, reg(Operands[0]));
+  } else if (Name == ".cfi_register") {
+    if (!operandsAre(2)) {
+      return;
+    }
+    Instructions.push_back(DwCfaRegister);
+    appendUleb(Instructions, reg(Operands[0]));
+    appendUleb(Instructions, reg(Operands[1]));
+  } else if (Name == ".cfi_remember_state") {
+    CfaOffsetStack.push_back(CfaOffset);
+    Instructions.push_back(DwCfaRememberState);
+  } else if (Name == ".cfi_restore_state") {
+    if (CfaOffsetStack.empty()) {
+      unsupported(".cfi_restore_state without .cfi_remember_state");
+      return;
+    }
+    CfaOffset = CfaOffsetStack.back();
+    CfaOffsetStack.pop_back();
+    Instructions.push_back(DwCfaRestoreState);
+  } else if (Name == ".cfi_escape") {
+    for (int64_t Byte : Operands) {
+      Instructions.push_back(static_cast<uint8_t>(Byte));
+    }
+  } else {
+    // e.g. .cfi_personality and .cfi_lsda, which refer to symbols.
+    unsupported("unsupported " + Name + " directive");
+    return;
+  }
+
+  // Advance to the directive's location first.
+  std::vector<uint8_t>& Out = OpenFrame->Instructions;
+  uint64_t Delta = SectionOffset - FrameLocation;
+  if (Delta > 0 && Delta < 0x40) {
+    Out.push_back(DwCfaAdvanceLoc | static_cast<uint8_t>(Delta));
+  } else if (Delta > 0 && Delta <= 0xff) {
+    Out.push_back(DwCfaAdvanceLoc1);
+    appendLE(Out, Delta, 1);
+  } else if (Delta > 0 && Delta <= 0xffff) {
+    Out.push_back(DwCfaAdvanceLoc2);
+    appendLE(Out, Delta, 2);
+  } else if (Delta > 0) {
+    Out.push_back(DwCfaAdvanceLoc4);
+    appendLE(Out, Delta, 4);
+  }
+  FrameLocation = SectionOffset;
+  Out.insert(Out.end(), Instructions.begin(), Instructions.end());
+}
+
+void ElfObjectPrinter::buildEhFrame() {
+  if (Frames.empty()) {
+    return;
+  }
+  if (SectionIndices.count(".eh_frame")) {
+    unsupported(".eh_frame printed along with CFI directives");
+    return;
+  }
+
+  ElfObjectSection EhFrame;
+  EhFrame.Name = ".eh_frame";
+  EhFrame.Type = ShtX86_64Unwind;
+  EhFrame.Flags = ShfAlloc;
+  EhFrame.Alignment = 8;
+  std::vector<uint8_t>& Data = EhFrame.Contents;
+  auto pad = [&Data](size_t Start) {
+    while ((Data.size() - Start) % 8 != 0) {
+      Data.push_back(0); // DW_CFA_nop
+    }
+  };
+  auto setLength = [&Data](size_t Start) {
+    uint64_t Length = Data.size() - Start - 4;
+    for (int I = 0; I < 4; ++I) {
+      Data[Start + I] = static_cast<uint8_t>(Length >> (8 * I));
+    }
+  };
+
+  // CIE
+  appendLE(Data, 0, 4); // length
+  appendLE(Data, 0, 4); // CIE id
+  Data.push_back(1);    // version
+  Data.insert(Data.end(), {'z', 'R', 0}); // augmentation
+  appendUleb(Data, 1);
+  appendSleb(Data, DataAlignment);
+  appendUleb(Data, 16); // return address column (rip)
+  appendUleb(Data, 1);  // augmentation data length
+  Data.push_back(0x1b); // FDE encoding: DW_EH_PE_pcrel | DW_EH_PE_sdata4
+  Data.push_back(DwCfaDefCfa);
+  appendUleb(Data, 7); // rsp
+  appendUleb(Data, InitialCfaOffset);
+  Data.push_back(DwCfaOffset | 16);
+  appendUleb(Data, 1);
+  pad(0);
+  setLength(0);
+
+  size_t Index = Object.Sections.size();
+  for (const Frame& F : Frames) {
+    size_t Start = Data.size();
+    appendLE(Data, 0, 4);         // length
+    appendLE(Data, Start + 4, 4); // CIE pointer
+    // pc_begin, relative to the field.
+    EhFrame.Relocations.push_back({Data.size(), sectionSymbol(F.Section),
+                                   ElfRelocationType::X86_64_PC32,
+                                   static_cast<int64_t>(F.Begin)});
+    appendLE(Data, 0, 4);
+    appendLE(Data, F.End - F.Begin, 4); // pc_range
+    appendUleb(Data, 0);                // augmentation data length
+    Data.insert(Data.end(), F.Instructions.begin(), F.Instructions.end());
+    pad(Start);
+    setLength(Start);
+  }
+
+  SectionIndices[EhFrame.Name] = Index;
+  Object.Sections.push_back(std::move(EhFrame));
+}
+
+} // namespace gtirb_pprint
@@ -0,0 +1,255 @@
+//===- ElfObjectWriter.cpp -------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ElfObjectWriter.hpp"
+#include "ElfWriter.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace gtirb_bprint {
+
+namespace {
+
+using elf_writer::alignTo;
+using elf_writer::SectionHeader;
+using elf_writer::StringTable;
+using elf_writer::Writer;
+
+// ELF constants used by the writer; see the System V gABI and the x86-64
+// psABI.
+constexpr uint8_t ElfClass64 = 2;
+constexpr uint8_t ElfData2Lsb = 1;
+constexpr uint8_t ElfOsAbiNone = 0;
+constexpr uint8_t ElfOsAbiGnu = 3;
+constexpr uint16_t EtRel = 1;
+constexpr uint16_t EmX86_64 = 62;
+
+constexpr uint32_t ShtSymtab = 2;
+constexpr uint32_t ShtStrtab = 3;
+constexpr uint32_t ShtRela = 4;
+constexpr uint32_t ShtNobits = 8;
+constexpr uint64_t ShfInfoLink = 0x40;
+
+constexpr uint16_t ShnAbs = 0xfff1;
+constexpr uint16_t ShnCommon = 0xfff2;
+constexpr uint16_t ShnLoReserve = 0xff00;
+
+constexpr uint8_t StbLocal = 0;
+constexpr uint8_t StbGnuUnique = 10;
+constexpr uint8_t SttGnuIFunc = 10;
+
+constexpr uint64_t EhdrSize = 64;
+constexpr uint64_t ShdrSize = 64;
+constexpr uint64_t SymSize = 24;
+constexpr uint64_t RelaSize = 24;
+
+} // namespace
+
+bool writeElfObject(const std::string& Path, const ElfObject& Object) {
+  const size_t SectionCount = Object.Sections.size();
+
+  // Locals must precede the other symbols in .symtab; sh_info of .symtab is
+  // the index of the first non-local symbol.
+  std::vector<size_t> Order;
+  for (size_t I = 0; I < Object.Symbols.size(); ++I) {
+    if (Object.Symbols[I].Binding == StbLocal) {
+      Order.push_back(I);
+    }
+  }
+  const uint32_t FirstGlobal = static_cast<uint32_t>(Order.size() + 1);
+  for (size_t I = 0; I < Object.Symbols.size(); ++I) {
+    if (Object.Symbols[I].Binding != StbLocal) {
+      Order.push_back(I);
+    }
+  }
+  std::vector<uint32_t> SymbolIndices(Object.Symbols.size());
+  for (size_t I = 0; I < Order.size(); ++I) {
+    SymbolIndices[Order[I]] = static_cast<uint32_t>(I + 1);
+  }
+
+  StringTable StrTab;
+  std::vector<uint32_t> SymbolNames;
+  bool GnuSpecific = false;
+  for (size_t I : Order) {
+    const ElfObjectSymbol& Symbol = Object.Symbols[I];
+    if (Symbol.Kind == ElfObjectSymbolKind::Defined &&
+        Symbol.Section >= SectionCount) {
+      return false;
+    }
+    SymbolNames.push_back(StrTab.add(Symbol.Name));
+    GnuSpecific |=
+        Symbol.Type == SttGnuIFunc || Symbol.Binding == StbGnuUnique;
+  }
+
+  // Section headers: the null section, the object's sections, their
+  // relocation sections, and then the symbol and string tables.
+  StringTable ShStr;
+  std::vector<SectionHeader> Sections;
+  Sections.push_back({});
+  uint64_t Cursor = EhdrSize;
+  for (const ElfObjectSection& Section : Object.Sections) {
+    uint64_t Align = std::max<uint64_t>(Section.Alignment, 1);
+    uint64_t Size = Section.Contents.size();
+    if (Section.Type == ShtNobits) {
+      Size = Section.NoBitsSize;
+    } else {
+      Cursor = alignTo(Cursor, Align);
+    }
+    Sections.push_back({ShStr.add(Section.Name), Section.Type, Section.Flags,
+                        0, Cursor, Size, 0, 0, Align, 0});
+    if (Section.Type != ShtNobits) {
+      Cursor += Size;
+    }
+  }
+  const uint32_t RelaCount = static_cast<uint32_t>(
+      std::count_if(Object.Sections.begin(), Object.Sections.end(),
+                    [](const ElfObjectSection& S) {
+                      return !S.Relocations.empty();
+                    }));
+  const uint32_t SymTabIdx =
+      static_cast<uint32_t>(SectionCount + 1 + RelaCount);
+  const uint32_t StrTabIdx = SymTabIdx + 1;
+  if (StrTabIdx + 1 >= ShnLoReserve) {
+    return false;
+  }
+  for (size_t I = 0; I < SectionCount; ++I) {
+    const ElfObjectSection& Section = Object.Sections[I];
+    if (Section.Relocations.empty()) {
+      continue;
+    }
+    Cursor = alignTo(Cursor, 8);
+    uint64_t Size = Section.Relocations.size() * RelaSize;
+    Sections.push_back({ShStr.add(".rela" + Section.Name), ShtRela,
+                        ShfInfoLink, 0, Cursor, Size, SymTabIdx,
+                        static_cast<uint32_t>(I + 1), 8, RelaSize});
+    Cursor += Size;
+  }
+  const uint64_t SymTabOff = alignTo(Cursor, 8);
+  const uint64_t SymTabSize = (Order.size() + 1) * SymSize;
+  Sections.push_back({ShStr.add(".symtab"), ShtSymtab, 0, 0, SymTabOff,
+                      SymTabSize, StrTabIdx, FirstGlobal, 8, SymSize});
+  const uint64_t StrTabOff = SymTabOff + SymTabSize;
+  Sections.push_back({ShStr.add(".strtab"), ShtStrtab, 0, 0, StrTabOff,
+                      StrTab.data().size(), 0, 0, 1, 0});
+  const uint32_t ShStrIdx = ShStr.add(".shstrtab");
+  const uint64_t ShStrOff = StrTabOff + StrTab.data().size();
+  Sections.push_back(
+      {ShStrIdx, ShtStrtab, 0, 0, ShStrOff, ShStr.data().size(), 0, 0, 1, 0});
+  const uint64_t ShOff = alignTo(ShStrOff + ShStr.data().size(), 8);
+
+  Writer W(true);
+
+  // ELF header.
+  W.bytes("\x7f"
+          "ELF");
+  W.u8(ElfClass64);
+  W.u8(ElfData2Lsb);
+  W.u8(1); // EI_VERSION
+  // As with the assembler, mark files using GNU_IFUNC or GNU_UNIQUE symbols
+  // as GNU-specific.
+  W.u8(GnuSpecific ? ElfOsAbiGnu : ElfOsAbiNone);
+  W.padTo(16);
+  W.u16(EtRel);
+  W.u16(EmX86_64);
+  W.u32(1); // e_version
+  W.u64(0); // e_entry
+  W.u64(0); // e_phoff
+  W.u64(ShOff);
+  W.u32(0); // e_flags
+  W.u16(static_cast<uint16_t>(EhdrSize));
+  W.u16(0); // e_phentsize
+  W.u16(0); // e_phnum
+  W.u16(static_cast<uint16_t>(ShdrSize));
+  W.u16(static_cast<uint16_t>(Sections.size()));
+  W.u16(static_cast<uint16_t>(Sections.size() - 1));
+
+  // Section contents.
+  for (size_t I = 0; I < SectionCount; ++I) {
+    const ElfObjectSection& Section = Object.Sections[I];
+    if (Section.Type == ShtNobits) {
+      continue;
+    }
+    W.padTo(Sections[I + 1].Offset);
+    W.bytes(std::string(Section.Contents.begin(), Section.Contents.end()));
+  }
+
+  // Relocations.
+  for (const ElfObjectSection& Section : Object.Sections) {
+    if (Section.Relocations.empty()) {
+      continue;
+    }
+    W.padTo(alignTo(W.size(), 8));
+    for (const ElfObjectRelocation& Rela : Section.Relocations) {
+      if (Rela.Symbol >= SymbolIndices.size()) {
+        return false;
+      }
+      W.u64(Rela.Offset);
+      W.u64(static_cast<uint64_t>(SymbolIndices[Rela.Symbol]) << 32 |
+            static_cast<uint32_t>(Rela.Type));
+      W.u64(static_cast<uint64_t>(Rela.Addend));
+    }
+  }
+
+  // .symtab
+  W.padTo(SymTabOff + SymSize);
+  for (size_t I = 0; I < Order.size(); ++I) {
+    const ElfObjectSymbol& Symbol = Object.Symbols[Order[I]];
+    uint16_t Section = 0;
+    switch (Symbol.Kind) {
+    case ElfObjectSymbolKind::Undefined:
+      break;
+    case ElfObjectSymbolKind::Defined:
+      Section = static_cast<uint16_t>(Symbol.Section + 1);
+      break;
+    case ElfObjectSymbolKind::Absolute:
+      Section = ShnAbs;
+      break;
+    case ElfObjectSymbolKind::Common:
+      Section = ShnCommon;
+      break;
+    }
+    W.u32(SymbolNames[I]);
+    W.u8(static_cast<uint8_t>(Symbol.Binding << 4 | (Symbol.Type & 0xf)));
+    W.u8(Symbol.Visibility & 0x3);
+    W.u16(Section);
+    W.u64(Symbol.Value);
+    W.u64(Symbol.Size);
+  }
+
+  // .strtab and .shstrtab
+  W.bytes(StrTab.data());
+  W.bytes(ShStr.data());
+
+  // Section headers.
+  W.padTo(ShOff);
+  for (const SectionHeader& S : Sections) {
+    W.u32(S.Name);
+    W.u32(S.Type);
+    W.u64(S.Flags);
+    W.u64(S.Addr);
+    W.u64(S.Offset);
+    W.u64(S.Size);
+    W.u32(S.Link);
+    W.u32(S.Info);
+    W.u64(S.Align);
+    W.u64(S.EntSize);
+  }
+
+  std::ofstream Out(Path, std::ios::binary | std::ios::trunc);
+  Out.write(W.data().data(), W.data().size());
+  Out.close();
+  return static_cast<bool>(Out);
+}
+
+} // namespace gtirb_bprint
@@ -220,6 +220,12 @@ void ElfPrettyPrinter::printFooter(std::ostream& /* os */){};
 
 void ElfPrettyPrinter::printSymbolHeader(std::ostream& os,
                                          const gtirb::Symbol& sym) {
+  if (Units && Units->Promoted.count(&sym) > 0) {
+    // The symbol is referenced from another compilation unit.
+    auto Name = getSymbolName(sym);
+    os << syntax.global() << ' ' << Name << '\n';
+    os << elfSyntax.hidden() << ' ' << Name << '\n';
+  }
   if (auto SymbolInfo = aux_data::getElfSymbolInfo(sym)) {
     auto Version = aux_data::getSymbolVersionString(sym);
 
@@ -412,7 +418,7 @@ void ElfPrettyPrinter::printIntegralSymbols(std::ostream& os) {
   // Print integral symbols attached to the PLT.
   for (const auto& sym : module.symbols_by_name()) {
     auto Section = IsExternalPLTSym(sym);
-    if (Section && shouldSkip(policy, *Section)) {
+    if (Section && shouldSkip(*Section)) {
       // Symbol is attached to the .plt, but it is skipped.
       // In such cases, we need to emit the symbol definition, ensuring
       // that we link with the correct symbol version (if versions
@@ -424,6 +430,11 @@ void ElfPrettyPrinter::printIntegralSymbols(std::ostream& os) {
 
 void ElfPrettyPrinter::printIntegralSymbol(std::ostream& Stream,
                                            const gtirb::Symbol& Symbol) {
+  // Local integral symbols are defined again in every compilation unit; the
+  // others are only defined in the first.
+  if (UnitIndex > 0 && !isLocalSymbol(Symbol)) {
+    return;
+  }
 
   printSymbolHeader(Stream, Symbol);
 
@@ -549,6 +560,35 @@ void ElfPrettyPrinter::printSectionFooter(std::ostream& os,
    PrettyPrinterBase::printSectionFooter(os, section);
 }
 
+bool ElfPrettyPrinter::canSplitUnits() const {
+  return module.getFileFormat() == gtirb::FileFormat::ELF &&
+         (module.getISA() == gtirb::ISA::X64 ||
+          module.getISA() == gtirb::ISA::IA32);
+}
+
+bool ElfPrettyPrinter::isLocalSymbol(const gtirb::Symbol& Symbol) const {
+  auto SymbolInfo = aux_data::getElfSymbolInfo(Symbol);
+  return !SymbolInfo || SymbolInfo->Binding == "LOCAL";
+}
+
+bool ElfPrettyPrinter::canCacheFunctions() const {
+  // References to `_RDATA` symbols are collected while printing functions,
+  // and printed with that section.
+  return canSplitUnits() && module.findSections("_RDATA").empty();
+}
+
+void ElfPrettyPrinter::addSymbolToKey(gtirb_bprint::CacheKey& Key,
+                                      const gtirb::Symbol& Symbol) const {
+  PrettyPrinterBase::addSymbolToKey(Key, Symbol);
+  if (auto SymbolInfo = aux_data::getElfSymbolInfo(Symbol)) {
+    Key.add(SymbolInfo->Size).add(SymbolInfo->Type).add(SymbolInfo->Binding);
+    Key.add(SymbolInfo->Visibility).add(SymbolInfo->SectionIndex);
+  } else {
+    Key.add("");
+  }
+  Key.add(aux_data::getSymbolVersionString(Symbol).value_or(""));
+}
+
 bool ElfPrettyPrinterFactory::isStaticBinary(
     const gtirb::Module& Module) const {
   return Module.findSections(".dynamic").empty();
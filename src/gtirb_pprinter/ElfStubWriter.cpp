@@ -0,0 +1,397 @@
+//===- ElfStubWriter.cpp ---------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ElfStubWriter.hpp"
+#include "ElfWriter.hpp"
+#include <fstream>
+#include <map>
+
+namespace gtirb_bprint {
+
+namespace {
+
+using elf_writer::alignTo;
+using elf_writer::SectionHeader;
+using elf_writer::StringTable;
+using elf_writer::Writer;
+
+// ELF constants used by the writer; see the System V gABI and the GNU
+// symbol versioning extensions.
+constexpr uint8_t ElfClass32 = 1;
+constexpr uint8_t ElfClass64 = 2;
+constexpr uint8_t ElfData2Lsb = 1;
+constexpr uint8_t ElfOsAbiNone = 0;
+constexpr uint8_t ElfOsAbiGnu = 3;
+constexpr uint16_t EtDyn = 3;
+
+constexpr uint32_t PtLoad = 1;
+constexpr uint32_t PtDynamic = 2;
+constexpr uint32_t PfX = 1;
+constexpr uint32_t PfW = 2;
+constexpr uint32_t PfR = 4;
+
+constexpr uint32_t ShtProgbits = 1;
+constexpr uint32_t ShtStrtab = 3;
+constexpr uint32_t ShtHash = 5;
+constexpr uint32_t ShtDynamic = 6;
+constexpr uint32_t ShtDynsym = 11;
+constexpr uint32_t ShtGnuVerdef = 0x6ffffffd;
+constexpr uint32_t ShtGnuVersym = 0x6fffffff;
+constexpr uint64_t ShfWrite = 1;
+constexpr uint64_t ShfAlloc = 2;
+constexpr uint64_t ShfExecinstr = 4;
+
+constexpr uint8_t StbGlobal = 1;
+constexpr uint8_t StbWeak = 2;
+
+constexpr uint64_t DtNull = 0;
+constexpr uint64_t DtHash = 4;
+constexpr uint64_t DtStrtab = 5;
+constexpr uint64_t DtSymtab = 6;
+constexpr uint64_t DtStrsz = 10;
+constexpr uint64_t DtSyment = 11;
+constexpr uint64_t DtSoname = 14;
+constexpr uint64_t DtVersym = 0x6ffffff0;
+constexpr uint64_t DtVerdef = 0x6ffffffc;
+constexpr uint64_t DtVerdefnum = 0x6ffffffd;
+
+constexpr uint16_t VerDefCurrent = 1;
+constexpr uint16_t VerFlgBase = 1;
+constexpr uint16_t VerNdxGlobal = 1;
+constexpr uint16_t VerNdxHidden = 0x8000;
+constexpr uint32_t VerdefSize = 20;
+constexpr uint32_t VerdauxSize = 8;
+
+// The hash function of the SysV .hash section (also used by verdefs).
+uint32_t elfHash(const std::string& Name) {
+  uint32_t H = 0;
+  for (unsigned char C : Name) {
+    H = (H << 4) + C;
+    uint32_t G = H & 0xf0000000;
+    if (G) {
+      H ^= G >> 24;
+    }
+    H &= ~G;
+  }
+  return H;
+}
+
+// Bucket counts for the .hash section, as chosen by the BFD linker.
+uint32_t hashBucketCount(size_t Symbols) {
+  static const uint32_t Buckets[] = {1,    3,    17,   37,    67,    97,
+                                     131,  197,  263,  521,   1031,  2053,
+                                     4099, 8209, 16411, 32771, 65537};
+  uint32_t Result = 1;
+  for (uint32_t B : Buckets) {
+    if (Symbols < B * 2) {
+      break;
+    }
+    Result = B;
+  }
+  return Result;
+}
+
+// Where a symbol is placed within its section.
+struct PlacedSymbol {
+  const ElfStubSymbol* Symbol;
+  bool Code;
+  uint64_t Offset;
+};
+
+} // namespace
+
+bool writeElfStub(const std::string& Path, const std::string& SoName,
+                  ElfStubMachine Machine,
+                  const std::vector<ElfStubGroup>& Groups) {
+  const bool Is64 = Machine != ElfStubMachine::X86;
+  const uint64_t PageSize =
+      Machine == ElfStubMachine::AArch64 ? 0x10000 : 0x1000;
+  const uint64_t WordSize = Is64 ? 8 : 4;
+  const uint64_t EhdrSize = Is64 ? 64 : 52;
+  const uint64_t PhdrSize = Is64 ? 56 : 32;
+  const uint64_t ShdrSize = Is64 ? 64 : 40;
+  const uint64_t SymSize = Is64 ? 24 : 16;
+  const uint64_t DynSize = 2 * WordSize;
+  const uint64_t PhdrCount = 3;
+
+  // Place the symbol groups in .text and .data.
+  std::vector<PlacedSymbol> Symbols;
+  uint64_t TextSize = 0, DataSize = 0;
+  bool HasIFunc = false;
+  for (const ElfStubGroup& Group : Groups) {
+    uint64_t& Cursor = Group.Code ? TextSize : DataSize;
+    Cursor = alignTo(Cursor, Group.Code ? 16 : 8);
+    for (const ElfStubSymbol& Symbol : Group.Symbols) {
+      Symbols.push_back({&Symbol, Group.Code, Cursor});
+      HasIFunc |= Symbol.Type == ElfStubSymbolType::GnuIFunc;
+    }
+    Cursor += Group.Size;
+  }
+  const uint64_t SymCount = Symbols.size() + 1;
+
+  // Number the versions; index 1 is the base definition naming the library.
+  std::vector<std::string> Versions{SoName};
+  std::map<std::string, uint16_t> VersionIndices;
+  for (const PlacedSymbol& P : Symbols) {
+    const std::string& Version = P.Symbol->Version;
+    if (!Version.empty() && VersionIndices.count(Version) == 0) {
+      Versions.push_back(Version);
+      VersionIndices[Version] = static_cast<uint16_t>(Versions.size());
+    }
+  }
+  const bool Versioned = Versions.size() > 1;
+
+  StringTable DynStr;
+  std::vector<uint32_t> VersionNames;
+  for (const std::string& Version : Versions) {
+    VersionNames.push_back(DynStr.add(Version));
+  }
+  std::vector<uint32_t> SymbolNames;
+  for (const PlacedSymbol& P : Symbols) {
+    SymbolNames.push_back(DynStr.add(P.Symbol->Name));
+  }
+
+  // Lay out the file. The read-only data and .text form the first segment,
+  // and .data and .dynamic the second, which is mapped one page higher than
+  // its file offset so that the segments do not share a page.
+  const uint32_t BucketCount = hashBucketCount(SymCount);
+  const uint64_t HashOff = alignTo(EhdrSize + PhdrCount * PhdrSize, 4);
+  const uint64_t HashSize = 4 * (2 + BucketCount + SymCount);
+  const uint64_t DynSymOff = alignTo(HashOff + HashSize, WordSize);
+  const uint64_t DynStrOff = DynSymOff + SymCount * SymSize;
+  const uint64_t DynStrSize = DynStr.data().size();
+  uint64_t End = DynStrOff + DynStrSize;
+  uint64_t VerSymOff = 0, VerDefOff = 0, VerDefSize = 0;
+  if (Versioned) {
+    VerSymOff = alignTo(End, 2);
+    VerDefOff = alignTo(VerSymOff + 2 * SymCount, 4);
+    VerDefSize = Versions.size() * (VerdefSize + VerdauxSize);
+    End = VerDefOff + VerDefSize;
+  }
+  const uint64_t TextOff = alignTo(End, 16);
+  const uint64_t DataOff = alignTo(TextOff + TextSize, 16);
+  const uint64_t DataAddr = DataOff + PageSize;
+  const uint64_t DynamicOff = alignTo(DataOff + DataSize, WordSize);
+  const uint64_t DynamicAddr = DynamicOff + PageSize;
+  const uint64_t DynamicSize = (Versioned ? 10 : 7) * DynSize;
+  const uint64_t RwEnd = DynamicOff + DynamicSize;
+
+  // Section headers, in order; their indices are referenced by sh_link and
+  // by the symbols.
+  StringTable ShStr;
+  std::vector<SectionHeader> Sections;
+  Sections.push_back({});
+  auto AddSection = [&](const std::string& Name, const SectionHeader& H) {
+    Sections.push_back(H);
+    Sections.back().Name = ShStr.add(Name);
+    return static_cast<uint32_t>(Sections.size() - 1);
+  };
+  const uint32_t HashIdx = AddSection(
+      ".hash", {0, ShtHash, ShfAlloc, HashOff, HashOff, HashSize, 0, 0, 4, 4});
+  const uint32_t DynSymIdx =
+      AddSection(".dynsym", {0, ShtDynsym, ShfAlloc, DynSymOff, DynSymOff,
+                             SymCount * SymSize, 0, 1, WordSize, SymSize});
+  const uint32_t DynStrIdx =
+      AddSection(".dynstr", {0, ShtStrtab, ShfAlloc, DynStrOff, DynStrOff,
+                             DynStrSize, 0, 0, 1, 0});
+  Sections[HashIdx].Link = DynSymIdx;
+  Sections[DynSymIdx].Link = DynStrIdx;
+  if (Versioned) {
+    AddSection(".gnu.version",
+               {0, ShtGnuVersym, ShfAlloc, VerSymOff, VerSymOff, 2 * SymCount,
+                DynSymIdx, 0, 2, 2});
+    AddSection(".gnu.version_d",
+               {0, ShtGnuVerdef, ShfAlloc, VerDefOff, VerDefOff, VerDefSize,
+                DynStrIdx, static_cast<uint32_t>(Versions.size()), 4, 0});
+  }
+  const uint32_t TextIdx =
+      AddSection(".text", {0, ShtProgbits, ShfAlloc | ShfExecinstr, TextOff,
+                           TextOff, TextSize, 0, 0, 16, 0});
+  const uint32_t DataIdx =
+      AddSection(".data", {0, ShtProgbits, ShfAlloc | ShfWrite, DataAddr,
+                           DataOff, DataSize, 0, 0, 16, 0});
+  AddSection(".dynamic", {0, ShtDynamic, ShfAlloc | ShfWrite, DynamicAddr,
+                          DynamicOff, DynamicSize, DynStrIdx, 0, WordSize,
+                          DynSize});
+  const uint32_t ShStrIdx = ShStr.add(".shstrtab");
+  Sections.push_back(
+      {ShStrIdx, ShtStrtab, 0, 0, RwEnd, ShStr.data().size(), 0, 0, 1, 0});
+  const uint64_t ShOff = alignTo(RwEnd + ShStr.data().size(), WordSize);
+
+  Writer W(Is64);
+
+  // ELF header.
+  W.bytes("\x7f"
+          "ELF");
+  W.u8(Is64 ? ElfClass64 : ElfClass32);
+  W.u8(ElfData2Lsb);
+  W.u8(1); // EI_VERSION
+  // As with the assembler, mark files using GNU_IFUNC as GNU-specific.
+  W.u8(HasIFunc ? ElfOsAbiGnu : ElfOsAbiNone);
+  W.padTo(16);
+  W.u16(EtDyn);
+  W.u16(static_cast<uint16_t>(Machine));
+  W.u32(1); // e_version
+  W.word(0);
+  W.word(EhdrSize);
+  W.word(ShOff);
+  W.u32(0); // e_flags
+  W.u16(static_cast<uint16_t>(EhdrSize));
+  W.u16(static_cast<uint16_t>(PhdrSize));
+  W.u16(static_cast<uint16_t>(PhdrCount));
+  W.u16(static_cast<uint16_t>(ShdrSize));
+  W.u16(static_cast<uint16_t>(Sections.size()));
+  W.u16(static_cast<uint16_t>(Sections.size() - 1));
+
+  // Program headers.
+  auto Phdr = [&](uint32_t Type, uint32_t Flags, uint64_t Offset,
+                  uint64_t Addr, uint64_t Size, uint64_t Align) {
+    W.u32(Type);
+    if (Is64) {
+      W.u32(Flags);
+    }
+    W.word(Offset);
+    W.word(Addr);
+    W.word(Addr);
+    W.word(Size);
+    W.word(Size);
+    if (!Is64) {
+      W.u32(Flags);
+    }
+    W.word(Align);
+  };
+  Phdr(PtLoad, PfR | PfX, 0, 0, TextOff + TextSize, PageSize);
+  Phdr(PtLoad, PfR | PfW, DataOff, DataAddr, RwEnd - DataOff, PageSize);
+  Phdr(PtDynamic, PfR | PfW, DynamicOff, DynamicAddr, DynamicSize, WordSize);
+
+  // .hash
+  std::vector<uint32_t> Buckets(BucketCount, 0), Chains(SymCount, 0);
+  for (uint32_t I = 1; I < SymCount; ++I) {
+    uint32_t Bucket = elfHash(Symbols[I - 1].Symbol->Name) % BucketCount;
+    Chains[I] = Buckets[Bucket];
+    Buckets[Bucket] = I;
+  }
+  W.padTo(HashOff);
+  W.u32(BucketCount);
+  W.u32(static_cast<uint32_t>(SymCount));
+  for (uint32_t B : Buckets) {
+    W.u32(B);
+  }
+  for (uint32_t C : Chains) {
+    W.u32(C);
+  }
+
+  // .dynsym
+  W.padTo(DynSymOff + SymSize);
+  for (size_t I = 0; I < Symbols.size(); ++I) {
+    const PlacedSymbol& P = Symbols[I];
+    uint8_t Info = static_cast<uint8_t>(
+        (P.Symbol->Weak ? StbWeak : StbGlobal) << 4 |
+        static_cast<uint8_t>(P.Symbol->Type));
+    uint16_t Section = static_cast<uint16_t>(P.Code ? TextIdx : DataIdx);
+    uint64_t Value = (P.Code ? TextOff : DataAddr) + P.Offset;
+    W.u32(SymbolNames[I]);
+    if (Is64) {
+      W.u8(Info);
+      W.u8(0); // st_other
+      W.u16(Section);
+      W.u64(Value);
+      W.u64(P.Symbol->Size);
+    } else {
+      W.u32(static_cast<uint32_t>(Value));
+      W.u32(static_cast<uint32_t>(P.Symbol->Size));
+      W.u8(Info);
+      W.u8(0); // st_other
+      W.u16(Section);
+    }
+  }
+
+  // .dynstr
+  W.bytes(DynStr.data());
+
+  if (Versioned) {
+    // .gnu.version
+    W.padTo(VerSymOff + 2);
+    for (const PlacedSymbol& P : Symbols) {
+      if (P.Symbol->Version.empty()) {
+        W.u16(VerNdxGlobal);
+      } else {
+        W.u16(VersionIndices[P.Symbol->Version] |
+              (P.Symbol->HiddenVersion ? VerNdxHidden : 0));
+      }
+    }
+
+    // .gnu.version_d
+    W.padTo(VerDefOff);
+    for (size_t I = 0; I < Versions.size(); ++I) {
+      bool Last = I + 1 == Versions.size();
+      W.u16(VerDefCurrent);
+      W.u16(I == 0 ? VerFlgBase : 0);
+      W.u16(static_cast<uint16_t>(I + 1));
+      W.u16(1); // vd_cnt
+      W.u32(elfHash(Versions[I]));
+      W.u32(VerdefSize);
+      W.u32(Last ? 0 : VerdefSize + VerdauxSize);
+      W.u32(VersionNames[I]);
+      W.u32(0); // vda_next
+    }
+  }
+
+  // .text and .data hold no code or data, only the symbols' addresses.
+  W.padTo(DataOff + DataSize);
+
+  // .dynamic
+  W.padTo(DynamicOff);
+  auto Dyn = [&](uint64_t Tag, uint64_t Value) {
+    W.word(Tag);
+    W.word(Value);
+  };
+  Dyn(DtSoname, VersionNames[0]);
+  Dyn(DtHash, HashOff);
+  Dyn(DtStrtab, DynStrOff);
+  Dyn(DtSymtab, DynSymOff);
+  Dyn(DtStrsz, DynStrSize);
+  Dyn(DtSyment, SymSize);
+  if (Versioned) {
+    Dyn(DtVersym, VerSymOff);
+    Dyn(DtVerdef, VerDefOff);
+    Dyn(DtVerdefnum, Versions.size());
+  }
+  Dyn(DtNull, 0);
+
+  // .shstrtab
+  W.bytes(ShStr.data());
+
+  // Section headers.
+  W.padTo(ShOff);
+  for (const SectionHeader& S : Sections) {
+    W.u32(S.Name);
+    W.u32(S.Type);
+    W.word(S.Flags);
+    W.word(S.Addr);
+    W.word(S.Offset);
+    W.word(S.Size);
+    W.u32(S.Link);
+    W.u32(S.Info);
+    W.word(S.Align);
+    W.word(S.EntSize);
+  }
+
+  std::ofstream Out(Path, std::ios::binary | std::ios::trunc);
+  Out.write(W.data().data(), W.data().size());
+  Out.close();
+  return static_cast<bool>(Out);
+}
+
+} // namespace gtirb_bprint
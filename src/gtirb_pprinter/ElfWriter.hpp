@@ -0,0 +1,98 @@
+//===- ElfWriter.hpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+//
+// Helpers shared by the writers that produce ELF files directly (stub shared
+// objects and relocatable objects).
+//
+//===----------------------------------------------------------------------===//
+#ifndef GTIRB_PP_ELF_WRITER_H
+#define GTIRB_PP_ELF_WRITER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace gtirb_bprint {
+namespace elf_writer {
+
+inline uint64_t alignTo(uint64_t Value, uint64_t Align) {
+  return (Value + Align - 1) / Align * Align;
+}
+
+// A string table with deduplicated entries.
+class StringTable {
+public:
+  StringTable() : Data(1, '\0') {}
+
+  uint32_t add(const std::string& S) {
+    auto [It, Inserted] = Offsets.emplace(S, Data.size());
+    if (Inserted) {
+      Data += S;
+      Data += '\0';
+    }
+    return It->second;
+  }
+
+  const std::string& data() const { return Data; }
+
+private:
+  std::string Data;
+  std::map<std::string, uint32_t> Offsets;
+};
+
+// Serializes little-endian ELF structures of either class.
+class Writer {
+public:
+  explicit Writer(bool Is64) : Wide(Is64) {}
+
+  void u8(uint8_t V) { Data.push_back(static_cast<char>(V)); }
+  void u16(uint16_t V) { put(V, 2); }
+  void u32(uint32_t V) { put(V, 4); }
+  void u64(uint64_t V) { put(V, 8); }
+  // A field that is 64 bits wide in ELF64 and 32 bits wide in ELF32.
+  void word(uint64_t V) { put(V, Wide ? 8 : 4); }
+  void bytes(const std::string& S) { Data += S; }
+  void padTo(uint64_t Offset) { Data.resize(Offset, '\0'); }
+  uint64_t size() const { return Data.size(); }
+  const std::string& data() const { return Data; }
+
+private:
+  void put(uint64_t V, int Bytes) {
+    for (int I = 0; I < Bytes; ++I) {
+      u8(static_cast<uint8_t>(V >> (8 * I)));
+    }
+  }
+
+  bool Wide;
+  std::string Data;
+};
+
+struct SectionHeader {
+  uint32_t Name;
+  uint32_t Type;
+  uint64_t Flags;
+  uint64_t Addr;
+  uint64_t Offset;
+  uint64_t Size;
+  uint32_t Link;
+  uint32_t Info;
+  uint64_t Align;
+  uint64_t EntSize;
+};
+
+} // namespace elf_writer
+} // namespace gtirb_bprint
+
+#endif // GTIRB_PP_ELF_WRITER_H
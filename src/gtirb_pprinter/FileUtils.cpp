@@ -13,6 +13,7 @@
 //
 //===----------------------------------------------------------------------===//
 #include "FileUtils.hpp"
+#include "ToolchainProbe.hpp"
 #include "driver/Logger.h"
 #ifdef __GNUC__
 #pragma GCC diagnostic push
@@ -27,7 +28,6 @@
 #pragma warning(disable : 4456) // variable shadowing warning
 #endif                          // __GNUC__
 #include <boost/filesystem.hpp>
-#include <boost/process/search_path.hpp>
 #include <boost/process/system.hpp>
 #include <iostream>
 #ifdef __GNUC__
@@ -35,6 +35,19 @@
 #elif defined(_MSC_VER)
 #pragma warning(pop)
 #endif // __GNUC__
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif // _WIN32
 
 namespace fs = boost::filesystem;
 namespace bp = boost::process;
@@ -99,6 +112,273 @@ TempDir::~TempDir() {
   }
 }
 
+// Size of the buffers handed to the writer thread of an AsyncOutputStream.
+static constexpr size_t AsyncBufferSize = 1 << 20;
+// Maximum number of filled buffers waiting for the writer thread.
+static constexpr size_t AsyncQueueDepth = 8;
+
+class AsyncOutputStream::Buffer : public std::streambuf {
+public:
+  explicit Buffer(std::unique_ptr<OutputSink> S) : Sink(std::move(S)) {
+    if (!Sink)
+      return;
+    resetBuffer();
+    Writer = std::thread([this]() { run(); });
+  }
+
+  ~Buffer() { finish(); }
+
+  bool isOpen() const { return Sink != nullptr; }
+
+  bool finish() {
+    if (Finished)
+      return Sink && !Failed;
+    Finished = true;
+    if (!Sink)
+      return false;
+    handOff();
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Done = true;
+    }
+    Filled.notify_one();
+    Writer.join();
+    return !Failed;
+  }
+
+protected:
+  int_type overflow(int_type Ch) override {
+    if (!Sink || Finished)
+      return traits_type::eof();
+    handOff();
+    if (Failed)
+      return traits_type::eof();
+    if (!traits_type::eq_int_type(Ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(Ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(Ch);
+  }
+
+  // Buffers are only handed off when full, or when the stream is closed, so
+  // that every write the sink performs is large.
+  int sync() override { return Failed ? -1 : 0; }
+
+private:
+  void resetBuffer() {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      if (!Free.empty()) {
+        Current = std::move(Free.back());
+        Free.pop_back();
+      }
+    }
+    Current.resize(AsyncBufferSize);
+    setp(Current.data(), Current.data() + Current.size());
+  }
+
+  // Queue the filled part of the current buffer for the writer thread,
+  // blocking while the queue is full.
+  void handOff() {
+    size_t Size = pptr() - pbase();
+    if (Size == 0)
+      return;
+    Current.resize(Size);
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Drained.wait(Lock, [this]() { return Queue.size() < AsyncQueueDepth; });
+      Queue.push_back(std::move(Current));
+    }
+    Filled.notify_one();
+    Current = std::vector<char>();
+    resetBuffer();
+  }
+
+  // Writer thread: take every queued buffer at once and write them as a
+  // single batch.
+  void run() {
+    std::vector<std::vector<char>> Batch;
+    std::vector<std::string_view> Views;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        for (auto& B : Batch) {
+          Free.push_back(std::move(B));
+        }
+        Batch.clear();
+        Filled.wait(Lock, [this]() { return !Queue.empty() || Done; });
+        if (Queue.empty())
+          break;
+        while (!Queue.empty()) {
+          Batch.push_back(std::move(Queue.front()));
+          Queue.pop_front();
+        }
+      }
+      Drained.notify_one();
+      // Keep draining after a failure so the formatting thread never blocks
+      // forever.
+      if (Failed)
+        continue;
+      Views.clear();
+      for (const auto& B : Batch) {
+        Views.emplace_back(B.data(), B.size());
+      }
+      if (!Sink->write(Views))
+        Failed = true;
+    }
+    if (!Sink->close())
+      Failed = true;
+  }
+
+  std::unique_ptr<OutputSink> Sink;
+  std::vector<char> Current;
+  std::deque<std::vector<char>> Queue;
+  std::vector<std::vector<char>> Free;
+  std::mutex Mutex;
+  std::condition_variable Filled;
+  std::condition_variable Drained;
+  std::thread Writer;
+  std::atomic<bool> Failed{false};
+  bool Done = false;
+  bool Finished = false;
+};
+
+AsyncOutputStream::AsyncOutputStream(std::unique_ptr<OutputSink> Sink)
+    : std::ostream(nullptr), Buf(std::make_unique<Buffer>(std::move(Sink))) {
+  rdbuf(Buf.get());
+  if (!Buf->isOpen())
+    setstate(std::ios::failbit);
+}
+
+AsyncOutputStream::~AsyncOutputStream() { close(); }
+
+bool AsyncOutputStream::isOpen() const { return Buf->isOpen(); }
+
+bool AsyncOutputStream::close() {
+  bool Success = Buf->finish();
+  if (!Success)
+    setstate(std::ios::badbit);
+  return Success;
+}
+
+namespace {
+#ifndef _WIN32
+// Writes to a file descriptor with writev, preallocating space if the size
+// of the output is known in advance.
+class FileSink : public OutputSink {
+public:
+  FileSink(int F, uint64_t EstimatedSize) : Fd(F) {
+#if defined(__linux__)
+    // Unlike posix_fallocate, fallocate fails on filesystems that cannot
+    // preallocate (e.g. NFS) instead of writing zeros to the whole file, in
+    // which case the file is written without preallocation.
+    if (EstimatedSize > 0 &&
+        ::fallocate(Fd, 0, 0, static_cast<off_t>(EstimatedSize)) == 0)
+      Preallocated = true;
+#else
+    (void)EstimatedSize;
+#endif
+  }
+
+  ~FileSink() { close(); }
+
+  bool write(const std::vector<std::string_view>& Buffers) override {
+    std::vector<struct iovec> Vec;
+    Vec.reserve(Buffers.size());
+    for (const auto& B : Buffers) {
+      if (!B.empty())
+        Vec.push_back({const_cast<char*>(B.data()), B.size()});
+    }
+    size_t First = 0;
+    while (First < Vec.size()) {
+      int Count =
+          static_cast<int>(std::min<size_t>(Vec.size() - First, IOV_MAX));
+      ssize_t Written = ::writev(Fd, &Vec[First], Count);
+      if (Written < 0) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      Size += Written;
+      // Skip the buffers that were written completely and adjust the first
+      // partially written one.
+      size_t Remaining = static_cast<size_t>(Written);
+      while (First < Vec.size() && Remaining >= Vec[First].iov_len) {
+        Remaining -= Vec[First].iov_len;
+        ++First;
+      }
+      if (Remaining > 0) {
+        Vec[First].iov_base =
+            static_cast<char*>(Vec[First].iov_base) + Remaining;
+        Vec[First].iov_len -= Remaining;
+      }
+    }
+    return true;
+  }
+
+  bool close() override {
+    if (Fd < 0)
+      return true;
+    bool Success = true;
+    // Drop any preallocated space that was not used.
+    if (Preallocated && ::ftruncate(Fd, static_cast<off_t>(Size)) != 0)
+      Success = false;
+    if (::close(Fd) != 0)
+      Success = false;
+    Fd = -1;
+    return Success;
+  }
+
+private:
+  int Fd;
+  uint64_t Size = 0;
+  bool Preallocated = false;
+};
+#else
+class FileSink : public OutputSink {
+public:
+  explicit FileSink(std::FILE* F) : File(F) {}
+
+  ~FileSink() { close(); }
+
+  bool write(const std::vector<std::string_view>& Buffers) override {
+    for (const auto& B : Buffers) {
+      if (std::fwrite(B.data(), 1, B.size(), File) != B.size())
+        return false;
+    }
+    return true;
+  }
+
+  bool close() override {
+    if (!File)
+      return true;
+    bool Success = std::fclose(File) == 0;
+    File = nullptr;
+    return Success;
+  }
+
+private:
+  std::FILE* File;
+};
+#endif // _WIN32
+} // namespace
+
+std::unique_ptr<OutputSink> openFileSink(const std::string& Path,
+                                         uint64_t EstimatedSize) {
+#ifndef _WIN32
+  int Fd = ::open(Path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (Fd < 0)
+    return nullptr;
+  return std::make_unique<FileSink>(Fd, EstimatedSize);
+#else
+  (void)EstimatedSize;
+  std::FILE* File = std::fopen(Path.c_str(), "wb");
+  if (!File)
+    return nullptr;
+  return std::make_unique<FileSink>(File);
+#endif // _WIN32
+}
+
 std::string replaceExtension(const std::string path,
                              const std::string new_ext) {
   return fs::path(path).stem().string() + new_ext;
@@ -109,7 +389,11 @@ std::optional<std::string> resolveRegularFilePath(const std::string& path) {
   // file.
   fs::path resolvedFilePath(path);
   while (fs::is_symlink(resolvedFilePath)) {
-    resolvedFilePath = fs::read_symlink(resolvedFilePath);
+    // Relative targets are relative to the directory of the link.
+    fs::path Target = fs::read_symlink(resolvedFilePath);
+    resolvedFilePath = Target.is_absolute()
+                           ? Target
+                           : resolvedFilePath.parent_path() / Target;
   }
   if (fs::is_regular_file(resolvedFilePath)) {
     return resolvedFilePath.string();
@@ -124,13 +408,105 @@ std::optional<std::string> resolveRegularFilePath(const std::string& path,
   return resolveRegularFilePath(filePath.string());
 }
 
+LibraryIndex::Directory& LibraryIndex::scan(const std::string& Dir) {
+  auto [It, Inserted] = Directories.try_emplace(Dir);
+  if (Inserted) {
+    // Directories that cannot be listed have no files.
+    boost::system::error_code EC;
+    for (fs::directory_iterator File(Dir, EC), End; !EC && File != End;
+         File.increment(EC)) {
+      It->second.try_emplace(File->path().filename().string());
+    }
+  }
+  return It->second;
+}
+
+std::optional<std::string>
+LibraryIndex::find(const std::vector<std::string>& Dirs,
+                   const std::string& Name) {
+  bool HasDirectory = fs::path(Name).has_parent_path();
+  std::lock_guard<std::mutex> Lock(Mutex);
+  for (const auto& Dir : Dirs) {
+    // Names with a directory are not in the index, and the current directory
+    // is not indexed.
+    if (HasDirectory || Dir.empty()) {
+      if (auto Path = resolveRegularFilePath(Dir, Name)) {
+        return Path;
+      }
+      continue;
+    }
+    Directory& Files = scan(Dir);
+    auto It = Files.find(Name);
+    if (It == Files.end()) {
+      continue;
+    }
+    Entry& File = It->second;
+    if (!File.Resolved) {
+      File.Path = resolveRegularFilePath(Dir, Name);
+      File.Resolved = true;
+    }
+    if (File.Path) {
+      return File.Path;
+    }
+  }
+  return std::nullopt;
+}
+
 std::optional<int> execute(const std::string& Tool,
                            const std::vector<std::string>& Args) {
-  fs::path Path = fs::is_regular_file(Tool) ? Tool : bp::search_path(Tool);
-  if (Path.empty()) {
+  std::optional<std::string> Path = ToolchainProbe::instance().find(Tool);
+  if (!Path) {
     return std::nullopt;
   }
-  return bp::system(Path, Args);
+  return bp::system(fs::path(*Path), Args);
+}
+
+ProcessPool::ProcessPool(unsigned Jobs)
+    : MaxThreads(Jobs ? Jobs
+                      : std::max(1u, std::thread::hardware_concurrency())) {}
+
+ProcessPool::~ProcessPool() {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Stopping = true;
+  }
+  Available.notify_all();
+  for (auto& Thread : Threads) {
+    Thread.join();
+  }
+}
+
+std::future<int> ProcessPool::submit(std::function<int()> Task) {
+  std::packaged_task<int()> Packaged(std::move(Task));
+  std::future<int> Result = Packaged.get_future();
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Tasks.push_back(std::move(Packaged));
+    // Threads are started lazily, up to the limit, when there are more
+    // queued tasks than idle threads.
+    if (Tasks.size() > Idle && Threads.size() < MaxThreads) {
+      Threads.emplace_back([this]() { run(); });
+    }
+  }
+  Available.notify_one();
+  return Result;
+}
+
+void ProcessPool::run() {
+  for (;;) {
+    std::packaged_task<int()> Task;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      ++Idle;
+      Available.wait(Lock, [this]() { return !Tasks.empty() || Stopping; });
+      --Idle;
+      if (Tasks.empty())
+        return;
+      Task = std::move(Tasks.front());
+      Tasks.pop_front();
+    }
+    Task();
+  }
 }
 
 void copyFile(const std::string& src, const std::string& dest) {
@@ -15,35 +15,97 @@
 
 #include "Fixup.hpp"
 #include "AuxDataUtils.hpp"
+#include "FileUtils.hpp"
+#include "FixupOverlay.hpp"
 #include "PrettyPrinter.hpp"
+#include <algorithm>
+#include <future>
 #include <gtirb/gtirb.hpp>
+#include <thread>
+#include <unordered_map>
 
 namespace gtirb_pprint {
 
 void applyFixups(gtirb::Context& Context, gtirb::Module& Module,
-                 const PrettyPrinter& Printer) {
+                 const PrettyPrinter& Printer, FixupOverlay* Overlay) {
   auto format = std::get<0>(Printer.getTarget());
   if (format == "pe") {
-    fixupPESymbols(Context, Module);
+    fixupPESymbols(Context, Module, Overlay);
   }
   if (format == "elf") {
-    fixupELFSymbols(Context, Module);
+    fixupELFSymbols(Context, Module, Overlay);
     if (Printer.getDynMode(Module) == DYN_MODE_SHARED) {
-      fixupSharedObject(Context, Module);
+      fixupSharedObject(Context, Module, Overlay);
     }
   }
 }
 
-void fixupSharedObject(gtirb::Context& Context, gtirb::Module& Module) {
-  std::unordered_set<gtirb::Symbol*> SymbolsToAlias;
-  std::vector<gtirb::ByteInterval::SymbolicExpressionElement> SEEsToAlias,
-      SEEsToPLT;
-  for (auto& CB : Module.code_blocks()) {
-    // Previously, the changes here were not applied to any code blocks that
-    // would be skipped by the PrettyPrinter. Now that these are being
-    // separated, all code blocks are corrected and the printer can decide
-    // whether to print them or not.
-    for (auto SEE : CB.getByteInterval()->findSymbolicExpressionsAtOffset(
+namespace {
+
+/// How direct references from code to a symbol must change in a shared
+/// object.
+enum class SharedObjectReference {
+  Keep,  ///< The reference is allowed.
+  Alias, ///< The reference must use a hidden alias of the symbol.
+  PLT,   ///< The reference must go through the PLT.
+};
+
+SharedObjectReference classifyReference(const gtirb::Symbol& Symbol) {
+  if (!Symbol.hasReferent() && Symbol.getAddress()) {
+    return SharedObjectReference::Keep; // integral symbols don't need fixed up
+  }
+  // direct references to global symbols are not allowed in shared objects
+  auto Info = aux_data::getElfSymbolInfo(Symbol);
+  if (!Info || Info->Binding == "LOCAL" || Info->Visibility != "DEFAULT") {
+    return SharedObjectReference::Keep;
+  }
+  if (!Symbol.hasReferent() || Symbol.getReferent<gtirb::ProxyBlock>() ||
+      aux_data::getForwardedSymbol(&Symbol)) {
+    // functions need to be referenced through the PLT
+    return Info->Type == "FUNC" ? SharedObjectReference::PLT
+                                : SharedObjectReference::Keep;
+  }
+  return SharedObjectReference::Alias;
+}
+
+/// A symbolic expression in code that must be rewritten for a shared object.
+struct SharedObjectRewrite {
+  uint64_t Offset;
+  /// Whether some of its symbols must be replaced by their hidden aliases.
+  bool Alias = false;
+  /// Whether it must go through the PLT.
+  bool PLT = false;
+};
+
+/// The changes to make to one ByteInterval for a shared object.
+struct IntervalRewrites {
+  std::vector<SharedObjectRewrite> Rewrites;
+  /// The symbols that need a hidden alias, in the order they are referenced.
+  std::vector<gtirb::Symbol*> Aliased;
+};
+
+using ReferenceCache =
+    std::unordered_map<const gtirb::Symbol*, SharedObjectReference>;
+
+/// Find the symbolic expressions of the code blocks of an interval that must
+/// be rewritten. This only reads the IR.
+void analyzeSharedObjectInterval(const gtirb::ByteInterval& Interval,
+                                 ReferenceCache& Cache,
+                                 IntervalRewrites& Result) {
+  auto classify = [&Cache](gtirb::Symbol* Symbol) {
+    auto [It, Inserted] = Cache.try_emplace(Symbol);
+    if (Inserted) {
+      It->second = classifyReference(*Symbol);
+    }
+    return It->second;
+  };
+
+  // Previously, the changes here were not applied to any code blocks that
+  // would be skipped by the PrettyPrinter. Now that these are being
+  // separated, all code blocks are corrected and the printer can decide
+  // whether to print them or not.
+  for (const auto& CB : Interval.code_blocks()) {
+    for (const auto& SEE : Interval.findSymbolicExpressionsAtOffset(
              CB.getOffset(), CB.getOffset() + CB.getSize())) {
       auto SymsToCheck = std::visit(
           [](const auto& SE) -> std::vector<gtirb::Symbol*> {
@@ -62,117 +124,170 @@ void fixupSharedObject(gtirb::Context& Context, gtirb::Module& Module) {
           },
           SEE.getSymbolicExpression());
 
+      SharedObjectRewrite Rewrite{SEE.getOffset()};
       for (auto* Symbol : SymsToCheck) {
-        if (!Symbol->hasReferent() && Symbol->getAddress()) {
-          continue; // integral symbols don't need fixed up
-        }
-
-        if (auto Info = aux_data::getElfSymbolInfo(*Symbol)) {
-          if (Info->Binding != "LOCAL" && Info->Visibility == "DEFAULT") {
-            // direct references to global symbols are not allowed in
-            // shared objects
-            if (!Symbol->hasReferent() ||
-                Symbol->getReferent<gtirb::ProxyBlock>() ||
-                aux_data::getForwardedSymbol(Symbol)) {
-              if (Info->Type == "FUNC") {
-                // need to turn into a PLT reference
-                SEEsToPLT.push_back(SEE);
-              }
-            } else {
-              // need to change to the hidden alias
-              SymbolsToAlias.insert(Symbol);
-              SEEsToAlias.push_back(SEE);
-            }
-          }
+        switch (classify(Symbol)) {
+        case SharedObjectReference::Alias:
+          Rewrite.Alias = true;
+          Result.Aliased.push_back(Symbol);
+          break;
+        case SharedObjectReference::PLT:
+          Rewrite.PLT = true;
+          break;
+        case SharedObjectReference::Keep:
+          break;
         }
       }
+      if (Rewrite.Alias || Rewrite.PLT) {
+        Result.Rewrites.push_back(Rewrite);
+      }
     }
   }
 
-  // make a hidden alias for every global symbol that is called
-  // directly by a code block
-  using GlobalToHiddenSymsType =
-      std::unordered_map<gtirb::Symbol*, gtirb::Symbol*>;
-  GlobalToHiddenSymsType GlobalToHiddenSyms;
-
-  for (auto* Symbol : SymbolsToAlias) {
-    struct SetHiddenSymbolReferent {
-      gtirb::Symbol* S;
-      SetHiddenSymbolReferent(gtirb::Symbol* Sym) : S{Sym} {}
-      void operator()(gtirb::Addr A) { S->setAddress(A); }
-      void operator()(gtirb::CodeBlock* B) { S->setReferent(B); }
-      void operator()(gtirb::DataBlock* B) { S->setReferent(B); }
-      void operator()(gtirb::ProxyBlock* B) { S->setReferent(B); }
-    };
-
-    auto* HiddenSymbol = Module.addSymbol(
-        Context, ".gtirb_pprinter.hidden_alias." + Symbol->getName());
-    Symbol->visit(SetHiddenSymbolReferent(HiddenSymbol));
-    auto SymInfo = *aux_data::getElfSymbolInfo(*Symbol);
-    aux_data::ElfSymbolInfo NewSymInfo{SymInfo};
-    NewSymInfo.Visibility = "HIDDEN";
-    aux_data::setElfSymbolInfo(*HiddenSymbol, NewSymInfo);
-    GlobalToHiddenSyms[Symbol] = HiddenSymbol;
+  // Code blocks may overlap, so an expression may have been found twice.
+  auto ByOffset = [](const SharedObjectRewrite& L,
+                     const SharedObjectRewrite& R) {
+    return L.Offset < R.Offset;
+  };
+  std::sort(Result.Rewrites.begin(), Result.Rewrites.end(), ByOffset);
+  Result.Rewrites.erase(
+      std::unique(Result.Rewrites.begin(), Result.Rewrites.end(),
+                  [](const SharedObjectRewrite& L,
+                     const SharedObjectRewrite& R) {
+                    return L.Offset == R.Offset;
+                  }),
+      Result.Rewrites.end());
+}
+
+/// Create a hidden alias of a global symbol.
+gtirb::Symbol* addHiddenAlias(gtirb::Context& Context, gtirb::Module& Module,
+                              gtirb::Symbol& Symbol, FixupOverlay* Overlay) {
+  struct SetHiddenSymbolReferent {
+    gtirb::Symbol* S;
+    SetHiddenSymbolReferent(gtirb::Symbol* Sym) : S{Sym} {}
+    void operator()(gtirb::Addr A) { S->setAddress(A); }
+    void operator()(gtirb::CodeBlock* B) { S->setReferent(B); }
+    void operator()(gtirb::DataBlock* B) { S->setReferent(B); }
+    void operator()(gtirb::ProxyBlock* B) { S->setReferent(B); }
+  };
+
+  auto* HiddenSymbol = Module.addSymbol(
+      Context, ".gtirb_pprinter.hidden_alias." + Symbol.getName());
+  if (Overlay) {
+    Overlay->addedSymbol(*HiddenSymbol);
+    Overlay->changingElfSymbolInfo(*HiddenSymbol);
   }
+  Symbol.visit(SetHiddenSymbolReferent(HiddenSymbol));
+  auto SymInfo = *aux_data::getElfSymbolInfo(Symbol);
+  aux_data::ElfSymbolInfo NewSymInfo{SymInfo};
+  NewSymInfo.Visibility = "HIDDEN";
+  aux_data::setElfSymbolInfo(*HiddenSymbol, NewSymInfo);
+  return HiddenSymbol;
+}
 
-  // reassign bad code block references to hidden symbols
-  for (auto SEE : SEEsToAlias) {
-    auto SEToAdd = std::visit(
-        [&GlobalToHiddenSyms](const auto& SE) -> gtirb::SymbolicExpression {
-          using T = std::decay_t<decltype(SE)>;
-          T NewSE{SE};
-
-          if constexpr (std::is_same_v<T, gtirb::SymAddrAddr>) {
-            if (auto It = GlobalToHiddenSyms.find(SE.Sym1);
-                It != GlobalToHiddenSyms.end()) {
-              NewSE.Sym1 = It->second;
-            }
-            if (auto It = GlobalToHiddenSyms.find(SE.Sym2);
-                It != GlobalToHiddenSyms.end()) {
-              NewSE.Sym2 = It->second;
-            }
-          } else if constexpr (std::is_same_v<T, gtirb::SymAddrConst>) {
-            NewSE.Sym = GlobalToHiddenSyms.at(SE.Sym);
-          }
+} // namespace
 
-          return {NewSE};
-        },
-        SEE.getSymbolicExpression());
-    SEE.getByteInterval()->addSymbolicExpression(SEE.getOffset(), SEToAdd);
+void fixupSharedObject(gtirb::Context& Context, gtirb::Module& Module,
+                       FixupOverlay* Overlay) {
+  std::vector<gtirb::ByteInterval*> Intervals;
+  for (auto& BI : Module.byte_intervals()) {
+    if (!BI.code_blocks().empty()) {
+      Intervals.push_back(&BI);
+    }
   }
 
-  // make bad code block references to extern symbols go through the PLT
-  for (auto SEE : SEEsToPLT) {
-    auto SEToAdd = std::visit(
-        [&Context](const auto& SE) -> gtirb::SymbolicExpression {
-          using T = std::decay_t<decltype(SE)>;
-          T NewSE{SE};
-          NewSE.Attributes.insert(gtirb::SymAttribute::PLT);
-
-          if constexpr (std::is_same_v<T, gtirb::SymAddrAddr>) {
-            if (auto Target = aux_data::getForwardedSymbol(SE.Sym1)) {
-              NewSE.Sym1 = getByUUID<gtirb::Symbol>(Context, *Target);
-            }
-            if (auto Target = aux_data::getForwardedSymbol(SE.Sym2)) {
-              NewSE.Sym2 = getByUUID<gtirb::Symbol>(Context, *Target);
+  // Find the expressions to rewrite and the symbols to alias. The analysis
+  // only reads the IR, so the intervals are analyzed concurrently; GTIRB
+  // decodes AuxData when it is first accessed, so that is done here first.
+  Module.getAuxData<gtirb::schema::ElfSymbolInfo>();
+  Module.getAuxData<gtirb::schema::SymbolForwarding>();
+  std::vector<IntervalRewrites> Results(Intervals.size());
+  // Small modules are not worth the threads.
+  constexpr size_t IntervalsPerWorker = 64;
+  size_t Workers = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()),
+      (Intervals.size() + IntervalsPerWorker - 1) / IntervalsPerWorker);
+  auto analyze = [&](size_t First) {
+    ReferenceCache Cache;
+    for (size_t I = First; I < Intervals.size(); I += Workers) {
+      analyzeSharedObjectInterval(*Intervals[I], Cache, Results[I]);
+    }
+    return 0;
+  };
+  if (Workers <= 1) {
+    Workers = 1;
+    analyze(0);
+  } else {
+    gtirb_bprint::ProcessPool Pool(static_cast<unsigned>(Workers));
+    std::vector<std::future<int>> Done;
+    for (size_t W = 0; W < Workers; ++W) {
+      Done.push_back(Pool.submit([&analyze, W]() { return analyze(W); }));
+    }
+    for (auto& F : Done) {
+      F.get();
+    }
+  }
+
+  // make a hidden alias for every global symbol that is referenced
+  // directly by a code block, once per symbol
+  std::unordered_map<gtirb::Symbol*, gtirb::Symbol*> GlobalToHiddenSyms;
+  for (const IntervalRewrites& Result : Results) {
+    for (gtirb::Symbol* Symbol : Result.Aliased) {
+      if (auto [It, Inserted] = GlobalToHiddenSyms.try_emplace(Symbol);
+          Inserted) {
+        It->second = addHiddenAlias(Context, Module, *Symbol, Overlay);
+      }
+    }
+  }
+
+  // reassign bad code block references to hidden symbols, and make bad
+  // code block references to extern symbols go through the PLT
+  for (size_t I = 0; I < Intervals.size(); ++I) {
+    gtirb::ByteInterval* BI = Intervals[I];
+    for (const SharedObjectRewrite& Rewrite : Results[I].Rewrites) {
+      auto replace = [&](gtirb::Symbol*& Symbol) {
+        if (auto It = GlobalToHiddenSyms.find(Symbol);
+            Rewrite.Alias && It != GlobalToHiddenSyms.end()) {
+          Symbol = It->second;
+        } else if (Rewrite.PLT) {
+          if (auto Target = aux_data::getForwardedSymbol(Symbol)) {
+            Symbol = getByUUID<gtirb::Symbol>(Context, *Target);
+          }
+        }
+      };
+      auto SEToAdd = std::visit(
+          [&](const auto& SE) -> gtirb::SymbolicExpression {
+            using T = std::decay_t<decltype(SE)>;
+            T NewSE{SE};
+            if (Rewrite.PLT) {
+              NewSE.Attributes.insert(gtirb::SymAttribute::PLT);
             }
-          } else if constexpr (std::is_same_v<T, gtirb::SymAddrConst>) {
-            if (auto Target = aux_data::getForwardedSymbol(SE.Sym)) {
-              NewSE.Sym = getByUUID<gtirb::Symbol>(Context, *Target);
+
+            if constexpr (std::is_same_v<T, gtirb::SymAddrAddr>) {
+              replace(NewSE.Sym1);
+              replace(NewSE.Sym2);
+            } else if constexpr (std::is_same_v<T, gtirb::SymAddrConst>) {
+              replace(NewSE.Sym);
             }
-          }
 
-          return {NewSE};
-        },
-        SEE.getSymbolicExpression());
-    SEE.getByteInterval()->addSymbolicExpression(SEE.getOffset(), SEToAdd);
+            return {NewSE};
+          },
+          *BI->getSymbolicExpression(Rewrite.Offset));
+      if (Overlay) {
+        Overlay->changingSymbolicExpression(*BI, Rewrite.Offset);
+      }
+      BI->addSymbolicExpression(Rewrite.Offset, SEToAdd);
+    }
   }
 };
 
 /**
 Update an ELF symbol's binding/visibility to GLOBAL/HIDDEN
 */
-static void promoteSymbolBinding(gtirb::Symbol& Sym) {
+static void promoteSymbolBinding(gtirb::Symbol& Sym, FixupOverlay* Overlay) {
+  if (Overlay) {
+    Overlay->changingElfSymbolInfo(Sym);
+  }
   auto SymInfo = aux_data::getElfSymbolInfo(Sym);
   aux_data::ElfSymbolInfo NewSymInfo{*SymInfo};
   NewSymInfo.Binding = "GLOBAL";
@@ -182,7 +297,8 @@ static void promoteSymbolBinding(gtirb::Symbol& Sym) {
   aux_data::setElfSymbolInfo(Sym, NewSymInfo);
 }
 
-void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
+void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module,
+                     FixupOverlay* Overlay) {
   // Promote main
   // Allows _start to reference main when using --policy=dynamic
   // With --policy=complete, this is unnecessary, but should have no impact on
@@ -191,7 +307,7 @@ void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
     auto& Symbol = *It.begin();
     if (auto SymInfo = aux_data::getElfSymbolInfo(Symbol)) {
       if (SymInfo->Binding != "GLOBAL") {
-        promoteSymbolBinding(Symbol);
+        promoteSymbolBinding(Symbol, Overlay);
       }
     }
   }
@@ -201,7 +317,7 @@ void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
     auto& Symbol = *It.begin();
     if (auto SymInfo = aux_data::getElfSymbolInfo(Symbol)) {
       if (SymInfo->Binding != "GLOBAL") {
-        promoteSymbolBinding(Symbol);
+        promoteSymbolBinding(Symbol, Overlay);
       }
     }
   }
@@ -216,7 +332,7 @@ void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
     auto Symbols = Module.findSymbols(*Block);
     if (!aux_data::findSymWithBinding(Symbols, "GLOBAL")) {
       if (auto LocalSym = aux_data::findSymWithBinding(Symbols, "LOCAL")) {
-        promoteSymbolBinding(*LocalSym);
+        promoteSymbolBinding(*LocalSym, Overlay);
       } else {
         std::string Name = DefaultName;
         for (unsigned int Count = 0; !Module.findSymbols(Name).empty();
@@ -225,6 +341,10 @@ void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
         }
 
         gtirb::Symbol* Symbol = Module.addSymbol(Context, Block, Name);
+        if (Overlay) {
+          Overlay->addedSymbol(*Symbol);
+          Overlay->changingElfSymbolInfo(*Symbol);
+        }
         aux_data::ElfSymbolInfo Info({0, "NOTYPE", "GLOBAL", "HIDDEN", 0});
         aux_data::setElfSymbolInfo(*Symbol, Info);
       }
@@ -239,10 +359,16 @@ void fixupELFSymbols(gtirb::Context& Context, gtirb::Module& Module) {
       "_fini");
 };
 
-void fixupPESymbols(gtirb::Context& Context, gtirb::Module& Module) {
+void fixupPESymbols(gtirb::Context& Context, gtirb::Module& Module,
+                    FixupOverlay* Overlay) {
   if (auto It = Module.findSymbols("__ImageBase"); !It.empty()) {
     auto ImageBase = &*It.begin();
-    ImageBase->setReferent(Module.addProxyBlock(Context));
+    auto* Proxy = Module.addProxyBlock(Context);
+    if (Overlay) {
+      Overlay->addedProxyBlock(*Proxy);
+      Overlay->changingSymbol(*ImageBase);
+    }
+    ImageBase->setReferent(Proxy);
     if (Module.getISA() == gtirb::ISA::IA32) {
       ImageBase->setName("___ImageBase");
     }
@@ -254,6 +380,9 @@ void fixupPESymbols(gtirb::Context& Context, gtirb::Module& Module) {
           gtirb::Symbol::Create(Context, *Block->getAddress(), "__EntryPoint");
       EntryPoint->setReferent<gtirb::CodeBlock>(Block);
       Module.addSymbol(EntryPoint);
+      if (Overlay) {
+        Overlay->addedSymbol(*EntryPoint);
+      }
     }
   }
 };
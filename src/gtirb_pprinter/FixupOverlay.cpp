@@ -0,0 +1,137 @@
+//===- FixupOverlay.cpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "FixupOverlay.hpp"
+#include "AuxDataSchema.hpp"
+#include "AuxDataUtils.hpp"
+#include <unordered_set>
+
+namespace gtirb_pprint {
+
+void FixupOverlay::saveLayout() {
+  std::vector<std::pair<gtirb::ByteInterval*, std::optional<gtirb::Addr>>>
+      Intervals;
+  for (gtirb::ByteInterval& BI : Module.byte_intervals()) {
+    Intervals.emplace_back(&BI, BI.getAddress());
+  }
+  std::vector<std::pair<gtirb::Symbol*, gtirb::Addr>> IntegralSymbols;
+  for (gtirb::Symbol& Sym : Module.symbols()) {
+    if (!Sym.hasReferent() && Sym.getAddress()) {
+      IntegralSymbols.emplace_back(&Sym, *Sym.getAddress());
+    }
+  }
+  // fixIntegralSymbols only adds 0-length blocks, as referents of integral
+  // symbols.
+  std::unordered_set<const gtirb::Node*> EmptyBlocks;
+  for (const gtirb::CodeBlock& Block : Module.code_blocks()) {
+    if (Block.getSize() == 0) {
+      EmptyBlocks.insert(&Block);
+    }
+  }
+  for (const gtirb::DataBlock& Block : Module.data_blocks()) {
+    if (Block.getSize() == 0) {
+      EmptyBlocks.insert(&Block);
+    }
+  }
+
+  Undo.push_back([Intervals = std::move(Intervals),
+                  IntegralSymbols = std::move(IntegralSymbols),
+                  EmptyBlocks = std::move(EmptyBlocks)]() {
+    for (const auto& [BI, Address] : Intervals) {
+      BI->setAddress(Address);
+    }
+    for (const auto& [Sym, Address] : IntegralSymbols) {
+      gtirb::Node* Referent = Sym->getReferent<gtirb::Node>();
+      Sym->setAddress(Address);
+      // Symbols at the same address share a block, which is removed once.
+      if (!Referent || EmptyBlocks.count(Referent)) {
+        continue;
+      }
+      if (auto* CB = gtirb::dyn_cast<gtirb::CodeBlock>(Referent);
+          CB && CB->getSize() == 0 && CB->getByteInterval()) {
+        CB->getByteInterval()->removeBlock(CB);
+      } else if (auto* DB = gtirb::dyn_cast<gtirb::DataBlock>(Referent);
+                 DB && DB->getSize() == 0 && DB->getByteInterval()) {
+        DB->getByteInterval()->removeBlock(DB);
+      }
+    }
+  });
+}
+
+void FixupOverlay::addedSymbol(gtirb::Symbol& Symbol) {
+  Undo.push_back([this, &Symbol]() { Module.removeSymbol(&Symbol); });
+}
+
+void FixupOverlay::addedProxyBlock(gtirb::ProxyBlock& Block) {
+  Undo.push_back([this, &Block]() { Module.removeProxyBlock(&Block); });
+}
+
+void FixupOverlay::changingSymbol(gtirb::Symbol& Symbol) {
+  Undo.push_back([&Symbol, Name = Symbol.getName(),
+                  Referent = Symbol.getReferent<gtirb::Node>(),
+                  Address = Symbol.getAddress()]() {
+    Symbol.setName(Name);
+    if (auto* CB = gtirb::dyn_cast_or_null<gtirb::CodeBlock>(Referent)) {
+      Symbol.setReferent(CB);
+    } else if (auto* DB = gtirb::dyn_cast_or_null<gtirb::DataBlock>(Referent)) {
+      Symbol.setReferent(DB);
+    } else if (auto* PB =
+                   gtirb::dyn_cast_or_null<gtirb::ProxyBlock>(Referent)) {
+      Symbol.setReferent(PB);
+    } else if (Address) {
+      Symbol.setAddress(*Address);
+    } else {
+      // The symbol had no payload; its new referent may be removed with
+      // the rest of the overlay, so it must not be left pointing to it.
+      Symbol.setReferent<gtirb::ProxyBlock>(nullptr);
+    }
+  });
+}
+
+void FixupOverlay::changingElfSymbolInfo(gtirb::Symbol& Symbol) {
+  Undo.push_back([this, &Symbol,
+                  Info = aux_data::getElfSymbolInfo(Symbol)]() mutable {
+    if (Info) {
+      aux_data::setElfSymbolInfo(Symbol, *Info);
+    } else if (auto* Table =
+                   Module.getAuxData<gtirb::schema::ElfSymbolInfo>()) {
+      Table->erase(Symbol.getUUID());
+    }
+  });
+}
+
+void FixupOverlay::changingSymbolicExpression(gtirb::ByteInterval& Interval,
+                                              uint64_t Offset) {
+  std::optional<gtirb::SymbolicExpression> Previous;
+  if (const gtirb::SymbolicExpression* SE =
+          Interval.getSymbolicExpression(Offset)) {
+    Previous = *SE;
+  }
+  Undo.push_back([&Interval, Offset, Previous = std::move(Previous)]() {
+    if (Previous) {
+      Interval.addSymbolicExpression(Offset, *Previous);
+    } else {
+      Interval.removeSymbolicExpression(Offset);
+    }
+  });
+}
+
+void FixupOverlay::discard() {
+  while (!Undo.empty()) {
+    Undo.back()();
+    Undo.pop_back();
+  }
+}
+
+} // namespace gtirb_pprint
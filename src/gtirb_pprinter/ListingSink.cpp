@@ -0,0 +1,126 @@
+//===- ListingSink.cpp ------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ListingSink.hpp"
+#include <algorithm>
+#include <ostream>
+
+namespace gtirb_pprint {
+
+static const char HexDigits[] = "0123456789abcdef";
+
+std::string jsonQuote(std::string_view Text) {
+  std::string Quoted = "\"";
+  Quoted.reserve(Text.size() + 2);
+  for (char C : Text) {
+    auto Byte = static_cast<unsigned char>(C);
+    if (C == '"' || C == '\\') {
+      Quoted += '\\';
+      Quoted += C;
+    } else if (C == '\n') {
+      Quoted += "\\n";
+    } else if (C == '\t') {
+      Quoted += "\\t";
+    } else if (Byte < 0x20 || Byte >= 0x7f) {
+      Quoted += "\\u00";
+      Quoted += HexDigits[Byte >> 4];
+      Quoted += HexDigits[Byte & 0xf];
+    } else {
+      Quoted += C;
+    }
+  }
+  Quoted += '"';
+  return Quoted;
+}
+
+// Write Bytes, followed by zeros up to Size bytes, as a hexadecimal string.
+static void writeHex(std::ostream& Out, std::string_view Bytes,
+                     uint64_t Size) {
+  Out << '"';
+  for (char C : Bytes) {
+    auto Byte = static_cast<unsigned char>(C);
+    Out << HexDigits[Byte >> 4] << HexDigits[Byte & 0xf];
+  }
+  for (uint64_t I = Bytes.size(); I < Size; ++I) {
+    Out << "00";
+  }
+  Out << '"';
+}
+
+void JsonLinesSink::onSection(const gtirb::Section& Section) {
+  Out << "{\"type\":\"section\",\"name\":" << jsonQuote(Section.getName());
+  if (std::optional<gtirb::Addr> Addr = Section.getAddress()) {
+    Out << ",\"address\":" << static_cast<uint64_t>(*Addr);
+  }
+  if (std::optional<uint64_t> Size = Section.getSize()) {
+    Out << ",\"size\":" << *Size;
+  }
+  Out << "}\n";
+}
+
+void JsonLinesSink::onSymbol(const gtirb::Symbol& /* Symbol */,
+                             std::string_view Name, gtirb::Addr Address) {
+  Out << "{\"type\":\"symbol\",\"name\":" << jsonQuote(Name)
+      << ",\"address\":" << static_cast<uint64_t>(Address) << "}\n";
+}
+
+void JsonLinesSink::onInstruction(const InstructionEvent& Instruction) {
+  Out << "{\"type\":\"instruction\",\"address\":"
+      << static_cast<uint64_t>(Instruction.Address) << ",\"bytes\":";
+  writeHex(Out, Instruction.Bytes, Instruction.Bytes.size());
+  Out << ",\"mnemonic\":" << jsonQuote(Instruction.Mnemonic)
+      << ",\"operands\":[";
+  for (size_t I = 0; I < Instruction.Operands.size(); ++I) {
+    Out << (I ? "," : "") << jsonQuote(Instruction.Operands[I]);
+  }
+  Out << ']';
+  writeReferences(Instruction.References);
+  Out << "}\n";
+}
+
+void JsonLinesSink::onData(const DataEvent& Data) {
+  Out << "{\"type\":\"data\",\"address\":"
+      << static_cast<uint64_t>(Data.Address) << ",\"size\":" << Data.Size;
+  if (Data.Type) {
+    Out << ",\"encoding\":" << jsonQuote(*Data.Type);
+  }
+  if (std::any_of(Data.Bytes.begin(), Data.Bytes.end(),
+                  [](char C) { return C != 0; })) {
+    Out << ",\"bytes\":";
+    writeHex(Out, Data.Bytes, Data.Size);
+  }
+  writeReferences(Data.References);
+  Out << "}\n";
+}
+
+void JsonLinesSink::writeReferences(
+    const std::vector<SymbolicReference>& References) {
+  if (References.empty()) {
+    return;
+  }
+  Out << ",\"refs\":[";
+  for (size_t I = 0; I < References.size(); ++I) {
+    const SymbolicReference& Ref = References[I];
+    Out << (I ? "," : "") << "{\"offset\":" << Ref.Offset
+        << ",\"symbol\":" << jsonQuote(Ref.Symbol);
+    if (Ref.Minus) {
+      Out << ",\"minus\":" << jsonQuote(*Ref.Minus)
+          << ",\"scale\":" << Ref.Scale;
+    }
+    Out << ",\"addend\":" << Ref.Addend << '}';
+  }
+  Out << ']';
+}
+
+} // namespace gtirb_pprint
@@ -226,7 +226,7 @@ void Mips32PrettyPrinter::printOperandList(std::ostream& os,
     if (i != 0) {
       os << ',';
     }
-    printOperand(os, block, inst, i);
+    printListedOperand(os, block, inst, i);
   }
 }
 
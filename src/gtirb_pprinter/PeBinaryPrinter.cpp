@@ -13,20 +13,22 @@
 //
 //===----------------------------------------------------------------------===//
 #include "PeBinaryPrinter.hpp"
+#include "ArtifactCache.hpp"
 #include "AuxDataSchema.hpp"
 #include "AuxDataUtils.hpp"
 #include "FileUtils.hpp"
+#include "ToolchainProbe.hpp"
 #include "driver/Logger.h"
 
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
 
 #include <boost/filesystem.hpp>
-#include <boost/process/io.hpp>
-#include <boost/process/search_path.hpp>
-#include <boost/process/system.hpp>
+#include <boost/process/environment.hpp>
 
 namespace fs = boost::filesystem;
-namespace bp = boost::process;
 
 namespace gtirb_bprint {
 
@@ -97,41 +99,37 @@ CommandList linkCommands(const PeLinkOptions& Options) {
   return AssembleLink(Options);
 }
 
+// Whether Tool can be found on PATH.
+bool hasTool(const std::string& Tool) {
+  return ToolchainProbe::instance().find(Tool).has_value();
+}
+
 // Read LLVM bin directory path from `llvm-config --bindir'.
 std::optional<std::string> llvmBinDir() {
-  bp::ipstream InputStream;
+  ToolchainProbe& Probe = ToolchainProbe::instance();
 
   // Look for a default `llvm-config' binary.
-  fs::path LlvmConfig = bp::search_path("llvm-config");
+  std::optional<std::string> LlvmConfig = Probe.find("llvm-config");
 
-  if (LlvmConfig.empty()) {
+  if (!LlvmConfig) {
     // Look for known versions.
     const static std::vector<std::string> Versions = {
         "12", "11", "10", "9", "8", "7", "6.0",
     };
     for (const auto& Version : Versions) {
-      LlvmConfig = bp::search_path("llvm-config-" + Version);
-      if (!LlvmConfig.empty()) {
+      LlvmConfig = Probe.find("llvm-config-" + Version);
+      if (LlvmConfig) {
         LOG_INFO << "Using llvm-config-" + Version + " to find llvm-dlltool\n";
         break;
       }
     }
   }
 
-  if (LlvmConfig.empty()) {
+  if (!LlvmConfig) {
     return std::nullopt;
   }
 
-  bp::child Child(LlvmConfig, "--bindir", bp::std_out > InputStream);
-  Child.wait();
-
-  std::string Line;
-  if (Child.exit_code() == 0 && std::getline(InputStream, Line) &&
-      !Line.empty()) {
-    return Line;
-  }
-
-  return std::nullopt;
+  return Probe.query(*LlvmConfig, {"--bindir"});
 }
 
 inline void appendCommands(CommandList& T, CommandList& U) {
@@ -163,6 +161,78 @@ int executeCommands(const CommandList& Commands) {
   return 0;
 }
 
+// An import library to generate, and the commands generating it.
+struct ImportLib {
+  std::string Lib;
+  CommandList Commands;
+  std::string Key;
+};
+
+// Build the commands generating a .LIB file for each import .DEF file. The
+// commands are built serially, as locating the tools may modify PATH.
+// Libraries that can be taken from Cache are copied into place instead.
+std::vector<ImportLib> importLibs(
+    const std::map<std::string, std::unique_ptr<TempFile>>& ImportDefs,
+    const std::optional<std::string>& Machine, const ArtifactCache* Cache) {
+  std::vector<ImportLib> Result;
+  for (auto& [Import, Temp] : ImportDefs) {
+    std::string Def = Temp->fileName();
+    std::string Lib = replaceExtension(Import, ".lib");
+    CommandList Commands = libCommands({Def, Lib, Machine});
+
+    std::string Key;
+    if (Cache) {
+      // The library is determined by the DEF file's contents, the target
+      // machine, and the tools building it.
+      std::ifstream DefIn(Def);
+      std::string DefText((std::istreambuf_iterator<char>(DefIn)),
+                          std::istreambuf_iterator<char>());
+      CacheKey Builder;
+      Builder.add("pe-import-lib").add(Lib).add(Machine.value_or(""));
+      Builder.add(DefText);
+      for (const auto& [Tool, Args] : Commands) {
+        (void)Args; // Args name temporary files; the tool determines them.
+        Builder.add(ArtifactCache::toolIdentity(Tool));
+      }
+      Key = Builder.str();
+      if (Cache->fetch(Key, Lib)) {
+        LOG_INFO << "Reusing cached import library " << Lib << "\n";
+        continue;
+      }
+    }
+    Result.push_back({Lib, std::move(Commands), Key});
+  }
+  return Result;
+}
+
+// Run the command lists of independent libraries concurrently; the commands
+// within each list still run in order.
+std::vector<std::future<int>>
+submitLibCommands(ProcessPool& Pool, std::vector<ImportLib> Libs,
+                  std::shared_ptr<ArtifactCache> Cache) {
+  std::vector<std::future<int>> Jobs;
+  for (auto& Lib : Libs) {
+    Jobs.push_back(Pool.submit([Lib = std::move(Lib), Cache]() {
+      int Rc = executeCommands(Lib.Commands);
+      if (Rc == 0 && Cache) {
+        Cache->publish(Lib.Key, Lib.Lib);
+      }
+      return Rc;
+    }));
+  }
+  return Jobs;
+}
+
+int waitForLibCommands(std::vector<std::future<int>>& Jobs) {
+  int Result = 0;
+  for (auto& Job : Jobs) {
+    if (int Rc = Job.get()) {
+      Result = Rc;
+    }
+  }
+  return Result;
+}
+
 // lib.exe /DEF:X.def /OUT:X.lib
 // Input: DEF  Output: LIB
 CommandList msvcLib(const PeLibOptions& Options) {
@@ -457,8 +527,7 @@ CommandList uasmAssembleLink(const PeLinkOptions& Options) {
 PeLib peLib() {
   auto Env = boost::this_process::environment();
   // Prefer MSVC `lib.exe'.
-  fs::path Path = bp::search_path("lib.exe");
-  if (!Path.empty()) {
+  if (hasTool("lib.exe")) {
     return msvcLib;
   } else {
     LOG_INFO << "lib.exe: command not found\n";
@@ -478,16 +547,14 @@ PeLib peLib() {
   }
 
   // Fallback to `llvm-dlltool'.
-  Path = bp::search_path("llvm-dlltool");
-  if (!Path.empty()) {
+  if (hasTool("llvm-dlltool")) {
     return llvmDllTool;
   }
 
   // Fallback to `lld-link':
   // When `link.exe' is invoked with `/DEF:' and no input files, it behaves as
   // `lib.exe' would. LLVM's `lld-link' emulates this behavior.
-  Path = bp::search_path("lld-link");
-  if (!Path.empty()) {
+  if (hasTool("lld-link")) {
     return llvmLib;
   }
 
@@ -497,14 +564,12 @@ PeLib peLib() {
 // Locate `link.exe' or alternative PE linker.
 PeLink peLink() {
   // Prefer MSVC `link.exe'.
-  fs::path Path = bp::search_path("link.exe");
-  if (!Path.empty()) {
+  if (hasTool("link.exe")) {
     return msvcLink;
   }
 
   // Fallback to `lld-link'.
-  Path = bp::search_path("lld-link");
-  if (!Path.empty()) {
+  if (hasTool("lld-link")) {
     return llvmLink;
   }
 
@@ -514,14 +579,12 @@ PeLink peLink() {
 // Locate MSVC `ml' or `uasm' MASM assembler.
 PeAssemble peAssemble() {
   // Prefer MSVC assembler.
-  fs::path Path = bp::search_path("cl");
-  if (!Path.empty()) {
+  if (hasTool("cl")) {
     return msvcAssemble;
   }
 
   // Fallback to UASM.
-  Path = bp::search_path("uasm");
-  if (!Path.empty()) {
+  if (hasTool("uasm")) {
     return uasmAssemble;
   }
 
@@ -531,14 +594,12 @@ PeAssemble peAssemble() {
 // Locate "assemble and link" tools.
 PeAssembleLink peAssembleLink() {
   // Prefer single, compound MSVC command.
-  fs::path Path = bp::search_path("cl");
-  if (!Path.empty()) {
+  if (hasTool("cl")) {
     return msvcAssembleLink;
   }
 
   // Fallback to UASM and a subsequent link command.
-  Path = bp::search_path("uasm");
-  if (!Path.empty()) {
+  if (hasTool("uasm")) {
     return uasmAssembleLink;
   }
 
@@ -616,6 +677,16 @@ PeBinaryPrinter::PeBinaryPrinter(
     const std::vector<std::string>& LibraryPaths_)
     : BinaryPrinter(Printer_, ExtraCompileArgs_, LibraryPaths_) {}
 
+void PeBinaryPrinter::addBuildToKey(CacheKey& Key,
+                                    const gtirb::Module& Module) const {
+  BinaryPrinter::addBuildToKey(Key, Module);
+  // The tools are chosen among those installed when the binary is built.
+  for (const char* Tool : {"cl", "ml.exe", "ml64.exe", "link.exe", "lib.exe",
+                           "uasm", "lld-link", "llvm-dlltool"}) {
+    Key.add(ArtifactCache::toolIdentity(Tool));
+  }
+}
+
 int PeBinaryPrinter::assemble(const std::string& Path, gtirb::Context& Context,
                               gtirb::Module& Module) const {
   // Print the Module to a temporary assembly file.
@@ -641,13 +712,6 @@ int PeBinaryPrinter::assemble(const std::string& Path, gtirb::Context& Context,
 int PeBinaryPrinter::link(const std::string& OutputFile,
                           gtirb::Context& Context,
                           gtirb::Module& Module) const {
-  // Prepare all ASM sources (temp files).
-  TempFile Compiland;
-  if (!prepareSource(Context, Module, Compiland)) {
-    LOG_ERROR << "Failed to write assembly to temporary file.\n";
-    return -1;
-  }
-
   // Prepare DEF import definition files (temp files).
   std::map<std::string, std::unique_ptr<TempFile>> ImportDefs;
   if (!prepareImportDefs(Module, ImportDefs)) {
@@ -655,6 +719,22 @@ int PeBinaryPrinter::link(const std::string& OutputFile,
     return -1;
   }
 
+  // Find the target platform.
+  std::optional<std::string> Machine = getPeMachine(Module);
+
+  // Generate the .LIB files from import .DEF files in the background while
+  // the module is printed.
+  ProcessPool Pool(Jobs);
+  std::vector<std::future<int>> LibJobs = submitLibCommands(
+      Pool, importLibs(ImportDefs, Machine, StubCache.get()), StubCache);
+
+  // Prepare all ASM sources (temp files).
+  TempFile Compiland;
+  if (!prepareSource(Context, Module, Compiland)) {
+    LOG_ERROR << "Failed to write assembly to temporary file.\n";
+    return -1;
+  }
+
   // Generate a DEF file for all exports.
   TempFile DefFile(".def");
   std::optional<std::string> ExportDef;
@@ -676,23 +756,16 @@ int PeBinaryPrinter::link(const std::string& OutputFile,
   // Find the PE subsystem.
   std::optional<std::string> Subsystem = getPeSubsystem(Module);
 
-  // Find the target platform.
-  std::optional<std::string> Machine = getPeMachine(Module);
-
   // Find the PE binary type.
   bool Dll = isPeDll(Module);
 
+  // The import libraries must exist before linking.
+  if (waitForLibCommands(LibJobs) != 0) {
+    return -1;
+  }
+
   // Build the list of commands.
   CommandList Commands;
-
-  // Add commands to generate .LIB files from import .DEF files.
-  for (auto& [Import, Temp] : ImportDefs) {
-    std::string Def = Temp->fileName();
-    std::string Lib = replaceExtension(Import, ".lib");
-
-    CommandList LibCommands = libCommands({Def, Lib, Machine});
-    appendCommands(Commands, LibCommands);
-  }
   std::vector<TempFile> Compilands;
   Compilands.emplace_back(std::move(Compiland));
   TempFile tempOutput(".bin");
@@ -721,19 +794,12 @@ int PeBinaryPrinter::libs(const gtirb::Module& Module) const {
   // Find the target platform.
   std::optional<std::string> Machine = getPeMachine(Module);
 
-  // Build the list of commands.
-  CommandList Commands;
-
-  // Add commands to generate .LIB files from import .DEF files.
-  for (auto& [Import, Temp] : ImportDefs) {
-    std::string Def = Temp->fileName();
-    std::string Lib = replaceExtension(Import, ".lib");
-
-    CommandList LibCommands = libCommands({Def, Lib, Machine});
-    appendCommands(Commands, LibCommands);
-  }
-
-  return executeCommands(Commands);
+  // Generate the .LIB files from import .DEF files; the libraries are
+  // independent, so their commands run concurrently.
+  ProcessPool Pool(Jobs);
+  std::vector<std::future<int>> LibJobs = submitLibCommands(
+      Pool, importLibs(ImportDefs, Machine, StubCache.get()), StubCache);
+  return waitForLibCommands(LibJobs);
 }
 
 int PeBinaryPrinter::resources(const gtirb::Module& Module,
@@ -0,0 +1,195 @@
+//===- PolicyMatcher.cpp ----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "PolicyMatcher.hpp"
+#include "PrettyPrinter.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace gtirb_pprint {
+
+// Return the position of the `]` closing the set starting at Begin, which is
+// the position of its `[`, or std::string::npos if it is not closed.
+static size_t findSetEnd(const std::string& Pattern, size_t Begin) {
+  size_t I = Begin + 1;
+  if (I < Pattern.size() && (Pattern[I] == '!' || Pattern[I] == '^')) {
+    ++I;
+  }
+  // A `]` first in the set is one of its characters.
+  if (I < Pattern.size() && Pattern[I] == ']') {
+    ++I;
+  }
+  return Pattern.find(']', I);
+}
+
+NameMatcher::Glob::Glob(const std::string& Pattern) {
+  bool InPrefix = true;
+  for (size_t I = 0; I < Pattern.size(); ++I) {
+    char C = Pattern[I];
+    size_t SetEnd = C == '[' ? findSetEnd(Pattern, I) : std::string::npos;
+    Position P;
+    if (C == '*') {
+      InPrefix = false;
+      // Consecutive stars match the same names as one.
+      if (!Positions.empty() && Positions.back().Star) {
+        continue;
+      }
+      P.Star = true;
+    } else if (C == '?') {
+      InPrefix = false;
+      P.Accepted.set();
+    } else if (SetEnd != std::string::npos) {
+      InPrefix = false;
+      size_t J = I + 1;
+      bool Negated = Pattern[J] == '!' || Pattern[J] == '^';
+      if (Negated) {
+        ++J;
+      }
+      for (; J < SetEnd; ++J) {
+        auto First = static_cast<unsigned char>(Pattern[J]);
+        auto Last = First;
+        if (J + 2 < SetEnd && Pattern[J + 1] == '-') {
+          Last = static_cast<unsigned char>(Pattern[J + 2]);
+          J += 2;
+        }
+        for (unsigned Char = First; Char <= Last; ++Char) {
+          P.Accepted.set(Char);
+        }
+      }
+      if (Negated) {
+        P.Accepted.flip();
+      }
+      I = SetEnd;
+    } else {
+      P.Accepted.set(static_cast<unsigned char>(C));
+      if (InPrefix) {
+        Prefix += C;
+      }
+    }
+    Positions.push_back(P);
+  }
+}
+
+bool NameMatcher::Glob::matches(const std::string& Name) const {
+  if (Name.compare(0, Prefix.size(), Prefix) != 0) {
+    return false;
+  }
+  // Match greedily, going back to the last star on a mismatch: the name
+  // only needs to be matched again from the character after the one the
+  // last star matched up to.
+  size_t P = 0, N = 0;
+  size_t LastStar = std::string::npos, LastStarEnd = 0;
+  while (N < Name.size()) {
+    if (P < Positions.size() && Positions[P].Star) {
+      LastStar = P++;
+      LastStarEnd = N;
+    } else if (P < Positions.size() &&
+               Positions[P].Accepted.test(
+                   static_cast<unsigned char>(Name[N]))) {
+      ++P;
+      ++N;
+    } else if (LastStar != std::string::npos) {
+      P = LastStar + 1;
+      N = ++LastStarEnd;
+    } else {
+      return false;
+    }
+  }
+  while (P < Positions.size() && Positions[P].Star) {
+    ++P;
+  }
+  return P == Positions.size();
+}
+
+NameMatcher::NameSet::NameSet(const std::unordered_set<std::string>& Names) {
+  for (const std::string& Name : Names) {
+    if (isPattern(Name)) {
+      Patterns.emplace_back(Name.substr(std::strlen(PatternPrefix)));
+    } else {
+      Exact.insert(Name);
+    }
+  }
+}
+
+bool NameMatcher::NameSet::contains(const std::string& Name) const {
+  return Exact.count(Name) != 0 ||
+         std::any_of(Patterns.begin(), Patterns.end(),
+                     [&Name](const Glob& G) { return G.matches(Name); });
+}
+
+NameMatcher::NameMatcher(const std::unordered_set<std::string>& Names,
+                         const std::unordered_set<std::string>& Exceptions)
+    : Included(Names), Excluded(Exceptions) {}
+
+bool NameMatcher::matches(const std::string& Name) const {
+  return Included.contains(Name) && !Excluded.contains(Name);
+}
+
+bool NameMatcher::isPattern(const std::string& Name) {
+  return Name.compare(0, std::strlen(PatternPrefix), PatternPrefix) == 0;
+}
+
+CompiledPolicy::CompiledPolicy(const PrintingPolicy& Policy,
+                               const gtirb::Module& M)
+    : Module(&M), FunctionNames(Policy.skipFunctions, Policy.keepFunctions),
+      SymbolNames(Policy.skipSymbols, Policy.keepSymbols),
+      SectionNames(Policy.skipSections, Policy.keepSections),
+      PrunedFunctionNames(Policy.prunedFunctions),
+      KeptFunctionNames(Policy.keepFunctions) {
+  for (const gtirb::Symbol& Symbol : M.symbols()) {
+    if (isSkippedFunctionName(Symbol.getName())) {
+      SkippedFunctions.insert(&Symbol);
+    }
+    if (SymbolNames.matches(Symbol.getName())) {
+      SkippedSymbols.insert(&Symbol);
+    }
+  }
+  for (const gtirb::Section& Section : M.sections()) {
+    if (SectionNames.matches(Section.getName())) {
+      SkippedSections.insert(&Section);
+    }
+  }
+}
+
+bool CompiledPolicy::isSkippedFunctionName(const std::string& Name) const {
+  return FunctionNames.matches(Name) ||
+         (PrunedFunctionNames.count(Name) != 0 &&
+          !KeptFunctionNames.matches(Name));
+}
+
+// Nodes of other modules were not matched in advance, and are matched by
+// name.
+
+bool CompiledPolicy::isSkippedFunction(const gtirb::Symbol& Symbol) const {
+  if (Symbol.getModule() != Module) {
+    return isSkippedFunctionName(Symbol.getName());
+  }
+  return SkippedFunctions.count(&Symbol) != 0;
+}
+
+bool CompiledPolicy::isSkippedSymbol(const gtirb::Symbol& Symbol) const {
+  if (Symbol.getModule() != Module) {
+    return SymbolNames.matches(Symbol.getName());
+  }
+  return SkippedSymbols.count(&Symbol) != 0;
+}
+
+bool CompiledPolicy::isSkippedSection(const gtirb::Section& Section) const {
+  if (Section.getModule() != Module) {
+    return SectionNames.matches(Section.getName());
+  }
+  return SkippedSections.count(&Section) != 0;
+}
+
+} // namespace gtirb_pprint
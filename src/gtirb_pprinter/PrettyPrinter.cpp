@@ -14,18 +14,27 @@
 //===----------------------------------------------------------------------===//
 #include "PrettyPrinter.hpp"
 #include "AuxDataUtils.hpp"
+#include "ElfObjectPrinter.hpp"
+#include "PrintError.hpp"
+#include "Reachability.hpp"
 #include "driver/Logger.h"
 
 #include "AuxDataSchema.hpp"
 #include "StringUtils.hpp"
+#include "version.h"
+#include <algorithm>
 #include <boost/lexical_cast.hpp>
 #include <boost/range/algorithm/find_if.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <capstone/capstone.h>
 #include <fstream>
 #include <gtirb/gtirb.hpp>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
 #include <variant>
 
@@ -143,6 +152,16 @@ std::string getModuleISA(const gtirb::Module& module) {
   }
 }
 
+uint64_t estimateListingSize(const gtirb::Module& module) {
+  // Listings are typically five to ten times larger than the bytes they
+  // describe.
+  constexpr uint64_t BytesPerByte = 8;
+  uint64_t Size = 0;
+  for (const auto& BI : module.byte_intervals())
+    Size += BI.getSize();
+  return Size * BytesPerByte;
+}
+
 bool setDefaultSyntax(std::initializer_list<std::string> formats,
                       std::initializer_list<std::string> isas,
                       std::initializer_list<std::string> modes,
@@ -250,29 +269,181 @@ PrettyPrinter::getPolicy(const gtirb::Module& Module) const {
                                  : *Factory.findNamedPolicy(PolicyName);
 }
 
+PrintingPolicy
+PrettyPrinter::configurePolicy(const gtirb::Module& Module) const {
+  PrintingPolicy policy(getPolicy(Module));
+  policy.LstMode = LstMode;
+  policy.IgnoreSymbolVersions = IgnoreSymbolVersions;
+  FunctionPolicy.apply(policy.skipFunctions, policy.keepFunctions);
+  if (PruneUnreachable) {
+    // Functions kept explicitly are still printed, as keepFunctions takes
+    // precedence over prunedFunctions.
+    policy.prunedFunctions = unreachableFunctions(Module);
+  }
+  SymbolPolicy.apply(policy.skipSymbols, policy.keepSymbols);
+  SectionPolicy.apply(policy.skipSections, policy.keepSections);
+  ArraySectionPolicy.apply(policy.arraySections);
+  return policy;
+}
+
+const std::unordered_set<std::string>&
+PrettyPrinter::unreachableFunctions(const gtirb::Module& Module) const {
+  // The policy is configured each time a printer is created or a kept printer
+  // is checked, so the module is only analyzed the first time.
+  auto [It, Inserted] = Caches.UnreachableFunctions.try_emplace(&Module);
+  if (Inserted) {
+    It->second = findUnreachableFunctions(Module);
+  }
+  return It->second;
+}
+
+std::unordered_set<std::string>
+PrettyPrinter::skippedSections(const gtirb::Module& Module) const {
+  PrintingPolicy Policy(getPolicy(Module));
+  SectionPolicy.apply(Policy.skipSections, Policy.keepSections);
+  NameMatcher Skipped(Policy.skipSections, Policy.keepSections);
+  std::unordered_set<std::string> Names;
+  for (const gtirb::Section& Section : Module.sections()) {
+    if (Skipped.matches(Section.getName())) {
+      Names.insert(Section.getName());
+    }
+  }
+  return Names;
+}
+
 int PrettyPrinter::print(std::ostream& Stream, gtirb::Context& Context,
                          const gtirb::Module& Module) const {
   // Find pretty printer factory.
   PrettyPrinterFactory& Factory = getFactory(Module);
 
   // Configure printing policy.
-  PrintingPolicy policy(getPolicy(Module));
-  policy.LstMode = LstMode;
-  policy.IgnoreSymbolVersions = IgnoreSymbolVersions;
-  FunctionPolicy.apply(policy.skipFunctions);
-  SymbolPolicy.apply(policy.skipSymbols);
-  SectionPolicy.apply(policy.skipSections);
-  ArraySectionPolicy.apply(policy.arraySections);
+  PrintingPolicy policy = configurePolicy(Module);
 
   // Create the pretty printer and print the IR.
   if (aux_data::validateAuxData(Module, m_format)) {
-    if (Factory.create(Context, Module, policy)->print(Stream)) {
+    auto Printer = Factory.create(Context, Module, policy);
+    Printer->setFunctionCache(FunctionCache);
+    if (Printer->print(Stream)) {
       return 0;
     }
   }
   return -1;
 }
 
+std::vector<std::unique_ptr<PrettyPrinterBase>>
+PrettyPrinter::createUnitPrinters(gtirb::Context& Context,
+                                  const gtirb::Module& Module,
+                                  size_t Count) const {
+  std::vector<std::unique_ptr<PrettyPrinterBase>> Printers;
+  if (!aux_data::validateAuxData(Module, m_format)) {
+    return Printers;
+  }
+  PrettyPrinterFactory& Factory = getFactory(Module);
+  PrintingPolicy Policy = configurePolicy(Module);
+  Printers.push_back(Factory.create(Context, Module, Policy));
+  std::shared_ptr<const CompilationUnits> Units =
+      Printers.front()->splitUnits(Count);
+  if (Units->size() > 1) {
+    while (Printers.size() < Units->size()) {
+      Printers.push_back(Factory.create(Context, Module, Policy));
+      Printers.back()->setCompiledPolicy(Printers.front()->compiledPolicy());
+    }
+    for (size_t Unit = 0; Unit < Printers.size(); ++Unit) {
+      Printers[Unit]->setCompilationUnit(Units, Unit);
+    }
+  }
+  for (auto& Printer : Printers) {
+    Printer->setFunctionCache(FunctionCache);
+  }
+  return Printers;
+}
+
+std::unique_ptr<PrettyPrinterBase>
+PrettyPrinter::createPrinter(gtirb::Context& Context,
+                             const gtirb::Module& Module) const {
+  if (!aux_data::validateAuxData(Module, m_format)) {
+    return nullptr;
+  }
+  auto Printer =
+      getFactory(Module).create(Context, Module, configurePolicy(Module));
+  Printer->setFunctionCache(FunctionCache);
+  return Printer;
+}
+
+// Whether printers created with two policies print the same text.
+static bool samePolicy(const PrintingPolicy& A, const PrintingPolicy& B) {
+  return A.skipFunctions == B.skipFunctions &&
+         A.prunedFunctions == B.prunedFunctions &&
+         A.skipSymbols == B.skipSymbols && A.skipSections == B.skipSections &&
+         A.keepFunctions == B.keepFunctions &&
+         A.keepSymbols == B.keepSymbols && A.keepSections == B.keepSections &&
+         A.arraySections == B.arraySections &&
+         A.compilerArguments == B.compilerArguments && A.LstMode == B.LstMode &&
+         A.Shared == B.Shared &&
+         A.IgnoreSymbolVersions == B.IgnoreSymbolVersions;
+}
+
+PrettyPrinterBase*
+PrettyPrinter::keptPrinter(gtirb::Context& Context,
+                           const gtirb::Module& Module) const {
+  PrintingPolicy Policy = configurePolicy(Module);
+  KeptPrinter& Kept = Caches.Printers[&Module];
+  if (!Kept.Printer || Kept.Target != getTarget() ||
+      Kept.Cache != FunctionCache || !samePolicy(Kept.Policy, Policy)) {
+    Kept.Printer = createPrinter(Context, Module);
+    Kept.Target = getTarget();
+    Kept.Cache = FunctionCache;
+    Kept.Policy = std::move(Policy);
+  }
+  return Kept.Printer.get();
+}
+
+int PrettyPrinter::printFunction(std::ostream& Stream, gtirb::Context& Context,
+                                 const gtirb::Module& Module,
+                                 const gtirb::UUID& Function) const {
+  PrettyPrinterBase* Printer = keptPrinter(Context, Module);
+  if (!Printer || !Printer->printFunction(Stream, Function)) {
+    return -1;
+  }
+  return 0;
+}
+
+int PrettyPrinter::printAddressRange(std::ostream& Stream,
+                                     gtirb::Context& Context,
+                                     const gtirb::Module& Module,
+                                     gtirb::Addr Begin, gtirb::Addr End) const {
+  PrettyPrinterBase* Printer = keptPrinter(Context, Module);
+  if (!Printer) {
+    return -1;
+  }
+  Printer->printAddressRange(Stream, Begin, End);
+  return 0;
+}
+
+int PrettyPrinter::printEvents(ListingSink& Sink, gtirb::Context& Context,
+                               const gtirb::Module& Module) const {
+  std::unique_ptr<PrettyPrinterBase> Printer = createPrinter(Context, Module);
+  if (!Printer) {
+    return -1;
+  }
+  Printer->printEvents(Sink);
+  return 0;
+}
+
+int PrettyPrinter::writeObject(const std::string& Path,
+                               gtirb::Context& Context,
+                               const gtirb::Module& Module) const {
+  if (Module.getFileFormat() != gtirb::FileFormat::ELF ||
+      Module.getISA() != gtirb::ISA::X64 || LstMode != ListingAssembler) {
+    return -1;
+  }
+  if (!aux_data::validateAuxData(Module, "elf")) {
+    return -1;
+  }
+  ElfObjectPrinter Writer(Context, Module, configurePolicy(Module));
+  return Writer.write(Path) ? 0 : -1;
+}
+
 boost::iterator_range<NamedPolicyMap::const_iterator>
 PrettyPrinterFactory::namedPolicies() const {
   return boost::make_iterator_range(NamedPolicies.begin(), NamedPolicies.end());
@@ -464,7 +635,7 @@ void PrettyPrinterBase::printIntegralSymbols(std::ostream& os) {
   // print integral symbols
   for (const auto& sym : module.symbols_by_name()) {
     if (auto addr = sym.getAddress();
-        addr && !sym.hasReferent() && !shouldSkip(policy, sym)) {
+        addr && !sym.hasReferent() && !shouldSkip(sym)) {
       os << syntax.comment() << " WARNING: integral symbol " << sym.getName()
          << " may not have been correctly relocated\n";
       printIntegralSymbol(os, sym);
@@ -472,13 +643,16 @@ void PrettyPrinterBase::printIntegralSymbols(std::ostream& os) {
     if (!sym.getAddress() &&
         (!sym.hasReferent() ||
          sym.getReferent<gtirb::ProxyBlock>() != nullptr) &&
-        !shouldSkip(policy, sym)) {
+        !shouldSkip(sym)) {
       printUndefinedSymbol(os, sym);
     }
   }
 }
 
 std::ostream& PrettyPrinterBase::print(std::ostream& os) {
+  CFIStartProc = std::nullopt;
+  CachedFunctions = 0;
+  PrintedFunctions = 0;
   printHeader(os);
 
   // print every section
@@ -490,9 +664,68 @@ std::ostream& PrettyPrinterBase::print(std::ostream& os) {
 
   // print footer
   printFooter(os);
+
+  if (FunctionCache) {
+    LOG_INFO << "Reused the text of " << CachedFunctions << " of "
+             << CachedFunctions + PrintedFunctions
+             << " functions from the function cache.\n";
+  }
   return os;
 }
 
+std::ostream& PrettyPrinterBase::printBlocks(std::ostream& os,
+                                             const BlockFilter& Filter) {
+  SelectedBlocks = &Filter;
+  CFIStartProc = std::nullopt;
+  for (const auto& section : module.sections()) {
+    printSection(os, section);
+  }
+  SelectedBlocks = nullptr;
+  return os;
+}
+
+bool PrettyPrinterBase::printFunction(std::ostream& os,
+                                      const gtirb::UUID& Function) {
+  if (std::none_of(
+          BlockToFunction.begin(), BlockToFunction.end(),
+          [&Function](const auto& Pair) { return Pair.second == Function; })) {
+    return false;
+  }
+  printBlocks(os, [this, &Function](const gtirb::Node& Block) {
+    auto It = BlockToFunction.find(Block.getUUID());
+    return It != BlockToFunction.end() && It->second == Function;
+  });
+  return true;
+}
+
+void PrettyPrinterBase::printAddressRange(std::ostream& os, gtirb::Addr Begin,
+                                          gtirb::Addr End) {
+  printBlocks(os, [Begin, End](const gtirb::Node& Block) {
+    std::optional<gtirb::Addr> Addr;
+    uint64_t Size = 0;
+    if (auto* CB = dyn_cast<gtirb::CodeBlock>(&Block)) {
+      Addr = CB->getAddress();
+      Size = CB->getSize();
+    } else if (auto* DB = dyn_cast<gtirb::DataBlock>(&Block)) {
+      Addr = DB->getAddress();
+      Size = DB->getSize();
+    }
+    // Empty blocks hold the labels at their address.
+    return Addr && *Addr < End && *Addr + std::max<uint64_t>(Size, 1) > Begin;
+  });
+}
+
+void PrettyPrinterBase::printEvents(ListingSink& EventSink) {
+  // Nothing is printed while the events are sent.
+  std::ostream Discard(nullptr);
+  Sink = &EventSink;
+  CFIStartProc = std::nullopt;
+  for (const auto& section : module.sections()) {
+    printSection(Discard, section);
+  }
+  Sink = nullptr;
+}
+
 void PrettyPrinterBase::printOverlapWarning(std::ostream& os,
                                             const gtirb::Addr addr) {
   std::cerr << "WARNING: found overlapping element at address " << std::hex
@@ -529,7 +762,7 @@ void PrettyPrinterBase::printBlockContents(std::ostream& os,
   gtirb::Offset blockOffset(x.getUUID(), offset);
   for (size_t i = 0; i < count; i++) {
     fixupInstruction(insn[i]);
-    printInstruction(os, x, insn[i], blockOffset);
+    emitInstruction(os, x, insn[i], blockOffset);
     blockOffset.Displacement += insn[i].size;
   }
   // print any CFI directives located at the end of the block
@@ -603,7 +836,7 @@ bool PrettyPrinterBase::printSymbolReference(std::ostream& os,
       os << forwardedName.value();
       return false;
     } else {
-      if (policy.skipSymbols.count(forwardedName.value())) {
+      if (decisions().isSkippedSymbolName(forwardedName.value())) {
         // NOTE: It is OK not to print symbols in unexercised code (functions
         // that never execute, but were not skipped due to lack of information
         // : e.g., sectionless binaries). However, printing symbol addresses
@@ -619,7 +852,7 @@ bool PrettyPrinterBase::printSymbolReference(std::ostream& os,
       }
     }
   }
-  if (shouldSkip(policy, *symbol)) {
+  if (shouldSkip(*symbol)) {
     if (LstMode == ListingDebug || LstMode == ListingUI) {
       os << static_cast<uint64_t>(*symbol->getAddress());
     } else {
@@ -776,6 +1009,82 @@ void PrettyPrinterBase::printInstruction(std::ostream& os,
   os << '\n';
 }
 
+void PrettyPrinterBase::emitInstruction(std::ostream& os,
+                                        const gtirb::CodeBlock& block,
+                                        const cs_insn& inst,
+                                        const gtirb::Offset& offset) {
+  if (!Sink) {
+    printInstruction(os, block, inst, offset);
+    return;
+  }
+  InstructionEvent Event;
+  Event.Address = gtirb::Addr(inst.address);
+  Event.Bytes =
+      std::string_view(reinterpret_cast<const char*>(inst.bytes), inst.size);
+  Event.Mnemonic = ascii_str_tolower(inst.mnemonic);
+  // Operands are printed as in the listing, but comments about them are
+  // not part of the event.
+  std::ostringstream OperandList;
+  m_accum_comment.clear();
+  ListedOperands = &Event.Operands;
+  printOperandList(OperandList, block, inst);
+  ListedOperands = nullptr;
+  m_accum_comment.clear();
+  Event.References =
+      symbolicReferences(*block.getByteInterval(),
+                         block.getOffset() + offset.Displacement, inst.size);
+  Sink->onInstruction(Event);
+}
+
+void PrettyPrinterBase::emitData(const gtirb::DataBlock& Block,
+                                 uint64_t Offset) {
+  DataEvent Event;
+  Event.Address = *Block.getAddress() + Offset;
+  Event.Size = Block.getSize() - Offset;
+  if (Event.Size == 0) {
+    return;
+  }
+  const gtirb::ByteInterval* BI = Block.getByteInterval();
+  uint64_t Start = Block.getOffset() + Offset;
+  // Bytes past the initialized part of the byte interval are zero.
+  uint64_t Initialized = BI->getInitializedSize();
+  if (Initialized > Start) {
+    Event.Bytes = std::string_view(BI->rawBytes<char>() + Start,
+                                   std::min(Event.Size, Initialized - Start));
+  }
+  Event.Type = aux_data::getEncodingType(Block);
+  Event.References = symbolicReferences(*BI, Start, Event.Size);
+  Sink->onData(Event);
+}
+
+std::vector<SymbolicReference>
+PrettyPrinterBase::symbolicReferences(const gtirb::ByteInterval& BI,
+                                      uint64_t Start, uint64_t Size) const {
+  auto nameOf = [this](const gtirb::Symbol* Symbol) {
+    return getForwardedSymbolName(Symbol).value_or(getSymbolName(*Symbol));
+  };
+  std::vector<SymbolicReference> References;
+  for (const auto& SEE :
+       BI.findSymbolicExpressionsAtOffset(Start, Start + Size)) {
+    SymbolicReference Reference;
+    Reference.Offset = SEE.getOffset() - Start;
+    const gtirb::SymbolicExpression& Expr = SEE.getSymbolicExpression();
+    if (const auto* SAC = std::get_if<gtirb::SymAddrConst>(&Expr)) {
+      Reference.Symbol = nameOf(SAC->Sym);
+      Reference.Addend = SAC->Offset;
+    } else if (const auto* SAA = std::get_if<gtirb::SymAddrAddr>(&Expr)) {
+      Reference.Symbol = nameOf(SAA->Sym1);
+      Reference.Minus = nameOf(SAA->Sym2);
+      Reference.Scale = SAA->Scale;
+      Reference.Addend = SAA->Offset;
+    } else {
+      continue;
+    }
+    References.push_back(std::move(Reference));
+  }
+  return References;
+}
+
 void PrettyPrinterBase::printEA(std::ostream& os, gtirb::Addr ea) {
   os << syntax.tab();
   if (this->LstMode == ListingDebug) {
@@ -845,7 +1154,7 @@ void PrettyPrinterBase::printOperandList(std::ostream& os,
         (Op.reg >= X86_REG_K0 && Op.reg <= X86_REG_K7)) {
       // print AVX512 mask operand
       os << '{';
-      printOperand(os, block, inst, i);
+      printListedOperand(os, block, inst, i);
       os << '}';
       if (Op.avx_zero_opmask) {
         os << "{z}";
@@ -855,7 +1164,7 @@ void PrettyPrinterBase::printOperandList(std::ostream& os,
       if (i != 0) {
         os << ',';
       }
-      printOperand(os, block, inst, i);
+      printListedOperand(os, block, inst, i);
 
       if (IsBracketedSecondKAVX512Instr && Op.type == X86_OP_REG &&
           (Op.reg >= X86_REG_K0 && Op.reg <= X86_REG_K7)) {
@@ -865,6 +1174,27 @@ void PrettyPrinterBase::printOperandList(std::ostream& os,
   }
 }
 
+void PrettyPrinterBase::printListedOperand(std::ostream& os,
+                                           const gtirb::CodeBlock& block,
+                                           const cs_insn& inst,
+                                           uint64_t index) {
+  if (!ListedOperands) {
+    printOperand(os, block, inst, index);
+    return;
+  }
+  std::ostringstream Operand;
+  printOperand(Operand, block, inst, index);
+  printListedOperand(os, Operand.str());
+}
+
+void PrettyPrinterBase::printListedOperand(std::ostream& os,
+                                           const std::string& Text) {
+  if (ListedOperands) {
+    ListedOperands->push_back(Text);
+  }
+  os << Text;
+}
+
 void PrettyPrinterBase::printOperand(std::ostream& os,
                                      const gtirb::CodeBlock& block,
                                      const cs_insn& inst, uint64_t index) {
@@ -913,14 +1243,13 @@ void PrettyPrinterBase::printOperand(std::ostream& os,
     printOpIndirect(os, symbolic, inst, index);
     return;
   case X86_OP_INVALID:
-    std::cerr << "invalid operand\n";
-    exit(1);
+    throw PrintError("invalid operand");
   }
 }
 
 template <typename BlockType>
 void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
-  if (shouldSkip(policy, block)) {
+  if (shouldSkip(block)) {
     return;
   }
 
@@ -934,10 +1263,16 @@ void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
     // than place a label in the middle).
 
     offset = programCounter - addr;
-    printOverlapWarning(os, addr);
+    if (!Sink) {
+      printOverlapWarning(os, addr);
+    }
     for (const auto& sym : module.findSymbols(block)) {
-      if (!sym.getAtEnd() && !shouldSkip(policy, sym)) {
-        printSymbolDefinitionRelativeToPC(os, sym, programCounter);
+      if (!sym.getAtEnd() && !shouldSkip(sym)) {
+        if (Sink) {
+          printLabel(os, sym);
+        } else {
+          printSymbolDefinitionRelativeToPC(os, sym, programCounter);
+        }
       }
     }
   } else {
@@ -945,13 +1280,13 @@ void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
 
     offset = 0;
 
-    if (auto Align = getAlignment(block)) {
+    if (auto Align = getAlignment(block); Align && !Sink) {
       printAlignment(os, *Align);
     }
 
     for (const auto& sym : module.findSymbols(block)) {
-      if (!sym.getAtEnd() && !shouldSkip(policy, sym)) {
-        printSymbolDefinition(os, sym);
+      if (!sym.getAtEnd() && !shouldSkip(sym)) {
+        printLabel(os, sym);
       }
     }
   }
@@ -964,7 +1299,7 @@ void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
     if (auto SymExpr =
             block.getByteInterval()->getSymbolicExpression(block.getOffset())) {
       if (std::holds_alternative<gtirb::SymAddrConst>(*SymExpr)) {
-        if (shouldSkip(policy, *std::get<gtirb::SymAddrConst>(*SymExpr).Sym)) {
+        if (shouldSkip(*std::get<gtirb::SymAddrConst>(*SymExpr).Sym)) {
           return;
         }
       } else {
@@ -981,12 +1316,12 @@ void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
 
   // Print any symbols that should go at the end of this block.
   for (const auto& sym : module.findSymbols(block)) {
-    if (sym.getAtEnd() && !shouldSkip(policy, sym)) {
-      printSymbolDefinition(os, sym);
+    if (sym.getAtEnd() && !shouldSkip(sym)) {
+      printLabel(os, sym);
     }
   }
   // Print function ends if applicable
-  if (FunctionLastBlocks.count(block.getUUID()) > 0) {
+  if (FunctionLastBlocks.count(block.getUUID()) > 0 && !Sink) {
     const gtirb::Symbol* FunctionSymbol =
         getContainerFunctionSymbol(block.getUUID());
     // A function could have no name associated to it.
@@ -1002,6 +1337,15 @@ void PrettyPrinterBase::printBlockImpl(std::ostream& os, BlockType& block) {
   }
 }
 
+void PrettyPrinterBase::printLabel(std::ostream& OS,
+                                   const gtirb::Symbol& Symbol) {
+  if (Sink) {
+    Sink->onSymbol(Symbol, getSymbolName(Symbol), *Symbol.getAddress());
+  } else {
+    printSymbolDefinition(OS, Symbol);
+  }
+}
+
 void PrettyPrinterBase::printBlock(std::ostream& os,
                                    const gtirb::DataBlock& block) {
   printBlockImpl(os, block);
@@ -1019,6 +1363,10 @@ void PrettyPrinterBase::printBlockContents(std::ostream& os,
   if (offset > dataObject.getSize()) {
     return;
   }
+  if (Sink) {
+    emitData(dataObject, offset);
+    return;
+  }
 
   const auto* foundSymbolic =
       dataObject.getByteInterval()->getSymbolicExpression(
@@ -1365,9 +1713,27 @@ PrettyPrinterBase::getContainerFunctionSymbol(const gtirb::UUID& Uuid) const {
   return nullptr;
 }
 
+const std::shared_ptr<const CompiledPolicy>&
+PrettyPrinterBase::compiledPolicy() const {
+  if (!Compiled) {
+    Compiled = std::make_shared<const CompiledPolicy>(policy, module);
+  }
+  return Compiled;
+}
+
+void PrettyPrinterBase::setCompiledPolicy(
+    std::shared_ptr<const CompiledPolicy> Shared) {
+  Compiled = std::move(Shared);
+}
+
+const CompiledPolicy& PrettyPrinterBase::decisions() const {
+  return *compiledPolicy();
+}
+
 bool PrettyPrinterBase::isFunctionSkipped(
-    const PrintingPolicy& Policy, const gtirb::Symbol& FunctionSymbol) const {
-  if (Policy.skipFunctions.count(FunctionSymbol.getName())) {
+    const gtirb::Symbol& FunctionSymbol) const {
+  const CompiledPolicy& Decisions = decisions();
+  if (Decisions.isSkippedFunction(FunctionSymbol)) {
     return true;
   }
   auto Aliases = FunctionAliases.find(&FunctionSymbol);
@@ -1375,16 +1741,15 @@ bool PrettyPrinterBase::isFunctionSkipped(
     return false;
   }
   for (const auto* Alias : Aliases->second) {
-    if (Policy.skipFunctions.count(Alias->getName())) {
+    if (Decisions.isSkippedFunction(*Alias)) {
       return true;
     }
   }
   return false;
 }
 
-bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
-                                   const gtirb::Section& section) const {
-  if (Policy.LstMode == ListingDebug) {
+bool PrettyPrinterBase::shouldSkip(const gtirb::Section& section) const {
+  if (policy.LstMode == ListingDebug) {
     return false;
   }
 
@@ -1393,25 +1758,24 @@ bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
     return true;
   }
 
-  return Policy.skipSections.count(section.getName());
+  return decisions().isSkippedSection(section);
 }
 
-bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
-                                   const gtirb::Symbol& Symbol) const {
-  if (Policy.LstMode == ListingDebug) {
+bool PrettyPrinterBase::shouldSkip(const gtirb::Symbol& Symbol) const {
+  if (policy.LstMode == ListingDebug) {
     return false;
   }
 
-  if (Policy.skipSymbols.count(Symbol.getName())) {
+  if (decisions().isSkippedSymbol(Symbol)) {
     return true;
   }
 
   if (Symbol.hasReferent()) {
     const auto* Referent = Symbol.getReferent<gtirb::Node>();
     if (auto* CB = dyn_cast<gtirb::CodeBlock>(Referent)) {
-      return shouldSkip(Policy, *CB);
+      return shouldSkip(*CB);
     } else if (auto* DB = dyn_cast<gtirb::DataBlock>(Referent)) {
-      return shouldSkip(Policy, *DB);
+      return shouldSkip(*DB);
     } else if (isa<gtirb::ProxyBlock>(Referent)) {
       return false;
     } else {
@@ -1425,7 +1789,7 @@ bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
     if (BlocksAtSymbolAddr.begin() != BlocksAtSymbolAddr.end()) {
       auto FunctionSymbol =
           getContainerFunctionSymbol(BlocksAtSymbolAddr.begin()->getUUID());
-      return FunctionSymbol && isFunctionSkipped(Policy, *FunctionSymbol);
+      return FunctionSymbol && isFunctionSkipped(*FunctionSymbol);
     }
     return false;
   } else {
@@ -1433,34 +1797,30 @@ bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
   }
 }
 
-bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
-                                   const gtirb::CodeBlock& block) const {
-  if (Policy.LstMode == ListingDebug) {
+bool PrettyPrinterBase::shouldSkip(const gtirb::CodeBlock& block) const {
+  if (policy.LstMode == ListingDebug) {
     return false;
   }
 
-  if (Policy.skipSections.count(
-          block.getByteInterval()->getSection()->getName())) {
+  if (decisions().isSkippedSection(*block.getByteInterval()->getSection())) {
     return true;
   }
 
   auto FunctionSymbol = getContainerFunctionSymbol(block.getUUID());
-  return FunctionSymbol && isFunctionSkipped(Policy, *FunctionSymbol);
+  return FunctionSymbol && isFunctionSkipped(*FunctionSymbol);
 }
 
-bool PrettyPrinterBase::shouldSkip(const PrintingPolicy& Policy,
-                                   const gtirb::DataBlock& block) const {
-  if (Policy.LstMode == ListingDebug) {
+bool PrettyPrinterBase::shouldSkip(const gtirb::DataBlock& block) const {
+  if (policy.LstMode == ListingDebug) {
     return false;
   }
 
-  if (Policy.skipSections.count(
-          block.getByteInterval()->getSection()->getName())) {
+  if (decisions().isSkippedSection(*block.getByteInterval()->getSection())) {
     return true;
   }
 
   auto FunctionSymbol = getContainerFunctionSymbol(block.getUUID());
-  return FunctionSymbol && isFunctionSkipped(Policy, *FunctionSymbol);
+  return FunctionSymbol && isFunctionSkipped(*FunctionSymbol);
 }
 
 const std::optional<const gtirb::Section*>
@@ -1573,6 +1933,11 @@ void PrettyPrinterBase::printAlignment(std::ostream& OS, uint64_t Alignment) {
 
 std::string
 PrettyPrinterBase::getSymbolName(const gtirb::Symbol& Symbol) const {
+  if (Units) {
+    if (auto It = Units->Promoted.find(&Symbol); It != Units->Promoted.end()) {
+      return syntax.formatSymbolName(It->second);
+    }
+  }
   if (auto Renaming = AmbiguousSymbols.find(&Symbol);
       Renaming != AmbiguousSymbols.end()) {
     auto newName = Renaming->second;
@@ -1604,24 +1969,553 @@ PrettyPrinterBase::getForwardedSymbol(const gtirb::Symbol* Symbol) const {
 
 void PrettyPrinterBase::printSection(std::ostream& os,
                                      const gtirb::Section& section) {
-  if (shouldSkip(policy, section)) {
+  if (shouldSkip(section)) {
+    return;
+  }
+  std::pair<size_t, size_t> Range{0, std::numeric_limits<size_t>::max()};
+  if (Units) {
+    auto It = UnitBlocks.find(&section);
+    if (It == UnitBlocks.end()) {
+      return;
+    }
+    Range = It->second;
+  }
+  auto Selected = [this](const gtirb::Node& Block) {
+    return !SelectedBlocks || (*SelectedBlocks)(Block);
+  };
+  if (SelectedBlocks &&
+      std::none_of(section.blocks().begin(), section.blocks().end(),
+                   Selected)) {
     return;
   }
   programCounter = gtirb::Addr{0};
 
-  printSectionHeader(os, section);
+  if (Sink) {
+    Sink->onSection(section);
+  } else {
+    printSectionHeader(os, section);
+  }
 
+  // With a function cache, consecutive blocks of the same function are
+  // printed (or copied from the cache) together.
+  std::vector<const gtirb::Node*> FunctionBlocks;
+  const gtirb::UUID* Function = nullptr;
+  auto flushFunction = [&]() {
+    if (!FunctionBlocks.empty()) {
+      printFunctionBlocks(os, FunctionBlocks);
+      FunctionBlocks.clear();
+    }
+  };
+
+  size_t BlockIndex = 0;
   for (const auto& Block : section.blocks()) {
-    if (auto* CB = dyn_cast<gtirb::CodeBlock>(&Block)) {
-      printBlock(os, *CB);
-    } else if (auto* DB = dyn_cast<gtirb::DataBlock>(&Block)) {
-      printBlock(os, *DB);
+    bool InUnit = BlockIndex >= Range.first && BlockIndex < Range.second;
+    ++BlockIndex;
+    if (!InUnit || !Selected(Block)) {
+      continue;
+    }
+    // Events are not cached.
+    if (!FunctionCache || Sink) {
+      printNode(os, Block);
+      continue;
+    }
+    auto It = BlockToFunction.find(Block.getUUID());
+    if (It == BlockToFunction.end() || !Function || *Function != It->second) {
+      flushFunction();
+    }
+    if (It == BlockToFunction.end()) {
+      Function = nullptr;
+      printNode(os, Block);
     } else {
-      assert(!"non block in block iterator!");
+      Function = &It->second;
+      FunctionBlocks.push_back(&Block);
+    }
+  }
+  flushFunction();
+
+  if (!Sink) {
+    printSectionFooter(os, section);
+  }
+}
+
+void PrettyPrinterBase::printNode(std::ostream& OS, const gtirb::Node& Node) {
+  if (auto* CB = dyn_cast<gtirb::CodeBlock>(&Node)) {
+    printBlock(OS, *CB);
+  } else if (auto* DB = dyn_cast<gtirb::DataBlock>(&Node)) {
+    printBlock(OS, *DB);
+  } else {
+    assert(!"non block in block iterator!");
+  }
+}
+
+void PrettyPrinterBase::setFunctionCache(
+    std::shared_ptr<gtirb_bprint::ArtifactCache> Cache) {
+  FunctionCache.reset();
+  if (!Cache || LstMode != ListingAssembler || !canCacheFunctions()) {
+    return;
+  }
+  FunctionCache = std::move(Cache);
+
+  gtirb_bprint::CacheKey Salt;
+  Salt.add(GTIRB_PPRINTER_VERSION_STRING).add(GTIRB_PPRINTER_BUILD_REVISION);
+  Salt.add(typeid(*this).name());
+  Salt.add(static_cast<uint64_t>(module.getFileFormat()))
+      .add(static_cast<uint64_t>(module.getISA()));
+  Salt.add(policy.IgnoreSymbolVersions);
+  for (const auto* Names :
+       {&policy.skipFunctions, &policy.prunedFunctions, &policy.skipSymbols,
+        &policy.skipSections, &policy.keepFunctions, &policy.keepSymbols,
+        &policy.keepSections, &policy.arraySections}) {
+    std::set<std::string> Sorted(Names->begin(), Names->end());
+    Salt.add(Sorted.size());
+    for (const std::string& Name : Sorted) {
+      Salt.add(Name);
+    }
+  }
+  FunctionCacheSalt = Salt.str();
+}
+
+void PrettyPrinterBase::printFunctionBlocks(
+    std::ostream& OS, const std::vector<const gtirb::Node*>& Blocks) {
+  auto Extent = [this](const gtirb::Node* Node) {
+    std::optional<gtirb::Addr> Addr;
+    uint64_t Size = 0;
+    bool Skipped = false;
+    if (auto* CB = dyn_cast<gtirb::CodeBlock>(Node)) {
+      Addr = CB->getAddress();
+      Size = CB->getSize();
+      Skipped = shouldSkip(*CB);
+    } else if (auto* DB = dyn_cast<gtirb::DataBlock>(Node)) {
+      Addr = DB->getAddress();
+      Size = DB->getSize();
+      Skipped = shouldSkip(*DB);
+    }
+    return std::make_tuple(Addr, Size, Skipped);
+  };
+
+  // Overlapping blocks are printed relative to the program counter, which
+  // depends on what was printed before them.
+  if (std::optional<gtirb::Addr> Begin = std::get<0>(Extent(Blocks.front()));
+      !Begin || *Begin < programCounter) {
+    for (const gtirb::Node* Block : Blocks) {
+      printNode(OS, *Block);
+    }
+    return;
+  }
+
+  // Entries hold whether a CFI frame is open after the blocks, then their
+  // text.
+  std::string Key = functionKey(Blocks);
+  if (std::optional<std::string> Entry = FunctionCache->load(Key);
+      Entry && !Entry->empty()) {
+    OS.write(Entry->data() + 1, Entry->size() - 1);
+    if ((*Entry)[0] == '1') {
+      CFIStartProc = programCounter;
+    } else {
+      CFIStartProc = std::nullopt;
+    }
+    for (const gtirb::Node* Block : Blocks) {
+      if (auto [Addr, Size, Skipped] = Extent(Block); Addr && !Skipped) {
+        programCounter = std::max(programCounter, *Addr + Size);
+      }
+    }
+    ++CachedFunctions;
+    return;
+  }
+
+  std::ostringstream Text;
+  for (const gtirb::Node* Block : Blocks) {
+    printNode(Text, *Block);
+  }
+  std::string Entry = (CFIStartProc ? "1" : "0") + Text.str();
+  FunctionCache->store(Key, Entry);
+  OS.write(Entry.data() + 1, Entry.size() - 1);
+  ++PrintedFunctions;
+}
+
+std::string
+PrettyPrinterBase::functionKey(const std::vector<const gtirb::Node*>& Blocks) {
+  gtirb_bprint::CacheKey Key;
+  Key.add(FunctionCacheSalt);
+  Key.add(CFIStartProc.has_value());
+  for (const gtirb::Node* Block : Blocks) {
+    if (auto* CB = dyn_cast<gtirb::CodeBlock>(Block)) {
+      addBlockToKey(Key, *CB);
+    } else if (auto* DB = dyn_cast<gtirb::DataBlock>(Block)) {
+      addBlockToKey(Key, *DB);
     }
   }
+  return Key.str();
+}
 
-  printSectionFooter(os, section);
+template <typename BlockType>
+void PrettyPrinterBase::addBlockToKey(gtirb_bprint::CacheKey& Key,
+                                      const BlockType& Block) {
+  const gtirb::ByteInterval* BI = Block.getByteInterval();
+  Key.add("block").add(BI->getSection()->getName());
+  Key.add(static_cast<uint64_t>(*Block.getAddress())).add(Block.getSize());
+  Key.add(shouldSkip(Block));
+  std::optional<uint64_t> Alignment = getAlignment(Block);
+  Key.add(Alignment.has_value()).add(Alignment.value_or(0));
+  if constexpr (std::is_same_v<BlockType, gtirb::CodeBlock>) {
+    Key.add(static_cast<uint64_t>(Block.getDecodeMode()));
+  } else {
+    Key.add(aux_data::getEncodingType(Block).value_or(""));
+  }
+
+  // Bytes past the initialized part of the byte interval are zero.
+  uint64_t Start = Block.getOffset();
+  uint64_t Initialized = BI->getInitializedSize();
+  uint64_t Length =
+      Initialized > Start ? std::min(Block.getSize(), Initialized - Start) : 0;
+  Key.add(std::string_view(BI->rawBytes<char>() + Start, Length));
+
+  for (const auto& SEE : BI->findSymbolicExpressionsAtOffset(
+           Start, Start + Block.getSize())) {
+    Key.add("expr").add(SEE.getOffset() - Start);
+    const gtirb::SymbolicExpression& Expr = SEE.getSymbolicExpression();
+    auto addAttributes = [&Key](const gtirb::SymAttributeSet& Attributes) {
+      for (gtirb::SymAttribute Attribute : Attributes) {
+        Key.add(static_cast<uint64_t>(Attribute));
+      }
+      Key.add("attributes");
+    };
+    if (const auto* SAC = std::get_if<gtirb::SymAddrConst>(&Expr)) {
+      Key.add("const").add(static_cast<uint64_t>(SAC->Offset));
+      addSymbolToKey(Key, *SAC->Sym);
+      addAttributes(SAC->Attributes);
+    } else if (const auto* SAA = std::get_if<gtirb::SymAddrAddr>(&Expr)) {
+      Key.add("addr").add(static_cast<uint64_t>(SAA->Scale));
+      Key.add(static_cast<uint64_t>(SAA->Offset));
+      addSymbolToKey(Key, *SAA->Sym1);
+      addSymbolToKey(Key, *SAA->Sym2);
+      addAttributes(SAA->Attributes);
+    }
+    if constexpr (std::is_same_v<BlockType, gtirb::DataBlock>) {
+      Key.add(getSymbolicExpressionSize(SEE));
+    }
+  }
+
+  for (const auto& Symbol : module.findSymbols(Block)) {
+    Key.add("symbol");
+    addSymbolToKey(Key, Symbol);
+  }
+
+  if (const auto* Cfi = module.getAuxData<gtirb::schema::CfiDirectives>()) {
+    for (auto It = Cfi->lower_bound(gtirb::Offset(Block.getUUID(), 0));
+         It != Cfi->end() && It->first.ElementId == Block.getUUID(); ++It) {
+      Key.add("cfi").add(It->first.Displacement);
+      for (const auto& Directive : It->second) {
+        Key.add(std::get<0>(Directive));
+        Key.add(std::get<1>(Directive).size());
+        for (int64_t Operand : std::get<1>(Directive)) {
+          Key.add(static_cast<uint64_t>(Operand));
+        }
+        if (const auto* Symbol =
+                nodeFromUUID<gtirb::Symbol>(context, std::get<2>(Directive))) {
+          addSymbolToKey(Key, *Symbol);
+        } else {
+          Key.add("");
+        }
+      }
+    }
+  }
+
+  if (FunctionLastBlocks.count(Block.getUUID()) > 0) {
+    if (const gtirb::Symbol* FunctionSymbol =
+            getContainerFunctionSymbol(Block.getUUID())) {
+      Key.add("end");
+      addSymbolToKey(Key, *FunctionSymbol);
+      if (auto Aliases = FunctionAliases.find(FunctionSymbol);
+          Aliases != FunctionAliases.end()) {
+        for (const auto* Alias : Aliases->second) {
+          addSymbolToKey(Key, *Alias);
+        }
+      }
+    }
+  }
+}
+
+void PrettyPrinterBase::addSymbolToKey(gtirb_bprint::CacheKey& Key,
+                                       const gtirb::Symbol& Symbol) const {
+  Key.add(getSymbolName(Symbol));
+  Key.add(shouldSkip(Symbol)).add(Symbol.getAtEnd());
+  std::optional<gtirb::Addr> Addr = Symbol.getAddress();
+  Key.add(Addr.has_value()).add(static_cast<uint64_t>(Addr.value_or(0)));
+  Key.add(Symbol.hasReferent());
+  Key.add(Symbol.getReferent<gtirb::ProxyBlock>() != nullptr);
+  Key.add(getForwardedSymbolName(&Symbol).value_or(""));
+  Key.add(Units && Units->Promoted.count(&Symbol) > 0);
+}
+
+std::shared_ptr<const CompilationUnits>
+PrettyPrinterBase::splitUnits(size_t Count) const {
+  auto Result = std::make_shared<CompilationUnits>();
+  if (Count < 2 || LstMode != ListingAssembler || !canSplitUnits()) {
+    return Result;
+  }
+
+  // The blocks of the printed sections, in the order they are printed; each
+  // unit is a contiguous range of them.
+  struct Position {
+    size_t Section;
+    size_t Block;
+    uint64_t Size;
+    bool CanStartUnit;
+  };
+  std::vector<Position> Positions;
+  std::map<gtirb::UUID, size_t> BlockPositions;
+
+  std::set<const gtirb::CfgNode*> FallthroughTargets;
+  if (const gtirb::IR* Ir = module.getIR()) {
+    const gtirb::CFG& Cfg = Ir->getCFG();
+    for (const auto& Edge : boost::make_iterator_range(boost::edges(Cfg))) {
+      if (const auto& Label = Cfg[Edge];
+          Label && std::get<gtirb::EdgeType>(*Label) ==
+                       gtirb::EdgeType::Fallthrough) {
+        FallthroughTargets.insert(Cfg[boost::target(Edge, Cfg)]);
+      }
+    }
+  }
+
+  size_t SectionIndex = 0;
+  for (const auto& Section : module.sections()) {
+    if (!shouldSkip(Section)) {
+      size_t BlockIndex = 0;
+      gtirb::Addr End{0};
+      for (const auto& Block : Section.blocks()) {
+        gtirb::Addr Addr{0};
+        uint64_t Size = 0;
+        bool FunctionStart = false;
+        if (auto* CB = dyn_cast<gtirb::CodeBlock>(&Block)) {
+          Addr = *CB->getAddress();
+          Size = CB->getSize();
+          FunctionStart = FunctionFirstBlocks.count(CB->getUUID()) > 0 &&
+                          FallthroughTargets.count(CB) == 0;
+        } else if (auto* DB = dyn_cast<gtirb::DataBlock>(&Block)) {
+          Addr = *DB->getAddress();
+          Size = DB->getSize();
+        }
+        // Only split sections between functions that do not overlap the
+        // preceding blocks.
+        bool CanStartUnit =
+            BlockIndex == 0 || (FunctionStart && Addr >= End);
+        BlockPositions[Block.getUUID()] = Positions.size();
+        Positions.push_back({SectionIndex, BlockIndex, Size, CanStartUnit});
+        End = std::max(End, Addr + Size);
+        ++BlockIndex;
+      }
+    }
+    ++SectionIndex;
+  }
+
+  auto SymbolPosition =
+      [&](const gtirb::Symbol* Symbol) -> std::optional<size_t> {
+    const gtirb::Node* Referent = nullptr;
+    if (auto* CB = Symbol->getReferent<gtirb::CodeBlock>()) {
+      Referent = CB;
+    } else if (auto* DB = Symbol->getReferent<gtirb::DataBlock>()) {
+      Referent = DB;
+    }
+    if (Referent) {
+      if (auto It = BlockPositions.find(Referent->getUUID());
+          It != BlockPositions.end()) {
+        return It->second;
+      }
+    }
+    return std::nullopt;
+  };
+
+  // Positions that must stay in the same unit are tied together, which
+  // forbids starting a unit anywhere in between.
+  std::vector<int64_t> Ties(Positions.size() + 1, 0);
+  auto Tie = [&](size_t P1, size_t P2) {
+    if (P1 != P2) {
+      Ties[std::min(P1, P2) + 1]++;
+      Ties[std::max(P1, P2) + 1]--;
+    }
+  };
+
+  // Symbols referenced from each position.
+  std::vector<std::pair<size_t, const gtirb::Symbol*>> References;
+
+  // Functions are printed with a `.size` directive after their last block.
+  std::map<gtirb::UUID, std::pair<size_t, size_t>> FunctionRanges;
+  for (const auto& [Block, Function] : BlockToFunction) {
+    if (auto It = BlockPositions.find(Block); It != BlockPositions.end()) {
+      auto [Range, Inserted] =
+          FunctionRanges.emplace(Function, std::make_pair(It->second,
+                                                          It->second));
+      if (!Inserted) {
+        Range->second.first = std::min(Range->second.first, It->second);
+        Range->second.second = std::max(Range->second.second, It->second);
+      }
+    }
+  }
+  for (const auto& [Function, Range] : FunctionRanges) {
+    Tie(Range.first, Range.second);
+  }
+
+  // CFI frames cannot span units.
+  std::vector<std::optional<bool>> OpensFrame(Positions.size());
+  if (const auto* Cfi = module.getAuxData<gtirb::schema::CfiDirectives>()) {
+    for (const auto& [Offset, Directives] : *Cfi) {
+      auto It = BlockPositions.find(Offset.ElementId);
+      if (It == BlockPositions.end()) {
+        continue;
+      }
+      for (const auto& Directive : Directives) {
+        const std::string& Name = std::get<0>(Directive);
+        if (Name == ".cfi_startproc") {
+          OpensFrame[It->second] = true;
+        } else if (Name == ".cfi_endproc") {
+          OpensFrame[It->second] = false;
+        }
+        if (auto* Symbol = nodeFromUUID<gtirb::Symbol>(
+                context, std::get<2>(Directive))) {
+          References.emplace_back(It->second, Symbol);
+        }
+      }
+    }
+  }
+  bool InFrame = false;
+  for (size_t P = 0; P < Positions.size(); ++P) {
+    if (InFrame) {
+      Positions[P].CanStartUnit = false;
+    }
+    InFrame = OpensFrame[P].value_or(InFrame);
+  }
+
+  // Symbolic expressions. The assembler resolves `A - B` itself if A and B
+  // are in the same section, which must then be in the unit of the
+  // expression; otherwise B must be in the section of the expression, which
+  // the assembler turns into a PC-relative relocation against A.
+  for (const auto& Section : module.sections()) {
+    if (shouldSkip(Section)) {
+      continue;
+    }
+    for (const auto& Block : Section.blocks()) {
+      const gtirb::ByteInterval* BI = nullptr;
+      uint64_t Offset = 0, Size = 0;
+      bool Leb128 = false;
+      if (auto* CB = dyn_cast<gtirb::CodeBlock>(&Block)) {
+        BI = CB->getByteInterval();
+        Offset = CB->getOffset();
+        Size = CB->getSize();
+      } else if (auto* DB = dyn_cast<gtirb::DataBlock>(&Block)) {
+        BI = DB->getByteInterval();
+        Offset = DB->getOffset();
+        Size = DB->getSize();
+        std::optional<std::string> Type = aux_data::getEncodingType(*DB);
+        Leb128 = Type == "uleb128" || Type == "sleb128";
+      }
+      if (!BI) {
+        continue;
+      }
+      size_t P = BlockPositions[Block.getUUID()];
+      for (const auto& SEE :
+           BI->findSymbolicExpressionsAtOffset(Offset, Offset + Size)) {
+        const gtirb::SymbolicExpression& Expr = SEE.getSymbolicExpression();
+        if (const auto* SAC = std::get_if<gtirb::SymAddrConst>(&Expr)) {
+          References.emplace_back(P, SAC->Sym);
+        } else if (const auto* SAA = std::get_if<gtirb::SymAddrAddr>(&Expr)) {
+          References.emplace_back(P, SAA->Sym1);
+          References.emplace_back(P, SAA->Sym2);
+          std::optional<size_t> P1 = SymbolPosition(SAA->Sym1);
+          std::optional<size_t> P2 = SymbolPosition(SAA->Sym2);
+          if (P2) {
+            Tie(P, *P2);
+          }
+          bool PCRelative = P2 && SAA->Scale == 1 && !Leb128 &&
+                            Positions[*P2].Section == Positions[P].Section;
+          if (P1 && !PCRelative) {
+            Tie(P, *P1);
+          }
+        }
+      }
+    }
+  }
+
+  // Start a new unit at the first allowed position after each share of the
+  // listing.
+  uint64_t Total = 0;
+  for (const Position& Pos : Positions) {
+    Total += Pos.Size;
+  }
+  const uint64_t Share = std::max<uint64_t>(Total / Count, 1);
+  std::vector<size_t> PositionUnits(Positions.size());
+  uint64_t Printed = 0;
+  int64_t Tied = 0;
+  for (size_t P = 0; P < Positions.size(); ++P) {
+    Tied += Ties[P];
+    if (P > 0 && Positions[P].CanStartUnit && Tied == 0 &&
+        Result->size() < Count && Printed >= Share * Result->size()) {
+      Result->Starts.emplace_back(Positions[P].Section, Positions[P].Block);
+    }
+    PositionUnits[P] = Result->Starts.size();
+    Printed += Positions[P].Size;
+  }
+
+  // Promote the local symbols referenced from another unit.
+  std::set<std::string> Names;
+  auto Promote = [&](size_t From, const gtirb::Symbol* Symbol) {
+    std::optional<size_t> P = Symbol ? SymbolPosition(Symbol) : std::nullopt;
+    if (!P || PositionUnits[*P] == PositionUnits[From] ||
+        !isLocalSymbol(*Symbol) || shouldSkip(*Symbol) ||
+        Result->Promoted.count(Symbol)) {
+      return;
+    }
+    std::string Base = Symbol->getName();
+    if (auto It = AmbiguousSymbols.find(Symbol);
+        It != AmbiguousSymbols.end()) {
+      Base = It->second;
+    }
+    // Assembler-local labels are never exported, whatever their binding.
+    if (Base.rfind(".L", 0) == 0) {
+      Base = Base.substr(2);
+    }
+    Base += "_unit" + std::to_string(PositionUnits[*P]);
+    std::string Name = Base;
+    for (int Index = 1;
+         !module.findSymbols(Name).empty() || Names.count(Name) > 0;
+         ++Index) {
+      Name = Base + "_" + std::to_string(Index);
+    }
+    Names.insert(Name);
+    Result->Promoted.emplace(Symbol, Name);
+  };
+  for (const auto& [From, Symbol] : References) {
+    Promote(From, Symbol);
+    Promote(From, getForwardedSymbol(Symbol));
+  }
+  return Result;
+}
+
+void PrettyPrinterBase::setCompilationUnit(
+    std::shared_ptr<const CompilationUnits> UnitsToPrint, size_t Unit) {
+  Units = std::move(UnitsToPrint);
+  UnitIndex = Unit;
+  UnitBlocks.clear();
+
+  const size_t Last = std::numeric_limits<size_t>::max();
+  std::pair<size_t, size_t> Begin{0, 0}, End{Last, Last};
+  if (Unit > 0) {
+    Begin = Units->Starts[Unit - 1];
+  }
+  if (Unit < Units->Starts.size()) {
+    End = Units->Starts[Unit];
+  }
+  size_t SectionIndex = 0;
+  for (const auto& Section : module.sections()) {
+    if (SectionIndex >= Begin.first && SectionIndex <= End.first) {
+      size_t First = SectionIndex == Begin.first ? Begin.second : 0;
+      size_t Limit = SectionIndex == End.first ? End.second : Last;
+      if (First < Limit) {
+        UnitBlocks[&Section] = {First, Limit};
+      }
+    }
+    ++SectionIndex;
+  }
 }
 
 uint64_t PrettyPrinterBase::getSymbolicExpressionSize(
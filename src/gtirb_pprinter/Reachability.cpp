@@ -0,0 +1,285 @@
+//===- Reachability.cpp -----------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "Reachability.hpp"
+#include "AuxDataSchema.hpp"
+#include "AuxDataUtils.hpp"
+#include <boost/range/iterator_range.hpp>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace gtirb_pprint {
+
+namespace {
+
+// Propagates reachability over the blocks of a module, reaching every block
+// of a function as soon as one of its blocks is reached.
+class Reachability {
+public:
+  explicit Reachability(const gtirb::Module& M);
+
+  bool hasFunctions() const { return !Functions.empty(); }
+  bool isInFunction(const gtirb::CodeBlock& Block) const {
+    return BlockFunctions.count(&Block) != 0;
+  }
+
+  void reach(const gtirb::CodeBlock* Block);
+  void reach(const gtirb::Symbol* Symbol);
+  void reachSymbol(const gtirb::UUID& SymbolUUID);
+  void reachBlock(const gtirb::UUID& BlockUUID);
+  void reachReferences(const gtirb::ByteInterval& Interval, uint64_t Begin,
+                       uint64_t End);
+
+  // Reach everything reachable from the blocks reached so far.
+  void propagate();
+
+  std::unordered_set<std::string> unreachableFunctionNames() const;
+
+private:
+  struct Function {
+    std::vector<const gtirb::CodeBlock*> Blocks;
+    const gtirb::Symbol* Name = nullptr;
+    bool Reached = false;
+  };
+
+  const gtirb::Module& Module;
+  std::vector<Function> Functions;
+  std::map<gtirb::UUID, const gtirb::Symbol*> Symbols;
+  std::map<gtirb::UUID, const gtirb::CodeBlock*> Blocks;
+  std::unordered_map<const gtirb::CodeBlock*, std::vector<size_t>>
+      BlockFunctions;
+  std::unordered_map<const gtirb::CfgNode*,
+                     std::vector<const gtirb::CodeBlock*>>
+      Successors;
+  std::unordered_set<const gtirb::CodeBlock*> Reached;
+  std::vector<const gtirb::CodeBlock*> Pending;
+};
+
+Reachability::Reachability(const gtirb::Module& M) : Module(M) {
+  for (const gtirb::Symbol& Symbol : M.symbols()) {
+    Symbols.emplace(Symbol.getUUID(), &Symbol);
+  }
+  for (const gtirb::CodeBlock& Block : M.code_blocks()) {
+    Blocks.emplace(Block.getUUID(), &Block);
+  }
+  auto Names = aux_data::getFunctionNames(M);
+  for (const auto& [FunctionUUID, BlockUUIDs] :
+       aux_data::getFunctionBlocks(M)) {
+    Function F;
+    for (const gtirb::UUID& BlockUUID : BlockUUIDs) {
+      if (auto It = Blocks.find(BlockUUID); It != Blocks.end()) {
+        F.Blocks.push_back(It->second);
+        BlockFunctions[It->second].push_back(Functions.size());
+      }
+    }
+    if (auto Name = Names.find(FunctionUUID); Name != Names.end()) {
+      if (auto It = Symbols.find(Name->second); It != Symbols.end()) {
+        F.Name = It->second;
+      }
+    }
+    Functions.push_back(std::move(F));
+  }
+
+  if (const gtirb::IR* Ir = M.getIR()) {
+    const gtirb::CFG& Cfg = Ir->getCFG();
+    for (const auto& Edge : boost::make_iterator_range(boost::edges(Cfg))) {
+      if (const auto* Target = gtirb::dyn_cast<gtirb::CodeBlock>(
+              Cfg[boost::target(Edge, Cfg)])) {
+        Successors[Cfg[boost::source(Edge, Cfg)]].push_back(Target);
+      }
+    }
+  }
+}
+
+void Reachability::reach(const gtirb::CodeBlock* Block) {
+  if (Block && Reached.insert(Block).second) {
+    Pending.push_back(Block);
+  }
+}
+
+void Reachability::reach(const gtirb::Symbol* Symbol) {
+  if (!Symbol) {
+    return;
+  }
+  if (Symbol->hasReferent()) {
+    reach(Symbol->getReferent<gtirb::CodeBlock>());
+  } else if (auto Addr = Symbol->getAddress()) {
+    for (const gtirb::CodeBlock& Block : Module.findCodeBlocksOn(*Addr)) {
+      reach(&Block);
+    }
+  }
+}
+
+void Reachability::reachSymbol(const gtirb::UUID& SymbolUUID) {
+  if (auto It = Symbols.find(SymbolUUID); It != Symbols.end()) {
+    reach(It->second);
+  }
+}
+
+void Reachability::reachBlock(const gtirb::UUID& BlockUUID) {
+  if (auto It = Blocks.find(BlockUUID); It != Blocks.end()) {
+    reach(It->second);
+  }
+}
+
+void Reachability::reachReferences(const gtirb::ByteInterval& Interval,
+                                   uint64_t Begin, uint64_t End) {
+  for (const auto& SEE : Interval.findSymbolicExpressionsAtOffset(Begin, End)) {
+    std::visit(
+        [this](const auto& SE) {
+          using T = std::decay_t<decltype(SE)>;
+          if constexpr (std::is_same_v<T, gtirb::SymAddrAddr>) {
+            this->reach(SE.Sym1);
+            this->reach(SE.Sym2);
+          } else if constexpr (std::is_same_v<T, gtirb::SymAddrConst>) {
+            this->reach(SE.Sym);
+          }
+        },
+        SEE.getSymbolicExpression());
+  }
+}
+
+void Reachability::propagate() {
+  while (!Pending.empty()) {
+    const gtirb::CodeBlock* Block = Pending.back();
+    Pending.pop_back();
+    if (auto It = BlockFunctions.find(Block); It != BlockFunctions.end()) {
+      for (size_t Index : It->second) {
+        Function& F = Functions[Index];
+        if (!F.Reached) {
+          F.Reached = true;
+          for (const auto* Other : F.Blocks) {
+            reach(Other);
+          }
+        }
+      }
+    }
+    if (auto It = Successors.find(Block); It != Successors.end()) {
+      for (const auto* Successor : It->second) {
+        reach(Successor);
+      }
+    }
+    if (const gtirb::ByteInterval* Interval = Block->getByteInterval()) {
+      reachReferences(*Interval, Block->getOffset(),
+                      Block->getOffset() + Block->getSize());
+    }
+  }
+}
+
+std::unordered_set<std::string> Reachability::unreachableFunctionNames() const {
+  // Functions are skipped by name, so the names shared with a reachable
+  // function, e.g. of local functions of different objects, are kept.
+  std::unordered_set<std::string> Names, ReachedNames;
+  for (const Function& F : Functions) {
+    if (F.Name) {
+      (F.Reached ? ReachedNames : Names).insert(F.Name->getName());
+    }
+  }
+  for (const std::string& Name : ReachedNames) {
+    Names.erase(Name);
+  }
+  return Names;
+}
+
+// Whether the ELF symbol is visible to other modules.
+bool isElfExported(const gtirb::Symbol& Symbol,
+                   const gtirb::schema::ElfSymbolTabIdxInfo::Type& Tables) {
+  auto Info = aux_data::getElfSymbolInfo(Symbol);
+  if (!Info || Info->Binding == "LOCAL" || Info->Visibility == "HIDDEN" ||
+      Info->Visibility == "INTERNAL") {
+    return false;
+  }
+  // Without the symbol tables of the symbols, every global symbol may be
+  // exported.
+  if (Tables.empty()) {
+    return true;
+  }
+  auto It = Tables.find(Symbol.getUUID());
+  if (It == Tables.end()) {
+    return false;
+  }
+  for (const auto& [Table, Index] : It->second) {
+    if (Table == ".dynsym") {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+std::unordered_set<std::string>
+findUnreachableFunctions(const gtirb::Module& Module) {
+  bool IsElf = Module.getFileFormat() == gtirb::FileFormat::ELF;
+  bool IsPe = Module.getFileFormat() == gtirb::FileFormat::PE;
+  if (!IsElf && !IsPe) {
+    return {};
+  }
+  Reachability Analysis(Module);
+  if (!Analysis.hasFunctions()) {
+    return {};
+  }
+
+  Analysis.reach(Module.getEntryPoint());
+  for (const char* Name : {"_start", "_init", "_fini"}) {
+    for (const gtirb::Symbol& Symbol : Module.findSymbols(Name)) {
+      Analysis.reach(&Symbol);
+    }
+  }
+  if (IsElf) {
+    auto Tables = aux_data::getElfSymbolTabIdxInfo(Module);
+    for (const gtirb::Symbol& Symbol : Module.symbols()) {
+      if (isElfExported(Symbol, Tables)) {
+        Analysis.reach(&Symbol);
+      }
+    }
+  } else {
+    for (const gtirb::UUID& UUID : aux_data::getPeExportedSymbols(Module)) {
+      Analysis.reachSymbol(UUID);
+    }
+    for (const gtirb::UUID& UUID :
+         aux_data::getPeSafeExceptionHandlers(Module)) {
+      Analysis.reachBlock(UUID);
+    }
+  }
+  // Personality routines and language-specific data are referenced from
+  // CFI directives.
+  if (const auto* Directives =
+          Module.getAuxData<gtirb::schema::CfiDirectives>()) {
+    for (const auto& [Offset, List] : *Directives) {
+      for (const auto& Directive : List) {
+        Analysis.reachSymbol(std::get<2>(Directive));
+      }
+    }
+  }
+  for (const gtirb::DataBlock& Block : Module.data_blocks()) {
+    if (const gtirb::ByteInterval* Interval = Block.getByteInterval()) {
+      Analysis.reachReferences(*Interval, Block.getOffset(),
+                               Block.getOffset() + Block.getSize());
+    }
+  }
+  for (const gtirb::CodeBlock& Block : Module.code_blocks()) {
+    if (!Analysis.isInFunction(Block)) {
+      Analysis.reach(&Block);
+    }
+  }
+
+  Analysis.propagate();
+  return Analysis.unreachableFunctionNames();
+}
+
+} // namespace gtirb_pprint
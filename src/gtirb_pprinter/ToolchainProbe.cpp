@@ -0,0 +1,242 @@
+//===- ToolchainProbe.cpp --------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include "ToolchainProbe.hpp"
+#include "driver/Logger.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wunknown-warning-option"
+#pragma GCC diagnostic ignored "-Wshadow"
+#pragma GCC diagnostic ignored "-Wc++11-compat"
+#pragma GCC diagnostic ignored "-Wpessimizing-move"
+#pragma GCC diagnostic ignored "-Wdeprecated-copy"
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4456) // variable shadowing warning
+#endif                          // __GNUC__
+#include <boost/filesystem.hpp>
+#include <boost/process/child.hpp>
+#include <boost/process/io.hpp>
+#include <boost/process/search_path.hpp>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif // __GNUC__
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace fs = boost::filesystem;
+namespace bp = boost::process;
+
+namespace gtirb_bprint {
+
+namespace {
+
+constexpr const char* FileHeader = "gtirb-pprinter toolchain probe 2";
+
+// Separates the parts of an entry's key.
+constexpr char KeySeparator = '\x1f';
+
+#ifdef _WIN32
+constexpr char PathSeparator = ';';
+#else
+constexpr char PathSeparator = ':';
+#endif // _WIN32
+
+std::string currentPath() {
+  const char* Value = std::getenv("PATH");
+  return Value ? Value : "";
+}
+
+// Identify a file by its size and modification time.
+std::string fileStamp(const std::string& Path) {
+  boost::system::error_code EC;
+  std::ostringstream Stamp;
+  Stamp << fs::file_size(Path, EC) << ';' << fs::last_write_time(Path, EC);
+  return EC ? std::string() : Stamp.str();
+}
+
+// Identify the directories on a PATH up to and including \p Last, or all of
+// them without \p Last, so that a tool is searched for again once a file is
+// added to or removed from a directory that is searched before it is found.
+std::string pathStamp(const std::string& PathVar,
+                      const std::optional<fs::path>& Last = std::nullopt) {
+  std::string Stamp;
+  std::istringstream Dirs(PathVar);
+  for (std::string Dir; std::getline(Dirs, Dir, PathSeparator);) {
+    boost::system::error_code EC;
+    std::time_t Time = fs::last_write_time(Dir, EC);
+    Stamp += EC ? std::string("-") : std::to_string(Time);
+    Stamp += ';';
+    if (Last && fs::equivalent(Dir, *Last, EC)) {
+      break;
+    }
+  }
+  return Stamp;
+}
+
+} // namespace
+
+ToolchainProbe& ToolchainProbe::instance() {
+  static ToolchainProbe Probe;
+  return Probe;
+}
+
+std::optional<std::string> ToolchainProbe::find(const std::string& Tool) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  return findLocked(Tool);
+}
+
+std::optional<std::string>
+ToolchainProbe::findLocked(const std::string& Tool) {
+  boost::system::error_code EC;
+  if (fs::is_regular_file(Tool, EC)) {
+    return Tool;
+  }
+  if (fs::path(Tool).has_parent_path()) {
+    return std::nullopt;
+  }
+
+  std::string PathVar = currentPath();
+  std::string Key =
+      std::string("find") + KeySeparator + PathVar + KeySeparator + Tool;
+  auto Stamp = [&PathVar](const std::optional<std::string>& Result) {
+    if (!Result) {
+      return pathStamp(PathVar);
+    }
+    return fileStamp(*Result) + '|' +
+           pathStamp(PathVar, fs::path(*Result).parent_path());
+  };
+  auto It = Entries.find(Key);
+  if (It != Entries.end() && !It->second.Checked) {
+    It->second.Checked = Stamp(It->second.Result) == It->second.Stamp;
+  }
+  if (It == Entries.end() || !It->second.Checked) {
+    Entry& E = Entries[Key];
+    fs::path Path = bp::search_path(Tool);
+    E.Result = Path.empty() ? std::nullopt : std::optional(Path.string());
+    E.Stamp = Stamp(E.Result);
+    E.Checked = true;
+    return E.Result;
+  }
+  return It->second.Result;
+}
+
+std::optional<std::string>
+ToolchainProbe::query(const std::string& Tool,
+                      const std::vector<std::string>& Args) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  std::optional<std::string> Path = findLocked(Tool);
+  if (!Path) {
+    return std::nullopt;
+  }
+
+  std::string Key = std::string("query") + KeySeparator + *Path;
+  for (const std::string& Arg : Args) {
+    Key += KeySeparator + Arg;
+  }
+  auto It = Entries.find(Key);
+  if (It != Entries.end() && !It->second.Checked) {
+    It->second.Checked = fileStamp(*Path) == It->second.Stamp;
+  }
+  if (It != Entries.end() && It->second.Checked) {
+    return It->second.Result;
+  }
+
+  Entry& E = Entries[Key];
+  E.Result = std::nullopt;
+  bp::ipstream Output;
+  bp::child Child(*Path, Args, bp::std_out > Output);
+  std::string Line;
+  std::getline(Output, Line);
+  // Drain the output so that the tool does not block writing it.
+  Output.ignore(std::numeric_limits<std::streamsize>::max());
+  Child.wait();
+  if (Child.exit_code() == 0 && !Line.empty()) {
+    E.Result = Line;
+  }
+  E.Stamp = fileStamp(*Path);
+  E.Checked = true;
+  return E.Result;
+}
+
+bool ToolchainProbe::load(const std::string& Path) {
+  std::ifstream In(Path);
+  std::string Line;
+  if (!std::getline(In, Line) || Line != FileHeader) {
+    return false;
+  }
+  std::lock_guard<std::mutex> Lock(Mutex);
+  // Each entry is a line holding its key, whether it has a result, the
+  // result, and its stamp, separated by tabs.
+  while (std::getline(In, Line)) {
+    std::vector<std::string> Fields;
+    std::istringstream Stream(Line);
+    for (std::string Field; std::getline(Stream, Field, '\t');) {
+      Fields.push_back(Field);
+    }
+    if (Fields.size() != 4 || Entries.count(Fields[0]) > 0) {
+      continue;
+    }
+    Entry& E = Entries[Fields[0]];
+    if (Fields[1] == "1") {
+      E.Result = Fields[2];
+    }
+    E.Stamp = Fields[3];
+  }
+  return true;
+}
+
+bool ToolchainProbe::save(const std::string& Path) const {
+  fs::path Target(Path);
+  fs::path Staged = Target;
+  Staged += fs::unique_path(".%%%%-%%%%.tmp");
+  std::ofstream Out(Staged.string());
+  Out << FileHeader << '\n';
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    for (const auto& [Key, E] : Entries) {
+      std::string Line = Key + '\t' + (E.Result ? "1" : "0") + '\t' +
+                         E.Result.value_or("") + '\t' + E.Stamp;
+      // Fields cannot contain the separators; such entries are probed again.
+      if (Line.find('\n') == std::string::npos &&
+          std::count(Line.begin(), Line.end(), '\t') == 3) {
+        Out << Line << '\n';
+      }
+    }
+  }
+  Out.close();
+
+  // Stage the file and rename it, so that concurrent runs never read a
+  // partial file.
+  boost::system::error_code EC;
+  if (Out) {
+    fs::rename(Staged, Target, EC);
+  }
+  if (!Out || EC) {
+    LOG_WARNING << "Could not write the toolchain probe file: " << Path
+                << "\n";
+    fs::remove(Staged, EC);
+    return false;
+  }
+  return true;
+}
+
+} // namespace gtirb_bprint
@@ -0,0 +1,105 @@
+#include "batch.hpp"
+#include "Logger.h"
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <gtirb_pprinter/FileUtils.hpp>
+#include <iomanip>
+
+namespace pt = boost::property_tree;
+
+namespace gtirb_pprint {
+
+std::vector<BatchJob> readBatchManifest(const std::string& Path) {
+  pt::ptree Manifest;
+  try {
+    pt::read_json(Path, Manifest);
+  } catch (const pt::json_parser_error& Err) {
+    throw batch_error(Err.what());
+  }
+
+  auto JobList = Manifest.get_child_optional("jobs");
+  if (!JobList) {
+    throw batch_error(Path + ": the manifest has no \"jobs\" array");
+  }
+
+  std::vector<BatchJob> Jobs;
+  for (const auto& Child : *JobList) {
+    const pt::ptree& Entry = Child.second;
+    std::string Where = Path + ": job " + std::to_string(Jobs.size());
+    BatchJob Job;
+    auto IR = Entry.get_optional<std::string>("ir");
+    if (!IR || IR->empty()) {
+      throw batch_error(Where + " has no \"ir\"");
+    }
+    Job.IR = *IR;
+    Job.Args = {"--ir", Job.IR};
+
+    if (auto Options = Entry.get_child_optional("options")) {
+      for (const auto& Option : *Options) {
+        Job.Args.push_back(Option.second.data());
+      }
+    }
+
+    // Without an output, the assembly would be printed to the standard
+    // output, interleaved with that of the other jobs.
+    auto Outputs = Entry.get_child_optional("outputs");
+    if (!Outputs || Outputs->empty()) {
+      throw batch_error(Where + " has no \"outputs\"");
+    }
+    for (const auto& [Kind, File] : *Outputs) {
+      if (Kind != "asm" && Kind != "binary" && Kind != "version-script") {
+        throw batch_error(Where + " has an unknown output \"" + Kind + "\"");
+      }
+      Job.Args.push_back("--" + Kind);
+      Job.Args.push_back(File.data());
+    }
+    Jobs.push_back(std::move(Job));
+  }
+  return Jobs;
+}
+
+int runBatch(const std::vector<BatchJob>& Jobs, unsigned Threads,
+             const std::function<int(const BatchJob&)>& Run) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> Seconds(Jobs.size());
+  std::vector<std::future<int>> Results;
+  {
+    gtirb_bprint::ProcessPool Pool(Threads);
+    for (size_t I = 0; I < Jobs.size(); ++I) {
+      Results.push_back(Pool.submit([&Jobs, &Run, &Seconds, I]() {
+        auto Start = Clock::now();
+        int Status = EXIT_FAILURE;
+        try {
+          Status = Run(Jobs[I]);
+        } catch (const std::exception& Err) {
+          LOG_ERROR << "Batch job " << I << " (" << Jobs[I].IR
+                    << ") failed: " << Err.what() << "\n";
+        }
+        Seconds[I] =
+            std::chrono::duration<double>(Clock::now() - Start).count();
+        return Status;
+      }));
+    }
+  }
+
+  size_t Failed = 0;
+  LOG_INFO << "Batch summary:\n";
+  for (size_t I = 0; I < Jobs.size(); ++I) {
+    bool Succeeded = Results[I].get() == EXIT_SUCCESS;
+    if (!Succeeded) {
+      ++Failed;
+    }
+    LOG_INFO << "  " << std::setw(6) << I << "  "
+             << (Succeeded ? "ok    " : "FAILED") << "  " << std::fixed
+             << std::setprecision(2) << Seconds[I] << "s  " << Jobs[I].IR
+             << "\n";
+  }
+  LOG_INFO << (Jobs.size() - Failed) << " of " << Jobs.size()
+           << " batch jobs succeeded.\n";
+  return Failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace gtirb_pprint
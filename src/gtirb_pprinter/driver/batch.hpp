@@ -0,0 +1,82 @@
+#ifndef GTIRB_PPRINT_BATCH_H
+#define GTIRB_PPRINT_BATCH_H
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gtirb_pprint {
+
+// width: 80; tab-width: 2
+static const std::string_view batch_help_message{R"""(
+`--batch MANIFEST` runs many print jobs in one process, on a pool of at most
+`--batch-jobs` threads. MANIFEST is a JSON file listing the jobs:
+
+  {"jobs": [
+    {"ir": "hello.gtirb",
+     "options": ["--dummy-so", "yes"],
+     "outputs": {"binary": "hello"}},
+    {"ir": "libfoo.gtirb",
+     "outputs": {"asm": "libfoo.s", "version-script": "libfoo.map"}}
+  ]}
+
+Each job gives:
+
+  ir        The GTIRB file to print.
+
+  outputs   The files to write, as an object whose keys are `asm`, `binary`,
+            or `version-script`. The values are the arguments of the option of
+            the same name, and may select modules as described by
+            `gtirb-pprinter --help modules`.
+
+  options   Optionally, other command-line arguments for the job.
+
+Options given on the command line along with `--batch` apply to every job, and
+must not be given again in a job's `options`. Relative paths are relative to
+the current directory.
+
+A failing job does not stop the others. A summary of the jobs that succeeded
+and failed is printed at the end, and the exit status is non-zero if any job
+failed.
+)"""};
+
+/// @brief One invocation of the pretty printer listed in a batch manifest.
+struct BatchJob {
+  /// The GTIRB file to print.
+  std::string IR;
+  /// The command-line arguments for the job, not including the program name.
+  std::vector<std::string> Args;
+};
+
+class batch_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/// @brief Read the jobs listed in a batch manifest.
+///
+/// The manifest is a JSON object with a `jobs` array. Each job names its
+/// input (`ir`), its outputs (`outputs`, an object mapping `asm`, `binary`,
+/// or `version-script` to a file name or module pattern), and optionally
+/// further command-line `options`:
+///
+///     {"jobs": [{"ir": "hello.gtirb",
+///                "options": ["--dummy-so", "yes"],
+///                "outputs": {"binary": "hello"}}]}
+///
+/// @throws batch_error if the manifest cannot be read or a job is malformed.
+std::vector<BatchJob> readBatchManifest(const std::string& Path);
+
+/// @brief Run \p Jobs with \p Run, at most \p Threads at a time, and log a
+/// summary of the results.
+///
+/// A job fails if \p Run returns non-zero or throws; other jobs are not
+/// affected. If \p Threads is zero, the number of hardware threads is used.
+///
+/// @return EXIT_SUCCESS if every job succeeded, EXIT_FAILURE otherwise.
+int runBatch(const std::vector<BatchJob>& Jobs, unsigned Threads,
+             const std::function<int(const BatchJob&)>& Run);
+
+} // namespace gtirb_pprint
+#endif // GTIRB_PPRINT_BATCH_H
@@ -0,0 +1,218 @@
+#include "compression.hpp"
+#include <algorithm>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <cctype>
+#ifdef GTIRB_PPRINTER_HAVE_BOOST_ZSTD
+#include <boost/iostreams/filter/zstd.hpp>
+#endif
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace io = boost::iostreams;
+
+namespace gtirb_pprint {
+
+// Size of the buffers used while decompressing.
+static constexpr size_t ChunkSize = 1 << 20;
+
+std::string compressionName(Compression C) {
+  switch (C) {
+  case Compression::Gzip:
+    return "gzip";
+  case Compression::Zstd:
+    return "zstd";
+  case Compression::None:
+    break;
+  }
+  return "none";
+}
+
+bool compressionSupported(Compression C) {
+#ifdef GTIRB_PPRINTER_HAVE_BOOST_ZSTD
+  (void)C;
+  return true;
+#else
+  return C != Compression::Zstd;
+#endif
+}
+
+Compression compressionFromExtension(const fs::path& Path) {
+  std::string Ext = Path.extension().string();
+  std::transform(Ext.begin(), Ext.end(), Ext.begin(),
+                 [](unsigned char C) { return std::tolower(C); });
+  if (Ext == ".gz")
+    return Compression::Gzip;
+  if (Ext == ".zst")
+    return Compression::Zstd;
+  return Compression::None;
+}
+
+static Compression detectCompression(const std::string& Magic) {
+  if (Magic.size() >= 2 && Magic[0] == '\x1f' && Magic[1] == '\x8b')
+    return Compression::Gzip;
+  if (Magic.size() >= 4 && Magic.compare(0, 4, "\x28\xb5\x2f\xfd") == 0)
+    return Compression::Zstd;
+  return Compression::None;
+}
+
+namespace {
+// A Boost.Iostreams source that yields the bytes consumed from a stream while
+// sniffing its header, followed by the remainder of that stream.
+class PrefixedSource {
+public:
+  typedef char char_type;
+  typedef io::source_tag category;
+
+  PrefixedSource(std::string P, std::istream& S)
+      : Prefix(std::move(P)), Stream(&S) {}
+
+  std::streamsize read(char* S, std::streamsize N) {
+    std::streamsize Count = 0;
+    if (Pos < Prefix.size()) {
+      Count = std::min<std::streamsize>(N, Prefix.size() - Pos);
+      std::memcpy(S, Prefix.data() + Pos, Count);
+      Pos += Count;
+    }
+    if (Count < N && *Stream) {
+      Stream->read(S + Count, N - Count);
+      Count += Stream->gcount();
+    }
+    return Count == 0 ? -1 : Count;
+  }
+
+private:
+  std::string Prefix;
+  size_t Pos = 0;
+  std::istream* Stream;
+};
+} // namespace
+
+std::unique_ptr<std::istream> openDecompressedInput(std::istream& In,
+                                                    Compression& Detected) {
+  std::string Magic(4, '\0');
+  In.read(&Magic[0], Magic.size());
+  Magic.resize(In.gcount());
+  Detected = detectCompression(Magic);
+  if (!compressionSupported(Detected))
+    return nullptr;
+
+  auto Result = std::make_unique<io::filtering_istream>();
+  switch (Detected) {
+  case Compression::Gzip:
+    Result->push(io::gzip_decompressor(), ChunkSize);
+    break;
+  case Compression::Zstd:
+#ifdef GTIRB_PPRINTER_HAVE_BOOST_ZSTD
+    Result->push(io::zstd_decompressor(), ChunkSize);
+#endif
+    break;
+  case Compression::None:
+    break;
+  }
+  Result->push(PrefixedSource(std::move(Magic), In), ChunkSize);
+  return Result;
+}
+
+namespace {
+// A Boost.Iostreams source that adds the bytes it reads from a stream to a
+// CacheKey.
+class HashingSource {
+public:
+  typedef char char_type;
+  typedef io::source_tag category;
+
+  HashingSource(std::istream& S, gtirb_bprint::CacheKey& K, uint64_t& N)
+      : Stream(&S), Key(&K), Size(&N) {}
+
+  std::streamsize read(char* S, std::streamsize N) {
+    if (!*Stream)
+      return -1;
+    Stream->read(S, N);
+    std::streamsize Count = Stream->gcount();
+    Key->addChunk(std::string_view(S, static_cast<size_t>(Count)));
+    *Size += static_cast<uint64_t>(Count);
+    return Count == 0 ? -1 : Count;
+  }
+
+private:
+  std::istream* Stream;
+  gtirb_bprint::CacheKey* Key;
+  uint64_t* Size;
+};
+} // namespace
+
+HashingInput::HashingInput(std::istream& In)
+    : Stream(std::make_unique<io::stream<HashingSource>>(
+          HashingSource(In, Key, Size), ChunkSize)) {}
+
+HashingInput::~HashingInput() = default;
+
+std::string HashingInput::digest() {
+  // The loader may stop before the end of the input (e.g. at the end of a
+  // compressed stream), but the digest covers every byte.
+  Stream->ignore(std::numeric_limits<std::streamsize>::max());
+  return Key.add(Size).str();
+}
+
+namespace {
+// Compresses the buffers of an AsyncOutputStream into a file.
+class CompressedFileSink : public gtirb_bprint::OutputSink {
+public:
+  CompressedFileSink(io::file_sink& Sink, Compression C) {
+    switch (C) {
+    case Compression::Gzip:
+      Out.push(io::gzip_compressor());
+      break;
+    case Compression::Zstd:
+#ifdef GTIRB_PPRINTER_HAVE_BOOST_ZSTD
+      Out.push(io::zstd_compressor());
+#endif
+      break;
+    case Compression::None:
+      break;
+    }
+    Out.push(Sink);
+  }
+
+  bool write(const std::vector<std::string_view>& Buffers) override {
+    try {
+      for (const auto& B : Buffers) {
+        if (!Out.write(B.data(), B.size()))
+          return false;
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }
+
+  bool close() override {
+    try {
+      // Closing the chain writes the trailer of the compressed format.
+      Out.reset();
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  io::filtering_ostream Out;
+};
+} // namespace
+
+std::unique_ptr<gtirb_bprint::OutputSink>
+openCompressedFileSink(const std::string& Path, Compression C) {
+  if (!compressionSupported(C))
+    return nullptr;
+  io::file_sink Sink(Path, std::ios::out | std::ios::binary);
+  if (!Sink.is_open())
+    return nullptr;
+  return std::make_unique<CompressedFileSink>(Sink, C);
+}
+
+} // namespace gtirb_pprint
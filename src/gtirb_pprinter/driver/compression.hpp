@@ -0,0 +1,79 @@
+#ifndef GTIRB_PPRINT_COMPRESSION_H
+#define GTIRB_PPRINT_COMPRESSION_H
+#include <boost/filesystem.hpp>
+#include <gtirb_pprinter/ArtifactCache.hpp>
+#include <gtirb_pprinter/FileUtils.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace fs = boost::filesystem;
+namespace gtirb_pprint {
+
+enum class Compression { None, Gzip, Zstd };
+
+/// @brief Return a human-readable name for a compression format.
+std::string compressionName(Compression C);
+
+/// @brief Check whether this build can read and write the given format.
+bool compressionSupported(Compression C);
+
+/// @brief Select the compression of an output file from its extension.
+///
+/// Files ending in `.gz` are gzip compressed and files ending in `.zst` are
+/// zstd compressed; any other extension selects no compression.
+Compression compressionFromExtension(const fs::path& Path);
+
+/// @brief Open a stream over the decompressed contents of \p In.
+///
+/// The leading bytes of \p In are inspected for a gzip or zstd header and, if
+/// one is found, the returned stream decompresses the data as it is read.
+/// Uncompressed data is passed through unmodified. The bytes read while
+/// sniffing the header are replayed, so \p In does not have to be seekable
+/// (e.g. it may be `std::cin`).
+///
+/// @param In: The stream to read from. It must outlive the returned stream.
+/// @param Detected: Set to the compression format that was detected.
+/// @return The stream to read from, or nullptr if the detected format is not
+/// supported by this build.
+std::unique_ptr<std::istream> openDecompressedInput(std::istream& In,
+                                                    Compression& Detected);
+
+/// @brief A stream that hashes the bytes of another stream as they are read.
+///
+/// This lets the digest of a (possibly compressed) input be computed in the
+/// same pass that loads it, without holding a copy of the input in memory.
+class HashingInput {
+public:
+  /// @param In: The stream to read from. It must outlive this object.
+  explicit HashingInput(std::istream& In);
+  ~HashingInput();
+
+  /// @brief Return the stream to read \p In through.
+  std::istream& stream() { return *Stream; }
+
+  /// @brief Read the rest of the input and return the digest of all of it.
+  ///
+  /// The input is hashed as a single field, followed by its length. Call
+  /// this once, after reading what is needed.
+  std::string digest();
+
+private:
+  gtirb_bprint::CacheKey Key;
+  uint64_t Size = 0;
+  std::unique_ptr<std::istream> Stream;
+};
+
+/// @brief Open a file sink that compresses what is written to it.
+///
+/// The returned sink is meant to be driven by an AsyncOutputStream, so
+/// compression runs on the stream's writer thread and overlaps with
+/// formatting.
+///
+/// @return The sink, or nullptr if the file cannot be opened or the format is
+/// not supported by this build.
+std::unique_ptr<gtirb_bprint::OutputSink>
+openCompressedFileSink(const std::string& Path, Compression C);
+
+} // namespace gtirb_pprint
+#endif // GTIRB_PPRINT_COMPRESSION_H
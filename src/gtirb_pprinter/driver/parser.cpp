@@ -1,4 +1,6 @@
 #include "parser.hpp"
+#include <algorithm>
+#include <cctype>
 #include <iomanip>
 
 using namespace std::literals;
@@ -13,6 +15,81 @@ std::string quote(char C) {
     return ""s + C;
 }
 
+namespace {
+
+// Matches the elements of a module pattern against a name, trying the
+// shortest match of each `*` first. Whether the rest of the name matches the
+// rest of the pattern does not depend on the groups matched so far, so the
+// positions where it failed are remembered, and each element is tried at
+// each position of the name at most once.
+class PatternMatcher {
+public:
+  PatternMatcher(const ModulePattern& P, const std::string& N, ModuleMatch& M)
+      : Elements(P.Elements), Name(N), Match(M),
+        Failed((Elements.size() + 1) * (Name.size() + 1)),
+        GroupBegins(P.GroupCount + 1) {}
+
+  bool match(size_t Element, size_t Pos) {
+    if (Element == Elements.size()) {
+      return Pos == Name.size();
+    }
+    size_t State = Element * (Name.size() + 1) + Pos;
+    if (Failed[State]) {
+      return false;
+    }
+    const ModulePattern::Element& E = Elements[Element];
+    bool Matched = false;
+    switch (E.Kind) {
+    case ModulePattern::Element::Literal:
+      Matched = Name.compare(Pos, E.Text.size(), E.Text) == 0 &&
+                match(Element + 1, Pos + E.Text.size());
+      break;
+    case ModulePattern::Element::AnyChar:
+      Matched = Pos < Name.size() && match(Element + 1, Pos + 1);
+      break;
+    case ModulePattern::Element::AnyString:
+      // Match nothing, or one more character and try again.
+      Matched = match(Element + 1, Pos) ||
+                (Pos < Name.size() && match(Element, Pos + 1));
+      break;
+    case ModulePattern::Element::GroupBegin:
+      GroupBegins[E.Group] = Pos;
+      Matched = match(Element + 1, Pos);
+      break;
+    case ModulePattern::Element::GroupEnd:
+      Matched = match(Element + 1, Pos);
+      if (Matched) {
+        Match[E.Group] =
+            Name.substr(GroupBegins[E.Group], Pos - GroupBegins[E.Group]);
+      }
+      break;
+    }
+    if (!Matched) {
+      Failed[State] = true;
+    }
+    return Matched;
+  }
+
+private:
+  const std::vector<ModulePattern::Element>& Elements;
+  const std::string& Name;
+  ModuleMatch& Match;
+  std::vector<bool> Failed;
+  std::vector<size_t> GroupBegins;
+};
+
+} // namespace
+
+std::optional<ModuleMatch>
+ModulePattern::matches(const std::string& Name) const {
+  ModuleMatch Match(GroupCount + 1);
+  if (!PatternMatcher(*this, Name, Match).match(0, 0)) {
+    return std::nullopt;
+  }
+  Match[0] = Name;
+  return Match;
+}
+
 std::optional<fs::path>
 getOutputFilePath(const std::vector<FileTemplateRule>& Subs,
                   const std::string& ModuleName) {
@@ -60,7 +137,9 @@ std::vector<FileTemplateRule> parseInput(const std::string& Input) {
 
 FileTemplateRule::FileTemplateRule(std::string::const_iterator SpecBegin,
                                    std::string::const_iterator SpecEnd)
-    : MPattern{".*", {{"name", 0}, {"n", 0}}} {
+    : MPattern{".*",
+               {{"name", 0}, {"n", 0}},
+               {{ModulePattern::Element::AnyString, "", 0}}} {
   bool Escape = false;
   for (auto SpecIter = SpecBegin; SpecIter != SpecEnd; ++SpecIter) {
     if (Escape) {
@@ -80,7 +159,7 @@ FileTemplateRule::FileTemplateRule(std::string::const_iterator SpecBegin,
   FileTemplate = makeFileTemplate(SpecBegin, SpecEnd);
 }
 
-std::string
+std::vector<FileTemplateRule::TemplatePart>
 FileTemplateRule::makeFileTemplate(std::string::const_iterator PBegin,
                                    std::string::const_iterator PEnd) {
   /*
@@ -95,7 +174,13 @@ FileTemplateRule::makeFileTemplate(std::string::const_iterator PBegin,
    * sequence
    */
   std::string SpecialChars{"{\\,="};
-  std::string Pattern;
+  std::vector<TemplatePart> Pattern;
+  auto Append = [&Pattern](char C) {
+    if (Pattern.empty() || Pattern.back().Group) {
+      Pattern.emplace_back();
+    }
+    Pattern.back().Text.push_back(C);
+  };
   std::string GroupName;
   for (auto I = PBegin; I != PEnd; I++) {
     switch (*I) {
@@ -107,15 +192,7 @@ FileTemplateRule::makeFileTemplate(std::string::const_iterator PBegin,
         if (GroupIndexesIter == MPattern.GroupIndexes.end()) {
           throw parse_error("Undefined group: {"s + GroupName + "}");
         }
-        auto GI = GroupIndexesIter->second;
-        Pattern.push_back('$');
-        if (GI == 0) {
-          Pattern.push_back('&');
-        } else if (GI < 10) {
-          Pattern.append("0"s + std::to_string(GI));
-        } else {
-          Pattern.append(std::to_string(GI));
-        }
+        Pattern.push_back({"", GroupIndexesIter->second});
         I = J;
       } else {
         throw parse_error("Unclosed `{` in file template");
@@ -124,20 +201,17 @@ FileTemplateRule::makeFileTemplate(std::string::const_iterator PBegin,
     case '\\':
       I++;
       if (I != PEnd && SpecialChars.find(*I) != std::string::npos) {
-        Pattern.push_back(*I);
+        Append(*I);
       } else {
-        Pattern.push_back('\\');
+        Append('\\');
         --I;
       }
       break;
-    case '$':
-      Pattern.append("$$");
-      break;
     case ',':
     case '=':
       throw parse_error("Character "s + *I + " must be escaped");
     default:
-      Pattern.push_back(*I);
+      Append(*I);
       break;
     }
   }
@@ -147,7 +221,11 @@ FileTemplateRule::makeFileTemplate(std::string::const_iterator PBegin,
 std::optional<std::string>
 FileTemplateRule::substitute(const std::string& P) const {
   if (auto M = matches(P)) {
-    return M->format(FileTemplate);
+    std::string Path;
+    for (const TemplatePart& Part : FileTemplate) {
+      Path += Part.Group ? (*M)[*Part.Group] : Part.Text;
+    }
+    return Path;
   }
   return {};
 }
@@ -177,71 +255,85 @@ ModulePattern makePattern(std::string::const_iterator FieldBegin,
   Pattern.GroupIndexes["name"] = 0;
   Pattern.GroupIndexes["n"] = 0;
 
+  using Element = ModulePattern::Element;
+  auto AppendLiteral = [&Pattern](char C) {
+    Pattern.RegexStr.append(quote(C));
+    if (Pattern.Elements.empty() ||
+        Pattern.Elements.back().Kind != Element::Literal) {
+      Pattern.Elements.push_back({Element::Literal, "", 0});
+    }
+    Pattern.Elements.back().Text.push_back(C);
+  };
+
   std::string SpecialChars{"\\=,{}:*?[]"};
   std::vector<std::string> GroupNames;
-  std::regex WordChars("^\\w+", std::regex::optimize);
   bool OpenGroup = false;
   for (auto i = FieldBegin; i != FieldEnd; i++) {
-    std::smatch M;
     switch (*i) {
-    case '{':
+    case '{': {
       if (OpenGroup) {
         throw parse_error("Invalid character in pattern: "s + *i);
       }
       OpenGroup = true;
       Pattern.RegexStr.push_back('(');
+      Pattern.Elements.push_back(
+          {Element::GroupBegin, "", GroupNames.size() + 1});
       ++i;
-      // We know at this point that `i <= FieldEnd`. If `i == FieldEnd`, then
-      // std::regex_search will scan an empty sequence and won't dereference
-      // `i`, and M.str().length() will be 0 so `i` won't advance further
-      std::regex_search(i, FieldEnd, M, WordChars);
-      // M.str().length() can never be greater than `FieldEnd - i`
-      i += M.str().length();
+      auto NameEnd = std::find_if(i, FieldEnd, [](char C) {
+        return !std::isalnum(static_cast<unsigned char>(C)) && C != '_';
+      });
+      std::string GroupName(i, NameEnd);
+      i = NameEnd;
       if (i == FieldEnd) {
-        throw parse_error("Unclosed '{' in group "s + GroupNames.back());
+        throw parse_error("Unclosed '{' in group "s + GroupName);
       }
       if (*i != ':') {
         throw parse_error("Invalid character in group name: '"s + *i + "'");
       }
-      if (M.str().length() == 0) {
+      if (GroupName.empty()) {
         throw parse_error("All groups must be named");
       }
-      GroupNames.push_back(M.str());
+      GroupNames.push_back(GroupName);
       break;
+    }
     case '}':
       if (OpenGroup) {
         Pattern.RegexStr.push_back(')');
+        Pattern.Elements.push_back({Element::GroupEnd, "", GroupNames.size()});
         OpenGroup = false;
       } else {
-        Pattern.RegexStr.append("\\}");
+        AppendLiteral(*i);
       }
       break;
     case '*':
       Pattern.RegexStr.append(".*?");
+      Pattern.Elements.push_back({Element::AnyString, "", 0});
       break;
     case '?':
       Pattern.RegexStr.push_back('.');
+      Pattern.Elements.push_back({Element::AnyChar, "", 0});
       break;
     case '\\':
       ++i;
       if (i != FieldEnd && SpecialChars.find(*i) != std::string::npos) {
-        Pattern.RegexStr.append(quote(*i));
+        AppendLiteral(*i);
       } else {
-        Pattern.RegexStr.append("\\\\");
+        AppendLiteral('\\');
         --i;
       }
       break;
     default:
-      Pattern.RegexStr.append(quote(*i));
+      AppendLiteral(*i);
     }
   }
   if (OpenGroup) {
-    throw parse_error("Unclosed '{' in group"s + GroupNames.back());
+    throw parse_error("Unclosed '{' in group "s + GroupNames.back());
   }
   for (size_t s = 0; s < GroupNames.size(); s++) {
     auto& Name = GroupNames[s];
     Pattern.GroupIndexes[Name] = s + 1;
   }
+  Pattern.GroupCount = GroupNames.size();
   return Pattern;
 }
 
@@ -2,9 +2,11 @@
 #define GTPPRINT_PARSER_H
 #include <boost/filesystem.hpp>
 #include <optional>
-#include <regex>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <map>
+#include <vector>
 
 namespace fs = boost::filesystem;
 
@@ -124,35 +126,50 @@ std::optional<fs::path>
 getOutputFilePath(const std::vector<FileTemplateRule>& Subs,
                   const std::string& ModuleName);
 
+/**
+ * @brief The text matched by a module pattern: the whole module name,
+ * followed by the text matched by each group of the pattern
+ */
+using ModuleMatch = std::vector<std::string>;
+
 /**
  * @brief Translates a wildcard expression, given by the user,
- *  into a regular expression for matching and parsing module names
+ *  into a compiled pattern for matching and parsing module names
  *
  */
 struct ModulePattern {
+  /**
+   * @brief A step of a compiled pattern: a literal string, `?`, `*`, or the
+   * beginning or end of a group
+   */
+  struct Element {
+    enum KindTy { Literal, AnyChar, AnyString, GroupBegin, GroupEnd };
+    KindTy Kind;
+    std::string Text;
+    size_t Group = 0;
+  };
+
+  /// The pattern as an equivalent ECMAScript regex, for diagnostics.
   std::string RegexStr;
   std::map<std::string, size_t> GroupIndexes;
+  std::vector<Element> Elements;
+  size_t GroupCount = 0;
 
   /**
-   * @brief Returns a match group that matches the pattern in Name,
+   * @brief Returns the groups of the pattern matched in Name,
    * or std::nullopt if there is no match
    *
+   * Like `*?` in a regex, each `*` matches as few characters as it can.
+   *
    * @param Name
-   * @return std::optional<std::smatch>
+   * @return std::optional<ModuleMatch>
    */
-  std::optional<std::smatch> matches(const std::string& Name) const {
-    std::smatch Match;
-    std::regex ModuleRegex{RegexStr};
-    if (std::regex_match(Name, Match, ModuleRegex)) {
-      return Match;
-    }
-    return {};
-  }
+  std::optional<ModuleMatch> matches(const std::string& Name) const;
 };
 
 /**
  * @brief Translates a character sequence representing a module pattern
- * into an ECMAScript regex, along with a map from names to
+ * into a compiled pattern, along with a map from names to
  * group numbers
  *
  * @param Begin An iterator pointing to the beginning of the sequence
@@ -170,13 +187,21 @@ ModulePattern makePattern(std::string::const_iterator Begin,
 class FileTemplateRule {
   ModulePattern MPattern;
 
-  std::string FileTemplate;
-  std::string makeFileTemplate(std::string::const_iterator PBegin,
-                               std::string::const_iterator PEnd);
-  std::string makeFileTemplate(const std::string& P) {
+  /// A part of a file template: literal text, or the text matched by a
+  /// group of the module pattern.
+  struct TemplatePart {
+    std::string Text;
+    std::optional<size_t> Group;
+  };
+
+  std::vector<TemplatePart> FileTemplate;
+  std::vector<TemplatePart>
+  makeFileTemplate(std::string::const_iterator PBegin,
+                   std::string::const_iterator PEnd);
+  std::vector<TemplatePart> makeFileTemplate(const std::string& P) {
     return makeFileTemplate(P.begin(), P.end());
   };
-  std::optional<std::smatch> matches(const std::string& Name) const {
+  std::optional<ModuleMatch> matches(const std::string& Name) const {
     return MPattern.matches(Name);
   }
 
@@ -6,22 +6,34 @@
 #include <fstream>
 #include <gtirb/Module.hpp>
 #include <gtirb_layout/gtirb_layout.hpp>
+#include <gtirb_pprinter/ArtifactCache.hpp>
 #include <gtirb_pprinter/ElfBinaryPrinter.hpp>
 #include <gtirb_pprinter/ElfVersionScriptPrinter.hpp>
+#include <gtirb_pprinter/FileUtils.hpp>
 #include <gtirb_pprinter/Fixup.hpp>
+#include <gtirb_pprinter/FixupOverlay.hpp>
 #include <gtirb_pprinter/PeBinaryPrinter.hpp>
 #include <gtirb_pprinter/PrettyPrinter.hpp>
+#include <gtirb_pprinter/PrintError.hpp>
+#include <gtirb_pprinter/ToolchainProbe.hpp>
 #include <gtirb_pprinter/version.h>
 #if defined(_MSC_VER)
 #include <io.h>
 #endif
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
 #if defined(__unix__)
 #include <unistd.h>
 #endif
+#include "batch.hpp"
+#include "compression.hpp"
 #include "parser.hpp"
 #include "printing_paths.hpp"
+#include "serve.hpp"
 
 namespace fs = boost::filesystem;
 namespace po = boost::program_options;
@@ -72,6 +84,78 @@ getBinaryPrinter(const std::string& format,
   return nullptr;
 }
 
+// Parse an address range given as BEGIN-END, where BEGIN is below END.
+static std::optional<std::pair<gtirb::Addr, gtirb::Addr>>
+parseAddressRange(const std::string& Range) {
+  size_t Dash = Range.find('-');
+  if (Dash == std::string::npos) {
+    return std::nullopt;
+  }
+  try {
+    size_t BeginEnd, EndEnd;
+    std::string Begin = Range.substr(0, Dash), End = Range.substr(Dash + 1);
+    uint64_t BeginAddr = std::stoull(Begin, &BeginEnd, 0);
+    uint64_t EndAddr = std::stoull(End, &EndEnd, 0);
+    if (BeginEnd != Begin.size() || EndEnd != End.size() ||
+        BeginAddr >= EndAddr) {
+      return std::nullopt;
+    }
+    return std::make_pair(gtirb::Addr{BeginAddr}, gtirb::Addr{EndAddr});
+  } catch (const std::logic_error&) {
+    return std::nullopt;
+  }
+}
+
+// A variant of the output, printed from the same IR to its own files.
+struct OutputVariant {
+  std::string Name;
+  std::string Shared;
+  std::string Policy;
+};
+
+// Parse a variant given as NAME[:SETTING[,SETTING...]], where each setting
+// is shared=MODE or policy=POLICY. Settings not given are taken from Base.
+static std::optional<OutputVariant> parseVariant(const std::string& Spec,
+                                                 const OutputVariant& Base) {
+  OutputVariant Variant = Base;
+  size_t Colon = Spec.find(':');
+  Variant.Name = Spec.substr(0, Colon);
+  if (Variant.Name.empty() ||
+      Variant.Name.find_first_of("/\\") != std::string::npos) {
+    return std::nullopt;
+  }
+  if (Colon == std::string::npos) {
+    return Variant;
+  }
+  std::istringstream Settings(Spec.substr(Colon + 1));
+  for (std::string Setting; std::getline(Settings, Setting, ',');) {
+    size_t Equals = Setting.find('=');
+    if (Equals == std::string::npos) {
+      return std::nullopt;
+    }
+    std::string Key = Setting.substr(0, Equals);
+    std::string Value = Setting.substr(Equals + 1);
+    if (Key == "shared") {
+      Variant.Shared = Value;
+    } else if (Key == "policy") {
+      Variant.Policy = Value;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return Variant;
+}
+
+// Insert ".NAME" before the extension of an output file of a variant.
+static std::optional<fs::path> variantPath(const std::optional<fs::path>& Path,
+                                           const std::string& Name) {
+  if (!Path || Name.empty()) {
+    return Path;
+  }
+  return Path->parent_path() /
+         (Path->stem().string() + "." + Name + Path->extension().string());
+}
+
 static std::vector<gtirb_pprint_parser::FileTemplateRule>
 getTemplateRules(const po::variables_map& vm, const std::string& name) {
   if (vm.count(name)) {
@@ -87,21 +171,22 @@ getTemplateRules(const po::variables_map& vm, const std::string& name) {
   }
 };
 
-int main(int argc, char** argv) {
-  gtirb_layout::registerAuxDataTypes();
-  gtirb_pprint::registerAuxDataTypes();
-  gtirb_pprint::registerPrettyPrinters();
-
+// Print the IR as directed by the command line. Jobs run with --batch use this
+// too, concurrently, so it must not modify global state.
+static int run(int argc, const char* const* argv, bool InBatch) {
   po::options_description desc("Allowed options");
   desc.add_options()(
       "help,h", po::value<std::string>()->implicit_value(""),
       "Print this help message, or use `-h modules` to print help"
       "with selecting modules and specifying file names");
   desc.add_options()("version", "Print version info and exit.");
-  desc.add_options()("ir,i", po::value<std::string>(), "GTIRB file to print.");
+  desc.add_options()("ir,i", po::value<std::string>(),
+                     "GTIRB file to print. The file may be gzip or zstd "
+                     "compressed.");
   desc.add_options()(
       "asm,a", po::value<std::string>()->value_name("FILE"),
       "Print IR as assembly code to FILE. "
+      "FILE is compressed if its name ends in .gz or .zst. "
       "If there is more than one module, files for each can be specified "
       "as so: \n `[MODULE1=]FILE1[,[MODULE2]=FILE2...]`\n"
       "Run `gtirb-pprinter --help modules` for more details regarding "
@@ -132,9 +217,26 @@ int main(int argc, char** argv) {
                      "arm, arm64, att, intel, masm, mips32");
   desc.add_options()("layout,l", "Layout code and data in memory to "
                                  "avoid overlap");
+  desc.add_options()("incremental-layout",
+                     "When laying out a module, only move the byte intervals "
+                     "that have no address or overlap others.");
   desc.add_options()(
       "listing-mode", po::value<std::string>(),
       "The mode of use for the listing: assembler, ui, or debug");
+  desc.add_options()(
+      "function", po::value<std::string>()->value_name("NAME"),
+      "Print only the blocks of the function NAME, with the headers of their "
+      "sections. Only used when printing assembly.");
+  desc.add_options()(
+      "address-range", po::value<std::string>()->value_name("BEGIN-END"),
+      "Print only the blocks overlapping the addresses from BEGIN up to END "
+      "(e.g. 0x401000-0x401100), with the headers of their sections. Only "
+      "used when printing assembly.");
+  desc.add_options()("format-listing",
+                     po::value<std::string>()->default_value("asm"),
+                     "The format of the assembly output: asm, or jsonl to "
+                     "write one JSON object per section, label, instruction, "
+                     "and data block.");
   desc.add_options()(
       "policy,p", po::value<std::string>(),
       "The default set of objects to skip when printing assembly. To modify "
@@ -152,9 +254,17 @@ int main(int argc, char** argv) {
                      " by default (e.g. _start).");
   desc.add_options()("skip-function",
                      po::value<std::vector<std::string>>()->multitoken(),
-                     "Do not print the given function.");
+                     "Do not print the given function, or the functions "
+                     "matching the glob pattern given as 'glob:PATTERN' "
+                     "(e.g. 'glob:asan_*').");
   desc.add_options()("keep-all-functions",
                      "Do not use the default list of functions to skip.");
+  desc.add_options()(
+      "prune-unreachable",
+      "Also skip the functions that cannot be reached from the entry points "
+      "of the module: the entry block, the exported symbols, and the symbols "
+      "referenced from data (e.g. .init_array). Only used for ELF and PE "
+      "modules; --keep-function still prints a function.");
 
   desc.add_options()("keep-symbol",
                      po::value<std::vector<std::string>>()->multitoken(),
@@ -162,7 +272,9 @@ int main(int argc, char** argv) {
                      " by default (e.g. __TMC_END__).");
   desc.add_options()("skip-symbol",
                      po::value<std::vector<std::string>>()->multitoken(),
-                     "Do not print the given symbol.");
+                     "Do not print the given symbol, or the symbols "
+                     "matching the glob pattern given as 'glob:PATTERN' "
+                     "(e.g. 'glob:asan_*').");
   desc.add_options()("keep-all-symbols",
                      "Do not use the default list of symbols to skip.");
 
@@ -172,7 +284,9 @@ int main(int argc, char** argv) {
                      "default (e.g. .text).");
   desc.add_options()("skip-section",
                      po::value<std::vector<std::string>>()->multitoken(),
-                     "Do not print the given section.");
+                     "Do not print the given section, or the sections "
+                     "matching the glob pattern given as 'glob:PATTERN' "
+                     "(e.g. 'glob:asan_*').");
   desc.add_options()("keep-all-sections",
                      "Do not use the default list of sections to skip.");
 
@@ -192,6 +306,63 @@ int main(int argc, char** argv) {
   desc.add_options()("dummy-so", po::value<bool>()->default_value(false),
                      "Use artificial .so files for linking rather than actual "
                      "libraries. Only relevant for ELF executables.");
+  desc.add_options()(
+      "jobs,j", po::value<unsigned>()->value_name("N"),
+      "Maximum number of tool processes (e.g. building dummy .so files or "
+      "import libraries) to run concurrently while generating a binary. "
+      "Defaults to the number of hardware threads.");
+  desc.add_options()(
+      "stub-cache", po::value<std::string>()->value_name("DIR"),
+      "Cache the libraries generated for linking (--dummy-so libraries and "
+      "PE import libraries) in DIR, and reuse them when the same library is "
+      "needed again. The directory may be shared by concurrent runs.");
+  desc.add_options()(
+      "split-units", po::value<unsigned>()->value_name("N"),
+      "Split the assembly for a binary into up to N compilation units at "
+      "section and function boundaries, and assemble them concurrently "
+      "(see --jobs). Only x86 and x86-64 ELF binaries are split.");
+  desc.add_options()(
+      "output-cache", po::value<std::string>()->value_name("DIR"),
+      "Cache the binaries generated with --binary in DIR, keyed by the IR, "
+      "the command line, the libraries linked against, and the toolchain. "
+      "When the same binary is requested again it is copied from DIR instead "
+      "of being printed and linked.");
+  desc.add_options()(
+      "serve", po::value<std::string>()->value_name("SOCKET"),
+      "Load the IR once and answer requests to print its modules, functions, "
+      "or address ranges on the Unix domain socket SOCKET. Run "
+      "`gtirb-pprinter --help serve` for the format of the requests.");
+  desc.add_options()(
+      "batch", po::value<std::string>()->value_name("MANIFEST"),
+      "Run the jobs listed in the JSON file MANIFEST in this process, and "
+      "report which of them failed. Other options given on the command line "
+      "apply to every job. Run `gtirb-pprinter --help batch` for the format "
+      "of the manifest.");
+  desc.add_options()(
+      "batch-jobs", po::value<unsigned>()->value_name("N"),
+      "Maximum number of --batch jobs to run concurrently. Defaults to the "
+      "number of hardware threads.");
+  desc.add_options()(
+      "toolchain-cache", po::value<std::string>()->value_name("FILE"),
+      "Remember the locations of the compilers, assemblers, and linkers "
+      "found on PATH in FILE, and reuse them on later runs while PATH and "
+      "the tools are unchanged.");
+  desc.add_options()(
+      "function-cache", po::value<std::string>()->value_name("DIR"),
+      "Cache the assembly printed for each function in DIR, and reuse it for "
+      "functions that did not change since it was printed. Only x86 and "
+      "x86-64 ELF listings in assembler mode are cached.");
+  desc.add_options()(
+      "function-cache-size",
+      po::value<uint64_t>()->value_name("MB")->default_value(512),
+      "Evict the least recently used entries of the function cache when it "
+      "grows beyond MB megabytes.");
+  desc.add_options()(
+      "native-object",
+      "Write x86-64 ELF objects directly from the IR instead of running the "
+      "assembler on the printed listing. Modules that need the assembler "
+      "(e.g. for TLS relocations) are still assembled. Compiler arguments "
+      "are not applied to objects written directly.");
   desc.add_options()("use-gcc", po::value<std::string>(),
                      "Specify the gcc binary to use for ELF binary printing.");
   desc.add_options()(
@@ -207,17 +378,28 @@ int main(int argc, char** argv) {
       "as so: \n `[MODULE1=]FILE1[,[MODULE2]=FILE2...]`\n"
       "Run `gtirb-ppprinter --help modules` for more details regarding "
       "selecting modules and specifying file names.");
+  desc.add_options()(
+      "variant", po::value<std::vector<std::string>>()->value_name("SPEC"),
+      "Also print the output files as the variant "
+      "`NAME[:shared=MODE][,policy=POLICY]`, without loading the IR again. "
+      "The files of the variant have `.NAME` inserted before their "
+      "extension. May be given more than once.");
   po::positional_options_description pd;
   pd.add("ir", -1);
   po::variables_map vm;
+  po::parsed_options Parsed(&desc);
   try {
-    po::store(
-        po::command_line_parser(argc, argv).options(desc).positional(pd).run(),
-        vm);
+    Parsed =
+        po::command_line_parser(argc, argv).options(desc).positional(pd).run();
+    po::store(Parsed, vm);
     if (vm.count("help") != 0) {
       auto help_arg = vm["help"].as<std::string>();
       if (help_arg == "modules") {
         std::cout << gtirb_pprint_parser::module_help_message << "\n";
+      } else if (help_arg == "batch") {
+        std::cout << gtirb_pprint::batch_help_message << "\n";
+      } else if (help_arg == "serve") {
+        std::cout << gtirb_pprint::serve_help_message << "\n";
       } else {
         std::cout << desc << "\n";
       }
@@ -237,6 +419,45 @@ int main(int argc, char** argv) {
   }
   po::notify(vm);
 
+  if (vm.count("batch") != 0) {
+    if (InBatch) {
+      LOG_ERROR << "Batch jobs cannot run other batches.\n";
+      return EXIT_FAILURE;
+    }
+    if (vm.count("ir") != 0) {
+      LOG_ERROR << "The input of each batch job is given in the manifest.\n";
+      return EXIT_FAILURE;
+    }
+    std::vector<gtirb_pprint::BatchJob> Jobs;
+    try {
+      Jobs = gtirb_pprint::readBatchManifest(vm["batch"].as<std::string>());
+    } catch (const gtirb_pprint::batch_error& Err) {
+      LOG_ERROR << "Invalid batch manifest: " << Err.what() << "\n";
+      return EXIT_FAILURE;
+    }
+    // The remaining options are shared by all jobs.
+    std::vector<std::string> Shared;
+    for (const po::option& Option : Parsed.options) {
+      if (Option.string_key != "batch" && Option.string_key != "batch-jobs") {
+        Shared.insert(Shared.end(), Option.original_tokens.begin(),
+                      Option.original_tokens.end());
+      }
+    }
+    unsigned Threads =
+        vm.count("batch-jobs") != 0 ? vm["batch-jobs"].as<unsigned>() : 0;
+    return gtirb_pprint::runBatch(
+        Jobs, Threads, [&](const gtirb_pprint::BatchJob& Job) {
+          std::vector<const char*> Args = {argv[0]};
+          for (const std::string& Arg : Shared) {
+            Args.push_back(Arg.c_str());
+          }
+          for (const std::string& Arg : Job.Args) {
+            Args.push_back(Arg.c_str());
+          }
+          return run(static_cast<int>(Args.size()), Args.data(), true);
+        });
+  }
+
   class ContextForgetter {
     gtirb::Context ctx;
 
@@ -257,14 +478,42 @@ int main(int argc, char** argv) {
   } catch (const gtirb_pprint_parser::parse_error& /*err*/) {
     return EXIT_FAILURE;
   }
+  // Load the IR, transparently decompressing gzip or zstd input. Binaries
+  // in the output cache are keyed by a digest of the input.
+  std::string IrDigest;
+  auto loadIR = [&ctx, &vm, &IrDigest](std::istream& in) -> gtirb::IR* {
+    std::optional<gtirb_pprint::HashingInput> Hashed;
+    std::istream* Input = &in;
+    if (vm.count("output-cache") != 0) {
+      Input = &Hashed.emplace(in).stream();
+    }
+    gtirb_pprint::Compression Detected;
+    auto Stream = gtirb_pprint::openDecompressedInput(*Input, Detected);
+    if (!Stream) {
+      LOG_ERROR << "This build cannot read "
+                << gtirb_pprint::compressionName(Detected)
+                << " compressed GTIRB files.\n";
+      return nullptr;
+    }
+    if (Detected != gtirb_pprint::Compression::None) {
+      LOG_INFO << "Decompressing " << gtirb_pprint::compressionName(Detected)
+               << " input" << std::endl;
+    }
+    gtirb::ErrorOr<gtirb::IR*> iOrE = gtirb::IR::load(ctx, *Stream);
+    if (!iOrE)
+      return nullptr;
+    if (Hashed) {
+      IrDigest = Hashed->digest();
+    }
+    return *iOrE;
+  };
   if (vm.count("ir") != 0) {
     fs::path irPath = vm["ir"].as<std::string>();
     LOG_INFO << std::setw(24) << std::left << "Reading GTIRB file: " << irPath
              << std::endl;
     std::ifstream in(irPath.string(), std::ios::in | std::ios::binary);
     if (in) {
-      if (gtirb::ErrorOr<gtirb::IR*> iOrE = gtirb::IR::load(ctx, in))
-        ir = *iOrE;
+      ir = loadIR(in);
     } else {
       LOG_ERROR << "GTIRB file could not be opened: \"" << irPath << "\".\n";
       return EXIT_FAILURE;
@@ -274,9 +523,7 @@ int main(int argc, char** argv) {
       std::cout << desc << "\n";
       return EXIT_FAILURE;
     }
-    if (gtirb::ErrorOr<gtirb::IR*> iOrE = gtirb::IR::load(ctx, std::cin)) {
-      ir = *iOrE;
-    }
+    ir = loadIR(std::cin);
   }
   if (!ir) {
     LOG_ERROR << "Failed to load the GTIRB data from the file.\n";
@@ -287,8 +534,52 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  bool Serving = vm.count("serve") != 0;
+  std::optional<std::pair<gtirb::Addr, gtirb::Addr>> AddressRange;
+  if (vm.count("address-range") != 0) {
+    AddressRange = parseAddressRange(vm["address-range"].as<std::string>());
+    if (!AddressRange) {
+      LOG_ERROR << "Invalid address range: "
+                << vm["address-range"].as<std::string>() << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  const std::string& ListingFormat = vm["format-listing"].as<std::string>();
+  if (ListingFormat != "asm" && ListingFormat != "jsonl") {
+    LOG_ERROR << "Invalid listing format: " << ListingFormat
+              << " (should be either 'asm' or 'jsonl')\n";
+    return EXIT_FAILURE;
+  }
+  bool JsonListing = ListingFormat == "jsonl";
+  if (JsonListing && (Serving || vm.count("function") != 0 || AddressRange)) {
+    LOG_ERROR << "--format-listing=jsonl lists whole modules, and cannot be "
+                 "used with --serve, --function, or --address-range.\n";
+    return EXIT_FAILURE;
+  }
+  if (vm.count("function") != 0 || AddressRange) {
+    if (vm.count("function") != 0 && AddressRange) {
+      LOG_ERROR << "--function and --address-range cannot both be given.\n";
+      return EXIT_FAILURE;
+    }
+    if (Serving || vm.count("binary") != 0) {
+      LOG_ERROR << "--function and --address-range only select what is "
+                   "printed as assembly.\n";
+      return EXIT_FAILURE;
+    }
+  }
   std::vector<gtirb_pprint::ModulePrintingInfo> Modules;
-  if (vm.count("asm") || vm.count("binary") || vm.count("version-script")) {
+  bool HasOutputFiles = vm.count("asm") != 0 || vm.count("binary") != 0 ||
+                        vm.count("version-script") != 0;
+  if (vm.count("variant") != 0 && (Serving || !HasOutputFiles)) {
+    LOG_ERROR << "--variant requires output files, and cannot be used with "
+                 "--serve.\n";
+    return EXIT_FAILURE;
+  }
+  if (HasOutputFiles) {
+    if (Serving) {
+      LOG_ERROR << "Output files cannot be given with --serve.\n";
+      return EXIT_FAILURE;
+    }
     std::set<fs::path> Paths;
     for (auto& m : ir->modules()) {
       auto AsmName =
@@ -412,6 +703,10 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (vm.count("prune-unreachable") != 0) {
+    pp.setPruneUnreachable(true);
+  }
+
   if (vm.count("keep-all-symbols") != 0) {
     pp.symbolPolicy().useDefaults(false);
   }
@@ -466,26 +761,160 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  // The output of the command line is the first variant, which has no name.
+  std::vector<OutputVariant> Variants = {
+      {"", SharedOption, pp.getPolicyName()}};
+  if (vm.count("variant") != 0) {
+    for (const auto& Spec : vm["variant"].as<std::vector<std::string>>()) {
+      std::optional<OutputVariant> Variant = parseVariant(Spec, Variants[0]);
+      if (!Variant) {
+        LOG_ERROR << "Invalid variant: " << Spec << "\n";
+        return EXIT_FAILURE;
+      }
+      if (!(Variant->Shared == "yes" || Variant->Shared == "no" ||
+            Variant->Shared == "auto")) {
+        LOG_ERROR << "Invalid option for 'shared' in variant " << Variant->Name
+                  << ": " << Variant->Shared << "\n";
+        return EXIT_FAILURE;
+      }
+      if (Variant->Policy != "default" &&
+          !pp.namedPolicyExists(Variant->Policy)) {
+        LOG_ERROR << "Unknown policy '" << Variant->Policy << "' in variant "
+                  << Variant->Name << "\n";
+        return EXIT_FAILURE;
+      }
+      for (const auto& Other : Variants) {
+        if (Other.Name == Variant->Name) {
+          LOG_ERROR << "Variant " << Variant->Name << " is given twice\n";
+          return EXIT_FAILURE;
+        }
+      }
+      Variants.push_back(std::move(*Variant));
+    }
+  }
+
   bool EnableSymbolVersions = vm["symbol-versions"].as<bool>();
   if (!EnableSymbolVersions) {
     pp.setIgnoreSymbolVersions(!EnableSymbolVersions);
   }
 
+  if (vm.count("toolchain-cache") != 0) {
+    gtirb_bprint::ToolchainProbe::instance().load(
+        vm["toolchain-cache"].as<std::string>());
+  }
+
+  // The options a binary depends on, for the output cache. Options naming
+  // outputs or only affecting how the work is done are left out.
+  std::shared_ptr<gtirb_bprint::ArtifactCache> OutputCache;
+  std::string OptionsDigest;
+  if (vm.count("output-cache") != 0) {
+    OutputCache = std::make_shared<gtirb_bprint::ArtifactCache>(
+        vm["output-cache"].as<std::string>());
+    static const std::set<std::string> Ignored = {
+        "ir",           "asm",        "binary",         "version-script",
+        "output-cache", "stub-cache", "function-cache", "function-cache-size",
+        "jobs",         "toolchain-cache", "format-listing", "variant"};
+    gtirb_bprint::CacheKey Key;
+    Key.add(GTIRB_PPRINTER_VERSION_STRING).add(GTIRB_PPRINTER_BUILD_REVISION);
+    for (const po::option& Option : Parsed.options) {
+      if (Ignored.count(Option.string_key) == 0) {
+        Key.add(Option.string_key).add(Option.original_tokens.size());
+        for (const std::string& Token : Option.original_tokens) {
+          Key.add(Token);
+        }
+      }
+    }
+    OptionsDigest = Key.str();
+  }
+
+  std::shared_ptr<gtirb_bprint::ArtifactCache> FunctionCache;
+  if (vm.count("function-cache") != 0) {
+    FunctionCache = std::make_shared<gtirb_bprint::ArtifactCache>(
+        vm["function-cache"].as<std::string>());
+    pp.setFunctionCache(FunctionCache);
+  }
+
+  // Print the listing of a module, or only the function or address range
+  // selected on the command line, in the selected format.
+  auto printListing = [&](std::ostream& Stream,
+                          const gtirb::Module& M) -> int {
+    if (JsonListing) {
+      gtirb_pprint::JsonLinesSink Sink(Stream);
+      return pp.printEvents(Sink, ctx, M);
+    }
+    if (AddressRange) {
+      return pp.printAddressRange(Stream, ctx, M, AddressRange->first,
+                                  AddressRange->second);
+    }
+    if (vm.count("function") == 0) {
+      return pp.print(Stream, ctx, M);
+    }
+    const std::string& Name = vm["function"].as<std::string>();
+    for (const auto& [Function, SymbolUUID] : aux_data::getFunctionNames(M)) {
+      const auto* Symbol = nodeFromUUID<gtirb::Symbol>(ctx, SymbolUUID);
+      if (Symbol && Symbol->getName() == Name) {
+        return pp.printFunction(Stream, ctx, M, Function);
+      }
+    }
+    LOG_ERROR << "Module " << M.getName() << " has no function named " << Name
+              << "\n";
+    return -1;
+  };
+
   bool new_layout = false;
+  auto applyLayout = [&vm, &ctx](gtirb::Module& M) {
+    if (vm.count("incremental-layout")) {
+      gtirb_layout::layoutModuleIncremental(ctx, M);
+    } else {
+      gtirb_layout::layoutModule(ctx, M);
+    }
+  };
 
-  for (auto& MP : Modules) {
+  // Each module is printed once per variant. Between variants, the changes
+  // made to a module by the layout and the fixups are discarded, so that the
+  // next variant starts from the module as loaded.
+  std::vector<std::pair<const OutputVariant*, gtirb_pprint::ModulePrintingInfo>>
+      Outputs;
+  for (const auto& Variant : Variants) {
+    for (const auto& Info : Modules) {
+      Outputs.emplace_back(
+          &Variant,
+          gtirb_pprint::ModulePrintingInfo(
+              Info.Module, variantPath(Info.AsmName, Variant.Name),
+              variantPath(Info.BinaryName, Variant.Name),
+              variantPath(Info.VersionScriptName, Variant.Name)));
+    }
+  }
+  std::map<const gtirb::Module*, std::unique_ptr<gtirb_pprint::FixupOverlay>>
+      Overlays;
+
+  for (auto& [Variant, MP] : Outputs) {
     auto& M = *(MP.Module);
+    gtirb_pprint::FixupOverlay* Overlay = nullptr;
+    if (Variants.size() > 1) {
+      auto& Recorded = Overlays[&M];
+      if (!Recorded) {
+        Recorded = std::make_unique<gtirb_pprint::FixupOverlay>(M);
+      }
+      Recorded->discard();
+      Recorded->saveLayout();
+      Overlay = Recorded.get();
+      pp.setPolicyName(Variant->Policy);
+      if (!Variant->Name.empty()) {
+        LOG_INFO << "Printing variant " << Variant->Name << " of module "
+                 << M.getName() << "\n";
+      }
+    }
     // Layout IR in memory without overlap.
     if (vm.count("layout")) {
       LOG_INFO << "Applying new layout to module " << M.getUUID() << "..."
                << std::endl;
-      gtirb_layout::layoutModule(ctx, M);
+      applyLayout(M);
       new_layout = true;
     } else {
-      auto SkipSections = pp.getPolicy(M).skipSections;
-      pp.sectionPolicy().apply(SkipSections);
+      auto SkipSections = pp.skippedSections(M);
       if (gtirb_layout::layoutRequired(M, SkipSections)) {
-        gtirb_layout::layoutModule(ctx, M);
+        applyLayout(M);
         new_layout = true;
       }
     }
@@ -501,9 +930,13 @@ int main(int argc, char** argv) {
       }
     }
     // Update DynMode (-shared or -pie or none) for the module
-    pp.updateDynMode(M, SharedOption);
+    pp.updateDynMode(M, Variant->Shared);
     // Apply any needed fixups
-    applyFixups(ctx, M, pp);
+    applyFixups(ctx, M, pp, Overlay);
+    // The server prints the modules on request.
+    if (Serving) {
+      continue;
+    }
     // Write version script to a file
     if (MP.VersionScriptName) {
       LOG_INFO << "Generating version script for module " << M.getName()
@@ -537,12 +970,33 @@ int main(int argc, char** argv) {
       if (asmPath->has_parent_path()) {
         fs::create_directories(asmPath->parent_path());
       }
-      std::ofstream ofs(name);
-      if (ofs) {
-        if (pp.print(ofs, ctx, M)) {
-          LOG_INFO << "Assembly for module " << M.getName()
-                   << " written to: " << name << "\n";
+      std::unique_ptr<gtirb_bprint::OutputSink> Sink;
+      auto Compression = gtirb_pprint::compressionFromExtension(*asmPath);
+      if (Compression != gtirb_pprint::Compression::None) {
+        if (!gtirb_pprint::compressionSupported(Compression)) {
+          LOG_ERROR << "This build cannot write "
+                    << gtirb_pprint::compressionName(Compression)
+                    << " compressed assembly files.\n";
+          return EXIT_FAILURE;
+        }
+        Sink = gtirb_pprint::openCompressedFileSink(name, Compression);
+      } else {
+        Sink = gtirb_bprint::openFileSink(
+            name, gtirb_pprint::estimateListingSize(M));
+      }
+      gtirb_bprint::AsyncOutputStream ofs(std::move(Sink));
+      if (ofs.isOpen()) {
+        int Printed = printListing(ofs, M);
+        if (!ofs.close()) {
+          LOG_ERROR << "Could not write assembly output file: \"" << name
+                    << "\".\n";
+          return EXIT_FAILURE;
+        }
+        if (Printed != 0) {
+          return EXIT_FAILURE;
         }
+        LOG_INFO << "Assembly for module " << M.getName()
+                 << " written to: " << name << "\n";
       } else {
         LOG_ERROR << "Could not output assembly output file: \"" << name
                   << "\".\n";
@@ -575,6 +1029,33 @@ int main(int argc, char** argv) {
                   << "' is an unsupported binary printing format.\n";
         return EXIT_FAILURE;
       }
+      if (vm.count("jobs") != 0)
+        binaryPrinter->setJobs(vm["jobs"].as<unsigned>());
+      if (vm.count("stub-cache") != 0)
+        binaryPrinter->setStubCache(
+            std::make_shared<gtirb_bprint::ArtifactCache>(
+                vm["stub-cache"].as<std::string>()));
+      if (vm.count("native-object") != 0)
+        binaryPrinter->setNativeObject(true);
+      if (vm.count("split-units") != 0)
+        binaryPrinter->setSplitUnits(vm["split-units"].as<unsigned>());
+
+      std::string Key;
+      if (OutputCache) {
+        gtirb_bprint::CacheKey Builder;
+        Builder.add(vm.count("object") == 0 ? "binary" : "object");
+        Builder.add(IrDigest).add(boost::uuids::to_string(M.getUUID()));
+        Builder.add(OptionsDigest);
+        Builder.add(Variant->Name).add(Variant->Shared).add(Variant->Policy);
+        binaryPrinter->addBuildToKey(Builder, M);
+        Key = Builder.str();
+        if (OutputCache->fetch(Key, binaryPath->string())) {
+          LOG_INFO << "Output cache hit: copied " << binaryPath->string()
+                   << " from the cache.\n";
+          continue;
+        }
+        LOG_INFO << "Output cache miss for " << binaryPath->string() << "\n";
+      }
 
       int Errc;
       if (vm.count("object") == 0) {
@@ -586,13 +1067,42 @@ int main(int argc, char** argv) {
         LOG_ERROR << "Unable to assemble '" << binaryPath->string() << "'.\n";
         return EXIT_FAILURE;
       }
+      if (OutputCache) {
+        OutputCache->publish(Key, binaryPath->string());
+      }
     }
 
     // Write ASM to the standard output if no other action was taken.
     if ((vm.count("asm") == 0) && (vm.count("binary") == 0) &&
         (vm.count("version-script") == 0)) {
-      pp.print(std::cout, ctx, M);
+      if (printListing(std::cout, M) != 0) {
+        return EXIT_FAILURE;
+      }
     }
   }
+  if (Serving) {
+    return gtirb_pprint::serve(vm["serve"].as<std::string>(), ctx, *ir, pp,
+                               LstMode);
+  }
+  if (FunctionCache) {
+    FunctionCache->prune(vm["function-cache-size"].as<uint64_t>() << 20);
+  }
+  if (vm.count("toolchain-cache") != 0) {
+    gtirb_bprint::ToolchainProbe::instance().save(
+        vm["toolchain-cache"].as<std::string>());
+  }
   return EXIT_SUCCESS;
 }
+
+int main(int argc, char** argv) {
+  // Registration is shared by all the jobs of a batch.
+  gtirb_layout::registerAuxDataTypes();
+  gtirb_pprint::registerAuxDataTypes();
+  gtirb_pprint::registerPrettyPrinters();
+  try {
+    return run(argc, argv, false);
+  } catch (const gtirb_pprint::PrintError& Err) {
+    LOG_ERROR << Err.what() << "\n";
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,305 @@
+#include "serve.hpp"
+#include "Logger.h"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <tuple>
+
+namespace pt = boost::property_tree;
+
+namespace gtirb_pprint {
+
+namespace {
+
+class request_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// Sends the text printed for a request to the client as `{"text": ...}`
+// records while it is printed.
+class TextRecordBuffer : public std::streambuf {
+public:
+  explicit TextRecordBuffer(std::ostream& O) : Out(O) {}
+
+  // Send the text that was not sent yet.
+  void finish() {
+    if (!Pending.empty()) {
+      Out << "{\"text\":" << jsonQuote(Pending) << "}\n";
+      Pending.clear();
+    }
+  }
+
+protected:
+  int_type overflow(int_type C) override {
+    if (!traits_type::eq_int_type(C, traits_type::eof())) {
+      Pending.push_back(traits_type::to_char_type(C));
+      sendChunk();
+    }
+    return traits_type::not_eof(C);
+  }
+
+  std::streamsize xsputn(const char* S, std::streamsize N) override {
+    Pending.append(S, static_cast<size_t>(N));
+    sendChunk();
+    return N;
+  }
+
+private:
+  static constexpr size_t ChunkSize = 1 << 16;
+
+  std::ostream& Out;
+  std::string Pending;
+
+  // Printers flush their streams often, so text is only sent in chunks.
+  void sendChunk() {
+    if (Pending.size() >= ChunkSize) {
+      finish();
+    }
+  }
+};
+
+uint64_t parseAddress(const std::string& Text) {
+  size_t End = 0;
+  uint64_t Value = 0;
+  try {
+    Value = std::stoull(Text, &End, 0);
+  } catch (const std::logic_error&) {
+    End = 0;
+  }
+  if (Text.empty() || End != Text.size()) {
+    throw request_error("invalid address: " + Text);
+  }
+  return Value;
+}
+
+// Keeps the printers created for each module, syntax, and listing mode, and
+// the functions of each module, between requests. Printers are only kept to
+// print parts of modules; whole modules are printed by a new printer.
+class PrintServer {
+public:
+  PrintServer(gtirb::Context& C, const gtirb::IR& I, const PrettyPrinter& P,
+              std::string Mode)
+      : Context(C), Input(I), Base(P), DefaultMode(std::move(Mode)) {}
+
+  // Answer the request in Line, writing the response to Out. Returns false
+  // if the request asks the server to shut down.
+  bool answer(const std::string& Line, std::ostream& Out);
+
+private:
+  gtirb::Context& Context;
+  const gtirb::IR& Input;
+  const PrettyPrinter& Base;
+  std::string DefaultMode;
+
+  using PrinterKey =
+      std::tuple<const gtirb::Module*, std::string, std::string>;
+  std::map<PrinterKey, std::unique_ptr<PrettyPrinterBase>> Printers;
+  std::map<const gtirb::Module*, std::map<std::string, gtirb::UUID>> Functions;
+
+  const gtirb::Module& findModule(const std::string& Name) const;
+  PrettyPrinter configure(const gtirb::Module& Module,
+                          const std::string& Syntax,
+                          const std::string& Mode) const;
+  std::unique_ptr<PrettyPrinterBase> create(const PrettyPrinter& Printer,
+                                            const gtirb::Module& Module);
+  PrettyPrinterBase& printer(const gtirb::Module& Module,
+                             const std::string& Syntax,
+                             const std::string& Mode);
+  const gtirb::UUID& findFunction(const gtirb::Module& Module,
+                                  const std::string& Name);
+};
+
+const gtirb::Module& PrintServer::findModule(const std::string& Name) const {
+  for (const gtirb::Module& Module : Input.modules()) {
+    if (Name.empty() || Module.getName() == Name) {
+      return Module;
+    }
+  }
+  throw request_error("no module named " + Name);
+}
+
+// Configure a printer for the module in the syntax and listing mode.
+PrettyPrinter PrintServer::configure(const gtirb::Module& Module,
+                                     const std::string& Syntax,
+                                     const std::string& Mode) const {
+  PrettyPrinter Printer(Base);
+  if (!Printer.setListingMode(Mode)) {
+    throw request_error("invalid listing mode: " + Mode);
+  }
+  std::string Format = getModuleFileFormat(Module);
+  std::string ISA = getModuleISA(Module);
+  std::string Selected =
+      Syntax.empty() ? getDefaultSyntax(Format, ISA, Mode).value_or("")
+                     : Syntax;
+  TargetTy Target{Format, ISA, Selected};
+  if (getRegisteredTargets().count(Target) == 0) {
+    throw request_error("unsupported syntax for " + Format + " " + ISA +
+                        ": " + Selected);
+  }
+
+  Printer.setTarget(Target);
+  return Printer;
+}
+
+std::unique_ptr<PrettyPrinterBase>
+PrintServer::create(const PrettyPrinter& Printer, const gtirb::Module& Module) {
+  std::unique_ptr<PrettyPrinterBase> Created =
+      Printer.createPrinter(Context, Module);
+  if (!Created) {
+    throw request_error("module " + Module.getName() + " cannot be printed");
+  }
+  return Created;
+}
+
+PrettyPrinterBase& PrintServer::printer(const gtirb::Module& Module,
+                                        const std::string& Syntax,
+                                        const std::string& Mode) {
+  PrettyPrinter Printer = configure(Module, Syntax, Mode);
+  PrinterKey Key{&Module, std::get<2>(Printer.getTarget()), Mode};
+  if (auto It = Printers.find(Key); It != Printers.end()) {
+    return *It->second;
+  }
+  return *(Printers[Key] = create(Printer, Module));
+}
+
+const gtirb::UUID& PrintServer::findFunction(const gtirb::Module& Module,
+                                             const std::string& Name) {
+  auto [It, Inserted] = Functions.try_emplace(&Module);
+  std::map<std::string, gtirb::UUID>& ByName = It->second;
+  if (Inserted) {
+    for (const auto& [Function, SymbolUUID] :
+         aux_data::getFunctionNames(Module)) {
+      if (const auto* Symbol =
+              nodeFromUUID<gtirb::Symbol>(Context, SymbolUUID)) {
+        ByName[Symbol->getName()] = Function;
+      }
+    }
+  }
+  auto Found = ByName.find(Name);
+  if (Found == ByName.end()) {
+    throw request_error("no function named " + Name);
+  }
+  return Found->second;
+}
+
+bool PrintServer::answer(const std::string& Line, std::ostream& Out) {
+  bool Running = true;
+  try {
+    pt::ptree Request;
+    std::istringstream In(Line);
+    pt::read_json(In, Request);
+
+    if (Request.get<bool>("shutdown", false)) {
+      Running = false;
+    } else {
+      const gtirb::Module& Module =
+          findModule(Request.get<std::string>("module", ""));
+      std::string Syntax = Request.get<std::string>("syntax", "");
+      std::string Mode = Request.get<std::string>("listing-mode", DefaultMode);
+      auto Function = Request.get_optional<std::string>("function");
+      auto Begin = Request.get_optional<std::string>("begin");
+      auto End = Request.get_optional<std::string>("end");
+
+      TextRecordBuffer Buffer(Out);
+      std::ostream Text(&Buffer);
+      if (Function && (Begin || End)) {
+        throw request_error("a function and an address range cannot both be "
+                            "selected");
+      } else if (Function) {
+        PrettyPrinterBase& Printer = printer(Module, Syntax, Mode);
+        if (!Printer.printFunction(Text, findFunction(Module, *Function))) {
+          throw request_error("function " + *Function + " has no blocks");
+        }
+      } else if (Begin || End) {
+        gtirb::Addr First{Begin ? parseAddress(*Begin) : 0};
+        gtirb::Addr Last{End ? parseAddress(*End)
+                             : std::numeric_limits<uint64_t>::max()};
+        printer(Module, Syntax, Mode).printAddressRange(Text, First, Last);
+      } else {
+        // print() may only be called once on a printer.
+        create(configure(Module, Syntax, Mode), Module)->print(Text);
+      }
+      Buffer.finish();
+    }
+    Out << "{\"status\":\"ok\"}\n";
+  } catch (const std::exception& Err) {
+    // Requests are independent, so a failed request does not stop the
+    // server.
+    Out << "{\"status\":\"error\",\"message\":" << jsonQuote(Err.what())
+        << "}\n";
+  }
+  Out.flush();
+  return Running;
+}
+
+} // namespace
+
+int serve(const std::string& SocketPath, gtirb::Context& Context,
+          const gtirb::IR& IR, const PrettyPrinter& Printer,
+          const std::string& DefaultMode) {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+  namespace fs = boost::filesystem;
+  using boost::asio::local::stream_protocol;
+
+  boost::system::error_code EC;
+  // Remove the socket left behind by a previous server, if any.
+  if (fs::status(SocketPath, EC).type() == fs::socket_file) {
+    fs::remove(SocketPath, EC);
+  }
+
+  boost::asio::io_context IO;
+  stream_protocol::acceptor Acceptor(IO);
+  Acceptor.open(stream_protocol(), EC);
+  if (!EC) {
+    Acceptor.bind(stream_protocol::endpoint(SocketPath), EC);
+  }
+  if (!EC) {
+    Acceptor.listen(boost::asio::socket_base::max_listen_connections, EC);
+  }
+  if (EC) {
+    LOG_ERROR << "Cannot listen on " << SocketPath << ": " << EC.message()
+              << "\n";
+    return EXIT_FAILURE;
+  }
+  LOG_INFO << "Serving print requests on " << SocketPath << "\n";
+
+  PrintServer Server(Context, IR, Printer, DefaultMode);
+  int Status = EXIT_SUCCESS;
+  for (bool Running = true; Running;) {
+    stream_protocol::iostream Stream;
+    Acceptor.accept(Stream.socket(), EC);
+    if (EC) {
+      LOG_ERROR << "Cannot accept connections on " << SocketPath << ": "
+                << EC.message() << "\n";
+      Status = EXIT_FAILURE;
+      break;
+    }
+    for (std::string Line; Running && std::getline(Stream, Line);) {
+      if (!Line.empty()) {
+        Running = Server.answer(Line, Stream);
+      }
+    }
+  }
+  fs::remove(SocketPath, EC);
+  return Status;
+#else
+  (void)Context;
+  (void)IR;
+  (void)Printer;
+  (void)DefaultMode;
+  LOG_ERROR << "This build cannot serve requests on " << SocketPath
+            << ": Unix domain sockets are not supported.\n";
+  return EXIT_FAILURE;
+#endif // BOOST_ASIO_HAS_LOCAL_SOCKETS
+}
+
+} // namespace gtirb_pprint
@@ -0,0 +1,61 @@
+#ifndef GTIRB_PPRINT_SERVE_H
+#define GTIRB_PPRINT_SERVE_H
+#include <gtirb/IR.hpp>
+#include <gtirb_pprinter/PrettyPrinter.hpp>
+#include <string>
+#include <string_view>
+
+namespace gtirb_pprint {
+
+// width: 80; tab-width: 2
+static const std::string_view serve_help_message{R"""(
+`--serve SOCKET` loads the IR once and answers print requests on the Unix
+domain socket SOCKET until it receives a shutdown request. Clients connect to
+the socket and send requests, one JSON object per line:
+
+  {"module": "hello", "syntax": "intel", "listing-mode": "ui",
+   "function": "main"}
+
+All the fields are optional:
+
+  module        The name of the module to print. Defaults to the first module
+                of the IR.
+
+  syntax        The syntax to print, as for `--syntax`.
+
+  listing-mode  The listing mode, as for `--listing-mode`. Defaults to the
+                listing mode the server was started with.
+
+  function      Print only the blocks of the function with this name.
+
+  begin, end    Print only the blocks overlapping the addresses from `begin`
+                up to `end`, given as numbers or as strings such as "0x401000".
+                A function and an address range cannot both be selected.
+
+  shutdown      If true, stop the server.
+
+Without `function`, `begin`, or `end` the whole module is printed. Each
+response is a sequence of JSON objects, one per line: the printed text, in
+chunks, as `{"text": "..."}`, followed by `{"status": "ok"}` or by
+`{"status": "error", "message": "..."}`. Bytes of the text that are not ASCII
+are escaped as the code points U+0080 to U+00FF.
+
+The printers for each module, syntax, and listing mode are kept between
+requests. Clients are answered one connection at a time.
+)"""};
+
+/// @brief Answer print requests for the modules of \p IR on the Unix domain
+/// socket \p SocketPath, until a client asks the server to shut down.
+///
+/// The modules must already be laid out and fixed up for printing. Requests
+/// are printed with the configuration of \p Printer, except for the syntax
+/// and listing mode, which requests may select; \p DefaultMode is the
+/// listing mode of requests that do not.
+///
+/// @return EXIT_SUCCESS, or EXIT_FAILURE if the socket cannot be opened.
+int serve(const std::string& SocketPath, gtirb::Context& Context,
+          const gtirb::IR& IR, const PrettyPrinter& Printer,
+          const std::string& DefaultMode);
+
+} // namespace gtirb_pprint
+#endif // GTIRB_PPRINT_SERVE_H
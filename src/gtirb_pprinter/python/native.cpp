@@ -0,0 +1,174 @@
+// Native Python extension printing IR in-process, without spawning
+// gtirb-pprinter or writing the IR to disk. It is exposed to Python as
+// `gtirb_pprinter._native` and wrapped by `gtirb_pprinter.print_assembly`.
+#include "../driver/compression.hpp"
+#include <algorithm>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <fstream>
+#include <gtirb/IR.hpp>
+#include <gtirb_layout/gtirb_layout.hpp>
+#include <gtirb_pprinter/Fixup.hpp>
+#include <gtirb_pprinter/PrettyPrinter.hpp>
+#include <pybind11/pybind11.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+namespace {
+
+struct PrintOptions {
+  std::string Module;
+  std::string Syntax;
+  std::string ListingMode;
+};
+
+gtirb::Module& findModule(gtirb::IR& IR, const std::string& Name) {
+  for (gtirb::Module& Module : IR.modules()) {
+    if (Name.empty() || Module.getName() == Name) {
+      return Module;
+    }
+  }
+  throw std::invalid_argument(Name.empty() ? "the IR has no modules"
+                                           : "no module named " + Name);
+}
+
+// Print the assembly for a module of the IR read from Input, which may be
+// gzip or zstd compressed, preparing the module as the gtirb-pprinter driver
+// does.
+void printIR(std::istream& Input, std::ostream& Output,
+             const PrintOptions& Options) {
+  gtirb_pprint::Compression Detected;
+  auto Stream = gtirb_pprint::openDecompressedInput(Input, Detected);
+  if (!Stream) {
+    throw std::invalid_argument("this build cannot read " +
+                                gtirb_pprint::compressionName(Detected) +
+                                " compressed GTIRB data");
+  }
+  gtirb::Context Context;
+  gtirb::ErrorOr<gtirb::IR*> Loaded = gtirb::IR::load(Context, *Stream);
+  if (!Loaded) {
+    throw std::runtime_error("failed to load the GTIRB data");
+  }
+  gtirb::Module& Module = findModule(**Loaded, Options.Module);
+
+  gtirb_pprint::PrettyPrinter Printer;
+  if (!Printer.setListingMode(Options.ListingMode)) {
+    throw std::invalid_argument("invalid listing mode: " +
+                                Options.ListingMode);
+  }
+  std::string Format = gtirb_pprint::getModuleFileFormat(Module);
+  std::string ISA = gtirb_pprint::getModuleISA(Module);
+  std::string Syntax =
+      !Options.Syntax.empty()
+          ? Options.Syntax
+          : gtirb_pprint::getDefaultSyntax(Format, ISA, Options.ListingMode)
+                .value_or("");
+  gtirb_pprint::TargetTy Target{Format, ISA, Syntax};
+  if (gtirb_pprint::getRegisteredTargets().count(Target) == 0) {
+    throw std::invalid_argument("unsupported combination: format " + Format +
+                                ", ISA " + ISA + ", and syntax " + Syntax);
+  }
+  Printer.setTarget(std::move(Target));
+
+  auto SkipSections = Printer.skippedSections(Module);
+  if (gtirb_layout::layoutRequired(Module, SkipSections)) {
+    gtirb_layout::layoutModule(Context, Module);
+  } else if (std::any_of(Module.symbols_begin(), Module.symbols_end(),
+                         [](const gtirb::Symbol& Sym) {
+                           return !Sym.hasReferent() && Sym.getAddress();
+                         })) {
+    gtirb_layout::fixIntegralSymbols(Context, Module);
+  }
+  Printer.updateDynMode(Module, "auto");
+  gtirb_pprint::applyFixups(Context, Module, Printer);
+
+  if (Printer.print(Output, Context, Module) != 0) {
+    throw std::runtime_error("module " + Module.getName() +
+                             " cannot be printed");
+  }
+}
+
+// Load and print with the GIL released, then return the assembly, or write it
+// to OutputPath if it is not empty and return None.
+py::object printToPython(std::istream& Input, const std::string& OutputPath,
+                         const PrintOptions& Options) {
+  std::string Text;
+  {
+    py::gil_scoped_release Release;
+    if (!OutputPath.empty()) {
+      std::ofstream Output(OutputPath, std::ios::binary);
+      if (!Output) {
+        throw std::runtime_error("could not open " + OutputPath);
+      }
+      printIR(Input, Output, Options);
+      if (!Output.flush()) {
+        throw std::runtime_error("could not write " + OutputPath);
+      }
+    } else {
+      std::ostringstream Output;
+      printIR(Input, Output, Options);
+      Text = Output.str();
+    }
+  }
+  if (!OutputPath.empty()) {
+    return py::none();
+  }
+  return py::bytes(Text);
+}
+
+py::object printBytes(const py::buffer& Data, const std::string& OutputPath,
+                      const PrintOptions& Options) {
+  // The data is read in place: holding the buffer keeps the object alive and
+  // prevents resizing it while the GIL is released.
+  py::buffer_info Info = Data.request();
+  if (Info.ndim > 1 || (Info.ndim == 1 && Info.strides[0] != Info.itemsize)) {
+    throw std::invalid_argument("the GTIRB data must be contiguous");
+  }
+  boost::iostreams::stream<boost::iostreams::array_source> Input(
+      static_cast<const char*>(Info.ptr), Info.size * Info.itemsize);
+  return printToPython(Input, OutputPath, Options);
+}
+
+py::object printFile(const std::string& Path, const std::string& OutputPath,
+                     const PrintOptions& Options) {
+  std::ifstream Input(Path, std::ios::binary);
+  if (!Input) {
+    throw std::runtime_error("GTIRB file could not be opened: " + Path);
+  }
+  return printToPython(Input, OutputPath, Options);
+}
+
+} // namespace
+
+PYBIND11_MODULE(_native, M) {
+  M.doc() = "Print GTIRB to assembly in the calling process.";
+
+  gtirb_layout::registerAuxDataTypes();
+  gtirb_pprint::registerAuxDataTypes();
+  gtirb_pprint::registerPrettyPrinters();
+
+  // std::invalid_argument is raised as ValueError, other errors as
+  // RuntimeError.
+  M.def(
+      "print_bytes",
+      [](const py::buffer& Data, const std::string& Output,
+         const std::string& Module, const std::string& Syntax,
+         const std::string& ListingMode) {
+        return printBytes(Data, Output, {Module, Syntax, ListingMode});
+      },
+      py::arg("data"), py::arg("output") = "", py::arg("module") = "",
+      py::arg("syntax") = "", py::arg("listing_mode") = "",
+      "Print a module of the serialized IR in the bytes-like object data.");
+  M.def(
+      "print_file",
+      [](const std::string& Path, const std::string& Output,
+         const std::string& Module, const std::string& Syntax,
+         const std::string& ListingMode) {
+        return printFile(Path, Output, {Module, Syntax, ListingMode});
+      },
+      py::arg("path"), py::arg("output") = "", py::arg("module") = "",
+      py::arg("syntax") = "", py::arg("listing_mode") = "",
+      "Print a module of the IR in the GTIRB file at path.");
+}
@@ -0,0 +1,117 @@
+//===- elf_object_writer_test.cpp -------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <gtirb_pprinter/ElfObjectWriter.hpp>
+#include <iterator>
+
+using namespace gtirb_bprint;
+
+namespace {
+std::string writeObject(const ElfObject& Object) {
+  auto Path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("object-%%%%-%%%%.o");
+  EXPECT_TRUE(writeElfObject(Path.string(), Object));
+  std::ifstream In(Path.string(), std::ios::binary);
+  std::string Data((std::istreambuf_iterator<char>(In)),
+                   std::istreambuf_iterator<char>());
+  In.close();
+  boost::filesystem::remove(Path);
+  return Data;
+}
+
+template <typename T> T read(const std::string& Data, size_t Offset) {
+  T Value;
+  std::memcpy(&Value, Data.data() + Offset, sizeof(T));
+  return Value;
+}
+
+// Offset of the header of section Index.
+size_t sectionHeader(const std::string& Data, size_t Index) {
+  return read<uint64_t>(Data, 40) + Index * 64;
+}
+
+ElfObject exampleObject() {
+  ElfObject Object;
+  // call puts; ret
+  ElfObjectSection Text{".text", 1, 6, 16, {0xe8, 0, 0, 0, 0, 0xc3}, 0, {}};
+  ElfObjectSection Bss{".bss", 8, 3, 8, {}, 32, {}};
+  Object.Sections = {Text, Bss};
+
+  ElfObjectSymbol Main{"main", ElfObjectSymbolKind::Defined, 0, 0, 6, 2, 1, 0};
+  ElfObjectSymbol Puts{"puts", ElfObjectSymbolKind::Undefined, 0, 0, 0, 0, 1,
+                       0};
+  ElfObjectSymbol Buffer{"buffer", ElfObjectSymbolKind::Defined, 1, 0, 32, 1,
+                         0, 0};
+  Object.Symbols = {Main, Puts, Buffer};
+  Object.Sections[0].Relocations.push_back(
+      {1, 1, ElfRelocationType::X86_64_PLT32, -4});
+  return Object;
+}
+} // namespace
+
+TEST(Unit_ElfObjectWriter, TestHeader) {
+  std::string Data = writeObject(exampleObject());
+  ASSERT_GE(Data.size(), 64u);
+  EXPECT_EQ(Data.substr(0, 4), "\x7f"
+                               "ELF");
+  EXPECT_EQ(Data[4], 2);                   // ELFCLASS64
+  EXPECT_EQ(read<uint16_t>(Data, 16), 1);  // ET_REL
+  EXPECT_EQ(read<uint16_t>(Data, 18), 62); // EM_X86_64
+  EXPECT_EQ(read<uint16_t>(Data, 56), 0);  // e_phnum
+
+  // .text, .bss, .rela.text, .symtab, .strtab, .shstrtab
+  uint16_t ShNum = read<uint16_t>(Data, 60);
+  EXPECT_EQ(ShNum, 7);
+  EXPECT_EQ(read<uint64_t>(Data, 40) + ShNum * 64u, Data.size());
+}
+
+TEST(Unit_ElfObjectWriter, TestSections) {
+  std::string Data = writeObject(exampleObject());
+  size_t Text = sectionHeader(Data, 1);
+  EXPECT_EQ(read<uint64_t>(Data, Text + 32), 6u); // sh_size
+  uint64_t TextOff = read<uint64_t>(Data, Text + 24);
+  EXPECT_EQ(TextOff % 16, 0u);
+  EXPECT_EQ(static_cast<uint8_t>(Data[TextOff]), 0xe8);
+
+  size_t Bss = sectionHeader(Data, 2);
+  EXPECT_EQ(read<uint32_t>(Data, Bss + 4), 8u);   // SHT_NOBITS
+  EXPECT_EQ(read<uint64_t>(Data, Bss + 32), 32u); // sh_size
+
+  size_t Rela = sectionHeader(Data, 3);
+  EXPECT_EQ(read<uint32_t>(Data, Rela + 4), 4u);  // SHT_RELA
+  EXPECT_EQ(read<uint32_t>(Data, Rela + 40), 4u); // sh_link: .symtab
+  EXPECT_EQ(read<uint32_t>(Data, Rela + 44), 1u); // sh_info: .text
+  uint64_t RelaOff = read<uint64_t>(Data, Rela + 24);
+  EXPECT_EQ(read<uint64_t>(Data, RelaOff), 1u);
+  uint64_t Info = read<uint64_t>(Data, RelaOff + 8);
+  EXPECT_EQ(Info & 0xffffffff, 4u); // R_X86_64_PLT32
+  EXPECT_EQ(read<int64_t>(Data, RelaOff + 16), -4);
+
+  // The relocation refers to puts, which follows the local buffer symbol.
+  size_t SymTab = sectionHeader(Data, 4);
+  EXPECT_EQ(read<uint32_t>(Data, SymTab + 44), 2u); // first global
+  EXPECT_EQ(Info >> 32, 3u);
+}
+
+TEST(Unit_ElfObjectWriter, TestStrings) {
+  std::string Data = writeObject(exampleObject());
+  for (const char* S :
+       {"main", "puts", "buffer", ".text", ".rela.text", ".symtab"}) {
+    EXPECT_NE(Data.find(std::string(S) + '\0'), std::string::npos) << S;
+  }
+}
@@ -0,0 +1,96 @@
+//===- elf_stub_writer_test.cpp ---------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <gtirb_pprinter/ElfStubWriter.hpp>
+#include <iterator>
+
+using namespace gtirb_bprint;
+
+namespace {
+std::string writeStub(ElfStubMachine Machine,
+                      const std::vector<ElfStubGroup>& Groups) {
+  auto Path = boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("stub-%%%%-%%%%.so");
+  EXPECT_TRUE(writeElfStub(Path.string(), "libstub.so.1", Machine, Groups));
+  std::ifstream In(Path.string(), std::ios::binary);
+  std::string Data((std::istreambuf_iterator<char>(In)),
+                   std::istreambuf_iterator<char>());
+  In.close();
+  boost::filesystem::remove(Path);
+  return Data;
+}
+
+template <typename T> T read(const std::string& Data, size_t Offset) {
+  T Value;
+  std::memcpy(&Value, Data.data() + Offset, sizeof(T));
+  return Value;
+}
+
+std::vector<ElfStubGroup> exampleGroups() {
+  ElfStubSymbol Func{"func", "", false, ElfStubSymbolType::Func, false, 0};
+  ElfStubSymbol Data{"data", "VER_1", false, ElfStubSymbolType::Object, true,
+                     8};
+  ElfStubSymbol Old{"data", "VER_0", true, ElfStubSymbolType::Object, false,
+                    8};
+  return {{true, 4, {Func}}, {false, 8, {Data, Old}}};
+}
+} // namespace
+
+TEST(Unit_ElfStubWriter, TestElf64Header) {
+  std::string Data = writeStub(ElfStubMachine::X86_64, exampleGroups());
+  ASSERT_GE(Data.size(), 64u);
+  EXPECT_EQ(Data.substr(0, 4), "\x7f"
+                               "ELF");
+  EXPECT_EQ(Data[4], 2); // ELFCLASS64
+  EXPECT_EQ(Data[5], 1); // ELFDATA2LSB
+  EXPECT_EQ(read<uint16_t>(Data, 16), 3);  // ET_DYN
+  EXPECT_EQ(read<uint16_t>(Data, 18), 62); // EM_X86_64
+  EXPECT_EQ(read<uint16_t>(Data, 56), 3);  // e_phnum
+
+  // The section headers fit in the file.
+  uint64_t ShOff = read<uint64_t>(Data, 40);
+  uint16_t ShNum = read<uint16_t>(Data, 60);
+  EXPECT_EQ(ShOff + ShNum * 64u, Data.size());
+}
+
+TEST(Unit_ElfStubWriter, TestElf32Header) {
+  std::string Data = writeStub(ElfStubMachine::X86, exampleGroups());
+  ASSERT_GE(Data.size(), 52u);
+  EXPECT_EQ(Data[4], 1);                  // ELFCLASS32
+  EXPECT_EQ(read<uint16_t>(Data, 18), 3); // EM_386
+  uint32_t ShOff = read<uint32_t>(Data, 32);
+  uint16_t ShNum = read<uint16_t>(Data, 48);
+  EXPECT_EQ(ShOff + ShNum * 40u, Data.size());
+}
+
+TEST(Unit_ElfStubWriter, TestStrings) {
+  std::string Data = writeStub(ElfStubMachine::AArch64, exampleGroups());
+  EXPECT_EQ(read<uint16_t>(Data, 18), 183); // EM_AARCH64
+  for (const char* S : {"libstub.so.1", "func", "data", "VER_0", "VER_1",
+                        ".dynsym", ".gnu.version_d"}) {
+    EXPECT_NE(Data.find(std::string(S) + '\0'), std::string::npos) << S;
+  }
+}
+
+TEST(Unit_ElfStubWriter, TestUnversioned) {
+  ElfStubSymbol Func{"func", "", false, ElfStubSymbolType::Func, false, 0};
+  std::string Data = writeStub(ElfStubMachine::X86_64, {{true, 4, {Func}}});
+  // Without versioned symbols there is no version information.
+  EXPECT_EQ(Data.find(".gnu.version"), std::string::npos);
+  EXPECT_NE(Data.find(".dynamic"), std::string::npos);
+}
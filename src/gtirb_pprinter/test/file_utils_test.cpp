@@ -0,0 +1,169 @@
+//===- file_utils_test.cpp --------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <gtirb_pprinter/FileUtils.hpp>
+#include <iterator>
+
+namespace fs = boost::filesystem;
+using namespace gtirb_bprint;
+
+namespace {
+// A temporary directory removed with its contents at the end of a test.
+class TempDirectory {
+public:
+  TempDirectory()
+      : Path(fs::temp_directory_path() /
+             fs::unique_path("file-utils-%%%%-%%%%")) {
+    fs::create_directories(Path);
+  }
+  ~TempDirectory() {
+    boost::system::error_code EC;
+    fs::remove_all(Path, EC);
+  }
+  fs::path Path;
+};
+
+void writeFile(const fs::path& Path, const std::string& Contents) {
+  fs::create_directories(Path.parent_path());
+  std::ofstream Out(Path.string(), std::ios::binary);
+  Out << Contents;
+}
+} // namespace
+
+TEST(Unit_LibraryIndex, FirstDirectoryWins) {
+  TempDirectory Temp;
+  writeFile(Temp.Path / "a" / "libfoo.so", "a");
+  writeFile(Temp.Path / "b" / "libfoo.so", "b");
+  writeFile(Temp.Path / "b" / "libbar.so", "b");
+  std::vector<std::string> Dirs = {(Temp.Path / "missing").string(),
+                                   (Temp.Path / "a").string(),
+                                   (Temp.Path / "b").string()};
+
+  LibraryIndex Index;
+  EXPECT_EQ(Index.find(Dirs, "libfoo.so"),
+            (Temp.Path / "a" / "libfoo.so").string());
+  EXPECT_EQ(Index.find(Dirs, "libbar.so"),
+            (Temp.Path / "b" / "libbar.so").string());
+}
+
+TEST(Unit_LibraryIndex, SymlinkResolvesToRegularFile) {
+  TempDirectory Temp;
+  writeFile(Temp.Path / "libfoo.so.1.2", "foo");
+  fs::create_symlink("libfoo.so.1.2", Temp.Path / "libfoo.so.1");
+  fs::create_symlink("libfoo.so.1", Temp.Path / "libfoo.so");
+  // A link to a directory is not a library.
+  fs::create_directories(Temp.Path / "dir");
+  fs::create_symlink("dir", Temp.Path / "libdir.so");
+
+  LibraryIndex Index;
+  std::vector<std::string> Dirs = {Temp.Path.string()};
+  EXPECT_EQ(Index.find(Dirs, "libfoo.so"),
+            (Temp.Path / "libfoo.so.1.2").string());
+  EXPECT_EQ(Index.find(Dirs, "libfoo.so.1"),
+            (Temp.Path / "libfoo.so.1.2").string());
+  EXPECT_EQ(Index.find(Dirs, "libdir.so"), std::nullopt);
+}
+
+TEST(Unit_LibraryIndex, MissingName) {
+  TempDirectory Temp;
+  writeFile(Temp.Path / "libfoo.so", "foo");
+
+  LibraryIndex Index;
+  std::vector<std::string> Dirs = {Temp.Path.string()};
+  EXPECT_EQ(Index.find(Dirs, "libbar.so"), std::nullopt);
+  EXPECT_EQ(Index.find({}, "libfoo.so"), std::nullopt);
+}
+
+TEST(Unit_LibraryIndex, NamesLookedUpDirectly) {
+  TempDirectory Temp;
+  writeFile(Temp.Path / "sub" / "libfoo.so", "foo");
+
+  LibraryIndex Index;
+  EXPECT_EQ(Index.find({Temp.Path.string()}, "sub/libfoo.so"),
+            (Temp.Path / "sub" / "libfoo.so").string());
+
+  // An empty directory path is the current directory.
+  fs::path Cwd = fs::current_path();
+  fs::current_path(Temp.Path / "sub");
+  auto Found = Index.find({""}, "libfoo.so");
+  fs::current_path(Cwd);
+  EXPECT_EQ(Found, std::string("libfoo.so"));
+}
+
+namespace {
+std::string readFile(const fs::path& Path) {
+  std::ifstream In(Path.string(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(In),
+                     std::istreambuf_iterator<char>());
+}
+
+// Write Lines lines through an AsyncOutputStream to Path, returning the text
+// written.
+std::string writeLines(const fs::path& Path, uint64_t EstimatedSize,
+                       size_t Lines) {
+  std::string Expected;
+  AsyncOutputStream Out(openFileSink(Path.string(), EstimatedSize));
+  EXPECT_TRUE(Out.isOpen());
+  for (size_t I = 0; I < Lines; ++I) {
+    std::string Line = "  mov rax, " + std::to_string(I) + "\n";
+    Out << Line;
+    Expected += Line;
+  }
+  EXPECT_TRUE(Out.close());
+  return Expected;
+}
+
+class FailingSink : public OutputSink {
+public:
+  bool write(const std::vector<std::string_view>&) override { return false; }
+  bool close() override { return true; }
+};
+} // namespace
+
+TEST(Unit_AsyncOutputStream, WritesFile) {
+  TempDirectory Temp;
+  fs::path Path = Temp.Path / "out.s";
+  // Enough output to fill many buffers.
+  std::string Expected = writeLines(Path, 0, 200000);
+  EXPECT_EQ(fs::file_size(Path), Expected.size());
+  EXPECT_EQ(readFile(Path), Expected);
+}
+
+TEST(Unit_AsyncOutputStream, PreallocatedFileIsTruncated) {
+  TempDirectory Temp;
+  fs::path Over = Temp.Path / "over.s", Under = Temp.Path / "under.s";
+  std::string Expected = writeLines(Over, 64 << 20, 1000);
+  EXPECT_EQ(fs::file_size(Over), Expected.size());
+  EXPECT_EQ(readFile(Over), Expected);
+
+  Expected = writeLines(Under, 16, 100000);
+  EXPECT_EQ(fs::file_size(Under), Expected.size());
+  EXPECT_EQ(readFile(Under), Expected);
+}
+
+TEST(Unit_AsyncOutputStream, ReportsWriteErrors) {
+  AsyncOutputStream Out(std::make_unique<FailingSink>());
+  Out << std::string(1 << 20, 'x');
+  EXPECT_FALSE(Out.close());
+  EXPECT_TRUE(Out.bad());
+}
+
+TEST(Unit_AsyncOutputStream, CannotOpenFile) {
+  TempDirectory Temp;
+  EXPECT_EQ(openFileSink((Temp.Path / "missing" / "out.s").string()),
+            nullptr);
+}
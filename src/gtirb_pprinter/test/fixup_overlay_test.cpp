@@ -0,0 +1,188 @@
+//===- fixup_overlay_test.cpp -----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtest/gtest.h>
+#include <gtirb/gtirb.hpp>
+#include <gtirb_layout/gtirb_layout.hpp>
+#include <gtirb_pprinter/AuxDataSchema.hpp>
+#include <gtirb_pprinter/AuxDataUtils.hpp>
+#include <gtirb_pprinter/Fixup.hpp>
+#include <gtirb_pprinter/FixupOverlay.hpp>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <tuple>
+
+using namespace gtirb_pprint;
+
+namespace {
+// The parts of a module that the fixups and the layout change.
+struct ModuleState {
+  std::map<gtirb::UUID, std::tuple<std::string, const gtirb::Node*,
+                                   std::optional<gtirb::Addr>>>
+      Symbols;
+  std::map<std::pair<gtirb::UUID, uint64_t>, gtirb::SymbolicExpression>
+      Expressions;
+  gtirb::schema::ElfSymbolInfo::Type ElfSymbolInfo;
+  std::map<gtirb::UUID, std::optional<gtirb::Addr>> Intervals;
+  size_t ProxyBlocks = 0;
+  size_t CodeBlocks = 0;
+  size_t DataBlocks = 0;
+};
+
+ModuleState snapshot(gtirb::Module& M) {
+  ModuleState State;
+  for (const gtirb::Symbol& Sym : M.symbols()) {
+    State.Symbols.emplace(
+        Sym.getUUID(),
+        std::make_tuple(Sym.getName(), Sym.getReferent<gtirb::Node>(),
+                        Sym.hasReferent() ? std::nullopt : Sym.getAddress()));
+  }
+  for (const gtirb::ByteInterval& BI : M.byte_intervals()) {
+    State.Intervals.emplace(BI.getUUID(), BI.getAddress());
+    for (const auto& SEE : BI.symbolic_expressions()) {
+      State.Expressions.emplace(std::make_pair(BI.getUUID(), SEE.getOffset()),
+                                SEE.getSymbolicExpression());
+    }
+  }
+  if (const auto* Info = M.getAuxData<gtirb::schema::ElfSymbolInfo>()) {
+    State.ElfSymbolInfo = *Info;
+  }
+  State.ProxyBlocks = std::distance(M.proxy_blocks().begin(),
+                                    M.proxy_blocks().end());
+  State.CodeBlocks =
+      std::distance(M.code_blocks().begin(), M.code_blocks().end());
+  State.DataBlocks =
+      std::distance(M.data_blocks().begin(), M.data_blocks().end());
+  return State;
+}
+
+void expectSameState(const ModuleState& Expected, const ModuleState& Actual) {
+  EXPECT_TRUE(Expected.Symbols == Actual.Symbols);
+  EXPECT_TRUE(Expected.Expressions == Actual.Expressions);
+  EXPECT_EQ(Expected.ElfSymbolInfo, Actual.ElfSymbolInfo);
+  EXPECT_TRUE(Expected.Intervals == Actual.Intervals);
+  EXPECT_EQ(Expected.ProxyBlocks, Actual.ProxyBlocks);
+  EXPECT_EQ(Expected.CodeBlocks, Actual.CodeBlocks);
+  EXPECT_EQ(Expected.DataBlocks, Actual.DataBlocks);
+}
+
+void setInfo(gtirb::Symbol& Sym, const std::string& Type,
+             const std::string& Binding) {
+  aux_data::ElfSymbolInfo Info({0, Type, Binding, "DEFAULT", 0});
+  aux_data::setElfSymbolInfo(Sym, Info);
+}
+} // namespace
+
+TEST(Unit_FixupOverlay, DiscardElfSharedObjectFixups) {
+  gtirb::Context Ctx;
+  auto* M = gtirb::Module::Create(Ctx, "test");
+  M->setFileFormat(gtirb::FileFormat::ELF);
+  M->setISA(gtirb::ISA::X64);
+  M->addAuxData<gtirb::schema::ElfSymbolInfo>({});
+
+  auto* Text = M->addSection(Ctx, ".text")
+                   ->addByteInterval(Ctx, gtirb::Addr(0x1000), 16);
+  auto* Code = Text->addBlock<gtirb::CodeBlock>(Ctx, 0, 16);
+  auto* Data = M->addSection(Ctx, ".data")
+                   ->addByteInterval(Ctx, gtirb::Addr(0x2000), 8)
+                   ->addBlock<gtirb::DataBlock>(Ctx, 0, 8);
+
+  // A global variable, referenced directly and through a difference.
+  auto* Var = M->addSymbol(Ctx, Data, "var");
+  setInfo(*Var, "OBJECT", "GLOBAL");
+  // An undefined function, which must be called through the PLT.
+  auto* Fun = M->addSymbol(Ctx, M->addProxyBlock(Ctx), "fun");
+  setInfo(*Fun, "FUNC", "GLOBAL");
+  // A local main, which is promoted.
+  auto* Main = M->addSymbol(Ctx, Code, "main");
+  setInfo(*Main, "FUNC", "LOCAL");
+  // An integral symbol, which gets a 0-length block as its referent.
+  M->addSymbol(Ctx, gtirb::Addr(0x1008), "inner");
+
+  Text->addSymbolicExpression<gtirb::SymAddrConst>(2, 0, Var);
+  Text->addSymbolicExpression<gtirb::SymAddrConst>(6, 0, Fun);
+  Text->addSymbolicExpression<gtirb::SymAddrAddr>(10, 1, 0, Var, Main);
+
+  ModuleState Before = snapshot(*M);
+
+  FixupOverlay Overlay(*M);
+  Overlay.saveLayout();
+  gtirb_layout::fixIntegralSymbols(Ctx, *M);
+  fixupELFSymbols(Ctx, *M, &Overlay);
+  fixupSharedObject(Ctx, *M, &Overlay);
+  EXPECT_FALSE(Overlay.empty());
+
+  // The fixups did change the module.
+  ModuleState Fixed = snapshot(*M);
+  EXPECT_EQ(Fixed.Symbols.size(), Before.Symbols.size() + 1);
+  EXPECT_FALSE(Fixed.Expressions == Before.Expressions);
+  EXPECT_FALSE(Fixed.ElfSymbolInfo == Before.ElfSymbolInfo);
+  EXPECT_EQ(Fixed.CodeBlocks, Before.CodeBlocks + 1);
+
+  Overlay.discard();
+  EXPECT_TRUE(Overlay.empty());
+  expectSameState(Before, snapshot(*M));
+
+  // Discarding again changes nothing.
+  Overlay.discard();
+  expectSameState(Before, snapshot(*M));
+}
+
+TEST(Unit_FixupOverlay, DiscardLayout) {
+  gtirb::Context Ctx;
+  auto* M = gtirb::Module::Create(Ctx, "test");
+  M->setFileFormat(gtirb::FileFormat::ELF);
+  M->setISA(gtirb::ISA::X64);
+  auto* Text = M->addSection(Ctx, ".text")
+                   ->addByteInterval(Ctx, gtirb::Addr(0x1000), 16);
+  Text->addBlock<gtirb::CodeBlock>(Ctx, 0, 16);
+  M->addSection(Ctx, ".data")
+      ->addByteInterval(Ctx, gtirb::Addr(0x1008), 8)
+      ->addBlock<gtirb::DataBlock>(Ctx, 0, 8);
+  M->addSymbol(Ctx, gtirb::Addr(0x1004), "inner");
+
+  ModuleState Before = snapshot(*M);
+
+  FixupOverlay Overlay(*M);
+  Overlay.saveLayout();
+  ASSERT_TRUE(gtirb_layout::layoutModule(Ctx, *M));
+  EXPECT_FALSE(snapshot(*M).Intervals == Before.Intervals);
+
+  Overlay.discard();
+  expectSameState(Before, snapshot(*M));
+}
+
+TEST(Unit_FixupOverlay, DiscardPeImageBase) {
+  gtirb::Context Ctx;
+  auto* M = gtirb::Module::Create(Ctx, "test");
+  M->setFileFormat(gtirb::FileFormat::PE);
+  M->setISA(gtirb::ISA::IA32);
+  // __ImageBase has neither a referent nor an address; the fixup gives it a
+  // proxy block, which is removed again with the overlay.
+  auto* ImageBase = M->addSymbol(Ctx, "__ImageBase");
+
+  ModuleState Before = snapshot(*M);
+
+  FixupOverlay Overlay(*M);
+  fixupPESymbols(Ctx, *M, &Overlay);
+  EXPECT_EQ(ImageBase->getName(), "___ImageBase");
+  EXPECT_TRUE(ImageBase->getReferent<gtirb::ProxyBlock>());
+
+  Overlay.discard();
+  expectSameState(Before, snapshot(*M));
+  EXPECT_EQ(ImageBase->getName(), "__ImageBase");
+  EXPECT_EQ(ImageBase->getReferent<gtirb::Node>(), nullptr);
+  EXPECT_FALSE(ImageBase->getAddress());
+}
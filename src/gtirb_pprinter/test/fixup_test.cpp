@@ -0,0 +1,131 @@
+//===- fixup_test.cpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtest/gtest.h>
+#include <gtirb/gtirb.hpp>
+#include <gtirb_pprinter/AuxDataSchema.hpp>
+#include <gtirb_pprinter/AuxDataUtils.hpp>
+#include <gtirb_pprinter/Fixup.hpp>
+#include <iterator>
+#include <vector>
+
+using namespace gtirb_pprint;
+
+namespace {
+const std::string AliasPrefix = ".gtirb_pprinter.hidden_alias.";
+
+void setInfo(gtirb::Symbol& Sym, const std::string& Type,
+             const std::string& Binding) {
+  aux_data::ElfSymbolInfo Info({0, Type, Binding, "DEFAULT", 0});
+  aux_data::setElfSymbolInfo(Sym, Info);
+}
+
+gtirb::Module* createSharedObject(gtirb::Context& Ctx) {
+  auto* M = gtirb::Module::Create(Ctx, "test");
+  M->setFileFormat(gtirb::FileFormat::ELF);
+  M->setISA(gtirb::ISA::X64);
+  M->addAuxData<gtirb::schema::ElfSymbolInfo>({});
+  return M;
+}
+
+// Add a global variable, which code must reference through a hidden alias.
+gtirb::Symbol* addGlobalVariable(gtirb::Context& Ctx, gtirb::Module& M) {
+  auto* Data = M.addSection(Ctx, ".data")
+                   ->addByteInterval(Ctx, gtirb::Addr(0x100000), 8)
+                   ->addBlock<gtirb::DataBlock>(Ctx, 0, 8);
+  auto* Var = M.addSymbol(Ctx, Data, "var");
+  setInfo(*Var, "OBJECT", "GLOBAL");
+  return Var;
+}
+
+// Add an undefined function, which code must call through the PLT.
+gtirb::Symbol* addUndefinedFunction(gtirb::Context& Ctx, gtirb::Module& M) {
+  auto* Fun = M.addSymbol(Ctx, M.addProxyBlock(Ctx), "fun");
+  setInfo(*Fun, "FUNC", "GLOBAL");
+  return Fun;
+}
+
+size_t countSymbols(gtirb::Module& M, const std::string& Name) {
+  auto Symbols = M.findSymbols(Name);
+  return std::distance(Symbols.begin(), Symbols.end());
+}
+} // namespace
+
+TEST(Unit_Fixup, SharedObjectIntervalsInParallel) {
+  gtirb::Context Ctx;
+  auto* M = createSharedObject(Ctx);
+  auto* Var = addGlobalVariable(Ctx, *M);
+  auto* Fun = addUndefinedFunction(Ctx, *M);
+
+  // Enough intervals with code for the analysis to use several workers,
+  // each referencing the same variable and function.
+  auto* Text = M->addSection(Ctx, ".text");
+  std::vector<gtirb::ByteInterval*> Intervals;
+  for (uint64_t I = 0; I < 200; ++I) {
+    auto* BI = Text->addByteInterval(Ctx, gtirb::Addr(0x1000 + I * 16), 16);
+    BI->addBlock<gtirb::CodeBlock>(Ctx, 0, 16);
+    BI->addSymbolicExpression<gtirb::SymAddrConst>(2, 0, Var);
+    BI->addSymbolicExpression<gtirb::SymAddrConst>(8, 0, Fun);
+    Intervals.push_back(BI);
+  }
+
+  fixupSharedObject(Ctx, *M);
+
+  // The variable is aliased once, however many intervals reference it.
+  ASSERT_EQ(countSymbols(*M, AliasPrefix + "var"), 1u);
+  const gtirb::Symbol* Alias = &*M->findSymbols(AliasPrefix + "var").begin();
+  EXPECT_EQ(Alias->getReferent<gtirb::DataBlock>(),
+            Var->getReferent<gtirb::DataBlock>());
+  EXPECT_EQ(aux_data::getElfSymbolInfo(*Alias)->Visibility, "HIDDEN");
+  EXPECT_EQ(countSymbols(*M, AliasPrefix + "fun"), 0u);
+
+  for (const auto* BI : Intervals) {
+    const auto* VarRef = std::get_if<gtirb::SymAddrConst>(
+        BI->getSymbolicExpression(2));
+    ASSERT_NE(VarRef, nullptr);
+    EXPECT_EQ(VarRef->Sym, Alias);
+    EXPECT_EQ(VarRef->Attributes.count(gtirb::SymAttribute::PLT), 0u);
+
+    const auto* FunRef = std::get_if<gtirb::SymAddrConst>(
+        BI->getSymbolicExpression(8));
+    ASSERT_NE(FunRef, nullptr);
+    EXPECT_EQ(FunRef->Sym, Fun);
+    EXPECT_EQ(FunRef->Attributes.count(gtirb::SymAttribute::PLT), 1u);
+  }
+}
+
+TEST(Unit_Fixup, SharedObjectAliasAndPltDifference) {
+  gtirb::Context Ctx;
+  auto* M = createSharedObject(Ctx);
+  auto* Var = addGlobalVariable(Ctx, *M);
+  auto* Fun = addUndefinedFunction(Ctx, *M);
+
+  auto* Text = M->addSection(Ctx, ".text")
+                   ->addByteInterval(Ctx, gtirb::Addr(0x1000), 16);
+  Text->addBlock<gtirb::CodeBlock>(Ctx, 0, 16);
+  Text->addSymbolicExpression<gtirb::SymAddrAddr>(4, 1, 0, Var, Fun);
+
+  fixupSharedObject(Ctx, *M);
+
+  // The variable is replaced by its alias, and the whole expression goes
+  // through the PLT for the function.
+  ASSERT_EQ(countSymbols(*M, AliasPrefix + "var"), 1u);
+  const auto* Diff =
+      std::get_if<gtirb::SymAddrAddr>(Text->getSymbolicExpression(4));
+  ASSERT_NE(Diff, nullptr);
+  EXPECT_EQ(Diff->Sym1, &*M->findSymbols(AliasPrefix + "var").begin());
+  EXPECT_EQ(Diff->Sym2, Fun);
+  EXPECT_EQ(Diff->Attributes.count(gtirb::SymAttribute::PLT), 1u);
+  EXPECT_EQ(countSymbols(*M, AliasPrefix + "fun"), 0u);
+}
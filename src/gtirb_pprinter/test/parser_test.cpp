@@ -1,6 +1,7 @@
 #include "../driver/parser.hpp"
 #include <gtest/gtest.h>
 #include <iomanip>
+#include <regex>
 
 using namespace gtirb_pprint_parser;
 using namespace std::literals;
@@ -132,3 +133,28 @@ TEST(Unit_Parser, E2E) {
       << "Expected " << Name << ", got "
       << getOutputFilePath(Subs, Name)->generic_string();
 }
+
+TEST(Unit_Parser, ManyModules) {
+  // Patterns are compiled once by parseInput, and reused for every module.
+  auto Subs = parseInput(
+      "{s:lib*}.{ext:so*}=libs/{s}.rw.{ext},*.dll=dlls/{n},bin/{name}");
+  ASSERT_EQ(Subs.size(), 3);
+  for (size_t I = 0; I < 5000; ++I) {
+    std::string N = std::to_string(I);
+    EXPECT_EQ(getOutputFilePath(Subs, "lib" + N + ".so." + N),
+              fs::path("libs/lib" + N + ".rw.so." + N));
+    EXPECT_EQ(getOutputFilePath(Subs, "mod" + N + ".dll"),
+              fs::path("dlls/mod" + N + ".dll"));
+    EXPECT_EQ(getOutputFilePath(Subs, "exe" + N), fs::path("bin/exe" + N));
+  }
+
+  // Stars match as few characters as they can, even with many of them.
+  std::string Input = "{a:*}-{b:*}-*-*-*-*-*-*-*-*-x";
+  auto M = makePattern(Input.begin(), Input.end());
+  std::string Name(2000, '-');
+  EXPECT_FALSE(M.matches(Name));
+  auto Match = M.matches("1-2-3-4-5-6-7-8-9-10-x");
+  ASSERT_TRUE(Match);
+  EXPECT_EQ((*Match)[1], "1");
+  EXPECT_EQ((*Match)[2], "2");
+}
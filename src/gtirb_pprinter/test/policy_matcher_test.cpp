@@ -0,0 +1,55 @@
+//===- policy_matcher_test.cpp ----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2022 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+//  This project is sponsored by the Office of Naval Research, One Liberty
+//  Center, 875 N. Randolph Street, Arlington, VA 22203 under contract #
+//  N68335-17-C-0700.  The content of the information does not necessarily
+//  reflect the position or policy of the Government and no official
+//  endorsement should be inferred.
+//
+//===----------------------------------------------------------------------===//
+#include <gtest/gtest.h>
+#include <gtirb/gtirb.hpp>
+#include <gtirb_pprinter/PolicyMatcher.hpp>
+#include <gtirb_pprinter/PrettyPrinter.hpp>
+
+using namespace gtirb_pprint;
+
+TEST(Unit_PolicyMatcher, PrunedFunctionsAreExactNames) {
+  gtirb::Context Ctx;
+  auto* M = gtirb::Module::Create(Ctx, "test");
+  // An MSVC-decorated name, which would match other names as a glob.
+  auto* Pruned = M->addSymbol(Ctx, "?dead@@YAXXZ");
+  auto* Other = M->addSymbol(Ctx, "_dead@@YAXXZ");
+
+  PrintingPolicy Policy;
+  Policy.prunedFunctions.insert("?dead@@YAXXZ");
+  CompiledPolicy Compiled(Policy, *M);
+  EXPECT_TRUE(Compiled.isSkippedFunction(*Pruned));
+  EXPECT_FALSE(Compiled.isSkippedFunction(*Other));
+
+  // Functions kept explicitly are printed even if they were pruned.
+  Policy.keepFunctions.insert("?dead@@YAXXZ");
+  CompiledPolicy Kept(Policy, *M);
+  EXPECT_FALSE(Kept.isSkippedFunction(*Pruned));
+  EXPECT_FALSE(Kept.isSkippedFunction(*Other));
+}
+
+TEST(Unit_PolicyMatcher, PatternsArePrefixed) {
+  NameMatcher Exact({"asan_*", "?dead@@YAXXZ"});
+  EXPECT_TRUE(Exact.matches("asan_*"));
+  EXPECT_FALSE(Exact.matches("asan_init"));
+  EXPECT_TRUE(Exact.matches("?dead@@YAXXZ"));
+  EXPECT_FALSE(Exact.matches("_dead@@YAXXZ"));
+
+  NameMatcher Patterns({"glob:asan_*", "glob:f[!0-9]?"}, {"asan_report"});
+  EXPECT_TRUE(Patterns.matches("asan_init"));
+  EXPECT_FALSE(Patterns.matches("asan_report"));
+  EXPECT_TRUE(Patterns.matches("fxy"));
+  EXPECT_FALSE(Patterns.matches("f1y"));
+  EXPECT_FALSE(Patterns.matches("glob:asan_*"));
+}
@@ -0,0 +1,124 @@
+import json
+import os
+import subprocess
+
+import gtirb
+from gtirb_helpers import add_code_block, add_text_section, create_test_module
+from pprinter_helpers import (
+    PPrinterTest,
+    asm_lines,
+    pprinter_binary,
+    temp_directory,
+)
+
+
+class BatchTest(PPrinterTest):
+    def test_batch_isolates_failures(self):
+        """
+        Check that the jobs of a batch are printed in one run, and that a
+        failing job does not prevent the others from being printed.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\xC3")
+
+        with temp_directory() as tmpdir:
+            ir.save_protobuf(os.path.join(tmpdir, "test.gtirb"))
+            manifest = {
+                "jobs": [
+                    {"ir": "test.gtirb", "outputs": {"asm": "one.s"}},
+                    {"ir": "missing.gtirb", "outputs": {"asm": "bad.s"}},
+                    {
+                        "ir": "test.gtirb",
+                        "options": ["--syntax", "intel"],
+                        "outputs": {"asm": "two.s"},
+                    },
+                ]
+            }
+            with open(os.path.join(tmpdir, "batch.json"), "w") as f:
+                json.dump(manifest, f)
+
+            result = subprocess.run(
+                (pprinter_binary(), "--batch", "batch.json"),
+                cwd=tmpdir,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                universal_newlines=True,
+            )
+            self.assertNotEqual(result.returncode, 0)
+            self.assertIn("2 of 3 batch jobs succeeded", result.stdout)
+
+            with open(os.path.join(tmpdir, "one.s")) as f:
+                self.assertContains(asm_lines(f.read()), ["retq"])
+            with open(os.path.join(tmpdir, "two.s")) as f:
+                self.assertContains(asm_lines(f.read()), ["ret"])
+            self.assertFalse(os.path.exists(os.path.join(tmpdir, "bad.s")))
+
+    def test_batch_isolates_print_errors(self):
+        """
+        Check that a module that cannot be printed fails its own job without
+        ending the process.
+        """
+        good, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\xC3")
+
+        # Two bytes are not an ARM instruction, so the block cannot be
+        # decoded.
+        bad, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.ARM,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\x00\xBF")
+
+        with temp_directory() as tmpdir:
+            good.save_protobuf(os.path.join(tmpdir, "good.gtirb"))
+            bad.save_protobuf(os.path.join(tmpdir, "bad.gtirb"))
+
+            result = subprocess.run(
+                (pprinter_binary(), "bad.gtirb", "--asm", "bad.s"),
+                cwd=tmpdir,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                universal_newlines=True,
+            )
+            self.assertEqual(result.returncode, 1)
+            self.assertIn("Failed to decode block", result.stderr)
+
+            manifest = {
+                "jobs": [
+                    {"ir": "bad.gtirb", "outputs": {"asm": "bad.s"}},
+                    {"ir": "good.gtirb", "outputs": {"asm": "good.s"}},
+                ]
+            }
+            with open(os.path.join(tmpdir, "batch.json"), "w") as f:
+                json.dump(manifest, f)
+
+            result = subprocess.run(
+                (
+                    pprinter_binary(),
+                    "--batch",
+                    "batch.json",
+                    "--batch-jobs",
+                    "1",
+                ),
+                cwd=tmpdir,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.PIPE,
+                universal_newlines=True,
+            )
+            self.assertNotEqual(result.returncode, 0)
+            self.assertIn("Failed to decode block", result.stderr)
+            self.assertIn("1 of 2 batch jobs succeeded", result.stdout)
+            with open(os.path.join(tmpdir, "good.s")) as f:
+                self.assertContains(asm_lines(f.read()), ["retq"])
@@ -0,0 +1,88 @@
+import gzip
+import os
+import shutil
+import subprocess
+import unittest
+
+import gtirb
+from gtirb_helpers import add_code_block, add_text_section, create_test_module
+from pprinter_helpers import (
+    PPrinterTest,
+    asm_lines,
+    pprinter_binary,
+    temp_directory,
+)
+
+
+class CompressedIOTest(PPrinterTest):
+    def test_gzip_input_and_output(self):
+        """
+        Check that gzip compressed IR can be read and that the assembly is
+        compressed when the output file name ends in .gz.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\xC3")
+
+        with temp_directory() as tmpdir:
+            gtirb_path = os.path.join(tmpdir, "test.gtirb")
+            ir.save_protobuf(gtirb_path)
+            with open(gtirb_path, "rb") as f:
+                data = f.read()
+            with gzip.open(gtirb_path + ".gz", "wb") as f:
+                f.write(data)
+
+            asm_path = os.path.join(tmpdir, "test.s.gz")
+            subprocess.run(
+                (pprinter_binary(), gtirb_path + ".gz", "--asm", asm_path),
+                check=True,
+                cwd=tmpdir,
+                stdout=subprocess.DEVNULL,
+            )
+            with gzip.open(asm_path, "rt") as f:
+                asm = f.read()
+
+        self.assertContains(asm_lines(asm), ["retq"])
+
+    @unittest.skipUnless(shutil.which("zstd"), "zstd is not installed")
+    def test_zstd_input_and_output(self):
+        """
+        Check that zstd compressed IR can be read and that the assembly is
+        compressed when the output file name ends in .zst.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\xC3")
+
+        with temp_directory() as tmpdir:
+            gtirb_path = os.path.join(tmpdir, "test.gtirb")
+            ir.save_protobuf(gtirb_path)
+            subprocess.run(("zstd", "-q", gtirb_path), check=True)
+
+            asm_path = os.path.join(tmpdir, "test.s.zst")
+            result = subprocess.run(
+                (pprinter_binary(), gtirb_path + ".zst", "--asm", asm_path),
+                cwd=tmpdir,
+                stdout=subprocess.DEVNULL,
+                stderr=subprocess.PIPE,
+                text=True,
+            )
+            if "This build cannot" in result.stderr:
+                self.skipTest("gtirb-pprinter was built without zstd")
+            self.assertEqual(result.returncode, 0, result.stderr)
+            asm = subprocess.run(
+                ("zstd", "-q", "-d", "-c", asm_path),
+                check=True,
+                stdout=subprocess.PIPE,
+                text=True,
+            ).stdout
+
+        self.assertContains(asm_lines(asm), ["retq"])
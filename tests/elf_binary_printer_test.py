@@ -12,6 +12,7 @@ import gtirb
 import gtirb_test_helpers as gth
 import dummyso
 import hello_world
+from gtirb_helpers import add_elf_symbol_info, add_function
 
 from pprinter_helpers import pprinter_binary
 
@@ -137,6 +138,56 @@ class ElfBinaryPrinterTests(unittest.TestCase):
         )
         return ir, module
 
+    def build_multi_function_ir(self) -> gtirb.IR:
+        """
+        Build an IR whose _start calls three local functions, so that it can
+        be split into several compilation units.
+        """
+        ir, module = gth.create_test_module(
+            gtirb.Module.FileFormat.ELF,
+            gtirb.Module.ISA.X64,
+        )
+        _, text_bi = gth.add_text_section(module)
+
+        # For the following code:
+        #    e8 xx xx xx xx          call   f0
+        #    e8 xx xx xx xx          call   f1
+        #    e8 xx xx xx xx          call   f2
+        #    48 c7 c0 3c 00 00 00    mov    $0x3c,%rax
+        #    48 31 ff                xor    %rdi,%rdi
+        #    0f 05                   syscall
+        start = gth.add_code_block(
+            text_bi,
+            b"\xe8\x00\x00\x00\x00" * 3
+            + b"\x48\xc7\xc0\x3c\x00\x00\x00"
+            b"\x48\x31\xff"
+            b"\x0f\x05",
+        )
+        add_function(module, "_start", start)
+        for i in range(3):
+            # 15 nops and a ret
+            block = gth.add_code_block(text_bi, b"\x90" * 15 + b"\xc3")
+            symbol = gth.add_symbol(module, "f{}".format(i), block)
+            add_function(module, symbol, block)
+            add_elf_symbol_info(module, symbol, block.size, "FUNC", "LOCAL")
+            text_bi.symbolic_expressions[
+                start.offset + 1 + 5 * i
+            ] = gtirb.SymAddrConst(0, symbol)
+        return ir
+
+    def compiler_invocations(
+        self, result: BinaryPrintResult
+    ) -> typing.List[typing.List[str]]:
+        """
+        The arguments of the compiler invocations that built the binary.
+        """
+        prefix = "Compiler arguments:"
+        return [
+            line[len(prefix) :].split()
+            for line in result.completed_process.stdout.splitlines()
+            if line.startswith(prefix)
+        ]
+
     def test_dummyso(self):
         """
         Test printing a simple GTIRB with --dummy-so.
@@ -162,6 +213,61 @@ class ElfBinaryPrinterTests(unittest.TestCase):
             self.assertTrue("a() invoked!" in exec_proc.stdout)
             self.assertTrue("b() invoked!" in exec_proc.stdout)
 
+    def test_dummyso_stub_cache(self):
+        """
+        Test that --stub-cache reuses dummy .so files across runs.
+        """
+        ir = dummyso.build_gtirb()
+        with tempfile.TemporaryDirectory() as cache_dir:
+            args = ("--dummy-so", "yes", "--stub-cache", cache_dir)
+            with self.binary_print(ir, *args) as result:
+                output = (
+                    result.completed_process.stdout
+                    + result.completed_process.stderr
+                )
+                self.assertNotIn("Reusing cached dummy .so", output)
+            entries = sorted(os.listdir(cache_dir))
+            self.assertEqual(len(entries), 2)
+
+            with self.binary_print(ir, *args) as result:
+                output = (
+                    result.completed_process.stdout
+                    + result.completed_process.stderr
+                )
+                self.assertIn("Reusing cached dummy .so for libmya.so", output)
+                self.assertIn("Reusing cached dummy .so for libmyb.so", output)
+            self.assertEqual(sorted(os.listdir(cache_dir)), entries)
+
+            libdir = Path(__file__).parent / "dummyso_libs"
+            subprocess.run("make", cwd=libdir, check=True)
+            with self.binary_print(ir, *args) as result:
+                exec_proc = subprocess.run(
+                    str(result.path),
+                    env={"LD_LIBRARY_PATH": libdir},
+                    check=True,
+                    capture_output=True,
+                    text=True,
+                )
+                self.assertTrue("a() invoked!" in exec_proc.stdout)
+
+    def test_dummyso_native_stub(self):
+        """
+        Test the contents of a dummy .so written without the compiler.
+        """
+        ir = dummyso.build_versioned_syms_gtirb()
+        with tempfile.TemporaryDirectory() as cache_dir:
+            with self.binary_print(
+                ir, "--dummy-so", "yes", "--stub-cache", cache_dir
+            ):
+                pass
+            (entry,) = os.listdir(cache_dir)
+            stub = Path(cache_dir) / entry
+            dynamic = self.readelf(stub, "--dynamic").stdout
+            self.assertIn("Library soname: [libmya.so]", dynamic)
+            versions = self.readelf(stub, "--version-info").stdout
+            self.assertIn("LIBA_1.0", versions)
+            self.assertIn("LIBA_2.0", versions)
+
     def test_dummyso_plt_sec(self):
         """
         Test printing a GTIRB where a symbol is attached to a PLT entry in
@@ -310,6 +416,97 @@ class ElfBinaryPrinterTests(unittest.TestCase):
             )
             self.assertTrue("relocatable" in output.stdout)
 
+    def test_native_object(self):
+        """
+        Test the --native-object argument, both for objects and binaries
+        """
+        ir = hello_world.build_gtirb()
+        with self.binary_print(ir, "--object", "--native-object") as result:
+            output = subprocess.run(
+                ["file", result.path],
+                check=True,
+                capture_output=True,
+                text=True,
+            )
+            self.assertIn("relocatable", output.stdout)
+            self.assertNotIn(
+                "using the assembler", result.completed_process.stdout
+            )
+
+        with self.binary_print(ir, "--native-object"):
+            # Just verify binary_print succeeded.
+            pass
+
+    def test_split_units(self):
+        """
+        Test the --split-units argument
+        """
+        ir = self.build_multi_function_ir()
+        with self.binary_print(ir, "--split-units", "1") as result:
+            # A single unit is assembled and linked in one step.
+            for args in self.compiler_invocations(result):
+                self.assertNotIn("-c", args)
+            subprocess.run([result.path], check=True)
+
+        with self.binary_print(ir, "--split-units", "4") as result:
+            invocations = self.compiler_invocations(result)
+            assembled = [args for args in invocations if "-c" in args]
+            self.assertGreater(len(assembled), 1)
+            subprocess.run([result.path], check=True)
+
+    def test_split_units_jobs(self):
+        """
+        Test that the units of a split module are assembled concurrently,
+        and that each unit and the link get the compiler arguments of the user
+        and of the policy.
+        """
+        ir = self.build_multi_function_ir()
+        with self.binary_print(
+            ir,
+            "--split-units",
+            "4",
+            "--jobs",
+            "3",
+            "--compiler-args=-DSPLIT_UNITS_TEST",
+        ) as result:
+            invocations = self.compiler_invocations(result)
+            assembled = [args for args in invocations if "-c" in args]
+            linked = [args for args in invocations if "-c" not in args]
+
+            self.assertGreater(len(assembled), 1)
+            for args in assembled:
+                self.assertEqual(args.count("-DSPLIT_UNITS_TEST"), 1)
+                self.assertIn("-nostartfiles", args)
+            self.assertEqual(len(linked), 1)
+            self.assertEqual(linked[0].count("-DSPLIT_UNITS_TEST"), 1)
+            self.assertIn("-nostartfiles", linked[0])
+
+            # The functions called from _start are in other units.
+            subprocess.run([result.path], check=True)
+
+    def test_output_cache(self):
+        """
+        Test that --output-cache reuses binaries built with the same options.
+        """
+        ir = hello_world.build_gtirb()
+        with tempfile.TemporaryDirectory() as cache_dir:
+            args = ("--output-cache", cache_dir)
+            with self.binary_print(ir, *args) as result:
+                output = result.completed_process.stdout
+                self.assertIn("Output cache miss", output)
+                binary = result.path.read_bytes()
+
+            with self.binary_print(ir, *args) as result:
+                output = result.completed_process.stdout
+                self.assertIn("Output cache hit", output)
+                self.assertEqual(result.path.read_bytes(), binary)
+                self.assertTrue(os.access(result.path, os.X_OK))
+
+            # Different options build a different binary.
+            with self.binary_print(ir, *args, "--object") as result:
+                output = result.completed_process.stdout
+                self.assertIn("Output cache miss", output)
+
     def subtest_dyn_option(
         self,
         mode: str,
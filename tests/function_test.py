@@ -1,3 +1,6 @@
+import os
+import subprocess
+
 import gtirb
 from gtirb_helpers import (
     add_data_block,
@@ -9,7 +12,14 @@ from gtirb_helpers import (
     add_section,
     add_function,
 )
-from pprinter_helpers import run_asm_pprinter, PPrinterTest, asm_lines
+from pprinter_helpers import (
+    pprinter_binary,
+    run_asm_pprinter,
+    run_asm_pprinter_with_output,
+    temp_directory,
+    PPrinterTest,
+    asm_lines,
+)
 import uuid
 
 
@@ -134,3 +144,144 @@ class FunctionTests(PPrinterTest):
         # even if we skip foo and foo3, there code in between is left
         self.assertNotContains(asm_lines(asm), ["retq"])
         self.assertContains(asm_lines(asm), ["int $3"])
+
+    def test_function_cache(self):
+        """
+        Check that --function-cache reuses the text of unchanged functions.
+        """
+
+        def make_ir(foo_bytes):
+            ir, m = create_test_module(
+                file_format=gtirb.Module.FileFormat.ELF,
+                isa=gtirb.Module.ISA.X64,
+                binary_type=["DYN"],
+            )
+            _, _ = add_section(m, ".dynamic")
+            _, bi = add_text_section(m)
+            add_function(m, "foo", add_code_block(bi, foo_bytes))
+            add_function(m, "bar", add_code_block(bi, b"\xC3"))
+            return ir
+
+        with temp_directory() as cache_dir:
+            args = ["--function-cache", cache_dir]
+            asm1, output = run_asm_pprinter_with_output(
+                make_ir(b"\xC3"), args
+            )
+            self.assertIn("Reused the text of 0 of 2 functions", output)
+
+            asm2, output = run_asm_pprinter_with_output(
+                make_ir(b"\xC3"), args
+            )
+            self.assertIn("Reused the text of 2 of 2 functions", output)
+            self.assertEqual(asm1, asm2)
+
+            asm3, output = run_asm_pprinter_with_output(
+                make_ir(b"\xCC"), args
+            )
+            self.assertIn("Reused the text of 1 of 2 functions", output)
+            self.assertContains(
+                asm_lines(asm3),
+                ["foo:", "int $3", ".size foo, . - foo", "bar:", "retq"],
+            )
+
+    def test_print_single_function(self):
+        """
+        Check that --function prints only the blocks of that function.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_function(m, "foo", add_code_block(bi, b"\xC3"))
+        add_function(m, "bar", add_code_block(bi, b"\x90\xC3"))
+
+        asm = run_asm_pprinter(ir, ["--function", "bar"])
+
+        self.assertContains(asm_lines(asm), [".text", "bar:", "nop", "retq"])
+        self.assertNotIn("foo:", asm_lines(asm))
+
+    def test_print_unknown_function(self):
+        """
+        Check that --function fails if no function has the name.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_function(m, "foo", add_code_block(bi, b"\xC3"))
+
+        for args in ((), ("--asm", "test.s")):
+            with self.subTest(args=args), temp_directory() as tmpdir:
+                ir.save_protobuf(os.path.join(tmpdir, "test.gtirb"))
+                result = subprocess.run(
+                    (pprinter_binary(), "test.gtirb", "--function", "bar")
+                    + args,
+                    cwd=tmpdir,
+                    stdout=subprocess.PIPE,
+                    stderr=subprocess.PIPE,
+                    universal_newlines=True,
+                )
+                self.assertNotEqual(result.returncode, 0)
+                self.assertIn("has no function named bar", result.stderr)
+
+    def test_print_address_range(self):
+        """
+        Check that --address-range prints only the blocks overlapping the
+        range.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m, 0x1000)
+        add_function(m, "foo", add_code_block(bi, b"\xC3"))
+        add_function(m, "bar", add_code_block(bi, b"\x90\xC3"))
+        add_function(m, "baz", add_code_block(bi, b"\xCC\xC3"))
+
+        asm = run_asm_pprinter(ir, ["--address-range", "0x1001-0x1003"])
+        self.assertContains(asm_lines(asm), [".text", "bar:", "nop", "retq"])
+        self.assertNotIn("foo:", asm_lines(asm))
+        self.assertNotIn("baz:", asm_lines(asm))
+        self.assertNotIn("int $3", asm_lines(asm))
+
+        # A range overlapping the last byte of bar and the first of baz.
+        asm = run_asm_pprinter(ir, ["--address-range", "0x1002-0x1004"])
+        self.assertContains(
+            asm_lines(asm), ["bar:", "nop", "retq", "baz:", "int $3", "retq"]
+        )
+        self.assertNotIn("foo:", asm_lines(asm))
+
+    def test_print_bad_address_range(self):
+        """
+        Check that malformed and empty address ranges are rejected.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m, 0x1000)
+        add_function(m, "foo", add_code_block(bi, b"\xC3"))
+
+        for text in ("0x1000", "0x1000-bar", "0x1003-0x1001", "0x1000-0x1000"):
+            with self.subTest(range=text), temp_directory() as tmpdir:
+                ir.save_protobuf(os.path.join(tmpdir, "test.gtirb"))
+                result = subprocess.run(
+                    (
+                        pprinter_binary(),
+                        "test.gtirb",
+                        "--address-range",
+                        text,
+                    ),
+                    cwd=tmpdir,
+                    stdout=subprocess.PIPE,
+                    stderr=subprocess.PIPE,
+                    universal_newlines=True,
+                )
+                self.assertNotEqual(result.returncode, 0)
+                self.assertIn("Invalid address range", result.stderr)
@@ -0,0 +1,91 @@
+import json
+
+import gtirb
+from gtirb_helpers import (
+    add_code_block,
+    add_data_block,
+    add_data_section,
+    add_function,
+    add_symbol,
+    add_text_section,
+    create_test_module,
+)
+from pprinter_helpers import PPrinterTest, run_asm_pprinter
+
+
+class ListingFormatTest(PPrinterTest):
+    def test_jsonl_listing(self):
+        """
+        Check that --format-listing=jsonl writes sections, labels,
+        instructions, and data as JSON records with their symbolic
+        references.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m, 0x1000)
+        call_block = add_code_block(bi, b"\xE8\x00\x00\x00\x00")
+        ret_block = add_code_block(bi, b"\xC3")
+        foo = add_symbol(m, "foo", call_block)
+        bar = add_symbol(m, "bar", ret_block)
+        add_function(m, foo, call_block)
+        add_function(m, bar, ret_block)
+        bi.symbolic_expressions[1] = gtirb.symbolicexpression.SymAddrConst(
+            0, bar
+        )
+        _, dbi = add_data_section(m, 0x2000)
+        add_data_block(
+            dbi,
+            b"\x00" * 8,
+            {0: gtirb.symbolicexpression.SymAddrConst(0, foo)},
+        )
+
+        listing = run_asm_pprinter(ir, ["--format-listing", "jsonl"])
+        records = [json.loads(line) for line in listing.splitlines()]
+
+        sections = [r["name"] for r in records if r["type"] == "section"]
+        self.assertIn(".text", sections)
+        self.assertIn(".data", sections)
+        self.assertIn(
+            {"type": "symbol", "name": "foo", "address": 0x1000}, records
+        )
+
+        instructions = [r for r in records if r["type"] == "instruction"]
+        self.assertEqual(len(instructions), 2)
+        call, ret = instructions
+        self.assertEqual(call["address"], 0x1000)
+        self.assertEqual(call["bytes"], "e800000000")
+        self.assertEqual(len(call["operands"]), 1)
+        self.assertEqual(
+            call["refs"], [{"offset": 1, "symbol": "bar", "addend": 0}]
+        )
+        self.assertEqual(ret["address"], 0x1005)
+        self.assertNotIn("refs", ret)
+
+        (data,) = [r for r in records if r["type"] == "data"]
+        self.assertEqual(data["address"], 0x2000)
+        self.assertEqual(data["size"], 8)
+        self.assertNotIn("bytes", data)
+        self.assertEqual(
+            data["refs"], [{"offset": 0, "symbol": "foo", "addend": 0}]
+        )
+
+    def test_jsonl_shifted_operand(self):
+        """
+        Check that a shifted register is a single operand, even though its
+        text contains a comma.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.ARM64,
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\x00\x0c\x01\x8b")  # add x0, x0, x1, lsl #3
+
+        listing = run_asm_pprinter(ir, ["--format-listing", "jsonl"])
+        records = [json.loads(line) for line in listing.splitlines()]
+
+        (add,) = [r for r in records if r["type"] == "instruction"]
+        self.assertEqual(add["operands"], ["x0", "x0", "x1, lsl #3"])
@@ -232,9 +232,9 @@ def run_binary_pprinter_mock(
         # of spurious wakeups on this thread.
         listener.settimeout(0.01)
 
-        # The pretty-printer invokes processes synchronously and serially,
-        # so we don't need to get clever about multiple connections at
-        # once (or the ordering of things).
+        # The pretty-printer may run independent processes concurrently;
+        # their connections queue on the listener and are serviced one at
+        # a time, so callers must not depend on the order of invocations.
         generator_exit = False
         while not proc_future.done():
             try:
@@ -0,0 +1,94 @@
+import gzip
+import io
+import os
+import threading
+import unittest
+
+import gtirb
+from gtirb_helpers import add_code_block, add_text_section, create_test_module
+from pprinter_helpers import PPrinterTest, asm_lines, temp_directory
+
+try:
+    from gtirb_pprinter import _native  # noqa: F401
+    from gtirb_pprinter import print_assembly
+except ImportError:
+    print_assembly = None
+
+
+def create_ret_ir() -> bytes:
+    """
+    Create a serialized IR whose only module holds a return.
+    """
+    ir, m = create_test_module(
+        file_format=gtirb.Module.FileFormat.ELF,
+        isa=gtirb.Module.ISA.X64,
+        binary_type=["EXEC"],
+    )
+    _, bi = add_text_section(m)
+    add_code_block(bi, b"\xC3")
+    data = io.BytesIO()
+    ir.save_protobuf_to(data)
+    return data.getvalue()
+
+
+@unittest.skipIf(print_assembly is None, "the native extension is not built")
+class PrintAssemblyTest(PPrinterTest):
+    def test_print_bytes(self):
+        """
+        Check that serialized IR is printed from any bytes-like object.
+        """
+        data = create_ret_ir()
+        asm = print_assembly(data).decode()
+        self.assertContains(asm_lines(asm), ["retq"])
+        self.assertEqual(print_assembly(bytearray(data)).decode(), asm)
+        self.assertEqual(print_assembly(memoryview(data)).decode(), asm)
+        self.assertContains(
+            asm_lines(print_assembly(data, syntax="intel").decode()), ["ret"]
+        )
+
+    def test_print_compressed(self):
+        """
+        Check that gzip compressed IR is decompressed, as by gtirb-pprinter.
+        """
+        data = create_ret_ir()
+        asm = print_assembly(data)
+        self.assertEqual(print_assembly(gzip.compress(data)), asm)
+
+        with temp_directory() as tmpdir:
+            gtirb_path = os.path.join(tmpdir, "test.gtirb.gz")
+            with gzip.open(gtirb_path, "wb") as f:
+                f.write(data)
+            asm_path = os.path.join(tmpdir, "test.s")
+            self.assertIsNone(print_assembly(gtirb_path, asm_path))
+            with open(asm_path, "rb") as f:
+                self.assertEqual(f.read(), asm)
+
+    def test_print_from_threads(self):
+        """
+        Check that several threads can print at once.
+        """
+        data = create_ret_ir()
+        expected = print_assembly(data)
+        results = [None] * 4
+
+        def run(index):
+            results[index] = print_assembly(data)
+
+        threads = [
+            threading.Thread(target=run, args=(i,))
+            for i in range(len(results))
+        ]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(results, [expected] * len(results))
+
+    def test_print_errors(self):
+        """
+        Check that bad IR and unknown modules raise exceptions.
+        """
+        with self.assertRaises(RuntimeError):
+            print_assembly(b"not gtirb")
+        with self.assertRaises(ValueError):
+            print_assembly(create_ret_ir(), module="missing")
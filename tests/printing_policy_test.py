@@ -2,6 +2,8 @@ import gtirb
 from gtirb_helpers import (
     create_test_module,
     add_code_block,
+    add_data_block,
+    add_data_section,
     add_text_section,
     add_section,
     add_function,
@@ -62,3 +64,152 @@ class PrintingPolicyTests(PPrinterTest):
         self.assertContains(asm_lines(asm), function_lines)
         asm = run_asm_pprinter(ir, ["--skip-function", "foo_alias"])
         self.assertNotContains(asm_lines(asm), function_lines)
+
+    def test_skip_function_pattern(self):
+        """
+        Check that functions can be skipped by glob patterns, and that
+        functions kept by name are printed even if they match one.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["DYN"],
+        )
+        _, _ = add_section(m, ".dynamic")
+        _, bi = add_text_section(m)
+        add_function(m, "asan_init", add_code_block(bi, b"\xC3"))
+        add_function(m, "asan_report", add_code_block(bi, b"\xC3"))
+        add_function(m, "main", add_code_block(bi, b"\xC3"))
+
+        asm = run_asm_pprinter(ir, ["--skip-function", "glob:asan_*"])
+        self.assertNotIn("asan_init:", asm)
+        self.assertNotIn("asan_report:", asm)
+        self.assertIn("main:", asm)
+
+        # Without the prefix, the name is matched exactly.
+        asm = run_asm_pprinter(ir, ["--skip-function", "asan_*"])
+        self.assertIn("asan_init:", asm)
+        self.assertIn("asan_report:", asm)
+
+        asm = run_asm_pprinter(
+            ir,
+            [
+                "--skip-function",
+                "glob:asan_*",
+                "--keep-function",
+                "asan_report",
+            ],
+        )
+        self.assertNotIn("asan_init:", asm)
+        self.assertIn("asan_report:", asm)
+        self.assertIn("main:", asm)
+
+    def test_prune_unreachable(self):
+        """
+        Check that --prune-unreachable skips the functions that are neither
+        exported nor referenced from reachable code or from data.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["DYN"],
+        )
+        _, _ = add_section(m, ".dynamic")
+        _, bi = add_text_section(m, 0x1000)
+        main_block = add_code_block(bi, b"\xE8\x00\x00\x00\x00\xC3")
+        helper = add_symbol(m, "helper", add_code_block(bi, b"\xC3"))
+        callback = add_symbol(m, "callback", add_code_block(bi, b"\xC3"))
+        dead = add_symbol(m, "dead", add_code_block(bi, b"\xC3"))
+        add_function(m, "main", main_block)
+        for sym in (helper, callback, dead):
+            add_function(m, sym, sym.referent)
+            add_elf_symbol_info(m, sym, 0, "FUNC", binding="LOCAL")
+        bi.symbolic_expressions[1] = gtirb.symbolicexpression.SymAddrConst(
+            0, helper
+        )
+        _, dbi = add_data_section(m, 0x2000)
+        add_data_block(
+            dbi,
+            b"\x00" * 8,
+            {0: gtirb.symbolicexpression.SymAddrConst(0, callback)},
+        )
+
+        asm = run_asm_pprinter(ir)
+        self.assertIn("dead:", asm)
+
+        asm = run_asm_pprinter(ir, ["--prune-unreachable"])
+        self.assertIn("main:", asm)
+        self.assertIn("helper:", asm)
+        self.assertIn("callback:", asm)
+        self.assertNotIn("dead:", asm)
+
+        asm = run_asm_pprinter(
+            ir, ["--prune-unreachable", "--keep-function", "dead"]
+        )
+        self.assertIn("dead:", asm)
+
+    def test_skip_symbol_pattern(self):
+        """
+        Check that symbols can be skipped by glob patterns, character sets,
+        and negated character sets.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["DYN"],
+        )
+        _, _ = add_section(m, ".dynamic")
+        _, bi = add_data_section(m, 0x2000)
+        names = ("var1", "var2", "vax", "other")
+        for name in names:
+            sym = add_symbol(m, name, add_data_block(bi, b"\x00"))
+            add_elf_symbol_info(m, sym, 1, "OBJECT", binding="LOCAL")
+
+        def labels(*args):
+            asm = run_asm_pprinter(ir, args)
+            return {name for name in names if name + ":" in asm}
+
+        self.assertEqual(labels(), set(names))
+        self.assertEqual(
+            labels("--skip-symbol", "glob:var*"), {"vax", "other"}
+        )
+        # Without the prefix, the name is matched exactly.
+        self.assertEqual(labels("--skip-symbol", "var*"), set(names))
+        self.assertEqual(
+            labels("--skip-symbol", "glob:va[xy]"), {"var1", "var2", "other"}
+        )
+        self.assertEqual(
+            labels("--skip-symbol", "glob:var[!1]"), {"var1", "vax", "other"}
+        )
+        self.assertEqual(
+            labels("--skip-symbol", "glob:va?[^2]"), {"var2", "vax", "other"}
+        )
+
+    def test_skip_section_pattern(self):
+        """
+        Check that sections can be skipped by glob patterns, character sets,
+        and negated character sets.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["DYN"],
+        )
+        _, _ = add_section(m, ".dynamic")
+        names = (".tbl1", ".tbl2", ".tblx", ".other")
+        for i, name in enumerate(names):
+            _, bi = add_section(m, name, 0x2000 + 0x100 * i)
+            add_data_block(bi, b"\x00")
+
+        def sections(*args):
+            asm = run_asm_pprinter(ir, args)
+            return {name for name in names if name in asm}
+
+        self.assertEqual(sections(), set(names))
+        self.assertEqual(sections("--skip-section", "glob:.tbl*"), {".other"})
+        self.assertEqual(
+            sections("--skip-section", "glob:.tbl[0-9]"), {".tblx", ".other"}
+        )
+        self.assertEqual(
+            sections("--skip-section", "glob:.tbl[!1]"), {".tbl1", ".other"}
+        )
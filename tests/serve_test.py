@@ -0,0 +1,110 @@
+import json
+import os
+import socket
+import subprocess
+import time
+import unittest
+
+import gtirb
+from gtirb_helpers import (
+    add_code_block,
+    add_function,
+    add_text_section,
+    create_test_module,
+)
+from pprinter_helpers import (
+    PPrinterTest,
+    asm_lines,
+    pprinter_binary,
+    temp_directory,
+)
+
+
+def connect(path, server, timeout=30):
+    """
+    Connect to the server's socket once it is listening.
+    """
+    deadline = time.time() + timeout
+    while True:
+        try:
+            client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            client.connect(path)
+            return client
+        except OSError:
+            client.close()
+            if server.poll() is not None or time.time() > deadline:
+                raise
+            time.sleep(0.1)
+
+
+def request(stream, **fields):
+    """
+    Send a request and collect the text and final status of its response.
+    """
+    stream.write(json.dumps(fields) + "\n")
+    stream.flush()
+    text = ""
+    while True:
+        record = json.loads(stream.readline())
+        if "status" in record:
+            return text, record
+        text += record["text"]
+
+
+@unittest.skipUnless(os.name == "posix", "only runs on Linux")
+class ServeTest(PPrinterTest):
+    def test_serve_functions(self):
+        """
+        Check that a server prints whole modules and single functions of an
+        IR loaded once, and reports errors without stopping.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_function(m, "foo", add_code_block(bi, b"\xC3"))
+        add_function(m, "bar", add_code_block(bi, b"\x90\xC3"))
+
+        with temp_directory() as tmpdir:
+            gtirb_path = os.path.join(tmpdir, "test.gtirb")
+            ir.save_protobuf(gtirb_path)
+            sock_path = os.path.join(tmpdir, "pprinter.sock")
+            server = subprocess.Popen(
+                (pprinter_binary(), gtirb_path, "--serve", sock_path),
+                stdout=subprocess.DEVNULL,
+            )
+            try:
+                client = connect(sock_path, server)
+                with client, client.makefile("rw") as stream:
+                    whole, status = request(stream)
+                    self.assertEqual(status["status"], "ok")
+                    self.assertContains(
+                        asm_lines(whole), ["foo:", "retq", "bar:", "nop"]
+                    )
+
+                    text, status = request(
+                        stream, function="bar", syntax="intel"
+                    )
+                    self.assertEqual(status["status"], "ok")
+                    self.assertContains(asm_lines(text), ["bar:", "nop"])
+                    self.assertNotIn("foo:", asm_lines(text))
+
+                    # Printing a part of a module does not change how the
+                    # whole module is printed afterwards.
+                    _, status = request(stream, function="foo")
+                    self.assertEqual(status["status"], "ok")
+                    again, status = request(stream)
+                    self.assertEqual(status["status"], "ok")
+                    self.assertEqual(again, whole)
+
+                    _, status = request(stream, function="baz")
+                    self.assertEqual(status["status"], "error")
+
+                    _, status = request(stream, shutdown=True)
+                    self.assertEqual(status["status"], "ok")
+                self.assertEqual(server.wait(timeout=30), 0)
+            finally:
+                if server.poll() is None:
+                    server.kill()
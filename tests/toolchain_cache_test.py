@@ -0,0 +1,88 @@
+import os
+import stat
+import subprocess
+import unittest
+
+import gtirb
+from gtirb_helpers import add_code_block, add_text_section, create_test_module
+from pprinter_helpers import (
+    PPrinterTest,
+    can_mock_binaries,
+    pprinter_binary,
+    temp_directory,
+)
+
+
+def install_fake_gcc(directory: str, name: str) -> None:
+    """
+    Install a gcc into the directory that only appends its name to the file
+    named by the TOOL_LOG environment variable.
+    """
+    path = os.path.join(directory, "gcc")
+    with open(path, "w") as f:
+        f.write('#!/bin/sh\necho %s >> "$TOOL_LOG"\n' % name)
+    os.chmod(path, os.stat(path).st_mode | stat.S_IXUSR)
+
+
+@unittest.skipUnless(can_mock_binaries(), "cannot mock binaries")
+class ToolchainCacheTest(PPrinterTest):
+    def test_tool_installed_earlier_on_path(self):
+        """
+        Check that a tool found through the toolchain cache is searched for
+        again once a tool of the same name is installed in a directory that
+        comes before it on PATH.
+        """
+        ir, m = create_test_module(
+            file_format=gtirb.Module.FileFormat.ELF,
+            isa=gtirb.Module.ISA.X64,
+            binary_type=["EXEC"],
+        )
+        _, bi = add_text_section(m)
+        add_code_block(bi, b"\xC3")
+
+        with temp_directory() as tmpdir:
+            gtirb_path = os.path.join(tmpdir, "test.gtirb")
+            ir.save_protobuf(gtirb_path)
+            cache_path = os.path.join(tmpdir, "toolchain.cache")
+            log_path = os.path.join(tmpdir, "tools.log")
+            early = os.path.join(tmpdir, "early")
+            late = os.path.join(tmpdir, "late")
+            os.mkdir(early)
+            os.mkdir(late)
+            install_fake_gcc(late, "late")
+
+            env = dict(os.environ)
+            env["PATH"] = os.pathsep.join([early, late, env.get("PATH", "")])
+            env["TOOL_LOG"] = log_path
+
+            def run_tools():
+                if os.path.exists(log_path):
+                    os.remove(log_path)
+                subprocess.run(
+                    (
+                        pprinter_binary(),
+                        "--ir",
+                        gtirb_path,
+                        "--binary",
+                        os.path.join(tmpdir, "test"),
+                        "--toolchain-cache",
+                        cache_path,
+                    ),
+                    env=env,
+                    cwd=tmpdir,
+                    stdout=subprocess.DEVNULL,
+                    stderr=subprocess.DEVNULL,
+                )
+                with open(log_path) as f:
+                    return set(f.read().split())
+
+            self.assertEqual(run_tools(), {"late"})
+            self.assertTrue(os.path.exists(cache_path))
+            # The cached result is used while nothing changes.
+            self.assertEqual(run_tools(), {"late"})
+
+            install_fake_gcc(early, "early")
+            # Modification times may only have a granularity of a second.
+            stat_result = os.stat(early)
+            os.utime(early, (stat_result.st_atime, stat_result.st_mtime + 10))
+            self.assertEqual(run_tools(), {"early"})
@@ -0,0 +1,92 @@
+import os
+import subprocess
+
+import gtirb
+from gtirb_helpers import (
+    add_code_block,
+    add_elf_symbol_info,
+    add_function,
+    add_symbol,
+    add_text_section,
+    create_test_module,
+)
+from pprinter_helpers import (
+    PPrinterTest,
+    pprinter_binary,
+    temp_directory,
+)
+
+
+def create_call_module() -> gtirb.IR:
+    """
+    Create an executable whose main calls a global function directly; as a
+    shared object, the call must go through a hidden alias of the function.
+    """
+    ir, m = create_test_module(
+        file_format=gtirb.Module.FileFormat.ELF,
+        isa=gtirb.Module.ISA.X64,
+        binary_type=["EXEC"],
+    )
+    _, bi = add_text_section(m)
+    foo_block = add_code_block(bi, b"\xC3")
+    foo = add_symbol(m, "foo", foo_block)
+    add_elf_symbol_info(m, foo, 1, "FUNC")
+    add_function(m, foo, foo_block)
+    main_block = add_code_block(
+        bi, b"\xE8\x00\x00\x00\x00\xC3", {1: gtirb.SymAddrConst(0, foo)}
+    )
+    main = add_symbol(m, "main", main_block)
+    add_elf_symbol_info(m, main, 6, "FUNC")
+    add_function(m, main, main_block)
+    return ir
+
+
+class VariantTest(PPrinterTest):
+    def print_variants(self, ir: gtirb.IR, *args: str) -> dict:
+        """
+        Print the IR to test.s with the given arguments, and return the
+        contents of the assembly files that were written, by name.
+        """
+        with temp_directory() as tmpdir:
+            ir.save_protobuf(os.path.join(tmpdir, "test.gtirb"))
+            subprocess.run(
+                (pprinter_binary(), "test.gtirb", "--asm", "test.s") + args,
+                cwd=tmpdir,
+                check=True,
+                stdout=subprocess.DEVNULL,
+            )
+            outputs = {}
+            for name in os.listdir(tmpdir):
+                if name.endswith(".s"):
+                    with open(os.path.join(tmpdir, name)) as f:
+                        outputs[name] = f.read()
+            return outputs
+
+    def test_shared_variant_keeps_base_output(self):
+        """
+        Check that printing a shared variant does not change the output of
+        the command line.
+        """
+        ir = create_call_module()
+        single = self.print_variants(ir)
+        both = self.print_variants(ir, "--variant", "x:shared=yes")
+
+        self.assertEqual(set(both), {"test.s", "test.x.s"})
+        self.assertEqual(both["test.s"], single["test.s"])
+        self.assertNotIn("hidden_alias", both["test.s"])
+        self.assertIn(".gtirb_pprinter.hidden_alias.foo", both["test.x.s"])
+
+    def test_plain_variant_after_shared_variant(self):
+        """
+        Check that the fixups of a shared variant are undone before the next
+        variant is printed.
+        """
+        ir = create_call_module()
+        single = self.print_variants(ir)
+        outputs = self.print_variants(
+            ir, "--variant", "a:shared=yes", "--variant", "b"
+        )
+
+        self.assertIn(".gtirb_pprinter.hidden_alias.foo", outputs["test.a.s"])
+        self.assertNotIn("hidden_alias", outputs["test.b.s"])
+        self.assertEqual(outputs["test.b.s"], single["test.s"])